@@ -0,0 +1,67 @@
+#ifndef INCLUDE_WINREG_ADDON_HPP
+#define INCLUDE_WINREG_ADDON_HPP
+
+// Helpers shared by the translation units of the Node addon.
+
+#include <napi.h>
+
+#include "winreg.hpp"
+
+#include <string>
+
+// JS string to registry string, and back, through the UTF-16 Node-API
+// string functions
+std::wstring JsToWide(const Napi::Value& value);
+void JsToWide(const Napi::Value& value, std::wstring& out);
+Napi::String WideToJs(Napi::Env env, const wchar_t* str, size_t len);
+Napi::String WideToJs(Napi::Env env, const std::wstring& str);
+
+void toWindowSlashStyle(std::wstring& path);
+
+#define ThrowRegError(e) MakeRegError(env, e).ThrowAsJavaScriptException()
+
+Napi::Error MakeRegError(Napi::Env env, const winreg::RegException& e);
+Napi::Error MakeRegError(Napi::Env env, const winreg::RegResult& result);
+
+// number (REG_DWORD), BigInt (REG_QWORD), string, string[] or Buffer
+Napi::Value ValueDataToJs(Napi::Env env, const winreg::RegValueData& data);
+
+// FILETIME (100ns ticks since 1601) to JS time (ms since 1970), and to a Date
+double FileTimeToJsTime(const FILETIME& ft);
+Napi::Value FileTimeToDate(Napi::Env env, const FILETIME& ft);
+
+// JS time (ms since 1970) to FILETIME
+FILETIME JsTimeToFileTime(double ms);
+
+// Per-environment addon data: constructors of the wrapped classes
+struct AddonData {
+  Napi::FunctionReference regKey;
+  Napi::FunctionReference hiveKey;
+  Napi::FunctionReference hiveIndex;
+};
+
+AddonData* GetAddonData(Napi::Env env);
+
+namespace regf {
+class RegKey;
+}
+
+// The key of a HiveKey object; null if the value isn't one (hive.cc)
+const regf::RegKey* UnwrapHiveKey(Napi::Value value);
+
+// Recursive walks, incremental scans and snapshot files of registry subtrees
+// (walk.cc)
+Napi::Object InitWalk(Napi::Env env, Napi::Object exports);
+
+// Offline hive reader, writer and path index (hive.cc)
+Napi::Object InitHive(Napi::Env env, Napi::Object exports);
+
+// .reg file export and import (regfile.cc)
+Napi::Object InitRegFile(Napi::Env env, Napi::Object exports);
+
+#ifndef _WIN32
+// Controls of the in-memory stand-in registry (standin.cc)
+Napi::Object InitStandIn(Napi::Env env, Napi::Object exports);
+#endif
+
+#endif // INCLUDE_WINREG_ADDON_HPP
@@ -0,0 +1,31 @@
+// Reading and writing multi-MB REG_BINARY values.
+//
+// getBinary() sizes a Buffer with one RegGetValue size query and reads the
+// data straight into it; enumValues({data: true}) reads into a
+// std::vector<BYTE> first and copies that into a new Buffer. setBinary()
+// passes the memory of the Buffer or TypedArray to RegSetValueEx as is.
+
+const { reg, HKCU, ROOT, setup, cleanup, measure, report } = require("./common");
+
+const SIZE = 4 * 1024 * 1024;
+
+setup();
+const key = new reg.RegKey(HKCU, ROOT + "\\Blobs");
+const blob = Buffer.alloc(SIZE);
+for (let i = 0; i < SIZE; i += 4096) blob[i] = i & 0xff;
+key.setBinary("Blob", blob);
+
+console.log(`one REG_BINARY value of ${SIZE >> 20} MiB`);
+report("reading", [
+  ["enumValues({data: true})", measure(1, () => key.enumValues({ data: true }))],
+  ["getBinary", measure(1, () => key.getBinary("Blob"))],
+]);
+
+const words = new Uint32Array(blob.buffer, blob.byteOffset, SIZE / 4);
+report("writing", [
+  ["setBinary(Buffer)", measure(1, () => key.setBinary("Blob", blob))],
+  ["setBinary(Uint32Array)", measure(1, () => key.setBinary("Blob", words))],
+]);
+
+key.close();
+cleanup();
@@ -0,0 +1,45 @@
+// Shared helpers for the benchmarks.
+//
+// On Windows the benchmarks write a scratch tree under
+// HKEY_CURRENT_USER\Software\winreg-bench and delete it afterwards;
+// elsewhere they run against the in-memory stand-in registry.
+
+const reg = require("..");
+
+const HKCU = reg.HKEY_CURRENT_USER;
+const ROOT = "Software\\winreg-bench";
+
+function setup() {
+  if (reg.standin) reg.standin.reset();
+  reg.delete(HKCU, ROOT);
+}
+
+function cleanup() {
+  reg.delete(HKCU, ROOT);
+}
+
+// Run fn() (which processes `items` items per call) for at least `minMs`
+// milliseconds after a warm-up call, and return the mean cost per item.
+function measure(items, fn, minMs = 500) {
+  fn();
+  let calls = 0;
+  const start = process.hrtime.bigint();
+  let elapsed = 0n;
+  do {
+    fn();
+    calls++;
+    elapsed = process.hrtime.bigint() - start;
+  } while (elapsed < BigInt(minMs) * 1000000n);
+  return Number(elapsed) / (calls * items);
+}
+
+function report(title, rows) {
+  console.log(title);
+  const base = rows[0][1];
+  for (const [label, ns] of rows) {
+    const ratio = (base / ns).toFixed(2);
+    console.log(`  ${label.padEnd(28)} ${(ns / 1000).toFixed(2).padStart(9)} us/item  x${ratio}`);
+  }
+}
+
+module.exports = { reg, HKCU, ROOT, setup, cleanup, measure, report };
@@ -0,0 +1,58 @@
+// reg.exportReg (native formatting through a fixed-size buffer) against a JS
+// export that walks with enumSubKeys/enumValues and builds the whole .reg
+// text in memory, for a subtree of string and DWORD values.
+
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+const { reg, HKCU, ROOT, setup, cleanup, measure, report } = require("./common");
+
+const KEYS = 2000;
+
+setup();
+for (let i = 0; i < KEYS; i++) {
+  const key = `${ROOT}\\Products\\{${i}}`;
+  reg.set(HKCU, key, "DisplayName", `Application ${i}`);
+  reg.set(HKCU, key, "InstallLocation", `C:\\Program Files\\Application ${i}`);
+  for (let j = 0; j < 5; j++) reg.set(HKCU, key, `Value${j}`, j);
+}
+
+const quote = (s) => '"' + s.replace(/[\\"]/g, "\\$&") + '"';
+
+function loopExport(keyPath, lines) {
+  const key = reg.openKey(HKCU, keyPath);
+  lines.push("", `[HKEY_CURRENT_USER\\${keyPath}]`);
+  const values = key.enumValues({ data: true });
+  for (const name of Object.keys(values)) {
+    const value = values[name];
+    const data = typeof value === "number" ? "dword:" + value.toString(16).padStart(8, "0") : quote(value);
+    lines.push((name === "" ? "@" : quote(name)) + "=" + data);
+  }
+  for (const name of key.enumSubKeys()) loopExport(`${keyPath}\\${name}`, lines);
+  key.close();
+  return lines;
+}
+
+const dir = fs.mkdtempSync(path.join(os.tmpdir(), "winreg-bench-"));
+const loopFile = path.join(dir, "loop.reg");
+const nativeFile = path.join(dir, "native.reg");
+
+function loop() {
+  const lines = loopExport(ROOT, ["Windows Registry Editor Version 5.00"]);
+  fs.writeFileSync(loopFile, "\ufeff" + lines.join("\r\n") + "\r\n\r\n", "utf16le");
+}
+const native = () => reg.exportReg(HKCU, ROOT, nativeFile);
+
+loop();
+native();
+if (!fs.readFileSync(loopFile).equals(fs.readFileSync(nativeFile))) {
+  throw new Error("reg.exportReg and the JS export disagree");
+}
+
+report(`export of ${KEYS} keys`, [
+  ["enumSubKeys/enumValues loop", measure(KEYS, loop)],
+  ["reg.exportReg", measure(KEYS, native)],
+]);
+
+fs.rmSync(dir, { recursive: true });
+cleanup();
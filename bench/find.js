@@ -0,0 +1,70 @@
+// reg.find against the equivalent JS loop over enumSubKeys/enumValues, for
+// "every InstallLocation under an Uninstall key, in both WOW64 views" and
+// for a data search across a whole subtree.
+
+const { reg, HKCU, ROOT, setup, cleanup, measure, report } = require("./common");
+
+const ENTRIES = 500;
+const VIEWS = [`${ROOT}\\Microsoft\\Uninstall`, `${ROOT}\\WOW6432Node\\Microsoft\\Uninstall`];
+
+setup();
+for (const view of VIEWS) {
+  for (let i = 0; i < ENTRIES; i++) {
+    const path = `${view}\\{${i}}`;
+    reg.set(HKCU, path, "DisplayName", `Application ${i}`);
+    reg.set(HKCU, path, "Publisher", i % 10 ? "Publisher" : "Contoso");
+    if (i % 3) reg.set(HKCU, path, "InstallLocation", `C:\\Program Files\\Application ${i}`);
+    for (let j = 0; j < 5; j++) reg.set(HKCU, path, `Value${j}`, j);
+  }
+}
+// Keys the search has no reason to visit
+for (let i = 0; i < ENTRIES; i++) reg.set(HKCU, `${ROOT}\\Classes\\Class${i}`, "", `Class ${i}`);
+
+function loopInstallLocations() {
+  const found = [];
+  for (const view of VIEWS) {
+    const uninstall = reg.openKey(HKCU, view);
+    for (const name of uninstall.enumSubKeys()) {
+      const entry = reg.openKey(HKCU, `${view}\\${name}`);
+      const values = entry.enumValues({ data: true });
+      for (const valueName of Object.keys(values)) {
+        if (valueName.toLowerCase() === "installlocation") found.push([`${view}\\${name}`, values[valueName]]);
+      }
+      entry.close();
+    }
+    uninstall.close();
+  }
+  return found;
+}
+
+function loopData(path, regex, found = []) {
+  const key = reg.openKey(HKCU, path);
+  const values = key.enumValues({ data: true });
+  for (const name of Object.keys(values)) {
+    if (typeof values[name] === "string" && regex.test(values[name])) found.push([path, name]);
+  }
+  for (const name of key.enumSubKeys()) loopData(`${path}\\${name}`, regex, found);
+  key.close();
+  return found;
+}
+
+const findInstallLocations = () =>
+  reg.find(HKCU, VIEWS.map((view) => view + "\\*"), { valueName: "InstallLocation" });
+const findData = () => reg.find(HKCU, `${ROOT}\\**`, { dataRegex: /contoso/i });
+
+if (JSON.stringify(loopInstallLocations()) !== JSON.stringify(findInstallLocations().map((m) => [m.path, m.value])) ||
+    loopData(ROOT, /contoso/i).length !== findData().length) {
+  throw new Error("reg.find and the JS loop disagree");
+}
+
+const entries = 2 * ENTRIES;
+report(`InstallLocation of ${entries} uninstall entries`, [
+  ["enumSubKeys/enumValues loop", measure(entries, loopInstallLocations)],
+  ["reg.find", measure(entries, findInstallLocations)],
+]);
+report(`data search over ${entries + ENTRIES} keys`, [
+  ["enumSubKeys/enumValues loop", measure(entries, () => loopData(ROOT, /contoso/i))],
+  ["reg.find", measure(entries, findData)],
+]);
+
+cleanup();
@@ -0,0 +1,117 @@
+// Throughput of ScanHive() on a healthy hive of about 140 MB (2k keys of
+// 1000 short binary values each), by number of threads: the cell walk with
+// carving alone, then with the key tree walk that finds orphaned cells, and
+// the worst case for carving, every cell of the hive freed.
+// The hive is scanned in memory, so the figures are the same on every
+// platform.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -DUNICODE -I. bench/hive-scan.cc -o hive-scan-bench -lpthread && ./hive-scan-bench
+//   cl /O2 /std:c++17 /EHsc /DUNICODE /I. bench\hive-scan.cc advapi32.lib && hive-scan.exe
+
+#include "regfcheck.hpp"
+#include "regfwrite.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+const int kKeys = 2000;
+const int kValuesPerKey = 1000;
+
+template <typename Fn>
+double MsPerRun(Fn &&fn)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t rounds = 0;
+    const auto start = Clock::now();
+    Clock::duration elapsed{};
+    do
+    {
+        fn();
+        ++rounds;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+    return std::chrono::duration<double, std::milli>(elapsed).count() / rounds;
+}
+
+std::vector<BYTE> MakeHive()
+{
+    regf::KeyTree root;
+    root.name = L"ROOT";
+    root.subKeys.resize(kKeys);
+    for (int i = 0; i < kKeys; i++)
+    {
+        root.subKeys[i].name = L"Key" + std::to_wstring(i);
+        root.subKeys[i].values.resize(kValuesPerKey);
+        for (int j = 0; j < kValuesPerKey; j++)
+            root.subKeys[i].values[j] = {L"Value" + std::to_wstring(j), REG_BINARY, std::vector<BYTE>(24, 0xA5)};
+    }
+    return regf::WriteHive(root);
+}
+
+// Mark every cell free, as if the whole tree had been deleted
+std::vector<BYTE> FreeAll(std::vector<BYTE> hive)
+{
+    using regf::details::ReadU32;
+
+    BYTE *bins = hive.data() + regf::details::kBaseBlockSize;
+    const size_t binsSize = hive.size() - regf::details::kBaseBlockSize;
+    for (size_t bin = 0; bin < binsSize; bin += ReadU32(bins + bin + 8))
+    {
+        const size_t end = bin + ReadU32(bins + bin + 8);
+        for (size_t pos = bin + 32; pos < end;)
+        {
+            const auto size = static_cast<LONG>(ReadU32(bins + pos));
+            const DWORD freed = static_cast<DWORD>(size < 0 ? -size : size);
+            for (int i = 0; i < 4; i++)
+                bins[pos + i] = static_cast<BYTE>(freed >> (8 * i));
+            pos += freed;
+        }
+    }
+    return hive;
+}
+
+void Report(const char *title, const std::vector<BYTE> &hive, const bool findOrphans)
+{
+    const double mb = hive.size() / 1e6;
+    std::printf("%s\n", title);
+    // 1, 2, 4... threads, then one per CPU
+    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> counts;
+    for (unsigned threads = 1; threads < cpus; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(cpus);
+
+    double base = 0;
+    for (const unsigned threads : counts)
+    {
+        size_t cells = 0;
+        const double ms = MsPerRun([&] {
+            const auto report = regf::ScanHive(hive.data(), hive.size(), {threads, findOrphans, true});
+            cells = report.allocatedCells + report.carved.size();
+        });
+        if (threads == 1)
+            base = ms;
+        std::printf("  %2u thread(s) %9.1f ms %8.0f MB/s  x%.2f  %zu cells\n", threads, ms, mb / (ms / 1000), base / ms,
+                    cells);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const std::vector<BYTE> hive = MakeHive();
+    std::printf("Hive of %.1f MB\n", hive.size() / 1e6);
+    Report("ScanHive, cells and carving", hive, false);
+    Report("ScanHive, with orphaned cells", hive, true);
+    Report("ScanHive, every cell free (carved)", FreeAll(hive), false);
+    return 0;
+}
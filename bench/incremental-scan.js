@@ -0,0 +1,53 @@
+// Re-reading an Uninstall-like key (2000 entries of 10 values each) on a
+// schedule: a full snapshot every time, and an incremental Scanner, which
+// only reads the entries whose last write time moved since its last scan.
+//
+// On the stand-in registry, every API call can be given an artificial
+// latency (LATENCY_US, default 20us) to model the syscall cost of a real
+// hive.
+
+const { reg, HKCU, ROOT, setup, cleanup } = require("./common");
+
+const ENTRIES = 2000;
+const LATENCY_US = reg.standin ? Number(process.env.LATENCY_US || 20) : 0;
+const UNINSTALL = ROOT + "\\Uninstall";
+
+function time(fn) {
+  const start = process.hrtime.bigint();
+  const result = fn();
+  return [Number(process.hrtime.bigint() - start) / 1e6, result];
+}
+
+function touch(count) {
+  for (let i = 0; i < count; i++) {
+    const id = Math.floor(Math.random() * ENTRIES);
+    reg.set(HKCU, `${UNINSTALL}\\{${id}}`, "Version", Math.floor(Math.random() * 1e6));
+  }
+}
+
+setup();
+for (let i = 0; i < ENTRIES; i++) {
+  const path = `${UNINSTALL}\\{${i}}`;
+  reg.set(HKCU, path, "DisplayName", `Application ${i}`);
+  reg.set(HKCU, path, "Publisher", "Publisher");
+  reg.set(HKCU, path, "InstallLocation", `C:\\Program Files\\Application ${i}`);
+  reg.set(HKCU, path, "UninstallString", `C:\\Program Files\\Application ${i}\\uninstall.exe`);
+  for (let j = 0; j < 6; j++) reg.set(HKCU, path, `Value${j}`, j);
+}
+const scanner = new reg.Scanner(HKCU, UNINSTALL);
+scanner.scan();
+if (reg.standin) reg.standin.setLatency(LATENCY_US / 1000);
+
+console.log(`re-reading ${ENTRIES} uninstall entries` + (reg.standin ? `, ${LATENCY_US}us per call` : ""));
+const [full] = time(() => reg.snapshot(HKCU, UNINSTALL));
+console.log(`  ${"snapshot".padEnd(24)} ${full.toFixed(1).padStart(9)} ms`);
+for (const changes of [0, 20, 200]) {
+  touch(changes);
+  const [ms, delta] = time(() => scanner.scan());
+  console.log(`  ${`scan, ${changes} changed`.padEnd(24)} ${ms.toFixed(1).padStart(9)} ms  x${(full / ms).toFixed(2)}  ` +
+              `${delta.keysRead} keys read`);
+}
+console.log(`  saved state: ${(scanner.save().length / 1e6).toFixed(2)} MB`);
+
+if (reg.standin) reg.standin.setLatency(0);
+cleanup();
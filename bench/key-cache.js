@@ -0,0 +1,46 @@
+// queryValue with and without the key handle cache (reg.cache), polling the
+// same 50 keys over and over.
+
+const { reg, HKCU, ROOT, setup, cleanup, measure, report } = require("./common");
+
+const KEYS = 50;
+
+setup();
+const requests = [];
+for (let k = 0; k < KEYS; k++) {
+  const path = `${ROOT}\\Key${k}`;
+  reg.set(HKCU, path, "Enabled", k % 2);
+  reg.set(HKCU, path, "Name", `key ${k}`);
+  requests.push([path, "Enabled"], [path, "Name"]);
+}
+
+const poll = () => requests.map(([path, name]) => reg.queryValue(HKCU, path, name));
+
+// Registry calls per query, counted by the stand-in
+function callsPerQuery() {
+  if (!reg.standin) return "";
+  poll();
+  reg.standin.resetCallCounts();
+  poll();
+  const calls = Object.values(reg.standin.callCounts()).reduce((a, b) => a + b, 0);
+  return `${(calls / requests.length).toFixed(1)} registry calls per query`;
+}
+
+const uncachedCalls = callsPerQuery();
+const uncached = measure(requests.length, poll);
+
+reg.cache.enable(KEYS);
+const cachedCalls = callsPerQuery();
+const cached = measure(requests.length, poll);
+reg.cache.disable();
+
+report(`queryValue polling ${KEYS} keys`, [
+  ["no cache", uncached],
+  ["reg.cache", cached],
+]);
+if (reg.standin) {
+  console.log(`  no cache:  ${uncachedCalls}`);
+  console.log(`  reg.cache: ${cachedCalls}`);
+}
+
+cleanup();
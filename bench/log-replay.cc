@@ -0,0 +1,179 @@
+// Opening a dirty hive of about 130 MB with a transaction log rewriting 1% of
+// its pages: the page overlay of Hive::Open(path, logs) against the full copy
+// it replaces (read the file, patch the pages, open the copy from memory).
+// Both then read every value of one key. Files go to the temp directory.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -DUNICODE -I. bench/log-replay.cc -o log-replay-bench && ./log-replay-bench
+//   cl /O2 /std:c++17 /EHsc /DUNICODE /I. bench\log-replay.cc advapi32.lib && log-replay.exe
+
+#include "regf.hpp"
+#include "regfwrite.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int kKeys = 2000;
+const int kValuesPerKey = 1000;
+const std::size_t kPageStep = 100;
+
+template <typename Fn>
+double MsPerRun(Fn &&fn)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t rounds = 0;
+    const auto start = Clock::now();
+    Clock::duration elapsed{};
+    do
+    {
+        fn();
+        ++rounds;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+    return std::chrono::duration<double, std::milli>(elapsed).count() / rounds;
+}
+
+void PutU32(std::vector<BYTE> &buf, const std::size_t at, const DWORD value)
+{
+    for (int i = 0; i < 4; i++)
+        buf[at + i] = static_cast<BYTE>(value >> (8 * i));
+}
+
+void PutU64(std::vector<BYTE> &buf, const std::size_t at, const ULONGLONG value)
+{
+    PutU32(buf, at, static_cast<DWORD>(value));
+    PutU32(buf, at + 4, static_cast<DWORD>(value >> 32));
+}
+
+void Save(const std::filesystem::path &path, const std::vector<BYTE> &data)
+{
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+std::vector<BYTE> MakeHive()
+{
+    regf::KeyTree root;
+    root.name = L"ROOT";
+    root.subKeys.resize(kKeys);
+    for (int i = 0; i < kKeys; i++)
+    {
+        root.subKeys[i].name = L"Key" + std::to_wstring(i);
+        root.subKeys[i].values.resize(kValuesPerKey);
+        for (int j = 0; j < kValuesPerKey; j++)
+            root.subKeys[i].values[j] = {L"Value" + std::to_wstring(j), REG_BINARY, std::vector<BYTE>(24, 0xA5)};
+    }
+    return regf::WriteHive(root);
+}
+
+// Mark the hive dirty (as of sequence number 1) and return a log with one
+// entry rewriting every kPageStep-th page
+std::vector<BYTE> MakeLog(std::vector<BYTE> &hive, std::size_t &pages)
+{
+    using namespace regf::details;
+
+    PutU32(hive, 4, 2);
+    PutU32(hive, 8, 1);
+    PutU32(hive, 508, BaseBlockChecksum(hive.data()));
+
+    const std::size_t binsSize = hive.size() - kBaseBlockSize;
+    std::vector<DWORD> offsets;
+    for (std::size_t offset = kPageSize; offset < binsSize; offset += kPageStep * kPageSize)
+        offsets.push_back(static_cast<DWORD>(offset));
+    pages = offsets.size();
+
+    const std::size_t size = (kLogEntryHeaderSize + pages * (8 + kPageSize) + 511) / 512 * 512;
+    std::vector<BYTE> log(kLogBaseBlockSize + size);
+    std::copy(hive.begin(), hive.begin() + kLogBaseBlockSize, log.begin());
+    PutU32(log, 28, kFileTypeLog);
+    PutU32(log, 508, BaseBlockChecksum(log.data()));
+
+    BYTE *entry = &log[kLogBaseBlockSize];
+    std::memcpy(entry, "HvLE", 4);
+    PutU32(log, kLogBaseBlockSize + 4, static_cast<DWORD>(size));
+    PutU32(log, kLogBaseBlockSize + 12, 1);
+    PutU32(log, kLogBaseBlockSize + 16, static_cast<DWORD>(binsSize));
+    PutU32(log, kLogBaseBlockSize + 20, static_cast<DWORD>(pages));
+    std::size_t pos = kLogBaseBlockSize + kLogEntryHeaderSize;
+    for (const DWORD offset : offsets)
+    {
+        PutU32(log, pos, offset);
+        PutU32(log, pos + 4, static_cast<DWORD>(kPageSize));
+        pos += 8;
+    }
+    for (const DWORD offset : offsets)
+    {
+        std::copy_n(hive.begin() + kBaseBlockSize + offset, kPageSize, log.begin() + pos);
+        pos += kPageSize;
+    }
+    PutU64(log, kLogBaseBlockSize + 24, Marvin32(entry + kLogEntryHeaderSize, size - kLogEntryHeaderSize));
+    PutU64(log, kLogBaseBlockSize + 32, Marvin32(entry, 32));
+    return log;
+}
+
+// What replaying costs without an overlay: a private copy of the file
+std::vector<BYTE> CopyAndPatch(const std::filesystem::path &file, const std::vector<BYTE> &log, const std::size_t pages)
+{
+    using namespace regf::details;
+
+    std::ifstream in(file, std::ios::binary);
+    std::vector<BYTE> copy(std::filesystem::file_size(file));
+    in.read(reinterpret_cast<char *>(copy.data()), copy.size());
+    const BYTE *refs = &log[kLogBaseBlockSize + kLogEntryHeaderSize];
+    const BYTE *data = refs + pages * 8;
+    for (std::size_t i = 0; i < pages; i++, data += kPageSize)
+        std::memcpy(&copy[kBaseBlockSize + ReadU32(refs + i * 8)], data, kPageSize);
+    PutU32(copy, 8, 2);
+    return copy;
+}
+
+size_t ReadKey(const regf::Hive &hive)
+{
+    regf::RegKey key;
+    key.Open(hive.Root(), L"Key1234");
+    size_t size = 0;
+    key.ForEachRawValue([&size](const std::wstring &, DWORD, const BYTE *, DWORD dataSize) { size += dataSize; });
+    return size;
+}
+
+} // namespace
+
+int main()
+{
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto file = dir / "winreg-log-replay.hiv";
+    const auto logFile = dir / "winreg-log-replay.hiv.LOG1";
+
+    std::vector<BYTE> hive = MakeHive();
+    std::size_t pages = 0;
+    const std::vector<BYTE> log = MakeLog(hive, pages);
+    Save(file, hive);
+    Save(logFile, log);
+    std::printf("Dirty hive %.1f MB, log rewriting %zu pages (%.1f MB)\n", hive.size() / 1e6, pages, log.size() / 1e6);
+    hive = {};
+
+    size_t read = 0;
+    const double overlay = MsPerRun([&] {
+        const auto replayed = regf::Hive::Open(file, {logFile});
+        read = ReadKey(*replayed);
+    });
+    std::printf("  page overlay  %8.2f ms  (%zu bytes read)\n", overlay, read);
+
+    const double copy = MsPerRun([&] {
+        const std::vector<BYTE> patched = CopyAndPatch(file, log, pages);
+        read = ReadKey(*regf::Hive::FromMemory(patched.data(), patched.size()));
+    });
+    std::printf("  full copy     %8.2f ms  (%zu bytes read)  x%.1f\n", copy, read, copy / overlay);
+
+    std::filesystem::remove(file);
+    std::filesystem::remove(logFile);
+    return 0;
+}
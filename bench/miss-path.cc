@@ -0,0 +1,140 @@
+// Microbenchmark of the miss path: probing for keys and values that mostly
+// don't exist (70% misses), with the throwing RegKey API caught with
+// try/catch as the Node bindings used to, and with the Try* API they use now.
+// On Windows it probes a scratch key under
+// HKEY_CURRENT_USER\Software\winreg-bench; elsewhere the in-memory stand-in.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -DUNICODE -I. bench/miss-path.cc -o miss-bench && ./miss-bench
+//   cl /O2 /std:c++17 /EHsc /DUNICODE /I. bench\miss-path.cc advapi32.lib && miss-path.exe
+
+#include "winreg.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const wchar_t kRoot[] = L"Software\\winreg-bench";
+
+// 100 probes, 70 of them misses
+struct Probes
+{
+    std::vector<std::wstring> keys;
+    std::vector<std::wstring> values;
+};
+
+Probes MakeProbes()
+{
+    Probes probes;
+    for (int i = 0; i < 100; i++)
+    {
+        const bool hit = i % 10 < 3;
+        probes.keys.push_back(std::wstring{kRoot} + (hit ? L"\\Present" : L"\\Missing") + std::to_wstring(i % 3));
+        probes.values.push_back((hit ? L"Name" : L"Missing") + std::to_wstring(i % 3));
+    }
+    return probes;
+}
+
+template <typename Fn>
+double NsPerProbe(size_t probes, Fn &&fn)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t rounds = 0;
+    const auto start = Clock::now();
+    Clock::duration elapsed{};
+    do
+    {
+        fn();
+        ++rounds;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (rounds * probes);
+}
+
+void Report(const char *label, double baseline, double ns)
+{
+    std::printf("  %-28s %9.1f ns/probe  x%.2f\n", label, ns, baseline / ns);
+}
+
+} // namespace
+
+int main()
+{
+    using winreg::RegKey;
+    using winreg::RegException;
+
+    for (int i = 0; i < 3; i++)
+    {
+        RegKey key{HKEY_CURRENT_USER, std::wstring{kRoot} + L"\\Present" + std::to_wstring(i)};
+        key.SetStringValue(L"Name" + std::to_wstring(i), L"value");
+    }
+    RegKey root{HKEY_CURRENT_USER, kRoot};
+    const Probes probes = MakeProbes();
+    const size_t count = probes.keys.size();
+    size_t sink = 0;
+
+    std::printf("opening keys, 70%% missing\n");
+    const double openThrowing = NsPerProbe(count, [&] {
+        for (const auto &path : probes.keys)
+        {
+            RegKey key;
+            try
+            {
+                key.Open(HKEY_CURRENT_USER, path);
+                sink++;
+            }
+            catch (const RegException &e)
+            {
+                sink += e.ErrorCode() == ERROR_FILE_NOT_FOUND;
+            }
+        }
+    });
+    Report("Open + catch", openThrowing, openThrowing);
+    Report("TryOpen", openThrowing, NsPerProbe(count, [&] {
+        for (const auto &path : probes.keys)
+        {
+            RegKey key;
+            sink += key.TryOpen(HKEY_CURRENT_USER, path).Code() == ERROR_FILE_NOT_FOUND;
+        }
+    }));
+
+    RegKey present{HKEY_CURRENT_USER, std::wstring{kRoot} + L"\\Present0"};
+    for (int i = 1; i < 3; i++)
+        present.SetStringValue(L"Name" + std::to_wstring(i), L"value");
+
+    std::printf("reading string values with a default, 70%% missing\n");
+    const double getThrowing = NsPerProbe(count, [&] {
+        for (const auto &name : probes.values)
+        {
+            std::wstring value;
+            try
+            {
+                value = present.GetStringValue(name);
+            }
+            catch (const RegException &e)
+            {
+                if (e.ErrorCode() != ERROR_FILE_NOT_FOUND)
+                    throw;
+                value = L"default";
+            }
+            sink += value.size();
+        }
+    });
+    Report("GetStringValue + catch", getThrowing, getThrowing);
+    Report("TryGetStringValue", getThrowing, NsPerProbe(count, [&] {
+        for (const auto &name : probes.values)
+        {
+            auto value = present.TryGetStringValue(name);
+            sink += value ? value.GetValue().size() : 7;
+        }
+    }));
+
+    present.Close();
+    root.Close();
+    ::RegDeleteTree(HKEY_CURRENT_USER, kRoot);
+    return sink == 0;
+}
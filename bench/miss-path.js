@@ -0,0 +1,35 @@
+// Probing for keys and values that mostly don't exist (70% misses) through
+// the bindings: getString(name, default), queryValue returning null and
+// RegKey.open returning false. Misses are now returned by the Try* API of
+// winreg.hpp instead of thrown and caught; for the time saved, run this
+// benchmark on a build of the previous commit (bench/miss-path.cc compares
+// both in C++).
+
+const { reg, HKCU, ROOT, setup, cleanup, measure, report } = require("./common");
+
+const PROBES = 100;
+
+setup();
+const key = new reg.RegKey(HKCU, ROOT + "\\Present0");
+for (let i = 1; i < 3; i++) new reg.RegKey(HKCU, ROOT + "\\Present" + i).close();
+const names = [];
+const paths = [];
+for (let i = 0; i < PROBES; i++) {
+  const hit = i % 10 < 3;
+  names.push((hit ? "Name" : "Missing") + (i % 3));
+  paths.push(ROOT + (hit ? "\\Present" : "\\Missing") + (i % 3));
+  if (hit) key.setString(names[i], "value");
+}
+
+report(`${PROBES} probes, 70% misses`, [
+  ["getString(name, default)", measure(PROBES, () => names.forEach((name) => key.getString(name, "")))],
+  ["queryValue", measure(PROBES, () => names.forEach((name) => reg.queryValue(HKCU, ROOT + "\\Present0", name)))],
+  ["RegKey.open", measure(PROBES, () => paths.forEach((path) => {
+    const probe = new reg.RegKey();
+    probe.open(HKCU, path);
+    probe.close();
+  }))],
+]);
+
+key.close();
+cleanup();
@@ -0,0 +1,49 @@
+// Walking a key with a million subkeys (KEYS to change it): enumSubKeys()
+// returns all the names at once, key.subKeys() iterates them a page at a
+// time. Reports the time per name and the peak JS heap growth while the
+// names are walked; run with node --expose-gc for steadier heap figures.
+
+const { reg, HKCU, ROOT, setup, cleanup } = require("./common");
+
+const KEYS = Number(process.env.KEYS || 1000000);
+const PAGE_SIZES = [100, 1000, 10000];
+
+function heapUsed() {
+  if (global.gc) global.gc();
+  return process.memoryUsage().heapUsed;
+}
+
+async function walk(label, iterate) {
+  const base = heapUsed();
+  let peak = 0;
+  let count = 0;
+  const start = process.hrtime.bigint();
+  await iterate((name) => {
+    if (++count % 1000 === 0) peak = Math.max(peak, process.memoryUsage().heapUsed - base);
+  });
+  const ns = Number(process.hrtime.bigint() - start) / count;
+  peak = Math.max(peak, process.memoryUsage().heapUsed - base);
+  console.log(`  ${label.padEnd(28)} ${(ns / 1000).toFixed(2).padStart(9)} us/name  ` +
+              `peak heap +${(peak / 1e6).toFixed(1)} MB`);
+}
+
+(async () => {
+  setup();
+  const key = new reg.RegKey(HKCU, ROOT + "\\Wide");
+  for (let i = 0; i < KEYS; i++) {
+    new reg.RegKey(key.handle(), `{5F8C2A10-${1000000 + i}-Component}`).close();
+  }
+
+  console.log(`walking ${KEYS} subkeys`);
+  await walk("enumSubKeys()", async (visit) => {
+    for (const name of key.enumSubKeys()) visit(name);
+  });
+  for (const pageSize of PAGE_SIZES) {
+    await walk(`subKeys({pageSize: ${pageSize}})`, async (visit) => {
+      for await (const name of key.subKeys({ pageSize })) visit(name);
+    });
+  }
+
+  key.close();
+  cleanup();
+})();
@@ -0,0 +1,52 @@
+// Scaling of the parallel subtree walker (snapshot with {threads}) from 1 to
+// N threads on a synthetic tree.
+//
+// On the stand-in registry, every API call can be given an artificial
+// latency (LATENCY_US, default 20us) to model the syscall cost of a real
+// hive; the curve with latency 0 shows the CPU-bound scaling.
+
+const os = require("os");
+const { reg, HKCU, ROOT, setup, cleanup } = require("./common");
+
+const FANOUT = 8;
+const DEPTH = 4; // 4681 keys
+const LATENCIES = reg.standin ? [Number(process.env.LATENCY_US || 20), 0] : [0];
+
+function build(path, depth) {
+  reg.set(HKCU, path, "DisplayName", path);
+  reg.set(HKCU, path, "Version", depth);
+  if (depth === 0) return 1;
+  let keys = 1;
+  for (let i = 0; i < FANOUT; i++) {
+    keys += build(`${path}\\Key${i}`, depth - 1);
+  }
+  return keys;
+}
+
+function time(fn) {
+  const start = process.hrtime.bigint();
+  fn();
+  return Number(process.hrtime.bigint() - start) / 1e6;
+}
+
+setup();
+const keys = build(ROOT, DEPTH);
+const maxThreads = Math.max(8, os.cpus().length);
+const threadCounts = [1, 2, 4, 8, 16].filter((t) => t <= maxThreads);
+
+for (const latency of LATENCIES) {
+  if (reg.standin) reg.standin.setLatency(latency / 1000);
+  const label = reg.standin ? `, ${latency}us per call` : "";
+  console.log(`snapshot of ${keys} keys${label}`);
+
+  const serial = time(() => reg.snapshot(HKCU, ROOT));
+  console.log(`  ${"serial".padEnd(12)} ${serial.toFixed(1).padStart(9)} ms`);
+  for (const threads of threadCounts) {
+    const ms = time(() => reg.snapshot(HKCU, ROOT, { threads }));
+    const speedup = (serial / ms).toFixed(2);
+    console.log(`  ${(threads + " threads").padEnd(12)} ${ms.toFixed(1).padStart(9)} ms  x${speedup}  ${Math.round(keys / ms * 1000)} keys/s`);
+  }
+}
+
+if (reg.standin) reg.standin.setLatency(0);
+cleanup();
@@ -0,0 +1,138 @@
+// Opening keys of an offline hive by full path, 8 levels deep in a hive of
+// about 200k keys: RegKey::Open, a subkey list search per component, against
+// a lookup in a PathIndex built beforehand, for existing keys and for paths
+// whose last component is missing. Also reports the time to build the index,
+// and to load the saved one back. Files go to the temp directory.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -DUNICODE -I. bench/path-index.cc -o path-index-bench && ./path-index-bench
+//   cl /O2 /std:c++17 /EHsc /DUNICODE /I. bench\path-index.cc advapi32.lib && path-index.exe
+
+#include "regf.hpp"
+#include "regfindex.hpp"
+#include "regfwrite.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int kDepth = 8;
+const int kFanout = 4;
+const int kLeafKeys = 12; // Subkeys of each key of the last level
+const std::size_t kLookups = 10000;
+
+template <typename Fn>
+double MsPerRun(Fn &&fn)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t rounds = 0;
+    const auto start = Clock::now();
+    Clock::duration elapsed{};
+    do
+    {
+        fn();
+        ++rounds;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+    return std::chrono::duration<double, std::milli>(elapsed).count() / rounds;
+}
+
+void Save(const std::filesystem::path &path, const std::vector<BYTE> &data)
+{
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+// A tree kDepth levels deep, the paths of its deepest keys in 'leaves'
+void MakeTree(regf::KeyTree &key, const std::wstring &path, const int level, std::vector<std::wstring> &leaves)
+{
+    const int count = level + 1 == kDepth ? kLeafKeys : kFanout;
+    key.subKeys.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        regf::KeyTree &sub = key.subKeys[i];
+        sub.name = L"Level" + std::to_wstring(level) + L"Key" + std::to_wstring(i);
+        const std::wstring subPath = path.empty() ? sub.name : path + L'\\' + sub.name;
+        if (level + 1 == kDepth)
+            leaves.push_back(subPath);
+        else
+            MakeTree(sub, subPath, level + 1, leaves);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto file = dir / "winreg-path-index.hiv";
+    const auto indexFile = dir / "winreg-path-index.hiv.idx";
+
+    regf::KeyTree root;
+    root.name = L"ROOT";
+    std::vector<std::wstring> leaves;
+    MakeTree(root, L"", 0, leaves);
+    Save(file, regf::WriteHive(root));
+    root = {};
+
+    const auto hive = regf::Hive::Open(file);
+    const regf::RegKey rootKey = hive->Root();
+
+    // Random leaves, and the same paths with a missing last component
+    std::mt19937 random{42};
+    std::vector<std::wstring> hits(kLookups), misses(kLookups);
+    for (std::size_t i = 0; i < kLookups; i++)
+    {
+        hits[i] = leaves[random() % leaves.size()];
+        misses[i] = hits[i] + L"x";
+    }
+
+    std::size_t keys = 0;
+    const double build = MsPerRun([&] { keys = regf::PathIndex::Build(rootKey).KeyCount(); });
+    Save(indexFile, regf::PathIndex::Build(rootKey).Save());
+    std::printf("Hive %.1f MB, %zu keys, paths %d levels deep\n", std::filesystem::file_size(file) / 1e6, keys, kDepth);
+    std::printf("  build index   %8.2f ms  (%.1f MB saved)\n", build, std::filesystem::file_size(indexFile) / 1e6);
+    std::printf("  load index    %8.4f ms\n", MsPerRun([&] { keys = regf::PathIndex::Load(indexFile).KeyCount(); }));
+
+    const regf::PathIndex index = regf::PathIndex::Load(indexFile);
+    for (const auto *paths : {&hits, &misses})
+    {
+        std::size_t found = 0;
+        const double walk = MsPerRun([&] {
+            found = 0;
+            for (const std::wstring &path : *paths)
+            {
+                try
+                {
+                    regf::RegKey key;
+                    key.Open(rootKey, path);
+                    found++;
+                }
+                catch (const winreg::RegException &)
+                {
+                }
+            }
+        });
+        const double indexed = MsPerRun([&] {
+            found = 0;
+            regf::RegKey key;
+            for (const std::wstring &path : *paths)
+                found += index.TryOpen(rootKey, path, key);
+        });
+
+        std::printf("%s (%zu found of %zu)\n", paths == &hits ? "Existing keys" : "Missing keys", found, kLookups);
+        std::printf("  RegKey::Open  %8.1f ns/lookup\n", walk * 1e6 / kLookups);
+        std::printf("  PathIndex     %8.1f ns/lookup  x%.1f\n", indexed * 1e6 / kLookups, walk / indexed);
+    }
+
+    std::filesystem::remove(file);
+    std::filesystem::remove(indexFile);
+    return 0;
+}
@@ -0,0 +1,38 @@
+// queryValues (one native call, each key opened once) against a loop of
+// queryValue calls, for scans reading several values from each of many keys.
+
+const { reg, HKCU, ROOT, setup, cleanup, measure, report } = require("./common");
+
+const KEYS = 200;
+const VALUES_PER_KEY = 5;
+
+setup();
+const requests = [];
+for (let k = 0; k < KEYS; k++) {
+  const path = `${ROOT}\\Key${k}`;
+  for (let v = 0; v < VALUES_PER_KEY; v++) {
+    const name = `Value${v}`;
+    reg.set(HKCU, path, name, v % 2 ? v : `string value ${k}.${v}`);
+    requests.push([path, name]);
+  }
+}
+// A few misses, as in real scans
+for (let k = 0; k < KEYS; k += 10) {
+  requests.push([`${ROOT}\\Key${k}`, "Missing"]);
+  requests.push([`${ROOT}\\Missing${k}`, "Value0"]);
+}
+
+const loop = () => requests.map(([path, name]) => reg.queryValue(HKCU, path, name));
+const batch = () => reg.queryValues(HKCU, requests);
+
+const expected = JSON.stringify(loop());
+if (JSON.stringify(batch()) !== expected) {
+  throw new Error("queryValues and queryValue disagree");
+}
+
+report(`queryValue vs queryValues (${requests.length} values in ${KEYS} keys)`, [
+  ["queryValue loop", measure(requests.length, loop)],
+  ["queryValues", measure(requests.length, batch)],
+]);
+
+cleanup();
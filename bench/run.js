@@ -0,0 +1,14 @@
+// Run every benchmark in this directory: node bench/run.js [name...]
+
+const fs = require("fs");
+const path = require("path");
+const { execFileSync } = require("child_process");
+
+const only = process.argv.slice(2);
+const files = fs.readdirSync(__dirname)
+  .filter((f) => f.endsWith(".js") && f !== "run.js" && f !== "common.js")
+  .filter((f) => only.length === 0 || only.includes(path.basename(f, ".js")));
+
+for (const f of files) {
+  execFileSync(process.execPath, [path.join(__dirname, f)], { stdio: "inherit" });
+}
@@ -0,0 +1,50 @@
+// Reading short string values with RegKey.getString/getExpandString.
+//
+// Values up to 512 bytes are read with a single RegGetValue call into a
+// scratch buffer on the stack; longer ones take a second call once
+// RegGetValue has reported ERROR_MORE_DATA. Before, every read was a size
+// query plus a read. On the stand-in registry the calls are counted, and
+// its latency setting makes each one cost like a real registry call.
+
+const { reg, HKCU, ROOT, setup, cleanup, measure, report } = require("./common");
+
+const VALUES = 200;
+
+setup();
+const key = new reg.RegKey(HKCU, ROOT + "\\Short");
+const names = [];
+for (let i = 0; i < VALUES; i++) {
+  names.push(`Value${i}`);
+  key.setString(`Value${i}`, `C:\\Program Files\\Product ${i}\\bin`);
+  key.setExpandString(`Expand${i}`, `%ProgramFiles%\\Product ${i}`);
+  key.setString(`Long${i}`, "x".repeat(1000 + i));
+}
+
+if (reg.standin) {
+  const count = (fn) => {
+    reg.standin.resetCallCounts();
+    fn();
+    return reg.standin.callCounts().RegGetValue / VALUES;
+  };
+  console.log("RegGetValue calls per read:");
+  console.log(`  short getString        ${count(() => names.forEach((_, i) => key.getString(`Value${i}`)))}`);
+  console.log(`  short getExpandString  ${count(() => names.forEach((_, i) => key.getExpandString(`Expand${i}`)))}`);
+  console.log(`  long getString         ${count(() => names.forEach((_, i) => key.getString(`Long${i}`)))}`);
+}
+
+const run = (latencyUs) => {
+  if (reg.standin) reg.standin.setLatency(latencyUs / 1000);
+  report(`reading ${VALUES} values` + (reg.standin ? `, ${latencyUs}us per call` : ""), [
+    ["short getString", measure(VALUES, () => names.forEach((_, i) => key.getString(`Value${i}`)))],
+    ["short getExpandString", measure(VALUES, () => names.forEach((_, i) => key.getExpandString(`Expand${i}`)))],
+    ["long getString", measure(VALUES, () => names.forEach((_, i) => key.getString(`Long${i}`)))],
+  ]);
+};
+run(0);
+if (reg.standin) {
+  run(5);
+  reg.standin.setLatency(0);
+}
+
+key.close();
+cleanup();
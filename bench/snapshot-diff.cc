@@ -0,0 +1,125 @@
+// Diffing two snapshots of a tree of 100k keys (1000 entries of 100 subkeys,
+// two values each) where 10 keys changed: comparing the two trees key by key,
+// even already in memory, and DiffSnapshots() on the snapshot files, which
+// skips the subtrees whose Merkle hashes match.
+// On Windows it fills a scratch key under
+// HKEY_CURRENT_USER\Software\winreg-bench; elsewhere the in-memory stand-in.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -DUNICODE -I. bench/snapshot-diff.cc -o snapshot-bench && ./snapshot-bench
+//   cl /O2 /std:c++17 /EHsc /DUNICODE /I. bench\snapshot-diff.cc advapi32.lib && snapshot-diff.exe
+
+#include "regsnap.hpp"
+#include "regwalk.hpp"
+#include "winreg.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+const wchar_t kRoot[] = L"Software\\winreg-bench";
+const int kEntries = 1000;
+const int kSubKeys = 100;
+const int kChanged = 10;
+
+template <typename Fn>
+double MsPerRun(Fn &&fn)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t rounds = 0;
+    const auto start = Clock::now();
+    Clock::duration elapsed{};
+    do
+    {
+        fn();
+        ++rounds;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+    return std::chrono::duration<double, std::milli>(elapsed).count() / rounds;
+}
+
+// Keys whose values differ, comparing every key of the two trees
+size_t CompareAll(const winreg::KeySnapshot &a, const winreg::KeySnapshot &b)
+{
+    size_t changed = 0;
+    if (a.values.size() != b.values.size())
+        changed++;
+    else
+    {
+        for (size_t i = 0; i < a.values.size(); i++)
+        {
+            if (a.values[i].name != b.values[i].name || a.values[i].data != b.values[i].data)
+            {
+                changed++;
+                break;
+            }
+        }
+    }
+    std::unordered_map<std::wstring, const winreg::KeySnapshot *> others;
+    for (const auto &other : b.subKeys)
+        others.emplace(winreg::details::UpperCase(other.name), &other);
+    for (const auto &subKey : a.subKeys)
+    {
+        const auto found = others.find(winreg::details::UpperCase(subKey.name));
+        if (found != others.end())
+            changed += CompareAll(subKey, *found->second);
+    }
+    return changed;
+}
+
+} // namespace
+
+int main()
+{
+    using winreg::RegKey;
+
+    const std::wstring tree = std::wstring{kRoot} + L"\\Tree";
+    for (int i = 0; i < kEntries; i++)
+    {
+        RegKey entry{HKEY_CURRENT_USER, tree + L"\\Entry" + std::to_wstring(i)};
+        for (int j = 0; j < kSubKeys; j++)
+        {
+            RegKey subKey{entry.Get(), L"Key" + std::to_wstring(j)};
+            subKey.SetStringValue(L"Name", L"Entry " + std::to_wstring(i) + L" key " + std::to_wstring(j));
+            subKey.SetDwordValue(L"Version", j);
+        }
+    }
+
+    const winreg::WalkOptions options;
+    const winreg::KeySnapshot before = winreg::Snapshot(HKEY_CURRENT_USER, tree, options);
+    for (int i = 0; i < kChanged; i++)
+    {
+        RegKey subKey{HKEY_CURRENT_USER, tree + L"\\Entry" + std::to_wstring(i * 97) + L"\\Key7"};
+        subKey.SetDwordValue(L"Version", 1000 + i);
+    }
+    const winreg::KeySnapshot after = winreg::Snapshot(HKEY_CURRENT_USER, tree, options);
+
+    std::vector<BYTE> beforeFile;
+    std::vector<BYTE> afterFile;
+    const double save = MsPerRun([&] { beforeFile = winreg::SaveSnapshot(before); });
+    afterFile = winreg::SaveSnapshot(after);
+
+    size_t sink = 0;
+    std::printf("diff of %d keys, %d changed (snapshot file %.1f MB, saved in %.1f ms)\n",
+                kEntries * (kSubKeys + 1) + 1, kChanged, beforeFile.size() / 1e6, save);
+    const double all = MsPerRun([&] { sink += CompareAll(before, after); });
+    std::printf("  %-28s %9.3f ms\n", "compare every key", all);
+
+    winreg::SnapshotDiff diff;
+    const double merkle = MsPerRun([&] {
+        const auto a = winreg::SnapshotFile::FromMemory(beforeFile.data(), beforeFile.size());
+        const auto b = winreg::SnapshotFile::FromMemory(afterFile.data(), afterFile.size());
+        diff = winreg::DiffSnapshots(a, b);
+        sink += diff.changed.size();
+    });
+    std::printf("  %-28s %9.3f ms  x%.0f  %llu keys compared, %zu changed\n", "DiffSnapshots", merkle, all / merkle,
+                diff.keysCompared, diff.changed.size());
+
+    ::RegDeleteTree(HKEY_CURRENT_USER, kRoot);
+    return sink == 0;
+}
@@ -0,0 +1,52 @@
+// Reading a value-heavy key: the cost per string value of marshalling
+// registry strings to JS, now that strings travel as UTF-16 end to end.
+//
+// The bytes copied per value are counted for both ways of marshalling a
+// string of n UTF-16 code units encoded as u UTF-8 bytes:
+//   through UTF-8 (before): size probe (2n read), conversion (2n read,
+//     u written), then V8 decodes the UTF-8 (u read)
+//   as UTF-16 (now): V8 copies the code units (2n read)
+// For the time saved, run this benchmark on a build of the previous commit.
+
+const path = require("path");
+const { reg, HKCU, ROOT, setup, cleanup, measure, report } = require("./common");
+
+const products = require(path.join(__dirname, "..", "tests", "products.json"));
+
+setup();
+const strings = [];
+for (const product of products) {
+  for (const value of Object.values(product)) {
+    if (typeof value === "string" && value.length > 0) strings.push(value);
+  }
+}
+const VALUES = Math.min(strings.length, 2000);
+const key = new reg.RegKey(HKCU, ROOT + "\\Values");
+const names = [];
+for (let i = 0; i < VALUES; i++) {
+  names.push(`Value${i}`);
+  key.setString(names[i], strings[i]);
+}
+const requests = names.map((name) => [ROOT + "\\Values", name]);
+
+let units = 0;
+let utf8Bytes = 0;
+for (let i = 0; i < VALUES; i++) {
+  units += strings[i].length + names[i].length;
+  utf8Bytes += Buffer.byteLength(strings[i]) + Buffer.byteLength(names[i]);
+}
+const n = units / VALUES;
+const u = utf8Bytes / VALUES;
+console.log(`${VALUES} REG_SZ values, ${n.toFixed(1)} UTF-16 code units and ` +
+            `${u.toFixed(1)} UTF-8 bytes per value (name + data)`);
+console.log(`  bytes copied per value: ${(4 * n + 2 * u).toFixed(0)} through UTF-8, ` +
+            `${(2 * n).toFixed(0)} as UTF-16`);
+
+report(`reading ${VALUES} string values`, [
+  ["enumValues({data: true})", measure(VALUES, () => key.enumValues({ data: true }))],
+  ["getString", measure(VALUES, () => names.forEach((name) => key.getString(name)))],
+  ["queryValues", measure(VALUES, () => reg.queryValues(HKCU, requests))],
+]);
+
+key.close();
+cleanup();
@@ -0,0 +1,106 @@
+// Reading the last write time of every subkey of a key (2000 subkeys): with
+// EnumSubKeys, then opening each subkey for QueryInfoKey, and with a single
+// EnumSubKeysDetailed pass, which gets the times from RegEnumKeyEx; the
+// subkey and value counts still take an open per subkey.
+// On Windows it fills a scratch key under
+// HKEY_CURRENT_USER\Software\winreg-bench; elsewhere the in-memory stand-in,
+// which also reports the registry calls made per subkey.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -DUNICODE -I. bench/subkey-times.cc -o subkey-bench && ./subkey-bench
+//   cl /O2 /std:c++17 /EHsc /DUNICODE /I. bench\subkey-times.cc advapi32.lib && subkey-times.exe
+
+#include "winreg.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const wchar_t kRoot[] = L"Software\\winreg-bench";
+const int kSubKeys = 2000;
+
+template <typename Fn>
+double NsPerSubKey(Fn &&fn)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t rounds = 0;
+    const auto start = Clock::now();
+    Clock::duration elapsed{};
+    do
+    {
+        fn();
+        ++rounds;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (rounds * kSubKeys);
+}
+
+// Registry calls per subkey of one run of fn (stand-in only)
+template <typename Fn>
+double CallsPerSubKey(Fn &&fn)
+{
+#ifdef _WIN32
+    (void)fn;
+    return 0;
+#else
+    auto &registry = memreg::Registry::Instance();
+    registry.ResetCallCounts();
+    fn();
+    unsigned long long calls = 0;
+    for (auto api : {memreg::Api::RegOpenKeyEx, memreg::Api::RegCloseKey, memreg::Api::RegQueryInfoKey,
+                     memreg::Api::RegEnumKeyEx})
+        calls += registry.CallCount(api);
+    return static_cast<double>(calls) / kSubKeys;
+#endif
+}
+
+void Report(const char *label, double baseline, double ns, double calls)
+{
+    std::printf("  %-34s %9.1f ns/subkey  x%.2f  %.2f calls/subkey\n", label, ns, baseline / ns, calls);
+}
+
+} // namespace
+
+int main()
+{
+    using winreg::RegKey;
+
+    RegKey root{HKEY_CURRENT_USER, std::wstring{kRoot} + L"\\Wide"};
+    for (int i = 0; i < kSubKeys; i++)
+    {
+        RegKey subKey{root.Get(), L"Key" + std::to_wstring(i)};
+        subKey.SetDwordValue(L"Version", i);
+    }
+    size_t sink = 0;
+
+    const auto openEach = [&] {
+        for (const auto &name : root.EnumSubKeys())
+        {
+            RegKey subKey;
+            subKey.Open(root.Get(), name, KEY_QUERY_VALUE);
+            DWORD subKeys = 0;
+            DWORD values = 0;
+            FILETIME lastWriteTime{};
+            subKey.QueryInfoKey(subKeys, values, lastWriteTime);
+            sink += lastWriteTime.dwLowDateTime & 1;
+        }
+    };
+    const auto detailed = [&] { sink += root.EnumSubKeysDetailed().lastWriteTimes.size(); };
+    const auto detailedCounts = [&] {
+        sink += root.EnumSubKeysDetailed(RegKey::SubKeyCountsOption::Query).valueCounts.size();
+    };
+
+    std::printf("last write times of %d subkeys\n", kSubKeys);
+    const double baseline = NsPerSubKey(openEach);
+    Report("EnumSubKeys + open + QueryInfoKey", baseline, baseline, CallsPerSubKey(openEach));
+    Report("EnumSubKeysDetailed", baseline, NsPerSubKey(detailed), CallsPerSubKey(detailed));
+    Report("EnumSubKeysDetailed with counts", baseline, NsPerSubKey(detailedCounts), CallsPerSubKey(detailedCounts));
+
+    root.Close();
+    ::RegDeleteTree(HKEY_CURRENT_USER, kRoot);
+    return sink == 0;
+}
@@ -0,0 +1,201 @@
+// Microbenchmark of the UTF-8 transcoder (utf.hpp) against the conversions it
+// replaced in winreg.cc: MultiByteToWideChar/WideCharToMultiByte run twice
+// (size probe, then convert) on Windows, std::wstring_convert elsewhere.
+// The inputs are the strings of tests/products.json (installed programs).
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I. bench/utf.cc -o utf-bench && ./utf-bench
+//   cl /O2 /std:c++17 /EHsc /I. bench\utf.cc && utf.exe
+
+#include "utf.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <codecvt>
+#include <locale>
+#endif
+
+namespace
+{
+
+#ifdef _WIN32
+
+std::wstring BaselineToWide(const std::string &str)
+{
+    if (str.empty())
+        return std::wstring();
+    int size = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
+    std::wstring out(size, 0);
+    MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &out[0], size);
+    return out;
+}
+
+std::string BaselineToUtf8(const std::wstring &wstr)
+{
+    if (wstr.empty())
+        return std::string();
+    int size = WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), NULL, 0, NULL, NULL);
+    std::string out(size, 0);
+    WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &out[0], size, NULL, NULL);
+    return out;
+}
+
+#else
+
+std::wstring BaselineToWide(const std::string &str)
+{
+    std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
+    return conv.from_bytes(str);
+}
+
+std::string BaselineToUtf8(const std::wstring &wstr)
+{
+    std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
+    return conv.to_bytes(wstr);
+}
+
+#endif
+
+// The string values of a JSON file, decoded to UTF-8
+std::vector<std::string> ReadJsonStrings(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    const std::string json{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < json.size(); ++i)
+    {
+        if (json[i] != '"')
+            continue;
+
+        std::string utf8;
+        for (++i; i < json.size() && json[i] != '"'; ++i)
+        {
+            if (json[i] != '\\')
+            {
+                utf8.push_back(json[i]);
+                continue;
+            }
+            const char ch = json[++i];
+            if (ch != 'u')
+            {
+                utf8.push_back(ch == 'n' ? '\n' : ch == 't' ? '\t' : ch == 'r' ? '\r' : ch);
+                continue;
+            }
+
+            // \uXXXX, or a \uXXXX\uXXXX surrogate pair
+            std::u16string units(1, static_cast<char16_t>(std::stoul(json.substr(i + 1, 4), nullptr, 16)));
+            i += 4;
+            if (units[0] >= 0xD800 && units[0] <= 0xDBFF && json.compare(i + 1, 2, "\\u") == 0)
+            {
+                units.push_back(static_cast<char16_t>(std::stoul(json.substr(i + 3, 4), nullptr, 16)));
+                i += 6;
+            }
+            std::string encoded;
+            winreg::utf::WideToUtf8(units.data(), units.size(), encoded);
+            utf8 += encoded;
+        }
+        strings.push_back(std::move(utf8));
+    }
+    return strings;
+}
+
+template <typename Fn>
+double NsPerString(const std::vector<std::string> &strings, Fn &&fn)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t rounds = 0;
+    const auto start = Clock::now();
+    Clock::duration elapsed{};
+    do
+    {
+        fn();
+        ++rounds;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (rounds * strings.size());
+}
+
+void Report(const char *label, double baseline, double ns)
+{
+    std::printf("  %-36s %9.1f ns/string  x%.2f\n", label, ns, baseline / ns);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "tests/products.json";
+    const auto strings = ReadJsonStrings(path);
+    if (strings.empty())
+    {
+        std::fprintf(stderr, "no strings in %s\n", path);
+        return 1;
+    }
+
+    std::vector<std::wstring> wide;
+    size_t bytes = 0;
+    for (const auto &str : strings)
+    {
+        wide.push_back(BaselineToWide(str));
+        bytes += str.size();
+    }
+    std::printf("%zu strings, %zu bytes of UTF-8\n", strings.size(), bytes);
+
+    size_t sink = 0;
+    std::printf("UTF-8 to wide\n");
+    const double toWideBaseline = NsPerString(strings, [&] {
+        for (const auto &str : strings)
+            sink += BaselineToWide(str).size();
+    });
+    Report("previous (new string each call)", toWideBaseline, toWideBaseline);
+    Report("utf.hpp (new string each call)", toWideBaseline, NsPerString(strings, [&] {
+        for (const auto &str : strings)
+        {
+            std::wstring out;
+            winreg::utf::Utf8ToWide(str.data(), str.size(), out);
+            sink += out.size();
+        }
+    }));
+    std::wstring wideBuffer;
+    Report("utf.hpp (reused buffer)", toWideBaseline, NsPerString(strings, [&] {
+        for (const auto &str : strings)
+        {
+            winreg::utf::Utf8ToWide(str.data(), str.size(), wideBuffer);
+            sink += wideBuffer.size();
+        }
+    }));
+
+    std::printf("wide to UTF-8\n");
+    const double toUtf8Baseline = NsPerString(strings, [&] {
+        for (const auto &str : wide)
+            sink += BaselineToUtf8(str).size();
+    });
+    Report("previous (new string each call)", toUtf8Baseline, toUtf8Baseline);
+    Report("utf.hpp (new string each call)", toUtf8Baseline, NsPerString(strings, [&] {
+        for (const auto &str : wide)
+        {
+            std::string out;
+            winreg::utf::WideToUtf8(str.data(), str.size(), out);
+            sink += out.size();
+        }
+    }));
+    std::string utf8Buffer;
+    Report("utf.hpp (reused buffer)", toUtf8Baseline, NsPerString(strings, [&] {
+        for (const auto &str : wide)
+        {
+            winreg::utf::WideToUtf8(str.data(), str.size(), utf8Buffer);
+            sink += utf8Buffer.size();
+        }
+    }));
+
+    return sink == 0;
+}
@@ -7,7 +7,7 @@
     "msvs_settings": {
       "VCCLCompilerTool": { "ExceptionHandling": 1 },
     },
-    "sources": ["winreg.cc"],
+    "sources": ["winreg.cc", "walk.cc", "hive.cc", "regfile.cc", "standin.cc"],
     "defines": ["UNICODE", "_UNICODE"],
     'include_dirs': ['<!@(node -p "require(\'node-addon-api\').include")'],
     'dependencies': ['<!(node -p "require(\'node-addon-api\').gyp")'],
@@ -0,0 +1,661 @@
+#include <napi.h>
+
+#include "addon.hpp"
+#include "regf.hpp"
+#include "regfcheck.hpp"
+#include "regfindex.hpp"
+#include "regfwrite.hpp"
+
+#include <memory>
+
+// JavaScript wrapper of regf::RegKey: a key inside an offline hive file.
+class HiveKey : public Napi::ObjectWrap<HiveKey> {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  static Napi::Object NewInstance(Napi::Env env, const regf::RegKey& key);
+
+  static Napi::Value OpenHive(const Napi::CallbackInfo& info);
+
+  HiveKey(const Napi::CallbackInfo& info);
+
+  Napi::Value Open(const Napi::CallbackInfo& info);
+  Napi::Value Close(const Napi::CallbackInfo& info);
+  Napi::Value GetName(const Napi::CallbackInfo& info);
+  Napi::Value GetValueType(const Napi::CallbackInfo& info);
+  Napi::Value GetString(const Napi::CallbackInfo& info);
+  Napi::Value GetMultiString(const Napi::CallbackInfo& info);
+  Napi::Value GetDword(const Napi::CallbackInfo& info);
+  Napi::Value EnumSubKeys(const Napi::CallbackInfo& info);
+  Napi::Value EnumValues(const Napi::CallbackInfo& info);
+  Napi::Value QueryInfoKey(const Napi::CallbackInfo& info);
+  Napi::Value IsValid(const Napi::CallbackInfo& info);
+
+  const regf::RegKey& Key() const { return _key; }
+
+ private:
+  regf::RegKey _key;
+};
+
+Napi::Object HiveKey::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func =
+      DefineClass(env, "HiveKey",
+                  {InstanceMethod("open", &HiveKey::Open),
+                   InstanceMethod("close", &HiveKey::Close),
+                   InstanceMethod("getValueType", &HiveKey::GetValueType),
+                   InstanceMethod("getString", &HiveKey::GetString),
+                   InstanceMethod("getExpandString", &HiveKey::GetString),
+                   InstanceMethod("getMultiString", &HiveKey::GetMultiString),
+                   InstanceMethod("getDword", &HiveKey::GetDword),
+                   InstanceMethod("enumSubKeys", &HiveKey::EnumSubKeys),
+                   InstanceMethod("enumValues", &HiveKey::EnumValues),
+                   InstanceMethod("queryInfoKey", &HiveKey::QueryInfoKey),
+                   InstanceAccessor("name", &HiveKey::GetName, nullptr),
+                   InstanceAccessor("isValid", &HiveKey::IsValid, nullptr)});
+
+  GetAddonData(env)->hiveKey = Napi::Persistent(func);
+
+  exports.Set("HiveKey", func);
+  exports.Set("openHive", Napi::Function::New(env, HiveKey::OpenHive));
+  return exports;
+}
+
+Napi::Object HiveKey::NewInstance(Napi::Env env, const regf::RegKey& key) {
+  Napi::Object obj = GetAddonData(env)->hiveKey.New({});
+  Unwrap(obj)->_key = key;
+  return obj;
+}
+
+const regf::RegKey* UnwrapHiveKey(Napi::Value value) {
+  auto env = value.Env();
+  if (!value.IsObject() ||
+      !value.As<Napi::Object>().InstanceOf(GetAddonData(env)->hiveKey.Value())) {
+    return nullptr;
+  }
+  return &HiveKey::Unwrap(value.As<Napi::Object>())->Key();
+}
+
+HiveKey::HiveKey(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<HiveKey>(info) {
+}
+
+// file, options ({logs})?
+// logs: transaction log files to replay over a dirty hive, or true for the
+// file's .LOG1 and .LOG2 that exist
+Napi::Value HiveKey::OpenHive(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  Napi::Value options = info[1];
+  if (info.Length() < 1 || !info[0].IsString() ||
+      !(options.IsUndefined() || options.IsNull() || options.IsObject())) {
+    Napi::Error::New(env, "openHive - invalid arguments (file, options?)")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  try {
+    std::string file = info[0].As<Napi::String>();
+    const auto path = std::filesystem::u8path(file);
+    Napi::Value logs = options.IsObject()
+                           ? options.As<Napi::Object>().Get("logs")
+                           : env.Undefined();
+    if (logs.IsUndefined() || logs.IsNull() ||
+        (logs.IsBoolean() && !logs.As<Napi::Boolean>().Value())) {
+      return NewInstance(env, regf::Hive::Open(path)->Root());
+    }
+
+    std::vector<std::filesystem::path> logPaths;
+    if (logs.IsArray()) {
+      auto arr = logs.As<Napi::Array>();
+      for (uint32_t i = 0; i < arr.Length(); i++) {
+        logPaths.push_back(
+            std::filesystem::u8path(arr.Get(i).ToString().Utf8Value()));
+      }
+    } else {
+      for (const char* ext : {".LOG1", ".LOG2"}) {
+        auto log = std::filesystem::u8path(file + ext);
+        if (std::filesystem::exists(log)) {
+          logPaths.push_back(log);
+        }
+      }
+    }
+    auto hive = regf::Hive::Open(path, logPaths);
+    return NewInstance(env, hive->Root());
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// Open a subkey path relative to this key; null if it doesn't exist
+Napi::Value HiveKey::Open(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::Error::New(env, "open - invalid arguments (path)")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  try {
+    std::wstring p = JsToWide(info[0]);
+    toWindowSlashStyle(p);
+    regf::RegKey key;
+    key.Open(this->_key, p);
+    return NewInstance(env, key);
+  } catch (const winreg::RegException& e) {
+    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND) {
+      return env.Null();
+    }
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+Napi::Value HiveKey::Close(const Napi::CallbackInfo& info) {
+  this->_key.Close();
+  return info.This();
+}
+
+Napi::Value HiveKey::IsValid(const Napi::CallbackInfo& info) {
+  return Napi::Boolean::New(info.Env(), this->_key.IsValid());
+}
+
+Napi::Value HiveKey::GetName(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    return WideToJs(env, this->_key.GetName());
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+Napi::Value HiveKey::GetValueType(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    std::wstring p = JsToWide(info[0]);
+    return Napi::Number::New(env, this->_key.QueryValueType(p));
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+Napi::Value HiveKey::GetString(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    std::wstring p = JsToWide(info[0]);
+    auto v = this->_key.GetStringValue(p);
+    return WideToJs(env, v);
+  } catch (const winreg::RegException& e) {
+    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND && info.Length() > 1) {
+      return info[1];
+    }
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+Napi::Value HiveKey::GetMultiString(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    std::wstring p = JsToWide(info[0]);
+    auto vec = this->_key.GetMultiStringValue(p);
+    auto arr = Napi::Array::New(env, vec.size());
+    for (size_t i = 0; i < vec.size(); ++i) {
+      arr.Set(i, WideToJs(env, vec[i]));
+    }
+    return arr;
+  } catch (const winreg::RegException& e) {
+    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND && info.Length() > 1) {
+      return info[1];
+    }
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+Napi::Value HiveKey::GetDword(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    std::wstring p = JsToWide(info[0]);
+    auto v = this->_key.GetDwordValue(p);
+    return Napi::Number::New(env, (uint32_t)v);
+  } catch (const winreg::RegException& e) {
+    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND && info.Length() > 1) {
+      return info[1];
+    }
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+Napi::Value HiveKey::EnumSubKeys(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    auto v = this->_key.EnumSubKeys();
+    auto arr = Napi::Array::New(env, v.size());
+    for (size_t i = 0; i < v.size(); ++i) {
+      arr.Set(i, WideToJs(env, v[i]));
+    }
+    return arr;
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+Napi::Value HiveKey::EnumValues(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    auto v = this->_key.EnumValues();
+    auto obj = Napi::Object::New(env);
+    for (size_t i = 0; i < v.size(); ++i) {
+      obj.Set(WideToJs(env, v[i].first),
+              Napi::Number::New(env, (uint32_t)v[i].second));
+    }
+    return obj;
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+Napi::Value HiveKey::QueryInfoKey(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    DWORD subKeys = 0;
+    DWORD values = 0;
+    FILETIME lastWriteTime{};
+    this->_key.QueryInfoKey(subKeys, values, lastWriteTime);
+
+    auto obj = Napi::Object::New(env);
+    obj.Set("subKeys", Napi::Number::New(env, subKeys));
+    obj.Set("values", Napi::Number::New(env, values));
+    obj.Set("lastWriteTime", FileTimeToDate(env, lastWriteTime));
+    return obj;
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+// Append a JS string as UTF-16LE, with its terminating NUL
+static void AppendUtf16(std::vector<BYTE>& out, Napi::Value value) {
+  for (char16_t c : value.As<Napi::String>().Utf16Value()) {
+    out.push_back(static_cast<BYTE>(c));
+    out.push_back(static_cast<BYTE>(c >> 8));
+  }
+  out.push_back(0);
+  out.push_back(0);
+}
+
+// {type, data} to a hive value, data as in tests/fixtures/regf.js: a string
+// (REG_SZ, REG_EXPAND_SZ), an array of strings (REG_MULTI_SZ), a number or
+// BigInt (REG_DWORD, REG_QWORD) or a Buffer (any type)
+static bool JsToHiveValue(Napi::Value value, regf::KeyTree::Value& out) {
+  if (!value.IsObject() || !value.As<Napi::Object>().Get("type").IsNumber()) {
+    return false;
+  }
+  auto obj = value.As<Napi::Object>();
+  out.type = obj.Get("type").As<Napi::Number>().Uint32Value();
+  Napi::Value data = obj.Get("data");
+  if (data.IsBuffer()) {
+    auto buffer = data.As<Napi::Buffer<uint8_t>>();
+    out.data.assign(buffer.Data(), buffer.Data() + buffer.Length());
+  } else if (data.IsString()) {
+    AppendUtf16(out.data, data);
+  } else if (data.IsArray()) {
+    auto arr = data.As<Napi::Array>();
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+      if (!arr.Get(i).IsString()) {
+        return false;
+      }
+      AppendUtf16(out.data, arr.Get(i));
+    }
+    out.data.push_back(0);
+    out.data.push_back(0);
+  } else if (data.IsNumber() || data.IsBigInt()) {
+    bool lossless;
+    const uint64_t n = data.IsBigInt()
+        ? data.As<Napi::BigInt>().Uint64Value(&lossless)
+        : static_cast<uint64_t>(data.As<Napi::Number>().Int64Value());
+    const size_t size = out.type == REG_QWORD ? 8 : 4;
+    for (size_t i = 0; i < size; i++) {
+      out.data.push_back(static_cast<BYTE>(n >> (8 * i)));
+    }
+  } else if (!data.IsUndefined() && !data.IsNull()) {
+    return false;
+  }
+  return true;
+}
+
+// {values: {name: {type, data}}, keys: {name: tree}, lastWriteTime: Date} to
+// a key tree; false, with the path of the invalid part in error, if it isn't
+// one
+static bool JsToKeyTree(Napi::Value value, regf::KeyTree& key,
+                        const std::string& path, std::string& error) {
+  if (!value.IsObject()) {
+    error = path;
+    return false;
+  }
+  auto tree = value.As<Napi::Object>();
+  Napi::Value lastWriteTime = tree.Get("lastWriteTime");
+  if (lastWriteTime.IsDate()) {
+    key.lastWriteTime = JsTimeToFileTime(lastWriteTime.As<Napi::Date>().ValueOf());
+  }
+
+  Napi::Value values = tree.Get("values");
+  if (values.IsObject()) {
+    auto obj = values.As<Napi::Object>();
+    auto names = obj.GetPropertyNames();
+    key.values.resize(names.Length());
+    for (uint32_t i = 0; i < names.Length(); i++) {
+      Napi::Value name = names.Get(i);
+      key.values[i].name = JsToWide(name);
+      if (!JsToHiveValue(obj.Get(name), key.values[i])) {
+        error = path + " value \"" + name.As<Napi::String>().Utf8Value() + "\"";
+        return false;
+      }
+    }
+  }
+
+  Napi::Value keys = tree.Get("keys");
+  if (keys.IsObject()) {
+    auto obj = keys.As<Napi::Object>();
+    auto names = obj.GetPropertyNames();
+    key.subKeys.resize(names.Length());
+    for (uint32_t i = 0; i < names.Length(); i++) {
+      Napi::Value name = names.Get(i);
+      key.subKeys[i].name = JsToWide(name);
+      if (!JsToKeyTree(obj.Get(name), key.subKeys[i],
+                       path + "\\" + name.As<Napi::String>().Utf8Value(), error)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// tree, options ({rootName})?
+// The hive file of a key tree, as a Buffer. rootName is the name of the root
+// key ("ROOT" by default); names are unique case-insensitively, or RegError
+// ERROR_INVALID_PARAMETER.
+static Napi::Value WriteHive(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  Napi::Value options = info[1];
+  if (info.Length() < 1 || !info[0].IsObject() ||
+      !(options.IsUndefined() || options.IsNull() || options.IsObject())) {
+    Napi::Error::New(env, "writeHive - invalid arguments (tree, options?)")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  regf::KeyTree root;
+  root.name = L"ROOT";
+  if (options.IsObject() && options.As<Napi::Object>().Get("rootName").IsString()) {
+    root.name = JsToWide(options.As<Napi::Object>().Get("rootName"));
+  }
+  std::string error;
+  if (!JsToKeyTree(info[0], root, "tree", error)) {
+    Napi::Error::New(env, "writeHive - invalid " + error)
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  try {
+    const std::vector<BYTE> file = regf::WriteHive(root);
+    return Napi::Buffer<uint8_t>::Copy(env, file.data(), file.size());
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+static Napi::Array HiveCellsToJs(Napi::Env env,
+                                 const std::vector<regf::HiveCell>& cells) {
+  auto arr = Napi::Array::New(env, cells.size());
+  for (size_t i = 0; i < cells.size(); i++) {
+    const auto& cell = cells[i];
+    auto obj = Napi::Object::New(env);
+    obj.Set("offset", cell.offset);
+    obj.Set("size", cell.size);
+    obj.Set("kind", regf::CellKindName(cell.kind));
+    if (cell.kind == regf::CellKind::Key || cell.kind == regf::CellKind::Value) {
+      obj.Set("name", WideToJs(env, cell.name));
+    }
+    arr.Set(i, obj);
+  }
+  return arr;
+}
+
+// file or Buffer, options ({threads, orphans, carve})?
+// Check the cells of a hive file: {checksumValid, dirty, bins, allocated:
+// {cells, bytes}, free: {cells, bytes}, kinds: {nk, vk, ...}, orphaned,
+// carved, problems}. orphaned and carved list cells ({offset, size, kind,
+// name}, offsets relative to the first hive bin); problems are {offset,
+// message}. threads: 0, the default, for one per CPU; orphans and carve
+// (true by default) turn off the key tree walk and the free space search.
+static Napi::Value ScanHive(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  Napi::Value options = info[1];
+  if (info.Length() < 1 || !(info[0].IsString() || info[0].IsBuffer()) ||
+      !(options.IsUndefined() || options.IsNull() || options.IsObject())) {
+    Napi::Error::New(env, "scanHive - invalid arguments (file, options?)")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  regf::HiveScanOptions scanOptions;
+  if (options.IsObject()) {
+    auto obj = options.As<Napi::Object>();
+    if (obj.Get("threads").IsNumber()) {
+      scanOptions.threads = obj.Get("threads").As<Napi::Number>().Uint32Value();
+    }
+    if (obj.Get("orphans").IsBoolean()) {
+      scanOptions.findOrphans = obj.Get("orphans").As<Napi::Boolean>().Value();
+    }
+    if (obj.Get("carve").IsBoolean()) {
+      scanOptions.carve = obj.Get("carve").As<Napi::Boolean>().Value();
+    }
+  }
+
+  try {
+    regf::HiveScanReport report;
+    if (info[0].IsBuffer()) {
+      auto buffer = info[0].As<Napi::Buffer<uint8_t>>();
+      report = regf::ScanHive(buffer.Data(), buffer.Length(), scanOptions);
+    } else {
+      std::string file = info[0].As<Napi::String>();
+      report = regf::ScanHive(std::filesystem::u8path(file), scanOptions);
+    }
+
+    auto allocated = Napi::Object::New(env);
+    allocated.Set("cells", (double)report.allocatedCells);
+    allocated.Set("bytes", (double)report.allocatedBytes);
+    auto free = Napi::Object::New(env);
+    free.Set("cells", (double)report.freeCells);
+    free.Set("bytes", (double)report.freeBytes);
+    auto kinds = Napi::Object::New(env);
+    for (size_t kind = 0; kind < regf::kCellKindCount; kind++) {
+      kinds.Set(regf::CellKindName(static_cast<regf::CellKind>(kind)),
+                (double)report.cellsByKind[kind]);
+    }
+    auto problems = Napi::Array::New(env, report.problems.size());
+    for (size_t i = 0; i < report.problems.size(); i++) {
+      auto problem = Napi::Object::New(env);
+      problem.Set("offset", report.problems[i].offset);
+      problem.Set("message", report.problems[i].message);
+      problems.Set(i, problem);
+    }
+
+    auto result = Napi::Object::New(env);
+    result.Set("checksumValid", report.checksumValid);
+    result.Set("dirty", report.dirty);
+    result.Set("bins", (double)report.bins);
+    result.Set("allocated", allocated);
+    result.Set("free", free);
+    result.Set("kinds", kinds);
+    result.Set("orphaned", HiveCellsToJs(env, report.orphaned));
+    result.Set("carved", HiveCellsToJs(env, report.carved));
+    result.Set("problems", problems);
+    return result;
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// JavaScript wrapper of regf::PathIndex: constant-time lookups of the keys
+// under a HiveKey by full path.
+class HiveIndex : public Napi::ObjectWrap<HiveIndex> {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+  static Napi::Value Build(const Napi::CallbackInfo& info);
+  static Napi::Value Load(const Napi::CallbackInfo& info);
+
+  HiveIndex(const Napi::CallbackInfo& info);
+
+  Napi::Value Open(const Napi::CallbackInfo& info);
+  Napi::Value Save(const Napi::CallbackInfo& info);
+  Napi::Value GetKeyCount(const Napi::CallbackInfo& info);
+
+ private:
+  static Napi::Object NewInstance(Napi::Env env, regf::PathIndex index);
+
+  std::unique_ptr<regf::PathIndex> _index;
+
+  // The Buffer a loaded index is read from, kept alive with it
+  Napi::ObjectReference _buffer;
+};
+
+Napi::Object HiveIndex::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func =
+      DefineClass(env, "HiveIndex",
+                  {InstanceMethod("open", &HiveIndex::Open),
+                   InstanceMethod("save", &HiveIndex::Save),
+                   InstanceAccessor("keyCount", &HiveIndex::GetKeyCount, nullptr)});
+
+  GetAddonData(env)->hiveIndex = Napi::Persistent(func);
+
+  exports.Set("HiveIndex", func);
+  exports.Set("buildHiveIndex", Napi::Function::New(env, HiveIndex::Build));
+  exports.Set("loadHiveIndex", Napi::Function::New(env, HiveIndex::Load));
+  return exports;
+}
+
+Napi::Object HiveIndex::NewInstance(Napi::Env env, regf::PathIndex index) {
+  Napi::Object obj = GetAddonData(env)->hiveIndex.New({});
+  Unwrap(obj)->_index = std::make_unique<regf::PathIndex>(std::move(index));
+  return obj;
+}
+
+HiveIndex::HiveIndex(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<HiveIndex>(info) {
+}
+
+// hiveKey
+// Index the keys under a HiveKey (paths relative to it)
+Napi::Value HiveIndex::Build(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  const regf::RegKey* key = UnwrapHiveKey(info[0]);
+  if (key == nullptr) {
+    Napi::Error::New(env, "buildHiveIndex - invalid arguments (hiveKey)")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  try {
+    return NewInstance(env, regf::PathIndex::Build(*key));
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// file or Buffer
+// An index saved by save(), memory-mapped or read in place from the Buffer
+Napi::Value HiveIndex::Load(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 1 || !(info[0].IsString() || info[0].IsBuffer())) {
+    Napi::Error::New(env, "loadHiveIndex - invalid arguments (file)")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  try {
+    if (info[0].IsBuffer()) {
+      auto buffer = info[0].As<Napi::Buffer<uint8_t>>();
+      auto obj = NewInstance(
+          env, regf::PathIndex::FromMemory(buffer.Data(), buffer.Length()));
+      Unwrap(obj)->_buffer = Napi::Persistent(buffer.As<Napi::Object>());
+      return obj;
+    }
+    std::string file = info[0].As<Napi::String>();
+    return NewInstance(env, regf::PathIndex::Load(std::filesystem::u8path(file)));
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// hiveKey, path
+// The key at path under hiveKey, the key the index was built from; null if
+// it doesn't exist. RegError ERROR_INVALID_DATA if the hive has changed.
+Napi::Value HiveIndex::Open(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  const regf::RegKey* root = UnwrapHiveKey(info[0]);
+  if (root == nullptr || info.Length() < 2 || !info[1].IsString() || !_index) {
+    Napi::Error::New(env, "open - invalid arguments (hiveKey, path)")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  try {
+    std::wstring p = JsToWide(info[1]);
+    toWindowSlashStyle(p);
+    regf::RegKey key;
+    if (!_index->TryOpen(*root, p, key)) {
+      return env.Null();
+    }
+    return HiveKey::NewInstance(env, key);
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  }
+}
+
+// The index image, to be saved next to the hive file
+Napi::Value HiveIndex::Save(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (!_index) {
+    return env.Null();
+  }
+  const std::vector<BYTE> image = _index->Save();
+  return Napi::Buffer<uint8_t>::Copy(env, image.data(), image.size());
+}
+
+Napi::Value HiveIndex::GetKeyCount(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), _index ? (double)_index->KeyCount() : 0);
+}
+
+Napi::Object InitHive(Napi::Env env, Napi::Object exports) {
+  exports.Set("writeHive", Napi::Function::New(env, WriteHive));
+  exports.Set("scanHive", Napi::Function::New(env, ScanHive));
+  HiveIndex::Init(env, exports);
+  return HiveKey::Init(env, exports);
+}
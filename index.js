@@ -1,2 +1,60 @@
+const { Readable, promises: { pipeline } } = require("stream");
+
 const arch = process.arch;
-module.exports = require(`./${arch}/winreg.node`);
+const winreg = require(`./${arch}/winreg.node`);
+
+const SUBKEY_PAGE_SIZE = 1000;
+
+// for await (const name of key.subKeys({pageSize?})): the subkey names,
+// enumerated a page at a time on the thread pool. The next page is fetched
+// while the current one is consumed, so at most two pages are held at once
+// whatever the size of the key. Closing the key ends the iteration with an
+// error at the next page; subkeys added or deleted meanwhile may be skipped
+// or repeated.
+winreg.RegKey.prototype.subKeys = async function* subKeys(options) {
+  const pageSize = (options && options.pageSize) || SUBKEY_PAGE_SIZE;
+  const fetch = (start) => {
+    const page = this.enumSubKeysAsync(start, pageSize);
+    // Not awaited if the loop breaks early
+    page.catch(() => {});
+    return page;
+  };
+
+  let start = 0;
+  let next = fetch(start);
+  while (next) {
+    const page = await next;
+    start += page.length;
+    next = page.length === pageSize ? fetch(start) : null;
+    yield* page;
+  }
+};
+
+// A Readable of the .reg file of a subtree: a live key (hkey, path) or a key
+// of an offline hive (HiveKey, path), with options {root, access}. The file is
+// produced natively a chunk at a time as the stream is read, so memory stays
+// constant whatever the size of the tree.
+winreg.exportRegStream = function exportRegStream(hkey, path, options) {
+  const exporter = new winreg.RegFileExporter(hkey, path, options);
+  return new Readable({
+    read(size) {
+      try {
+        this.push(exporter.read(size));
+      } catch (e) {
+        this.destroy(e);
+      }
+    },
+  });
+};
+
+// exportReg(hkey, path, fileOrStream, options?): to a file name, written
+// natively, returning the number of bytes written; to a writable stream,
+// piped with backpressure, returning a Promise settled once it is written.
+winreg.exportReg = function exportReg(hkey, path, target, options) {
+  if (typeof target === "string") {
+    return winreg.exportRegFile(hkey, path, target, options);
+  }
+  return pipeline(winreg.exportRegStream(hkey, path, options), target);
+};
+
+module.exports = winreg;
@@ -0,0 +1,325 @@
+#ifndef INCLUDE_WINREG_KEYCACHE_HPP
+#define INCLUDE_WINREG_KEYCACHE_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// A process-wide cache of open registry key handles, built on winreg::RegKey.
+//
+// Callers that touch the same keys over and over (e.g. polling a few values
+// every second) can borrow an already open handle instead of paying a
+// RegOpenKeyEx/RegCloseKey pair around every query.
+//
+// Entries are keyed by (root key, path, access mask, WOW64 view) and evicted
+// least-recently-used first once more than MaxHandles() handles are cached.
+// Handles are lent out as shared_ptrs, so evicting or clearing an entry while
+// another thread uses it is safe: the handle is closed by the last user.
+//
+// Only subkeys of the predefined roots (HKEY_CURRENT_USER, ...) are cached:
+// other handle values can be closed and reused for a different key behind
+// the cache's back.
+//
+// All member functions are thread-safe.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "winreg.hpp"
+
+#include <cwctype>       // std::towupper
+#include <iterator>      // std::next, std::prev
+#include <list>          // std::list
+#include <memory>        // std::shared_ptr
+#include <mutex>         // std::mutex
+#include <string>        // std::wstring
+#include <unordered_map> // std::unordered_map
+
+namespace winreg
+{
+
+class KeyCache
+{
+  public:
+    struct Stats
+    {
+        size_t size{0};
+        size_t hits{0};
+        size_t misses{0};
+        size_t evictions{0};
+    };
+
+    // The cache shared by the whole process; disabled until Enable()
+    static KeyCache &Instance();
+
+    // Start caching, keeping at most maxHandles handles open
+    void Enable(size_t maxHandles);
+
+    // Stop caching and close all cached handles
+    void Disable();
+
+    bool IsEnabled() const;
+    size_t MaxHandles() const;
+
+    // Close all cached handles, e.g. after keys were deleted or renamed
+    void Clear();
+
+    // Drop the handles of hKeyParent\subKey and of all its subkeys
+    void Invalidate(HKEY hKeyParent, const std::wstring &subKey);
+
+    // Drop a single handle that turned out to be stale (ERROR_KEY_DELETED)
+    void Remove(HKEY hKeyParent, const std::wstring &subKey, REGSAM access);
+
+    // The cached handle of hKeyParent\subKey opened with the given access,
+    // or nullptr if there is none (or it can't be cached)
+    std::shared_ptr<RegKey> Find(HKEY hKeyParent, const std::wstring &subKey, REGSAM access);
+
+    // Cache an open handle of hKeyParent\subKey, evicting the least recently
+    // used handles over the limit. Does nothing if the cache is disabled.
+    void Insert(HKEY hKeyParent, const std::wstring &subKey, REGSAM access,
+                std::shared_ptr<RegKey> key);
+
+    Stats GetStats() const;
+
+    // Whether handles under hKeyParent can be cached
+    static bool IsCacheableRoot(HKEY hKeyParent) noexcept;
+
+  private:
+    struct Entry
+    {
+        std::wstring id;
+        std::shared_ptr<RegKey> key;
+    };
+
+    // Registry paths are case-insensitive and the WOW64 flags pick a
+    // different view, so both are part of the cache key
+    static std::wstring MakeId(HKEY hKeyParent, const std::wstring &subKey, REGSAM access);
+
+    static std::wstring FoldPath(const std::wstring &subKey);
+
+    void EvictOverLimit(std::list<Entry> &evicted);
+
+    mutable std::mutex m_mutex;
+    bool m_enabled{false};
+    size_t m_maxHandles{0};
+
+    // Most recently used first
+    std::list<Entry> m_lru;
+    std::unordered_map<std::wstring, std::list<Entry>::iterator> m_index;
+    Stats m_stats;
+};
+
+//------------------------------------------------------------------------------
+//                          KeyCache Inline Methods
+//------------------------------------------------------------------------------
+
+inline KeyCache &KeyCache::Instance()
+{
+    static KeyCache instance;
+    return instance;
+}
+
+inline void KeyCache::Enable(const size_t maxHandles)
+{
+    std::list<Entry> evicted;
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_enabled = true;
+    m_maxHandles = maxHandles;
+    EvictOverLimit(evicted);
+}
+
+inline void KeyCache::Disable()
+{
+    std::list<Entry> dropped;
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_enabled = false;
+    m_index.clear();
+    dropped.swap(m_lru);
+}
+
+inline bool KeyCache::IsEnabled() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_enabled;
+}
+
+inline size_t KeyCache::MaxHandles() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_maxHandles;
+}
+
+inline void KeyCache::Clear()
+{
+    std::list<Entry> dropped;
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_index.clear();
+    dropped.swap(m_lru);
+}
+
+inline void KeyCache::Invalidate(const HKEY hKeyParent, const std::wstring &subKey)
+{
+    if (!IsCacheableRoot(hKeyParent))
+    {
+        return;
+    }
+
+    // Ids start with "<root>|<wow64>|<access>|", then the folded path
+    std::wstring path = FoldPath(subKey);
+    const std::wstring root = std::to_wstring(reinterpret_cast<ULONG_PTR>(hKeyParent)) + L"|";
+
+    std::list<Entry> dropped;
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (auto it = m_lru.begin(); it != m_lru.end();)
+    {
+        const std::wstring &id = it->id;
+        bool match = false;
+        if (id.compare(0, root.size(), root) == 0)
+        {
+            const size_t pos = id.find(L'|', id.find(L'|', root.size()) + 1);
+            const std::wstring entryPath = id.substr(pos + 1);
+            match = path.empty() || entryPath == path ||
+                    (entryPath.size() > path.size() &&
+                     entryPath.compare(0, path.size(), path) == 0 &&
+                     entryPath[path.size()] == L'\\');
+        }
+
+        if (match)
+        {
+            m_index.erase(it->id);
+            auto next = std::next(it);
+            dropped.splice(dropped.end(), m_lru, it);
+            it = next;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+inline void KeyCache::Remove(const HKEY hKeyParent, const std::wstring &subKey, const REGSAM access)
+{
+    std::shared_ptr<RegKey> dropped;
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto found = m_index.find(MakeId(hKeyParent, subKey, access));
+    if (found != m_index.end())
+    {
+        dropped = std::move(found->second->key);
+        m_lru.erase(found->second);
+        m_index.erase(found);
+    }
+}
+
+inline std::shared_ptr<RegKey> KeyCache::Find(const HKEY hKeyParent, const std::wstring &subKey,
+                                              const REGSAM access)
+{
+    if (!IsCacheableRoot(hKeyParent))
+    {
+        return nullptr;
+    }
+
+    const std::wstring id = MakeId(hKeyParent, subKey, access);
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (!m_enabled)
+    {
+        return nullptr;
+    }
+
+    auto found = m_index.find(id);
+    if (found == m_index.end())
+    {
+        ++m_stats.misses;
+        return nullptr;
+    }
+
+    ++m_stats.hits;
+    m_lru.splice(m_lru.begin(), m_lru, found->second);
+    return found->second->key;
+}
+
+inline void KeyCache::Insert(const HKEY hKeyParent, const std::wstring &subKey, const REGSAM access,
+                             std::shared_ptr<RegKey> key)
+{
+    if (!IsCacheableRoot(hKeyParent))
+    {
+        return;
+    }
+
+    std::wstring id = MakeId(hKeyParent, subKey, access);
+    std::list<Entry> evicted;
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (!m_enabled || m_maxHandles == 0)
+    {
+        return;
+    }
+
+    auto found = m_index.find(id);
+    if (found != m_index.end())
+    {
+        // Another thread cached the same key meanwhile: keep the newer handle
+        found->second->key.swap(key);
+        m_lru.splice(m_lru.begin(), m_lru, found->second);
+        return;
+    }
+
+    m_lru.push_front(Entry{id, std::move(key)});
+    m_index.emplace(std::move(id), m_lru.begin());
+    EvictOverLimit(evicted);
+}
+
+inline KeyCache::Stats KeyCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    Stats stats = m_stats;
+    stats.size = m_lru.size();
+    return stats;
+}
+
+inline bool KeyCache::IsCacheableRoot(const HKEY hKeyParent) noexcept
+{
+    // HKEY_CLASSES_ROOT (0x80000000) to HKEY_CURRENT_USER_LOCAL_SETTINGS
+    return (static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(hKeyParent)) & 0xFFFFFFF0UL) == 0x80000000UL;
+}
+
+inline std::wstring KeyCache::MakeId(const HKEY hKeyParent, const std::wstring &subKey,
+                                     const REGSAM access)
+{
+    const REGSAM view = access & (KEY_WOW64_32KEY | KEY_WOW64_64KEY);
+    return std::to_wstring(reinterpret_cast<ULONG_PTR>(hKeyParent)) + L"|" +
+           std::to_wstring(view) + L"|" + std::to_wstring(access & ~view) + L"|" +
+           FoldPath(subKey);
+}
+
+inline std::wstring KeyCache::FoldPath(const std::wstring &subKey)
+{
+    std::wstring path;
+    path.reserve(subKey.size());
+    for (const wchar_t ch : subKey)
+    {
+        // Skip empty path components ("a\\b", "a\", "\a")
+        if (ch == L'\\' && (path.empty() || path.back() == L'\\'))
+        {
+            continue;
+        }
+        path.push_back(static_cast<wchar_t>(std::towupper(ch)));
+    }
+    if (!path.empty() && path.back() == L'\\')
+    {
+        path.pop_back();
+    }
+    return path;
+}
+
+// Called with m_mutex held. The evicted entries are moved to the caller's
+// list, declared before the lock, so their handles are closed after unlocking.
+inline void KeyCache::EvictOverLimit(std::list<Entry> &evicted)
+{
+    while (m_lru.size() > m_maxHandles)
+    {
+        m_index.erase(m_lru.back().id);
+        evicted.splice(evicted.begin(), m_lru, std::prev(m_lru.end()));
+        ++m_stats.evictions;
+    }
+}
+
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_KEYCACHE_HPP
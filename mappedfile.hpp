@@ -0,0 +1,186 @@
+#ifndef INCLUDE_WINREG_MAPPEDFILE_HPP
+#define INCLUDE_WINREG_MAPPEDFILE_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Read-only memory mapping of a whole file.
+//
+// Used by the offline engines (hive reader, .reg parser) to work on file
+// contents in place, without reading them into heap buffers.
+// Errors are signaled throwing winreg::RegException.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "regdefs.hpp"
+
+#include <cstddef>    // std::size_t
+#include <filesystem> // std::filesystem::path
+#include <utility>    // std::swap
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace winreg
+{
+
+//------------------------------------------------------------------------------
+// Movable, non-copyable owner of a read-only file mapping.
+// An empty file yields a valid mapping with Data() == nullptr and Size() == 0.
+//------------------------------------------------------------------------------
+class MappedFile
+{
+  public:
+    MappedFile() noexcept = default;
+
+    // Map the whole file read-only.
+    // Throw RegException on failure.
+    explicit MappedFile(const std::filesystem::path &path);
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    // Ban copy
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() noexcept;
+
+    const BYTE *Data() const noexcept
+    {
+        return m_data;
+    }
+
+    std::size_t Size() const noexcept
+    {
+        return m_size;
+    }
+
+    void Close() noexcept;
+
+  private:
+    const BYTE *m_data{nullptr};
+    std::size_t m_size{0};
+};
+
+inline MappedFile::MappedFile(const std::filesystem::path &path)
+{
+#ifdef _WIN32
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw RegException{"Cannot open file: CreateFile failed.", static_cast<LONG>(::GetLastError())};
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!::GetFileSizeEx(file, &fileSize))
+    {
+        const LONG error = static_cast<LONG>(::GetLastError());
+        ::CloseHandle(file);
+        throw RegException{"Cannot get file size: GetFileSizeEx failed.", error};
+    }
+
+    if (fileSize.QuadPart > 0)
+    {
+        HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const LONG error = static_cast<LONG>(::GetLastError());
+        ::CloseHandle(file);
+        if (mapping == nullptr)
+        {
+            throw RegException{"Cannot map file: CreateFileMapping failed.", error};
+        }
+
+        void *view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        const LONG viewError = static_cast<LONG>(::GetLastError());
+        ::CloseHandle(mapping);
+        if (view == nullptr)
+        {
+            throw RegException{"Cannot map file: MapViewOfFile failed.", viewError};
+        }
+
+        m_data = static_cast<const BYTE *>(view);
+        m_size = static_cast<std::size_t>(fileSize.QuadPart);
+    }
+    else
+    {
+        ::CloseHandle(file);
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw RegException{"Cannot open file: open failed.",
+                           errno == ENOENT ? ERROR_FILE_NOT_FOUND : ERROR_ACCESS_DENIED};
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throw RegException{"Cannot get file size: fstat failed.", ERROR_ACCESS_DENIED};
+    }
+
+    if (st.st_size > 0)
+    {
+        void *view = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED)
+        {
+            throw RegException{"Cannot map file: mmap failed.", ERROR_OUTOFMEMORY};
+        }
+
+        m_data = static_cast<const BYTE *>(view);
+        m_size = static_cast<std::size_t>(st.st_size);
+    }
+    else
+    {
+        ::close(fd);
+    }
+#endif
+}
+
+inline MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_data{other.m_data}, m_size{other.m_size}
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+inline MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+    }
+    return *this;
+}
+
+inline MappedFile::~MappedFile() noexcept
+{
+    Close();
+}
+
+inline void MappedFile::Close() noexcept
+{
+    if (m_data != nullptr)
+    {
+#ifdef _WIN32
+        ::UnmapViewOfFile(m_data);
+#else
+        ::munmap(const_cast<BYTE *>(m_data), m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_MAPPEDFILE_HPP
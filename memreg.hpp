@@ -0,0 +1,1116 @@
+#ifndef INCLUDE_WINREG_MEMREG_HPP
+#define INCLUDE_WINREG_MEMREG_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// In-memory stand-in for the Windows Registry C API.
+//
+// Implements the subset of the registry API used by winreg.hpp and the Node
+// addon (RegOpenKeyEx, RegGetValue, RegEnumKeyEx, ...) over an in-memory
+// tree, so the live-registry code builds, runs and can be tested on
+// platforms without a registry. winreg.hpp includes it instead of the
+// Platform SDK outside Windows.
+//
+// The functions follow their Win32 counterparts for everything the wrappers
+// rely on: error codes, buffer sizing and ERROR_MORE_DATA, RRF_RT_* type
+// filtering, NUL termination of strings in RegGetValue, case-insensitive
+// names, sorted subkey enumeration, access rights granted at open time and
+// the WOW64 32-bit view of HKLM\Software. Security descriptors, volatile
+// keys, symbolic links and remote registries are not emulated.
+//
+// For tests and benchmarks, the memreg namespace also offers a few knobs:
+// injected per-call latency, per-API call counters and a settable clock for
+// key last-write times.
+//
+// The stand-in is thread-safe: the key tree is guarded by a reader/writer
+// lock (readers run concurrently) and the handle table by its own mutex.
+// Injected latency is spent outside any lock, so concurrent callers overlap
+// like they would on a slow real hive.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "regdefs.hpp" // DWORD, LONG, REG_*, ERROR_*
+
+#include <algorithm>     // std::lower_bound
+#include <array>         // std::array
+#include <atomic>        // std::atomic
+#include <cassert>       // assert
+#include <chrono>        // std::chrono
+#include <cstdint>       // std::uintptr_t
+#include <cstdlib>       // std::getenv
+#include <cstring>       // std::memcpy
+#include <cwchar>        // std::wcslen
+#include <cwctype>       // std::towupper
+#include <map>           // std::map
+#include <memory>        // std::shared_ptr
+#include <mutex>         // std::mutex, std::unique_lock
+#include <shared_mutex>  // std::shared_mutex, std::shared_lock
+#include <string>        // std::wstring
+#include <thread>        // std::this_thread::sleep_for
+#include <unordered_set> // std::unordered_set
+#include <vector>        // std::vector
+
+//
+// Platform SDK types and constants
+//
+
+typedef struct HKEY__ *HKEY;
+typedef HKEY *PHKEY;
+typedef DWORD REGSAM;
+typedef DWORD *LPDWORD;
+typedef BYTE *LPBYTE;
+typedef void *PVOID;
+typedef wchar_t WCHAR;
+typedef WCHAR *LPWSTR;
+typedef const WCHAR *LPCWSTR;
+typedef int BOOL;
+typedef std::uintptr_t ULONG_PTR;
+
+struct SECURITY_ATTRIBUTES
+{
+    DWORD nLength;
+    void *lpSecurityDescriptor;
+    BOOL bInheritHandle;
+};
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+#define _ASSERTE(expr) assert(expr)
+
+#define HKEY_CLASSES_ROOT ((HKEY)(ULONG_PTR)0x80000000UL)
+#define HKEY_CURRENT_USER ((HKEY)(ULONG_PTR)0x80000001UL)
+#define HKEY_LOCAL_MACHINE ((HKEY)(ULONG_PTR)0x80000002UL)
+#define HKEY_USERS ((HKEY)(ULONG_PTR)0x80000003UL)
+#define HKEY_PERFORMANCE_DATA ((HKEY)(ULONG_PTR)0x80000004UL)
+#define HKEY_CURRENT_CONFIG ((HKEY)(ULONG_PTR)0x80000005UL)
+#define HKEY_CURRENT_USER_LOCAL_SETTINGS ((HKEY)(ULONG_PTR)0x80000007UL)
+#define HKEY_PERFORMANCE_TEXT ((HKEY)(ULONG_PTR)0x80000050UL)
+#define HKEY_PERFORMANCE_NLSTEXT ((HKEY)(ULONG_PTR)0x80000060UL)
+
+#define DELETE 0x00010000L
+#define READ_CONTROL 0x00020000L
+#define GENERIC_READ 0x80000000L
+#define GENERIC_WRITE 0x40000000L
+#define GENERIC_ALL 0x10000000L
+#define MAXIMUM_ALLOWED 0x02000000L
+
+#define KEY_QUERY_VALUE 0x0001
+#define KEY_SET_VALUE 0x0002
+#define KEY_CREATE_SUB_KEY 0x0004
+#define KEY_ENUMERATE_SUB_KEYS 0x0008
+#define KEY_NOTIFY 0x0010
+#define KEY_CREATE_LINK 0x0020
+#define KEY_WOW64_64KEY 0x0100
+#define KEY_WOW64_32KEY 0x0200
+#define KEY_WOW64_RES 0x0300
+#define KEY_READ 0x20019
+#define KEY_WRITE 0x20006
+#define KEY_EXECUTE KEY_READ
+#define KEY_ALL_ACCESS 0xF003F
+
+#define REG_OPTION_NON_VOLATILE 0x00000000L
+#define REG_OPTION_VOLATILE 0x00000001L
+
+#define REG_CREATED_NEW_KEY 0x00000001L
+#define REG_OPENED_EXISTING_KEY 0x00000002L
+
+#define RRF_RT_REG_NONE 0x00000001
+#define RRF_RT_REG_SZ 0x00000002
+#define RRF_RT_REG_EXPAND_SZ 0x00000004
+#define RRF_RT_REG_BINARY 0x00000008
+#define RRF_RT_REG_DWORD 0x00000010
+#define RRF_RT_REG_MULTI_SZ 0x00000020
+#define RRF_RT_REG_QWORD 0x00000040
+#define RRF_RT_DWORD (RRF_RT_REG_BINARY | RRF_RT_REG_DWORD)
+#define RRF_RT_QWORD (RRF_RT_REG_BINARY | RRF_RT_REG_QWORD)
+#define RRF_RT_ANY 0x0000ffff
+#define RRF_NOEXPAND 0x10000000
+#define RRF_ZEROONFAILURE 0x20000000
+
+#define ERROR_DATATYPE_MISMATCH 1629
+
+//
+// The TCHAR-style names used by winreg.hpp (UNICODE builds)
+//
+#define RegCreateKeyEx RegCreateKeyExW
+#define RegOpenKeyEx RegOpenKeyExW
+#define RegSetValueEx RegSetValueExW
+#define RegGetValue RegGetValueW
+#define RegQueryValueEx RegQueryValueExW
+#define RegQueryInfoKey RegQueryInfoKeyW
+#define RegEnumKeyEx RegEnumKeyExW
+#define RegEnumValue RegEnumValueW
+#define RegDeleteValue RegDeleteValueW
+#define RegDeleteKeyEx RegDeleteKeyExW
+#define RegDeleteTree RegDeleteTreeW
+#define RegLoadKey RegLoadKeyW
+#define RegSaveKey RegSaveKeyW
+#define RegConnectRegistry RegConnectRegistryW
+
+namespace memreg
+{
+
+// APIs with a call counter
+enum class Api
+{
+    RegCreateKeyEx,
+    RegOpenKeyEx,
+    RegCloseKey,
+    RegSetValueEx,
+    RegGetValue,
+    RegQueryValueEx,
+    RegQueryInfoKey,
+    RegEnumKeyEx,
+    RegEnumValue,
+    RegDeleteValue,
+    RegDeleteKeyEx,
+    RegDeleteTree,
+    Count
+};
+
+inline const char *ApiName(const Api api) noexcept
+{
+    static const char *const names[] = {
+        "RegCreateKeyEx", "RegOpenKeyEx", "RegCloseKey", "RegSetValueEx",
+        "RegGetValue", "RegQueryValueEx", "RegQueryInfoKey", "RegEnumKeyEx",
+        "RegEnumValue", "RegDeleteValue", "RegDeleteKeyEx", "RegDeleteTree"};
+    return names[static_cast<int>(api)];
+}
+
+namespace details
+{
+
+inline wchar_t FoldChar(const wchar_t c) noexcept
+{
+    if (c < L'a')
+        return c;
+    if (c <= L'z')
+        return static_cast<wchar_t>(c - 0x20);
+    return static_cast<wchar_t>(std::towupper(static_cast<wint_t>(c)));
+}
+
+// Case-insensitive ordering of key names, as in registry enumeration
+struct NameLess
+{
+    bool operator()(const std::wstring &a, const std::wstring &b) const noexcept
+    {
+        const std::size_t n = std::min(a.size(), b.size());
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const wchar_t ca = FoldChar(a[i]);
+            const wchar_t cb = FoldChar(b[i]);
+            if (ca != cb)
+                return ca < cb;
+        }
+        return a.size() < b.size();
+    }
+};
+
+inline bool NameEquals(const std::wstring &a, const wchar_t *b, const std::size_t bLen) noexcept
+{
+    if (a.size() != bLen)
+        return false;
+    for (std::size_t i = 0; i < bLen; ++i)
+    {
+        if (FoldChar(a[i]) != FoldChar(b[i]))
+            return false;
+    }
+    return true;
+}
+
+struct Value
+{
+    std::wstring name;
+    DWORD type{REG_NONE};
+    std::vector<BYTE> data;
+};
+
+struct Node
+{
+    std::wstring name;
+    Node *parent{nullptr};
+    std::map<std::wstring, std::shared_ptr<Node>, NameLess> children;
+    std::vector<Value> values; // in creation order, like the registry
+    ULONGLONG lastWriteTime{0};
+    bool deleted{false};
+
+    // Index of children for O(1) enumeration by position;
+    // rebuilt lazily after the children change
+    std::vector<Node *> order;
+    std::atomic<bool> orderValid{false};
+    std::mutex orderMutex;
+
+    Node *ChildAt(const DWORD index)
+    {
+        if (!orderValid.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock{orderMutex};
+            if (!orderValid.load(std::memory_order_relaxed))
+            {
+                order.clear();
+                order.reserve(children.size());
+                for (auto &child : children)
+                    order.push_back(child.second.get());
+                orderValid.store(true, std::memory_order_release);
+            }
+        }
+        return index < order.size() ? order[index] : nullptr;
+    }
+
+    Value *FindValue(const wchar_t *valueName)
+    {
+        const std::size_t len = valueName != nullptr ? std::wcslen(valueName) : 0;
+        for (auto &value : values)
+        {
+            if (NameEquals(value.name, valueName != nullptr ? valueName : L"", len))
+                return &value;
+        }
+        return nullptr;
+    }
+
+    void MarkDeleted() noexcept
+    {
+        deleted = true;
+        for (auto &child : children)
+            child.second->MarkDeleted();
+    }
+};
+
+} // namespace details
+} // namespace memreg
+
+// An open key handle
+struct HKEY__
+{
+    std::shared_ptr<memreg::details::Node> node;
+    REGSAM access{0};
+};
+
+namespace memreg
+{
+
+//------------------------------------------------------------------------------
+// The in-memory registry shared by all the API functions
+//------------------------------------------------------------------------------
+class Registry
+{
+  public:
+    static Registry &Instance()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    // Drop all keys and values; open handles now refer to deleted keys
+    void Reset()
+    {
+        std::unique_lock<std::shared_mutex> lock{m_mutex};
+        for (auto &root : m_roots)
+        {
+            if (root)
+                root->MarkDeleted();
+            root = std::make_shared<details::Node>();
+        }
+    }
+
+    // Sleep this long at the start of every API call
+    void SetLatency(const std::chrono::microseconds latency) noexcept
+    {
+        m_latencyUs = latency.count();
+    }
+
+    unsigned long long CallCount(const Api api) const noexcept
+    {
+        return m_calls[static_cast<int>(api)].load();
+    }
+
+    void ResetCallCounts() noexcept
+    {
+        for (auto &count : m_calls)
+            count = 0;
+    }
+
+    // Use a fixed FILETIME for last-write times (0 = the system clock)
+    void SetClock(const ULONGLONG fileTime) noexcept
+    {
+        m_clock = fileTime;
+    }
+
+    ULONGLONG Now() const noexcept
+    {
+        const ULONGLONG fixed = m_clock.load();
+        if (fixed != 0)
+            return fixed;
+
+        // FILETIME: 100ns ticks since 1601-01-01
+        const auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+        return static_cast<ULONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count() / 100) +
+               116444736000000000ULL;
+    }
+
+    // Count the call and spend the injected latency (outside any lock)
+    void Enter(const Api api) noexcept
+    {
+        ++m_calls[static_cast<int>(api)];
+        const long long latency = m_latencyUs.load();
+        if (latency > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds{latency});
+    }
+
+    std::shared_mutex &Mutex() noexcept
+    {
+        return m_mutex;
+    }
+
+    // Resolve a handle to its key node and granted access.
+    // Call with the tree lock held.
+    LONG Resolve(const HKEY hKey, std::shared_ptr<details::Node> &node, REGSAM &access) const
+    {
+        const auto bits = reinterpret_cast<ULONG_PTR>(hKey);
+        if ((bits & 0xFFFFFFF8UL) == 0x80000000UL && (bits >> 32 == 0 || bits >> 32 == 0xFFFFFFFFUL))
+        {
+            node = m_roots[bits & 7];
+            if (!node)
+                return ERROR_INVALID_HANDLE;
+            access = KEY_ALL_ACCESS;
+            return ERROR_SUCCESS;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{m_handleMutex};
+            if (hKey == nullptr || m_handles.count(hKey) == 0)
+                return ERROR_INVALID_HANDLE;
+
+            node = hKey->node;
+            access = hKey->access;
+        }
+        return node->deleted ? ERROR_KEY_DELETED : ERROR_SUCCESS;
+    }
+
+    bool IsPredefined(const HKEY hKey) const noexcept
+    {
+        return ((reinterpret_cast<ULONG_PTR>(hKey) & 0xFFFFFFF0UL) == 0x80000000UL);
+    }
+
+    bool IsLocalMachine(const HKEY hKey) const noexcept
+    {
+        return (reinterpret_cast<ULONG_PTR>(hKey) & 0xFFFFFFFFUL) == 0x80000002UL;
+    }
+
+    HKEY NewHandle(std::shared_ptr<details::Node> node, const REGSAM access)
+    {
+        HKEY handle = new HKEY__{std::move(node), access};
+        std::lock_guard<std::mutex> lock{m_handleMutex};
+        m_handles.insert(handle);
+        return handle;
+    }
+
+    bool CloseHandle(const HKEY hKey)
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_handleMutex};
+            if (m_handles.erase(hKey) == 0)
+                return false;
+        }
+        delete hKey;
+        return true;
+    }
+
+  private:
+    Registry()
+    {
+        for (auto &root : m_roots)
+            root = std::make_shared<details::Node>();
+        m_roots[4].reset(); // HKEY_PERFORMANCE_DATA
+        m_roots[6].reset(); // HKEY_DYN_DATA
+    }
+
+    mutable std::shared_mutex m_mutex;
+    std::array<std::shared_ptr<details::Node>, 8> m_roots;
+    mutable std::mutex m_handleMutex; // guards m_handles only
+    std::unordered_set<HKEY> m_handles;
+    std::atomic<long long> m_latencyUs{0};
+    std::array<std::atomic<unsigned long long>, static_cast<int>(Api::Count)> m_calls{};
+    std::atomic<ULONGLONG> m_clock{0};
+};
+
+namespace details
+{
+
+// Map generic rights to the specific registry rights
+inline REGSAM MapAccess(REGSAM access) noexcept
+{
+    if (access & GENERIC_READ)
+        access |= KEY_READ;
+    if (access & GENERIC_WRITE)
+        access |= KEY_WRITE;
+    if (access & (GENERIC_ALL | MAXIMUM_ALLOWED))
+        access |= KEY_ALL_ACCESS;
+    return access;
+}
+
+// Split a key path at backslashes, skipping empty components
+inline std::vector<std::wstring> SplitPath(const wchar_t *path)
+{
+    std::vector<std::wstring> parts;
+    if (path == nullptr)
+        return parts;
+
+    std::wstring curr;
+    for (const wchar_t *p = path; *p != L'\0'; ++p)
+    {
+        if (*p == L'\\')
+        {
+            if (!curr.empty())
+                parts.push_back(std::move(curr));
+            curr.clear();
+        }
+        else
+        {
+            curr.push_back(*p);
+        }
+    }
+    if (!curr.empty())
+        parts.push_back(std::move(curr));
+    return parts;
+}
+
+// The 32-bit view of HKLM\Software lives under HKLM\Software\WOW6432Node
+inline void ApplyWow64View(const HKEY hKey, const REGSAM access, std::vector<std::wstring> &parts)
+{
+    static const std::wstring kSoftware = L"Software";
+    static const std::wstring kWow64Node = L"WOW6432Node";
+    if ((access & KEY_WOW64_32KEY) && Registry::Instance().IsLocalMachine(hKey) && !parts.empty() &&
+        NameEquals(kSoftware, parts[0].c_str(), parts[0].size()) &&
+        (parts.size() < 2 || !NameEquals(kWow64Node, parts[1].c_str(), parts[1].size())))
+    {
+        parts.insert(parts.begin() + 1, kWow64Node);
+    }
+}
+
+inline std::shared_ptr<Node> FindChild(const Node &node, const std::wstring &name)
+{
+    const auto it = node.children.find(name);
+    return it != node.children.end() ? it->second : nullptr;
+}
+
+inline std::shared_ptr<Node> AddChild(Node &node, const std::wstring &name, const ULONGLONG now)
+{
+    auto child = std::make_shared<Node>();
+    child->name = name;
+    child->parent = &node;
+    child->lastWriteTime = now;
+    node.children.emplace(name, child);
+    node.orderValid = false;
+    node.lastWriteTime = now;
+    return child;
+}
+
+inline void RemoveChild(Node &node, const std::wstring &name, const ULONGLONG now)
+{
+    const auto it = node.children.find(name);
+    if (it != node.children.end())
+    {
+        it->second->MarkDeleted();
+        node.children.erase(it);
+        node.orderValid = false;
+        node.lastWriteTime = now;
+    }
+}
+
+inline bool IsStringType(const DWORD type) noexcept
+{
+    return type == REG_SZ || type == REG_EXPAND_SZ || type == REG_MULTI_SZ;
+}
+
+inline DWORD TypeFlag(const DWORD type) noexcept
+{
+    switch (type)
+    {
+    case REG_NONE:
+        return RRF_RT_REG_NONE;
+    case REG_SZ:
+        return RRF_RT_REG_SZ;
+    case REG_EXPAND_SZ:
+        return RRF_RT_REG_EXPAND_SZ;
+    case REG_BINARY:
+        return RRF_RT_REG_BINARY;
+    case REG_DWORD:
+        return RRF_RT_REG_DWORD;
+    case REG_MULTI_SZ:
+        return RRF_RT_REG_MULTI_SZ;
+    case REG_QWORD:
+        return RRF_RT_REG_QWORD;
+    default:
+        return 0;
+    }
+}
+
+// Expand %NAME% references from the process environment
+inline std::vector<BYTE> ExpandEnvironment(const std::vector<BYTE> &data)
+{
+    const auto *chars = reinterpret_cast<const wchar_t *>(data.data());
+    std::wstring in{chars, data.size() / sizeof(wchar_t)};
+    while (!in.empty() && in.back() == L'\0')
+        in.pop_back();
+
+    std::wstring out;
+    for (std::size_t i = 0; i < in.size(); ++i)
+    {
+        const std::size_t end = in[i] == L'%' ? in.find(L'%', i + 1) : std::wstring::npos;
+        if (end == std::wstring::npos)
+        {
+            out.push_back(in[i]);
+            continue;
+        }
+
+        const std::string name(in.begin() + i + 1, in.begin() + end);
+        const char *value = std::getenv(name.c_str());
+        if (value != nullptr)
+            out.append(value, value + std::strlen(value));
+        else
+            out.append(in, i, end - i + 1);
+        i = end;
+    }
+    out.push_back(L'\0');
+
+    const auto *bytes = reinterpret_cast<const BYTE *>(out.data());
+    return std::vector<BYTE>(bytes, bytes + out.size() * sizeof(wchar_t));
+}
+
+// Make sure string data is NUL-terminated (double-NUL for multi-strings)
+inline void TerminateString(const DWORD type, std::vector<BYTE> &data)
+{
+    data.resize(data.size() - data.size() % sizeof(wchar_t));
+    const std::size_t needed = type == REG_MULTI_SZ ? 2 : 1;
+    const auto endsWithNul = [&](const std::size_t n) {
+        if (data.size() < n * sizeof(wchar_t))
+            return false;
+        for (std::size_t i = data.size() - n * sizeof(wchar_t); i < data.size(); ++i)
+        {
+            if (data[i] != 0)
+                return false;
+        }
+        return true;
+    };
+
+    while (!endsWithNul(needed))
+        data.resize(data.size() + sizeof(wchar_t), 0);
+}
+
+// Copy data to a caller buffer with the usual size protocol
+inline LONG CopyOut(const std::vector<BYTE> &data, void *const buffer, DWORD *const bufferSize)
+{
+    if (bufferSize == nullptr)
+        return buffer == nullptr ? ERROR_SUCCESS : ERROR_INVALID_PARAMETER;
+
+    const auto required = static_cast<DWORD>(data.size());
+    if (buffer == nullptr)
+    {
+        *bufferSize = required;
+        return ERROR_SUCCESS;
+    }
+    if (*bufferSize < required)
+    {
+        *bufferSize = required;
+        return ERROR_MORE_DATA;
+    }
+    if (required > 0)
+        std::memcpy(buffer, data.data(), required);
+    *bufferSize = required;
+    return ERROR_SUCCESS;
+}
+
+// Copy a name to a caller buffer, sized in characters including the NUL
+inline LONG CopyName(const std::wstring &name, wchar_t *const buffer, DWORD *const bufferLen)
+{
+    if (buffer == nullptr || bufferLen == nullptr)
+        return ERROR_INVALID_PARAMETER;
+    if (*bufferLen < name.size() + 1)
+        return ERROR_MORE_DATA;
+    std::memcpy(buffer, name.c_str(), (name.size() + 1) * sizeof(wchar_t));
+    *bufferLen = static_cast<DWORD>(name.size());
+    return ERROR_SUCCESS;
+}
+
+} // namespace details
+} // namespace memreg
+
+//------------------------------------------------------------------------------
+//                  Registry API functions over the stand-in
+//------------------------------------------------------------------------------
+
+inline LONG RegCreateKeyExW(
+    const HKEY hKey, LPCWSTR lpSubKey, DWORD /*Reserved*/, LPWSTR /*lpClass*/, DWORD /*dwOptions*/,
+    const REGSAM samDesired, SECURITY_ATTRIBUTES * /*lpSecurityAttributes*/,
+    const PHKEY phkResult, const LPDWORD lpdwDisposition)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegCreateKeyEx);
+    if (phkResult == nullptr)
+        return ERROR_INVALID_PARAMETER;
+
+    std::unique_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM parentAccess = 0;
+    LONG status = registry.Resolve(hKey, node, parentAccess);
+    if (status != ERROR_SUCCESS)
+        return status;
+
+    auto parts = details::SplitPath(lpSubKey);
+    details::ApplyWow64View(hKey, samDesired, parts);
+
+    DWORD disposition = REG_OPENED_EXISTING_KEY;
+    for (const auto &part : parts)
+    {
+        auto child = details::FindChild(*node, part);
+        if (!child)
+        {
+            if (!registry.IsPredefined(hKey) && node == hKey->node && !(parentAccess & KEY_CREATE_SUB_KEY))
+                return ERROR_ACCESS_DENIED;
+            child = details::AddChild(*node, part, registry.Now());
+            disposition = REG_CREATED_NEW_KEY;
+        }
+        node = std::move(child);
+    }
+
+    *phkResult = registry.NewHandle(std::move(node), details::MapAccess(samDesired));
+    if (lpdwDisposition != nullptr)
+        *lpdwDisposition = disposition;
+    return ERROR_SUCCESS;
+}
+
+inline LONG RegOpenKeyExW(
+    const HKEY hKey, LPCWSTR lpSubKey, DWORD /*ulOptions*/, const REGSAM samDesired, const PHKEY phkResult)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegOpenKeyEx);
+    if (phkResult == nullptr)
+        return ERROR_INVALID_PARAMETER;
+
+    std::shared_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM parentAccess = 0;
+    LONG status = registry.Resolve(hKey, node, parentAccess);
+    if (status != ERROR_SUCCESS)
+        return status;
+
+    auto parts = details::SplitPath(lpSubKey);
+    // Like Windows, opening "" under a predefined key returns the same handle
+    if (parts.empty() && registry.IsPredefined(hKey))
+    {
+        *phkResult = hKey;
+        return ERROR_SUCCESS;
+    }
+
+    details::ApplyWow64View(hKey, samDesired, parts);
+    for (const auto &part : parts)
+    {
+        node = details::FindChild(*node, part);
+        if (!node)
+            return ERROR_FILE_NOT_FOUND;
+    }
+
+    *phkResult = registry.NewHandle(std::move(node), details::MapAccess(samDesired));
+    return ERROR_SUCCESS;
+}
+
+inline LONG RegCloseKey(const HKEY hKey)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegCloseKey);
+    if (registry.IsPredefined(hKey))
+        return ERROR_SUCCESS;
+
+    return registry.CloseHandle(hKey) ? ERROR_SUCCESS : ERROR_INVALID_HANDLE;
+}
+
+inline LONG RegSetValueExW(
+    const HKEY hKey, LPCWSTR lpValueName, DWORD /*Reserved*/, const DWORD dwType,
+    const BYTE *const lpData, const DWORD cbData)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegSetValueEx);
+    if (lpData == nullptr && cbData != 0)
+        return ERROR_INVALID_PARAMETER;
+
+    std::unique_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    LONG status = registry.Resolve(hKey, node, access);
+    if (status != ERROR_SUCCESS)
+        return status;
+    if (!(access & KEY_SET_VALUE))
+        return ERROR_ACCESS_DENIED;
+
+    details::Value *value = node->FindValue(lpValueName);
+    if (value == nullptr)
+    {
+        node->values.push_back(details::Value{lpValueName != nullptr ? lpValueName : L"", REG_NONE, {}});
+        value = &node->values.back();
+    }
+    value->type = dwType;
+    value->data.assign(lpData, lpData + cbData);
+    node->lastWriteTime = registry.Now();
+    return ERROR_SUCCESS;
+}
+
+inline LONG RegQueryValueExW(
+    const HKEY hKey, LPCWSTR lpValueName, const LPDWORD lpReserved, const LPDWORD lpType,
+    const LPBYTE lpData, const LPDWORD lpcbData)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegQueryValueEx);
+    if (lpReserved != nullptr || (lpData != nullptr && lpcbData == nullptr))
+        return ERROR_INVALID_PARAMETER;
+
+    std::shared_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    LONG status = registry.Resolve(hKey, node, access);
+    if (status != ERROR_SUCCESS)
+        return status;
+    if (!(access & KEY_QUERY_VALUE))
+        return ERROR_ACCESS_DENIED;
+
+    const details::Value *value = node->FindValue(lpValueName);
+    if (value == nullptr)
+        return ERROR_FILE_NOT_FOUND;
+
+    if (lpType != nullptr)
+        *lpType = value->type;
+    return details::CopyOut(value->data, lpData, lpcbData);
+}
+
+inline LONG RegGetValueW(
+    const HKEY hKey, LPCWSTR lpSubKey, LPCWSTR lpValue, const DWORD dwFlags,
+    const LPDWORD pdwType, const PVOID pvData, const LPDWORD pcbData)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegGetValue);
+    if ((dwFlags & RRF_RT_ANY) == 0 || (pvData != nullptr && pcbData == nullptr))
+        return ERROR_INVALID_PARAMETER;
+
+    std::shared_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    LONG status = registry.Resolve(hKey, node, access);
+    if (status != ERROR_SUCCESS)
+        return status;
+
+    for (const auto &part : details::SplitPath(lpSubKey))
+    {
+        node = details::FindChild(*node, part);
+        if (!node)
+            return ERROR_FILE_NOT_FOUND;
+    }
+    if (!(access & KEY_QUERY_VALUE))
+        return ERROR_ACCESS_DENIED;
+
+    const details::Value *value = node->FindValue(lpValue);
+    if (value == nullptr)
+        return ERROR_FILE_NOT_FOUND;
+
+    DWORD type = value->type;
+    std::vector<BYTE> data = value->data;
+    lock.unlock();
+
+    if (type == REG_EXPAND_SZ && !(dwFlags & RRF_NOEXPAND))
+    {
+        data = details::ExpandEnvironment(data);
+        type = REG_SZ;
+    }
+
+    if (!(dwFlags & details::TypeFlag(type)))
+        return ERROR_UNSUPPORTED_TYPE;
+    if (((dwFlags & RRF_RT_ANY) == RRF_RT_REG_DWORD && data.size() != sizeof(DWORD)) ||
+        ((dwFlags & RRF_RT_ANY) == RRF_RT_REG_QWORD && data.size() != sizeof(ULONGLONG)))
+        return ERROR_DATATYPE_MISMATCH;
+
+    if (details::IsStringType(type))
+        details::TerminateString(type, data);
+
+    if (pdwType != nullptr)
+        *pdwType = type;
+    return details::CopyOut(data, pvData, pcbData);
+}
+
+inline LONG RegQueryInfoKeyW(
+    const HKEY hKey, LPWSTR lpClass, const LPDWORD lpcchClass, const LPDWORD lpReserved,
+    const LPDWORD lpcSubKeys, const LPDWORD lpcbMaxSubKeyLen, const LPDWORD lpcbMaxClassLen,
+    const LPDWORD lpcValues, const LPDWORD lpcbMaxValueNameLen, const LPDWORD lpcbMaxValueLen,
+    const LPDWORD lpcbSecurityDescriptor, FILETIME *const lpftLastWriteTime)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegQueryInfoKey);
+    if (lpReserved != nullptr)
+        return ERROR_INVALID_PARAMETER;
+
+    std::shared_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    LONG status = registry.Resolve(hKey, node, access);
+    if (status != ERROR_SUCCESS)
+        return status;
+    if (!(access & KEY_QUERY_VALUE))
+        return ERROR_ACCESS_DENIED;
+
+    if (lpClass != nullptr && lpcchClass != nullptr && *lpcchClass > 0)
+        lpClass[0] = L'\0';
+    if (lpcchClass != nullptr)
+        *lpcchClass = 0;
+    if (lpcSubKeys != nullptr)
+        *lpcSubKeys = static_cast<DWORD>(node->children.size());
+    if (lpcbMaxSubKeyLen != nullptr)
+    {
+        std::size_t maxLen = 0;
+        for (const auto &child : node->children)
+            maxLen = std::max(maxLen, child.first.size());
+        *lpcbMaxSubKeyLen = static_cast<DWORD>(maxLen);
+    }
+    if (lpcbMaxClassLen != nullptr)
+        *lpcbMaxClassLen = 0;
+    if (lpcValues != nullptr)
+        *lpcValues = static_cast<DWORD>(node->values.size());
+    if (lpcbMaxValueNameLen != nullptr || lpcbMaxValueLen != nullptr)
+    {
+        std::size_t maxNameLen = 0;
+        std::size_t maxDataLen = 0;
+        for (const auto &value : node->values)
+        {
+            maxNameLen = std::max(maxNameLen, value.name.size());
+            maxDataLen = std::max(maxDataLen, value.data.size());
+        }
+        if (lpcbMaxValueNameLen != nullptr)
+            *lpcbMaxValueNameLen = static_cast<DWORD>(maxNameLen);
+        if (lpcbMaxValueLen != nullptr)
+            *lpcbMaxValueLen = static_cast<DWORD>(maxDataLen);
+    }
+    if (lpcbSecurityDescriptor != nullptr)
+        *lpcbSecurityDescriptor = 0;
+    if (lpftLastWriteTime != nullptr)
+    {
+        lpftLastWriteTime->dwLowDateTime = static_cast<DWORD>(node->lastWriteTime);
+        lpftLastWriteTime->dwHighDateTime = static_cast<DWORD>(node->lastWriteTime >> 32);
+    }
+    return ERROR_SUCCESS;
+}
+
+inline LONG RegEnumKeyExW(
+    const HKEY hKey, const DWORD dwIndex, LPWSTR lpName, const LPDWORD lpcchName, const LPDWORD lpReserved,
+    LPWSTR lpClass, const LPDWORD lpcchClass, FILETIME *const lpftLastWriteTime)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegEnumKeyEx);
+    if (lpReserved != nullptr)
+        return ERROR_INVALID_PARAMETER;
+
+    std::shared_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    LONG status = registry.Resolve(hKey, node, access);
+    if (status != ERROR_SUCCESS)
+        return status;
+    if (!(access & KEY_ENUMERATE_SUB_KEYS))
+        return ERROR_ACCESS_DENIED;
+
+    const details::Node *child = node->ChildAt(dwIndex);
+    if (child == nullptr)
+        return ERROR_NO_MORE_ITEMS;
+
+    status = details::CopyName(child->name, lpName, lpcchName);
+    if (status != ERROR_SUCCESS)
+        return status;
+
+    if (lpClass != nullptr && lpcchClass != nullptr && *lpcchClass > 0)
+        lpClass[0] = L'\0';
+    if (lpcchClass != nullptr)
+        *lpcchClass = 0;
+    if (lpftLastWriteTime != nullptr)
+    {
+        lpftLastWriteTime->dwLowDateTime = static_cast<DWORD>(child->lastWriteTime);
+        lpftLastWriteTime->dwHighDateTime = static_cast<DWORD>(child->lastWriteTime >> 32);
+    }
+    return ERROR_SUCCESS;
+}
+
+inline LONG RegEnumValueW(
+    const HKEY hKey, const DWORD dwIndex, LPWSTR lpValueName, const LPDWORD lpcchValueName,
+    const LPDWORD lpReserved, const LPDWORD lpType, const LPBYTE lpData, const LPDWORD lpcbData)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegEnumValue);
+    if (lpReserved != nullptr)
+        return ERROR_INVALID_PARAMETER;
+
+    std::shared_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    LONG status = registry.Resolve(hKey, node, access);
+    if (status != ERROR_SUCCESS)
+        return status;
+    if (!(access & KEY_QUERY_VALUE))
+        return ERROR_ACCESS_DENIED;
+    if (dwIndex >= node->values.size())
+        return ERROR_NO_MORE_ITEMS;
+
+    const details::Value &value = node->values[dwIndex];
+    status = details::CopyName(value.name, lpValueName, lpcchValueName);
+    if (status != ERROR_SUCCESS)
+        return status;
+
+    if (lpType != nullptr)
+        *lpType = value.type;
+    return details::CopyOut(value.data, lpData, lpcbData);
+}
+
+inline LONG RegDeleteValueW(const HKEY hKey, LPCWSTR lpValueName)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegDeleteValue);
+
+    std::unique_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    LONG status = registry.Resolve(hKey, node, access);
+    if (status != ERROR_SUCCESS)
+        return status;
+    if (!(access & KEY_SET_VALUE))
+        return ERROR_ACCESS_DENIED;
+
+    const details::Value *value = node->FindValue(lpValueName);
+    if (value == nullptr)
+        return ERROR_FILE_NOT_FOUND;
+
+    node->values.erase(node->values.begin() + (value - node->values.data()));
+    node->lastWriteTime = registry.Now();
+    return ERROR_SUCCESS;
+}
+
+inline LONG RegDeleteKeyExW(const HKEY hKey, LPCWSTR lpSubKey, const REGSAM samDesired, DWORD /*Reserved*/)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegDeleteKeyEx);
+
+    std::unique_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    LONG status = registry.Resolve(hKey, node, access);
+    if (status != ERROR_SUCCESS)
+        return status;
+
+    auto parts = details::SplitPath(lpSubKey);
+    details::ApplyWow64View(hKey, samDesired, parts);
+    if (parts.empty())
+        return ERROR_INVALID_PARAMETER;
+
+    for (const auto &part : parts)
+    {
+        node = details::FindChild(*node, part);
+        if (!node)
+            return ERROR_FILE_NOT_FOUND;
+    }
+    if (!node->children.empty())
+        return ERROR_ACCESS_DENIED;
+
+    details::RemoveChild(*node->parent, node->name, registry.Now());
+    return ERROR_SUCCESS;
+}
+
+inline LONG RegDeleteTreeW(const HKEY hKey, LPCWSTR lpSubKey)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    registry.Enter(Api::RegDeleteTree);
+
+    std::unique_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    LONG status = registry.Resolve(hKey, node, access);
+    if (status != ERROR_SUCCESS)
+        return status;
+
+    const auto parts = details::SplitPath(lpSubKey);
+    for (const auto &part : parts)
+    {
+        node = details::FindChild(*node, part);
+        if (!node)
+            return ERROR_FILE_NOT_FOUND;
+    }
+
+    const ULONGLONG now = registry.Now();
+    if (parts.empty())
+    {
+        // Delete the values and subkeys of the key itself
+        for (auto &child : node->children)
+            child.second->MarkDeleted();
+        node->children.clear();
+        node->orderValid = false;
+        node->values.clear();
+        node->lastWriteTime = now;
+    }
+    else
+    {
+        details::RemoveChild(*node->parent, node->name, now);
+    }
+    return ERROR_SUCCESS;
+}
+
+inline LONG RegFlushKey(const HKEY hKey)
+{
+    using namespace memreg;
+    auto &registry = Registry::Instance();
+    std::shared_lock<std::shared_mutex> lock{registry.Mutex()};
+    std::shared_ptr<details::Node> node;
+    REGSAM access = 0;
+    return registry.Resolve(hKey, node, access);
+}
+
+// Hive files, reflection and remote registries are not emulated
+
+inline LONG RegLoadKeyW(HKEY, LPCWSTR, LPCWSTR)
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+inline LONG RegSaveKeyW(HKEY, LPCWSTR, SECURITY_ATTRIBUTES *)
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+inline LONG RegEnableReflectionKey(HKEY)
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+inline LONG RegDisableReflectionKey(HKEY)
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+inline LONG RegQueryReflectionKey(HKEY, BOOL *isReflectionDisabled)
+{
+    *isReflectionDisabled = TRUE;
+    return ERROR_SUCCESS;
+}
+
+inline LONG RegConnectRegistryW(LPCWSTR, HKEY, PHKEY)
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+#endif // INCLUDE_WINREG_MEMREG_HPP
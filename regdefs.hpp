@@ -0,0 +1,106 @@
+#ifndef INCLUDE_WINREG_REGDEFS_HPP
+#define INCLUDE_WINREG_REGDEFS_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Registry types, constants and the RegException class shared by the live
+// registry wrapper (winreg.hpp) and the portable offline engines (regf.hpp).
+//
+// On Windows this simply pulls in the Platform SDK. Elsewhere it provides
+// the small subset of the Windows types and constants those modules need,
+// with the same names and values, so the portable code reads exactly like
+// the Windows code.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+#include <Windows.h> // Windows Platform SDK
+#else
+#include <cstdint>   // std::uint32_t, ...
+#endif
+
+#include <stdexcept> // std::runtime_error
+#include <string>    // std::string
+
+#ifndef _WIN32
+
+typedef std::uint8_t BYTE;
+typedef std::uint16_t WORD;
+typedef std::uint32_t DWORD;
+typedef std::int32_t LONG;
+typedef std::uint64_t ULONGLONG;
+
+struct FILETIME
+{
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+};
+
+//
+// Registry value types
+//
+#define REG_NONE 0
+#define REG_SZ 1
+#define REG_EXPAND_SZ 2
+#define REG_BINARY 3
+#define REG_DWORD 4
+#define REG_DWORD_BIG_ENDIAN 5
+#define REG_LINK 6
+#define REG_MULTI_SZ 7
+#define REG_RESOURCE_LIST 8
+#define REG_FULL_RESOURCE_DESCRIPTOR 9
+#define REG_RESOURCE_REQUIREMENTS_LIST 10
+#define REG_QWORD 11
+
+//
+// Error codes used by the registry APIs
+//
+#define ERROR_SUCCESS 0
+#define ERROR_FILE_NOT_FOUND 2
+#define ERROR_ACCESS_DENIED 5
+#define ERROR_INVALID_HANDLE 6
+#define ERROR_INVALID_DATA 13
+#define ERROR_OUTOFMEMORY 14
+#define ERROR_NOT_SUPPORTED 50
+#define ERROR_INVALID_PARAMETER 87
+#define ERROR_MORE_DATA 234
+#define ERROR_NO_MORE_ITEMS 259
+#define ERROR_BADDB 1009
+#define ERROR_BADKEY 1010
+#define ERROR_REGISTRY_CORRUPT 1015
+#define ERROR_KEY_DELETED 1018
+#define ERROR_UNSUPPORTED_TYPE 1630
+
+#endif // _WIN32
+
+namespace winreg
+{
+
+//------------------------------------------------------------------------------
+// An exception representing an error with the registry operations
+//------------------------------------------------------------------------------
+class RegException
+    : public std::runtime_error
+{
+  public:
+    RegException(const std::string &message, LONG errorCode)
+        : std::runtime_error(""), m_message(message + " code=" + std::to_string(errorCode)), m_errorCode{errorCode}
+    {
+    }
+
+    // Get the error code returned by Windows registry APIs
+    LONG ErrorCode() const noexcept
+    {
+        return m_errorCode;
+    }
+
+    virtual const char* what() const noexcept { return m_message.c_str(); }
+  private:
+    std::string m_message;
+    // Error code, as returned by Windows registry APIs
+    LONG m_errorCode;
+};
+
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_REGDEFS_HPP
@@ -0,0 +1,639 @@
+#ifndef INCLUDE_WINREG_REGEXPORT_HPP
+#define INCLUDE_WINREG_REGEXPORT_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Streaming export of registry subtrees as .reg files, in the format written
+// by regedit and reg.exe export ("Windows Registry Editor Version 5.00",
+// UTF-16LE with a BOM, CRLF line ends).
+//
+// RegFileWriter formats keys and values into a fixed-size buffer and hands
+// it to a sink whenever it fills up. RegExporter walks a live key (through
+// winreg::RegKey) or a key of an offline hive (regf::RegKey) one key at a
+// time, depth first, keeping only the open keys of the current path and a
+// page of subkey names per level: memory doesn't grow with the tree.
+//
+// Values are written like regedit does:
+//   REG_SZ                 "name"="data" (hex(1): if it can't be quoted)
+//   REG_DWORD              "name"=dword:0000002a
+//   REG_BINARY             "name"=hex:01,02,...
+//   anything else          "name"=hex(<type>):... of the raw data, e.g.
+//                          hex(2): REG_EXPAND_SZ, hex(7): REG_MULTI_SZ,
+//                          hex(b): REG_QWORD
+// Hex data is wrapped at 80 columns with "\" continuation lines indented by
+// two spaces; the default value is written as @.
+//
+// Errors are signaled throwing RegException, like in winreg.hpp. Subkeys
+// that disappear or can't be opened during the export are skipped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "regf.hpp" // regf::RegKey
+#include "winreg.hpp"
+
+#include <cstdint>    // std::uint32_t
+#include <cstdio>     // std::snprintf
+#include <cwctype>    // std::towupper
+#include <functional> // std::function
+#include <memory>     // std::unique_ptr
+#include <string>     // std::wstring
+#include <string_view> // std::wstring_view
+#include <type_traits> // std::is_same_v
+#include <utility>    // std::move
+#include <variant>    // std::visit
+#include <vector>     // std::vector
+
+namespace winreg
+{
+
+//------------------------------------------------------------------------------
+// Formats a .reg file into a bounded buffer, flushed through a sink
+//------------------------------------------------------------------------------
+class RegFileWriter
+{
+  public:
+    // Receives the file a chunk at a time
+    using Sink = std::function<void(const BYTE *data, size_t size)>;
+
+    static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+    // Start the file (BOM and version line)
+    explicit RegFileWriter(Sink sink, size_t bufferSize = kDefaultBufferSize);
+
+    // Start a key, given by its full path (e.g. HKEY_CURRENT_USER\Software)
+    void Key(const std::wstring &path);
+
+    // Write a value of the current key
+    void Value(const RegValue &value);
+
+    // Write a value from its raw data (strings in UTF-16LE)
+    void Value(const std::wstring &name, DWORD type, const BYTE *data, size_t size);
+
+    // End the file and flush it to the sink
+    void Finish();
+
+  private:
+    void Unit(char16_t c);
+    void Ascii(const char *s);
+    void Text(const std::wstring &s, bool escape);
+    void Newline();
+    void Hex(DWORD type, const BYTE *data, size_t size);
+    void Flush();
+
+    Sink m_sink;
+    std::vector<BYTE> m_buffer;
+    size_t m_capacity;
+
+    // UTF-16 units written on the current line
+    size_t m_column{0};
+
+    // Raw form of decoded values
+    std::vector<BYTE> m_raw;
+};
+
+// Name of a predefined key, as used in .reg files (e.g. HKEY_LOCAL_MACHINE);
+// empty for other keys
+std::wstring PredefinedKeyName(HKEY hKey);
+
+// The predefined key of a name as used in .reg files, also accepting the
+// HKLM-style abbreviations, in any case; nullptr for other names
+HKEY PredefinedKeyFromName(std::wstring_view name);
+
+namespace details
+{
+class ExportWalker;
+}
+
+//------------------------------------------------------------------------------
+// Exports a subtree a key at a time
+//------------------------------------------------------------------------------
+class RegExporter
+{
+  public:
+    // Export a live key; rootPath is the path written for it, e.g.
+    // HKEY_CURRENT_USER\Software\MyApp. Throw RegException if the key can't
+    // be opened.
+    RegExporter(HKEY hKeyParent, const std::wstring &subKey, std::wstring rootPath, REGSAM access = KEY_READ);
+
+    // Export a key of an offline hive
+    RegExporter(const regf::RegKey &key, std::wstring rootPath);
+
+    RegExporter(RegExporter &&) noexcept;
+    RegExporter &operator=(RegExporter &&) noexcept;
+    ~RegExporter();
+
+    // Write the next key with its values; false when there are no more
+    bool Next(RegFileWriter &writer);
+
+  private:
+    std::unique_ptr<details::ExportWalker> m_walker;
+};
+
+// Export a whole subtree through the sink
+void ExportReg(HKEY hKeyParent, const std::wstring &subKey, const std::wstring &rootPath, RegFileWriter::Sink sink);
+void ExportReg(const regf::RegKey &key, const std::wstring &rootPath, RegFileWriter::Sink sink);
+
+namespace details
+{
+
+// Hex data lines are broken once they reach this many characters
+constexpr size_t kRegFileHexColumns = 77;
+
+// Subkey names read at a time from a live key
+constexpr DWORD kExportPageSize = 256;
+
+inline void AppendUtf16(std::vector<BYTE> &out, const wchar_t *s, const size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const wchar_t c = s[i];
+        auto cp = static_cast<std::uint32_t>(c);
+        if (cp > 0xFFFF)
+        {
+            cp -= 0x10000;
+            const std::uint32_t high = 0xD800 + (cp >> 10);
+            out.push_back(static_cast<BYTE>(high));
+            out.push_back(static_cast<BYTE>(high >> 8));
+            cp = 0xDC00 + (cp & 0x3FF);
+        }
+        out.push_back(static_cast<BYTE>(cp));
+        out.push_back(static_cast<BYTE>(cp >> 8));
+    }
+}
+
+inline void AppendUtf16(std::vector<BYTE> &out, const std::wstring &s)
+{
+    AppendUtf16(out, s.data(), s.size());
+}
+
+// Can REG_SZ data be written as a quoted string and read back the same?
+// It must be whole UTF-16 units, without line breaks, and only NUL-terminated.
+inline bool IsQuotableString(const BYTE *data, const size_t size) noexcept
+{
+    if (size % 2 != 0)
+        return false;
+    for (size_t i = 0; i < size; i += 2)
+    {
+        const char16_t c = static_cast<char16_t>(data[i] | (data[i + 1] << 8));
+        if (c == u'\r' || c == u'\n' || (c == u'\0' && i + 2 != size))
+            return false;
+    }
+    return true;
+}
+
+class ExportWalker
+{
+  public:
+    virtual ~ExportWalker() = default;
+    virtual bool Next(RegFileWriter &writer) = 0;
+};
+
+// Depth-first walk over a stack of open keys. Source provides the key type,
+// its per-level subkey enumeration state, and how to read them.
+template <typename Source>
+class ExportWalkerOf : public ExportWalker
+{
+  public:
+    using Key = typename Source::Key;
+
+    ExportWalkerOf(Source source, Key root, std::wstring rootPath)
+        : m_source{std::move(source)}, m_root{std::move(root)}, m_path{std::move(rootPath)}
+    {
+    }
+
+    bool Next(RegFileWriter &writer) override
+    {
+        if (!m_started)
+        {
+            m_started = true;
+            Visit(std::move(m_root), writer);
+            return true;
+        }
+
+        while (!m_stack.empty())
+        {
+            Frame &top = m_stack.back();
+            std::wstring name;
+            if (!m_source.NextSubKey(top.key, top.subKeys, name))
+            {
+                m_stack.pop_back();
+                continue;
+            }
+
+            Key subKey;
+            if (!m_source.Open(top.key, name, subKey))
+                continue;
+            m_path.resize(top.pathLength);
+            m_path += L'\\';
+            m_path += name;
+            Visit(std::move(subKey), writer);
+            return true;
+        }
+        return false;
+    }
+
+  private:
+    struct Frame
+    {
+        Key key;
+        size_t pathLength;
+        typename Source::SubKeys subKeys;
+    };
+
+    void Visit(Key key, RegFileWriter &writer)
+    {
+        writer.Key(m_path);
+        m_source.WriteValues(key, writer);
+        m_stack.push_back(Frame{std::move(key), m_path.size(), {}});
+    }
+
+    Source m_source;
+    Key m_root;
+    std::wstring m_path;
+    std::vector<Frame> m_stack;
+    bool m_started{false};
+};
+
+struct LiveExportSource
+{
+    using Key = RegKey;
+
+    struct SubKeys
+    {
+        NameList names;
+        DWORD start{0};
+        size_t next{0};
+        bool last{false};
+    };
+
+    REGSAM access;
+
+    // The data as stored, like regedit writes it (decoding would drop what
+    // follows an embedded NUL); strings only need converting to UTF-16LE
+    // where wchar_t is wider
+    void WriteValues(RegKey &key, RegFileWriter &writer) const
+    {
+        std::vector<BYTE> utf16;
+        key.ForEachRawValue([&](const std::wstring &name, DWORD type, const BYTE *data, DWORD size) {
+            if (sizeof(wchar_t) != 2 && (type == REG_SZ || type == REG_EXPAND_SZ || type == REG_MULTI_SZ))
+            {
+                utf16.clear();
+                details::AppendUtf16(utf16, reinterpret_cast<const wchar_t *>(data), size / sizeof(wchar_t));
+                writer.Value(name, type, utf16.data(), utf16.size());
+            }
+            else
+            {
+                writer.Value(name, type, data, size);
+            }
+        });
+    }
+
+    bool NextSubKey(RegKey &key, SubKeys &subKeys, std::wstring &name) const
+    {
+        if (subKeys.next == subKeys.names.size())
+        {
+            if (subKeys.last)
+                return false;
+            subKeys.start += static_cast<DWORD>(subKeys.names.size());
+            key.EnumSubKeys(subKeys.start, kExportPageSize, subKeys.names);
+            subKeys.next = 0;
+            subKeys.last = subKeys.names.size() < kExportPageSize;
+            if (subKeys.names.empty())
+                return false;
+        }
+        name.assign(subKeys.names[subKeys.next++].name);
+        return true;
+    }
+
+    bool Open(RegKey &parent, const std::wstring &name, RegKey &subKey) const
+    {
+        const RegResult opened = subKey.TryOpen(parent.Get(), name, access);
+        if (opened.Failed())
+        {
+            // Deleted meanwhile, or not readable by us
+            const LONG code = opened.Code();
+            if (code == ERROR_FILE_NOT_FOUND || code == ERROR_ACCESS_DENIED || code == ERROR_KEY_DELETED)
+                return false;
+            opened.ThrowIfFailed();
+        }
+        return true;
+    }
+};
+
+struct HiveExportSource
+{
+    using Key = regf::RegKey;
+
+    struct SubKeys
+    {
+        std::vector<std::wstring> names;
+        size_t next{0};
+        bool read{false};
+    };
+
+    void WriteValues(const regf::RegKey &key, RegFileWriter &writer) const
+    {
+        key.ForEachRawValue([&writer](const std::wstring &name, DWORD type, const BYTE *data, DWORD size) {
+            writer.Value(name, type, data, size);
+        });
+    }
+
+    bool NextSubKey(const regf::RegKey &key, SubKeys &subKeys, std::wstring &name) const
+    {
+        if (!subKeys.read)
+        {
+            subKeys.names = key.EnumSubKeys();
+            subKeys.read = true;
+        }
+        if (subKeys.next == subKeys.names.size())
+            return false;
+        name = std::move(subKeys.names[subKeys.next++]);
+        return true;
+    }
+
+    bool Open(const regf::RegKey &parent, const std::wstring &name, regf::RegKey &subKey) const
+    {
+        subKey.Open(parent, name);
+        return true;
+    }
+};
+
+} // namespace details
+
+inline RegFileWriter::RegFileWriter(Sink sink, const size_t bufferSize)
+    : m_sink{std::move(sink)}, m_capacity{bufferSize < 16 ? 16 : bufferSize}
+{
+    m_buffer.reserve(m_capacity);
+    Unit(u'\xFEFF');
+    Ascii("Windows Registry Editor Version 5.00");
+    Newline();
+}
+
+inline void RegFileWriter::Key(const std::wstring &path)
+{
+    Newline();
+    Unit(u'[');
+    Text(path, false);
+    Unit(u']');
+    Newline();
+}
+
+inline void RegFileWriter::Value(const RegValue &value)
+{
+    m_raw.clear();
+    std::visit(
+        [this](const auto &v) {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, DWORD> || std::is_same_v<T, ULONGLONG>)
+            {
+                for (size_t i = 0; i < sizeof(T); i++)
+                    m_raw.push_back(static_cast<BYTE>(v >> (8 * i)));
+            }
+            else if constexpr (std::is_same_v<T, std::wstring>)
+            {
+                details::AppendUtf16(m_raw, v);
+                m_raw.insert(m_raw.end(), 2, 0);
+            }
+            else if constexpr (std::is_same_v<T, std::vector<std::wstring>>)
+            {
+                for (const auto &s : v)
+                {
+                    details::AppendUtf16(m_raw, s);
+                    m_raw.insert(m_raw.end(), 2, 0);
+                }
+                m_raw.insert(m_raw.end(), 2, 0);
+            }
+            else
+            {
+                m_raw = v;
+            }
+        },
+        value.data);
+    Value(value.name, value.type, m_raw.data(), m_raw.size());
+}
+
+inline void RegFileWriter::Value(const std::wstring &name, const DWORD type, const BYTE *const data, const size_t size)
+{
+    if (name.empty())
+    {
+        Unit(u'@');
+    }
+    else
+    {
+        Unit(u'"');
+        Text(name, true);
+        Unit(u'"');
+    }
+    Unit(u'=');
+
+    if (type == REG_SZ && details::IsQuotableString(data, size))
+    {
+        Unit(u'"');
+        for (size_t i = 0; i + 1 < size; i += 2)
+        {
+            const char16_t c = static_cast<char16_t>(data[i] | (data[i + 1] << 8));
+            if (c == u'\0')
+                break;
+            if (c == u'\\' || c == u'"')
+                Unit(u'\\');
+            Unit(c);
+        }
+        Unit(u'"');
+    }
+    else if (type == REG_DWORD && size == sizeof(DWORD))
+    {
+        char text[16];
+        const DWORD n = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<DWORD>(data[3]) << 24);
+        std::snprintf(text, sizeof(text), "dword:%08lx", static_cast<unsigned long>(n));
+        Ascii(text);
+    }
+    else
+    {
+        Hex(type, data, size);
+    }
+    Newline();
+}
+
+inline void RegFileWriter::Finish()
+{
+    Newline();
+    Flush();
+}
+
+inline void RegFileWriter::Unit(const char16_t c)
+{
+    if (m_buffer.size() + 2 > m_capacity)
+        Flush();
+    m_buffer.push_back(static_cast<BYTE>(c));
+    m_buffer.push_back(static_cast<BYTE>(c >> 8));
+    m_column++;
+}
+
+inline void RegFileWriter::Ascii(const char *s)
+{
+    for (; *s != '\0'; s++)
+        Unit(static_cast<char16_t>(*s));
+}
+
+inline void RegFileWriter::Text(const std::wstring &s, const bool escape)
+{
+    for (const wchar_t c : s)
+    {
+        auto cp = static_cast<std::uint32_t>(c);
+        if (escape && (c == L'\\' || c == L'"'))
+            Unit(u'\\');
+        if (cp > 0xFFFF)
+        {
+            cp -= 0x10000;
+            Unit(static_cast<char16_t>(0xD800 + (cp >> 10)));
+            cp = 0xDC00 + (cp & 0x3FF);
+        }
+        Unit(static_cast<char16_t>(cp));
+    }
+}
+
+inline void RegFileWriter::Newline()
+{
+    Unit(u'\r');
+    Unit(u'\n');
+    m_column = 0;
+}
+
+inline void RegFileWriter::Hex(const DWORD type, const BYTE *const data, const size_t size)
+{
+    char text[16];
+    if (type == REG_BINARY)
+        Ascii("hex:");
+    else
+    {
+        std::snprintf(text, sizeof(text), "hex(%lx):", static_cast<unsigned long>(type));
+        Ascii(text);
+    }
+
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < size; i++)
+    {
+        Unit(static_cast<char16_t>(digits[data[i] >> 4]));
+        Unit(static_cast<char16_t>(digits[data[i] & 15]));
+        if (i + 1 == size)
+            break;
+        Unit(u',');
+        if (m_column >= details::kRegFileHexColumns)
+        {
+            Unit(u'\\');
+            Newline();
+            Ascii("  ");
+        }
+    }
+}
+
+inline void RegFileWriter::Flush()
+{
+    if (!m_buffer.empty())
+    {
+        m_sink(m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+    }
+}
+
+inline std::wstring PredefinedKeyName(const HKEY hKey)
+{
+    if (hKey == HKEY_CLASSES_ROOT)
+        return L"HKEY_CLASSES_ROOT";
+    if (hKey == HKEY_CURRENT_USER)
+        return L"HKEY_CURRENT_USER";
+    if (hKey == HKEY_LOCAL_MACHINE)
+        return L"HKEY_LOCAL_MACHINE";
+    if (hKey == HKEY_USERS)
+        return L"HKEY_USERS";
+    if (hKey == HKEY_CURRENT_CONFIG)
+        return L"HKEY_CURRENT_CONFIG";
+    return std::wstring{};
+}
+
+inline HKEY PredefinedKeyFromName(const std::wstring_view name)
+{
+    static const struct
+    {
+        const wchar_t *name;
+        const wchar_t *abbreviation;
+        HKEY hKey;
+    } keys[] = {
+        {L"HKEY_CLASSES_ROOT", L"HKCR", HKEY_CLASSES_ROOT},
+        {L"HKEY_CURRENT_USER", L"HKCU", HKEY_CURRENT_USER},
+        {L"HKEY_LOCAL_MACHINE", L"HKLM", HKEY_LOCAL_MACHINE},
+        {L"HKEY_USERS", L"HKU", HKEY_USERS},
+        {L"HKEY_CURRENT_CONFIG", L"HKCC", HKEY_CURRENT_CONFIG},
+    };
+
+    const auto equal = [name](const wchar_t *s) {
+        for (const wchar_t c : name)
+        {
+            if (*s == L'\0' || std::towupper(static_cast<wint_t>(c)) != static_cast<wint_t>(*s))
+                return false;
+            s++;
+        }
+        return *s == L'\0';
+    };
+    for (const auto &key : keys)
+    {
+        if (equal(key.name) || equal(key.abbreviation))
+            return key.hKey;
+    }
+    return nullptr;
+}
+
+inline RegExporter::RegExporter(
+    const HKEY hKeyParent,
+    const std::wstring &subKey,
+    std::wstring rootPath,
+    const REGSAM access)
+{
+    RegKey root;
+    root.Open(hKeyParent, subKey, access);
+    m_walker = std::make_unique<details::ExportWalkerOf<details::LiveExportSource>>(
+        details::LiveExportSource{access}, std::move(root), std::move(rootPath));
+}
+
+inline RegExporter::RegExporter(const regf::RegKey &key, std::wstring rootPath)
+    : m_walker{std::make_unique<details::ExportWalkerOf<details::HiveExportSource>>(
+          details::HiveExportSource{}, key, std::move(rootPath))}
+{
+}
+
+inline RegExporter::RegExporter(RegExporter &&) noexcept = default;
+inline RegExporter &RegExporter::operator=(RegExporter &&) noexcept = default;
+inline RegExporter::~RegExporter() = default;
+
+inline bool RegExporter::Next(RegFileWriter &writer)
+{
+    return m_walker->Next(writer);
+}
+
+inline void ExportReg(
+    const HKEY hKeyParent,
+    const std::wstring &subKey,
+    const std::wstring &rootPath,
+    RegFileWriter::Sink sink)
+{
+    RegExporter exporter{hKeyParent, subKey, rootPath};
+    RegFileWriter writer{std::move(sink)};
+    while (exporter.Next(writer))
+    {
+    }
+    writer.Finish();
+}
+
+inline void ExportReg(const regf::RegKey &key, const std::wstring &rootPath, RegFileWriter::Sink sink)
+{
+    RegExporter exporter{key, rootPath};
+    RegFileWriter writer{std::move(sink)};
+    while (exporter.Next(writer))
+    {
+    }
+    writer.Finish();
+}
+
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_REGEXPORT_HPP
@@ -0,0 +1,1335 @@
+#ifndef INCLUDE_WINREG_REGF_HPP
+#define INCLUDE_WINREG_REGF_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//      *** Portable read-only access to offline registry hive files ***
+//
+// A hive file ("regf" format, as written by RegSaveKey or found under
+// %SystemRoot%\System32\config) is memory-mapped and its cells are walked
+// in place: opening a key or enumerating a subkey list never copies names
+// or data to the heap. Heap copies are made only for what the caller
+// actually reads (value data, enumerated names).
+//
+// A dirty hive (copied from a live or crashed system) can be opened with
+// its transaction logs (.LOG1, .LOG2): the pages they rewrite are overlaid
+// on the mapped file, read in place from the mapped logs.
+//
+// regf::RegKey mirrors the read side of winreg::RegKey (Open, EnumSubKeys,
+// EnumValues, Get*Value, QueryInfoKey, QueryValueType), so code written
+// against one is easy to point at the other.
+//
+// Errors are signaled throwing winreg::RegException, with the same error
+// codes the live registry would use (e.g. ERROR_FILE_NOT_FOUND for a
+// missing key or value, ERROR_REGISTRY_CORRUPT for malformed cells).
+//
+// This module has no dependency on the Windows registry APIs and builds on
+// any platform.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mappedfile.hpp" // winreg::MappedFile
+#include "regdefs.hpp"    // DWORD, FILETIME, REG_*, RegException
+
+#include <algorithm>  // std::min, std::sort, std::lower_bound
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uintptr_t
+#include <cstring>    // std::memcmp
+#include <filesystem> // std::filesystem::path
+#include <iterator>   // std::prev, std::begin, std::end
+#include <map>        // std::map
+#include <memory>     // std::shared_ptr, std::unique_ptr
+#include <string>     // std::wstring
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+
+namespace regf
+{
+
+using winreg::RegException;
+
+class RegKey;
+class PathIndex;
+
+namespace details
+{
+
+// Offset of the first hive bin: the base block is always 4 KB
+constexpr std::size_t kBaseBlockSize = 4096;
+
+// Hive bins are multiples of 4 KB pages; transaction logs rewrite whole pages
+constexpr std::size_t kPageSize = 4096;
+
+// Transaction logs (new format, written since Windows 8.1) start with a copy
+// of the first sector of the base block, followed by log entries
+constexpr std::size_t kLogBaseBlockSize = 512;
+constexpr std::size_t kLogEntryHeaderSize = 40;
+constexpr DWORD kFileTypeLog = 6;
+
+// Maximum data stored in a single cell; larger values use big data (db) cells
+constexpr DWORD kBigDataSegmentSize = 16344;
+
+// nk cell flags
+constexpr WORD kKeyCompressedName = 0x0020;
+
+// vk cell flags
+constexpr WORD kValueCompressedName = 0x0001;
+
+// Hive cells are little-endian; read them without alignment assumptions
+inline WORD ReadU16(const BYTE *p) noexcept
+{
+    return static_cast<WORD>(p[0] | (p[1] << 8));
+}
+
+inline DWORD ReadU32(const BYTE *p) noexcept
+{
+    return static_cast<DWORD>(p[0]) | (static_cast<DWORD>(p[1]) << 8) |
+           (static_cast<DWORD>(p[2]) << 16) | (static_cast<DWORD>(p[3]) << 24);
+}
+
+inline ULONGLONG ReadU64(const BYTE *p) noexcept
+{
+    return static_cast<ULONGLONG>(ReadU32(p)) | (static_cast<ULONGLONG>(ReadU32(p + 4)) << 32);
+}
+
+// Checksum of a base block: the XOR of its first 127 DWORDs, never 0 or -1
+inline DWORD BaseBlockChecksum(const BYTE *block) noexcept
+{
+    DWORD checksum = 0;
+    for (std::size_t i = 0; i < 508; i += 4)
+        checksum ^= ReadU32(block + i);
+    if (checksum == 0xFFFFFFFF)
+        return 0xFFFFFFFE;
+    if (checksum == 0)
+        return 1;
+    return checksum;
+}
+
+// Marvin32, the hash protecting transaction log entries
+inline ULONGLONG Marvin32(const BYTE *data, std::size_t size, const ULONGLONG seed = 0x82EF4D887A4E55C5) noexcept
+{
+    DWORD lo = static_cast<DWORD>(seed);
+    DWORD hi = static_cast<DWORD>(seed >> 32);
+    const auto rotl = [](const DWORD x, const int n) { return (x << n) | (x >> (32 - n)); };
+    const auto block = [&] {
+        hi ^= lo;
+        lo = rotl(lo, 20);
+        lo += hi;
+        hi = rotl(hi, 9);
+        hi ^= lo;
+        lo = rotl(lo, 27);
+        lo += hi;
+        hi = rotl(hi, 19);
+    };
+
+    for (; size >= 4; data += 4, size -= 4)
+    {
+        lo += ReadU32(data);
+        block();
+    }
+    DWORD last = 0x80;
+    for (std::size_t i = size; i-- > 0;)
+        last = (last << 8) | data[i];
+    lo += last;
+    block();
+    block();
+    return static_cast<ULONGLONG>(lo) | (static_cast<ULONGLONG>(hi) << 32);
+}
+
+inline bool HasSignature(const BYTE *p, const char (&signature)[3]) noexcept
+{
+    return p[0] == static_cast<BYTE>(signature[0]) && p[1] == static_cast<BYTE>(signature[1]);
+}
+
+// Upper-case mappings of the Basic Multilingual Plane, as runs of code
+// units that all map by the same delta (stride 1) or every other one of
+// which does (stride 2, the alternating upper/lower case pairs).
+// These are the Unicode simple upper-case mappings, less those Windows
+// doesn't apply to registry names: non-ASCII letters to ASCII (U+0131,
+// U+017F), the micro sign, and Georgian Mkhedruli to Mtavruli.
+struct UpcaseRun
+{
+    char16_t first;
+    char16_t last;
+    int delta;
+    int stride;
+};
+
+constexpr UpcaseRun kUpcaseRuns[] = {
+    {0x0061, 0x007A, -32, 1}, {0x00E0, 0x00F6, -32, 1}, {0x00F8, 0x00FE, -32, 1}, {0x00FF, 0x00FF, 121, 1},
+    {0x0101, 0x012F, -1, 2}, {0x0133, 0x0137, -1, 2}, {0x013A, 0x0148, -1, 2}, {0x014B, 0x0177, -1, 2},
+    {0x017A, 0x017E, -1, 2}, {0x0180, 0x0180, 195, 1}, {0x0183, 0x0185, -1, 2}, {0x0188, 0x0188, -1, 1},
+    {0x018C, 0x018C, -1, 1}, {0x0192, 0x0192, -1, 1}, {0x0195, 0x0195, 97, 1}, {0x0199, 0x0199, -1, 1},
+    {0x019A, 0x019A, 163, 1}, {0x019E, 0x019E, 130, 1}, {0x01A1, 0x01A5, -1, 2}, {0x01A8, 0x01A8, -1, 1},
+    {0x01AD, 0x01AD, -1, 1}, {0x01B0, 0x01B0, -1, 1}, {0x01B4, 0x01B6, -1, 2}, {0x01B9, 0x01B9, -1, 1},
+    {0x01BD, 0x01BD, -1, 1}, {0x01BF, 0x01BF, 56, 1}, {0x01C5, 0x01C5, -1, 1}, {0x01C6, 0x01C6, -2, 1},
+    {0x01C8, 0x01C8, -1, 1}, {0x01C9, 0x01C9, -2, 1}, {0x01CB, 0x01CB, -1, 1}, {0x01CC, 0x01CC, -2, 1},
+    {0x01CE, 0x01DC, -1, 2}, {0x01DD, 0x01DD, -79, 1}, {0x01DF, 0x01EF, -1, 2}, {0x01F2, 0x01F2, -1, 1},
+    {0x01F3, 0x01F3, -2, 1}, {0x01F5, 0x01F5, -1, 1}, {0x01F9, 0x021F, -1, 2}, {0x0223, 0x0233, -1, 2},
+    {0x023C, 0x023C, -1, 1}, {0x023F, 0x0240, 10815, 1}, {0x0242, 0x0242, -1, 1}, {0x0247, 0x024F, -1, 2},
+    {0x0250, 0x0250, 10783, 1}, {0x0251, 0x0251, 10780, 1}, {0x0252, 0x0252, 10782, 1},
+    {0x0253, 0x0253, -210, 1}, {0x0254, 0x0254, -206, 1}, {0x0256, 0x0257, -205, 1}, {0x0259, 0x0259, -202, 1},
+    {0x025B, 0x025B, -203, 1}, {0x025C, 0x025C, 42319, 1}, {0x0260, 0x0260, -205, 1},
+    {0x0261, 0x0261, 42315, 1}, {0x0263, 0x0263, -207, 1}, {0x0265, 0x0265, 42280, 1},
+    {0x0266, 0x0266, 42308, 1}, {0x0268, 0x0268, -209, 1}, {0x0269, 0x0269, -211, 1},
+    {0x026A, 0x026A, 42308, 1}, {0x026B, 0x026B, 10743, 1}, {0x026C, 0x026C, 42305, 1},
+    {0x026F, 0x026F, -211, 1}, {0x0271, 0x0271, 10749, 1}, {0x0272, 0x0272, -213, 1},
+    {0x0275, 0x0275, -214, 1}, {0x027D, 0x027D, 10727, 1}, {0x0280, 0x0280, -218, 1},
+    {0x0282, 0x0282, 42307, 1}, {0x0283, 0x0283, -218, 1}, {0x0287, 0x0287, 42282, 1},
+    {0x0288, 0x0288, -218, 1}, {0x0289, 0x0289, -69, 1}, {0x028A, 0x028B, -217, 1}, {0x028C, 0x028C, -71, 1},
+    {0x0292, 0x0292, -219, 1}, {0x029D, 0x029D, 42261, 1}, {0x029E, 0x029E, 42258, 1}, {0x0345, 0x0345, 84, 1},
+    {0x0371, 0x0373, -1, 2}, {0x0377, 0x0377, -1, 1}, {0x037B, 0x037D, 130, 1}, {0x03AC, 0x03AC, -38, 1},
+    {0x03AD, 0x03AF, -37, 1}, {0x03B1, 0x03C1, -32, 1}, {0x03C2, 0x03C2, -31, 1}, {0x03C3, 0x03CB, -32, 1},
+    {0x03CC, 0x03CC, -64, 1}, {0x03CD, 0x03CE, -63, 1}, {0x03D0, 0x03D0, -62, 1}, {0x03D1, 0x03D1, -57, 1},
+    {0x03D5, 0x03D5, -47, 1}, {0x03D6, 0x03D6, -54, 1}, {0x03D7, 0x03D7, -8, 1}, {0x03D9, 0x03EF, -1, 2},
+    {0x03F0, 0x03F0, -86, 1}, {0x03F1, 0x03F1, -80, 1}, {0x03F2, 0x03F2, 7, 1}, {0x03F3, 0x03F3, -116, 1},
+    {0x03F5, 0x03F5, -96, 1}, {0x03F8, 0x03F8, -1, 1}, {0x03FB, 0x03FB, -1, 1}, {0x0430, 0x044F, -32, 1},
+    {0x0450, 0x045F, -80, 1}, {0x0461, 0x0481, -1, 2}, {0x048B, 0x04BF, -1, 2}, {0x04C2, 0x04CE, -1, 2},
+    {0x04CF, 0x04CF, -15, 1}, {0x04D1, 0x052F, -1, 2}, {0x0561, 0x0586, -48, 1}, {0x13F8, 0x13FD, -8, 1},
+    {0x1C80, 0x1C80, -6254, 1}, {0x1C81, 0x1C81, -6253, 1}, {0x1C82, 0x1C82, -6244, 1},
+    {0x1C83, 0x1C84, -6242, 1}, {0x1C85, 0x1C85, -6243, 1}, {0x1C86, 0x1C86, -6236, 1},
+    {0x1C87, 0x1C87, -6181, 1}, {0x1C88, 0x1C88, 35266, 1}, {0x1D79, 0x1D79, 35332, 1},
+    {0x1D7D, 0x1D7D, 3814, 1}, {0x1D8E, 0x1D8E, 35384, 1}, {0x1E01, 0x1E95, -1, 2}, {0x1E9B, 0x1E9B, -59, 1},
+    {0x1EA1, 0x1EFF, -1, 2}, {0x1F00, 0x1F07, 8, 1}, {0x1F10, 0x1F15, 8, 1}, {0x1F20, 0x1F27, 8, 1},
+    {0x1F30, 0x1F37, 8, 1}, {0x1F40, 0x1F45, 8, 1}, {0x1F51, 0x1F57, 8, 2}, {0x1F60, 0x1F67, 8, 1},
+    {0x1F70, 0x1F71, 74, 1}, {0x1F72, 0x1F75, 86, 1}, {0x1F76, 0x1F77, 100, 1}, {0x1F78, 0x1F79, 128, 1},
+    {0x1F7A, 0x1F7B, 112, 1}, {0x1F7C, 0x1F7D, 126, 1}, {0x1FB0, 0x1FB1, 8, 1}, {0x1FBE, 0x1FBE, -7205, 1},
+    {0x1FD0, 0x1FD1, 8, 1}, {0x1FE0, 0x1FE1, 8, 1}, {0x1FE5, 0x1FE5, 7, 1}, {0x214E, 0x214E, -28, 1},
+    {0x2170, 0x217F, -16, 1}, {0x2184, 0x2184, -1, 1}, {0x24D0, 0x24E9, -26, 1}, {0x2C30, 0x2C5F, -48, 1},
+    {0x2C61, 0x2C61, -1, 1}, {0x2C65, 0x2C65, -10795, 1}, {0x2C66, 0x2C66, -10792, 1}, {0x2C68, 0x2C6C, -1, 2},
+    {0x2C73, 0x2C73, -1, 1}, {0x2C76, 0x2C76, -1, 1}, {0x2C81, 0x2CE3, -1, 2}, {0x2CEC, 0x2CEE, -1, 2},
+    {0x2CF3, 0x2CF3, -1, 1}, {0x2D00, 0x2D25, -7264, 1}, {0x2D27, 0x2D27, -7264, 1},
+    {0x2D2D, 0x2D2D, -7264, 1}, {0xA641, 0xA66D, -1, 2}, {0xA681, 0xA69B, -1, 2}, {0xA723, 0xA72F, -1, 2},
+    {0xA733, 0xA76F, -1, 2}, {0xA77A, 0xA77C, -1, 2}, {0xA77F, 0xA787, -1, 2}, {0xA78C, 0xA78C, -1, 1},
+    {0xA791, 0xA793, -1, 2}, {0xA794, 0xA794, 48, 1}, {0xA797, 0xA7A9, -1, 2}, {0xA7B5, 0xA7C3, -1, 2},
+    {0xA7C8, 0xA7CA, -1, 2}, {0xA7D1, 0xA7D1, -1, 1}, {0xA7D7, 0xA7D9, -1, 2}, {0xA7F6, 0xA7F6, -1, 1},
+    {0xAB53, 0xAB53, -928, 1}, {0xAB70, 0xABBF, -38864, 1}, {0xFF41, 0xFF5A, -32, 1},
+};
+
+// Upper-case a UTF-16 code unit the way hive name comparisons need it:
+// subkey lists are sorted, and their hashes computed, on upper-cased names.
+// Surrogates and code units without a mapping compare exactly.
+inline char16_t UpcaseChar(const char16_t c) noexcept
+{
+    if (c < u'a')
+        return c;
+    if (c <= u'z')
+        return static_cast<char16_t>(c - 0x20);
+    if (c < 0xE0)
+        return c;
+    if (c <= 0xFE)
+        return c == 0xF7 ? c : static_cast<char16_t>(c - 0x20);
+
+    const UpcaseRun *run = std::lower_bound(std::begin(kUpcaseRuns), std::end(kUpcaseRuns), c,
+                                            [](const UpcaseRun &r, const char16_t unit) { return r.last < unit; });
+    if (run == std::end(kUpcaseRuns) || c < run->first || (c - run->first) % run->stride != 0)
+        return c;
+    return static_cast<char16_t>(c + run->delta);
+}
+
+// Produce the UTF-16 code units of a wide string one by one.
+// wchar_t is UTF-16 on Windows and UTF-32 elsewhere.
+class Utf16Reader
+{
+  public:
+    Utf16Reader(const wchar_t *first, const wchar_t *last) noexcept
+        : m_curr{first}, m_last{last}
+    {
+    }
+
+    bool Next(char16_t &unit) noexcept
+    {
+        if (m_pending != 0)
+        {
+            unit = m_pending;
+            m_pending = 0;
+            return true;
+        }
+        if (m_curr == m_last)
+        {
+            return false;
+        }
+
+        const auto c = static_cast<unsigned long>(*m_curr++);
+        if (sizeof(wchar_t) > 2 && c > 0xFFFF)
+        {
+            unit = static_cast<char16_t>(0xD800 + ((c - 0x10000) >> 10));
+            m_pending = static_cast<char16_t>(0xDC00 + ((c - 0x10000) & 0x3FF));
+        }
+        else
+        {
+            unit = static_cast<char16_t>(c);
+        }
+        return true;
+    }
+
+  private:
+    const wchar_t *m_curr;
+    const wchar_t *m_last;
+    char16_t m_pending{0};
+};
+
+// Case-insensitive three-way comparison of a wide string with a name stored
+// in the hive, either as Latin-1 ("compressed") or as UTF-16LE.
+inline int CompareName(
+    const wchar_t *name, const std::size_t nameLen,
+    const BYTE *stored, const std::size_t storedBytes, const bool compressed) noexcept
+{
+    Utf16Reader reader{name, name + nameLen};
+    const std::size_t storedLen = compressed ? storedBytes : storedBytes / 2;
+
+    for (std::size_t i = 0;; ++i)
+    {
+        char16_t a{};
+        const bool hasA = reader.Next(a);
+        const bool hasB = i < storedLen;
+        if (!hasA || !hasB)
+        {
+            return hasA ? 1 : (hasB ? -1 : 0);
+        }
+
+        const char16_t b = compressed ? static_cast<char16_t>(stored[i]) : static_cast<char16_t>(ReadU16(stored + 2 * i));
+        const char16_t ua = UpcaseChar(a);
+        const char16_t ub = UpcaseChar(b);
+        if (ua != ub)
+        {
+            return ua < ub ? -1 : 1;
+        }
+    }
+}
+
+// Append UTF-16LE code units to a wide string
+inline void AppendUtf16(std::wstring &out, const BYTE *data, const std::size_t count)
+{
+    out.reserve(out.size() + count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const char16_t c = static_cast<char16_t>(ReadU16(data + 2 * i));
+        if (sizeof(wchar_t) > 2 && c >= 0xD800 && c <= 0xDBFF && i + 1 < count)
+        {
+            const char16_t low = static_cast<char16_t>(ReadU16(data + 2 * (i + 1)));
+            if (low >= 0xDC00 && low <= 0xDFFF)
+            {
+                out.push_back(static_cast<wchar_t>(0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00)));
+                ++i;
+                continue;
+            }
+        }
+        out.push_back(static_cast<wchar_t>(c));
+    }
+}
+
+// Decode a key or value name stored in the hive
+inline std::wstring DecodeName(const BYTE *stored, const std::size_t storedBytes, const bool compressed)
+{
+    std::wstring name;
+    if (compressed)
+    {
+        name.assign(stored, stored + storedBytes);
+    }
+    else
+    {
+        AppendUtf16(name, stored, storedBytes / 2);
+    }
+    return name;
+}
+
+// Raw value data as found in the hive.
+// 'data' points either into the mapping or into the caller's scratch buffer
+// (for big data values, whose segments must be joined).
+struct ValueView
+{
+    DWORD type{REG_NONE};
+    const BYTE *data{nullptr};
+    DWORD size{0};
+};
+
+} // namespace details
+
+//------------------------------------------------------------------------------
+// A memory-mapped hive file.
+//
+// Hive objects are always held by std::shared_ptr: every RegKey opened from
+// a hive keeps it (and its mapping) alive.
+//------------------------------------------------------------------------------
+class Hive
+    : public std::enable_shared_from_this<Hive>
+{
+  public:
+    // Marks "no cell" in offset fields
+    static constexpr DWORD kNoCell = 0xFFFFFFFF;
+
+    // Map a hive file read-only.
+    // Throw RegException on failure or if the file is not a valid hive.
+    static std::shared_ptr<Hive> Open(const std::filesystem::path &path);
+
+    // Map a hive file and replay its transaction logs over it: the log
+    // entries that continue the file (from its secondary sequence number on),
+    // from all the logs, in sequence order. Stale, empty or damaged logs and
+    // entries are ignored; without an entry to replay the hive is left as it
+    // is (and IsDirty() tells whether the logs were needed).
+    // The file is not copied: the pages the logs rewrite are read in place
+    // from the mapped logs, and only a hive bin spread over the file and the
+    // logs is copied to be contiguous.
+    // Throw RegException on failure, ERROR_NOT_SUPPORTED for logs in the
+    // format older than Windows 8.1.
+    static std::shared_ptr<Hive> Open(const std::filesystem::path &path,
+                                      const std::vector<std::filesystem::path> &logs);
+
+    // Use a hive image already in memory.
+    // The caller must keep the memory alive as long as the hive and its keys.
+    static std::shared_ptr<Hive> FromMemory(const void *data, std::size_t size);
+
+    // Ban copy
+    Hive(const Hive &) = delete;
+    Hive &operator=(const Hive &) = delete;
+
+    // The root key of the hive
+    RegKey Root() const;
+
+    // Sequence numbers in the base block differ: the latest changes may live
+    // in the transaction logs.
+    bool IsDirty() const noexcept
+    {
+        return m_dirty;
+    }
+
+    // Number of transaction log entries replayed over the file
+    std::size_t LogEntriesReplayed() const noexcept
+    {
+        return m_logEntriesReplayed;
+    }
+
+    DWORD MinorVersion() const noexcept
+    {
+        return m_minorVersion;
+    }
+
+    // Primary sequence number of the base block; after a replay, the one
+    // following the last log entry replayed
+    DWORD SequenceNumber() const noexcept
+    {
+        return m_sequence;
+    }
+
+    // Time stamp of the base block: when the hive was last written
+    FILETIME LastWriteTime() const noexcept
+    {
+        return m_lastWriteTime;
+    }
+
+    // Return the payload of the cell at the given offset (relative to the
+    // first hive bin) and its size in bytes.
+    // Throw RegException if the offset or the cell size is out of bounds.
+    const BYTE *Cell(DWORD offset, DWORD &payloadSize) const;
+
+    // Same as above, also checking that the payload holds at least minSize bytes
+    const BYTE *CellAtLeast(DWORD offset, std::size_t minSize) const;
+
+  private:
+    Hive(winreg::MappedFile file, const BYTE *data, std::size_t size);
+
+    // Overlay the log entries that continue the file
+    void Replay(std::vector<winreg::MappedFile> logs);
+
+    // A hive bin of a replayed hive, contiguous in memory
+    struct BinView
+    {
+        const BYTE *data;
+        DWORD offset;
+        DWORD size;
+    };
+
+    winreg::MappedFile m_file;
+    const BYTE *m_bins{nullptr};
+    std::size_t m_binsSize{0};
+    DWORD m_rootCell{kNoCell};
+    DWORD m_minorVersion{0};
+    DWORD m_sequence{0};
+    FILETIME m_lastWriteTime{};
+    bool m_dirty{false};
+
+    // After a replay: the mapped logs, the bin of every page, and the bins
+    // copied because their pages come from different files
+    std::vector<winreg::MappedFile> m_logs;
+    std::vector<BinView> m_pageBins;
+    std::vector<std::unique_ptr<BYTE[]>> m_copiedBins;
+    std::size_t m_logEntriesReplayed{0};
+};
+
+//------------------------------------------------------------------------------
+// A key inside an offline hive.
+//
+// This is a lightweight view (hive reference + cell offset): it is copyable,
+// and opening or copying keys never allocates.
+//------------------------------------------------------------------------------
+class RegKey
+{
+  public:
+    // Initialize as an empty key
+    RegKey() noexcept = default;
+
+    // Is this a valid key?
+    bool IsValid() const noexcept
+    {
+        return m_hive != nullptr;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return IsValid();
+    }
+
+    // Reset to an empty key, releasing the reference to the hive
+    void Close() noexcept
+    {
+        m_hive.reset();
+        m_cell = Hive::kNoCell;
+    }
+
+    // Open the subkey path (components separated by backslashes) relative to
+    // the parent key. Names are compared case-insensitively.
+    // Throw RegException (ERROR_FILE_NOT_FOUND) if a component doesn't exist.
+    void Open(const RegKey &parent, const std::wstring &subKey);
+
+    //
+    // Registry Value Getters
+    //
+
+    DWORD GetDwordValue(const std::wstring &valueName) const;
+    ULONGLONG GetQwordValue(const std::wstring &valueName) const;
+    std::wstring GetStringValue(const std::wstring &valueName) const;
+
+    // Environment variables can't be expanded offline: the string is
+    // always returned as stored.
+    std::wstring GetExpandStringValue(const std::wstring &valueName) const;
+
+    std::vector<std::wstring> GetMultiStringValue(const std::wstring &valueName) const;
+    std::vector<BYTE> GetBinaryValue(const std::wstring &valueName) const;
+
+    //
+    // Query Operations
+    //
+
+    void QueryInfoKey(DWORD &subKeys, DWORD &values, FILETIME &lastWriteTime) const;
+
+    // Return the DWORD type ID for the input registry value,
+    // REG_NONE if the value doesn't exist
+    DWORD QueryValueType(const std::wstring &valueName) const;
+
+    // Enumerate the subkeys of the key
+    std::vector<std::wstring> EnumSubKeys() const;
+
+    // Enumerate the values under the key.
+    // Returns a vector of pairs: In each pair, the wstring is the value name,
+    // the DWORD is the value type.
+    std::vector<std::pair<std::wstring, DWORD>> EnumValues() const;
+
+    // Call f(name, type, data, size) for every value, in order, with its data
+    // as stored (strings in UTF-16LE); data is only valid during the call
+    template <typename F>
+    void ForEachRawValue(F &&f) const;
+
+    // Name of this key as stored in the hive
+    std::wstring GetName() const;
+
+    // Offset of the key's nk cell (relative to the first hive bin)
+    DWORD CellOffset() const noexcept
+    {
+        return m_cell;
+    }
+
+  private:
+    friend class Hive;
+    friend class PathIndex;
+
+    RegKey(std::shared_ptr<const Hive> hive, DWORD cell) noexcept
+        : m_hive{std::move(hive)}, m_cell{cell}
+    {
+    }
+
+    // The nk cell of this key (validated)
+    const BYTE *KeyCell() const;
+    static const BYTE *KeyCellAt(const Hive &hive, DWORD cell);
+
+    // Find a direct subkey by name, returning its nk offset or kNoCell
+    static DWORD FindSubKey(const Hive &hive, const BYTE *nk, const wchar_t *name, std::size_t nameLen);
+    static DWORD FindInList(const Hive &hive, DWORD listOffset, const wchar_t *name, std::size_t nameLen, int depth);
+
+    // Call f(nkOffset) for every subkey in the list, in order
+    template <typename F>
+    void ForEachInList(DWORD listOffset, F &&f, int depth = 0) const;
+
+    // Call f(vk) for every vk cell in the value list, in order;
+    // stop early when f returns true
+    template <typename F>
+    void ForEachValue(F &&f) const;
+
+    // Find a value by name, returning its vk cell or nullptr
+    const BYTE *FindValue(const std::wstring &valueName) const;
+
+    // Locate the data of a value; big data is joined into 'scratch'
+    details::ValueView ReadValue(const BYTE *vk, std::vector<BYTE> &scratch) const;
+
+    // Find the value or throw ERROR_FILE_NOT_FOUND; check its type
+    details::ValueView GetTypedValue(
+        const std::wstring &valueName, DWORD expectedType, DWORD altType,
+        std::vector<BYTE> &scratch, const char *what) const;
+
+    std::shared_ptr<const Hive> m_hive;
+    DWORD m_cell{Hive::kNoCell};
+};
+
+//------------------------------------------------------------------------------
+//                          Hive Inline Methods
+//------------------------------------------------------------------------------
+
+inline std::shared_ptr<Hive> Hive::Open(const std::filesystem::path &path)
+{
+    winreg::MappedFile file{path};
+    const BYTE *data = file.Data();
+    const std::size_t size = file.Size();
+    return std::shared_ptr<Hive>(new Hive(std::move(file), data, size));
+}
+
+inline std::shared_ptr<Hive> Hive::Open(const std::filesystem::path &path,
+                                        const std::vector<std::filesystem::path> &logs)
+{
+    auto hive = Open(path);
+    std::vector<winreg::MappedFile> mapped;
+    for (const auto &log : logs)
+        mapped.emplace_back(log);
+    hive->Replay(std::move(mapped));
+    return hive;
+}
+
+inline std::shared_ptr<Hive> Hive::FromMemory(const void *const data, const std::size_t size)
+{
+    return std::shared_ptr<Hive>(new Hive(winreg::MappedFile{}, static_cast<const BYTE *>(data), size));
+}
+
+inline Hive::Hive(winreg::MappedFile file, const BYTE *const data, const std::size_t size)
+    : m_file{std::move(file)}
+{
+    using namespace details;
+
+    if (size < kBaseBlockSize || std::memcmp(data, "regf", 4) != 0)
+    {
+        throw RegException{"Not a registry hive file: bad base block signature.", ERROR_BADDB};
+    }
+
+    const DWORD majorVersion = ReadU32(data + 20);
+    if (majorVersion != 1)
+    {
+        throw RegException{"Unsupported hive format version.", ERROR_BADDB};
+    }
+
+    m_dirty = ReadU32(data + 4) != ReadU32(data + 8);
+    m_minorVersion = ReadU32(data + 24);
+    m_sequence = ReadU32(data + 4);
+    m_lastWriteTime.dwLowDateTime = ReadU32(data + 12);
+    m_lastWriteTime.dwHighDateTime = ReadU32(data + 16);
+    m_rootCell = ReadU32(data + 36);
+
+    // Trust the hive bins data size only as far as the file actually goes
+    const std::size_t binsSize = ReadU32(data + 40);
+    m_bins = data + kBaseBlockSize;
+    m_binsSize = std::min(binsSize, size - kBaseBlockSize);
+
+    if (m_binsSize < 32 || std::memcmp(m_bins, "hbin", 4) != 0)
+    {
+        throw RegException{"Not a registry hive file: missing first hive bin.", ERROR_BADDB};
+    }
+}
+
+inline const BYTE *Hive::Cell(const DWORD offset, DWORD &payloadSize) const
+{
+    if (offset == kNoCell || static_cast<std::size_t>(offset) + 4 > m_binsSize)
+    {
+        throw RegException{"Hive is corrupt: cell offset out of bounds.", ERROR_REGISTRY_CORRUPT};
+    }
+
+    const BYTE *cell = m_bins + offset;
+    std::size_t end = m_binsSize;
+    if (!m_pageBins.empty())
+    {
+        // A replayed hive is contiguous only bin by bin
+        const BinView &bin = m_pageBins[offset / details::kPageSize];
+        cell = bin.data + (offset - bin.offset);
+        end = static_cast<std::size_t>(bin.offset) + bin.size;
+        if (static_cast<std::size_t>(offset) + 4 > end)
+        {
+            throw RegException{"Hive is corrupt: cell offset out of bounds.", ERROR_REGISTRY_CORRUPT};
+        }
+    }
+
+    // Allocated cells have a negative size; the size includes the size field
+    const auto cellSize = static_cast<LONG>(details::ReadU32(cell));
+    const std::size_t absSize = cellSize < 0 ? static_cast<std::size_t>(-static_cast<long long>(cellSize))
+                                             : static_cast<std::size_t>(cellSize);
+    if (absSize < 4 || offset + absSize > end)
+    {
+        throw RegException{"Hive is corrupt: cell size out of bounds.", ERROR_REGISTRY_CORRUPT};
+    }
+
+    payloadSize = static_cast<DWORD>(absSize - 4);
+    return cell + 4;
+}
+
+inline const BYTE *Hive::CellAtLeast(const DWORD offset, const std::size_t minSize) const
+{
+    DWORD payloadSize = 0;
+    const BYTE *payload = Cell(offset, payloadSize);
+    if (payloadSize < minSize)
+    {
+        throw RegException{"Hive is corrupt: cell too small.", ERROR_REGISTRY_CORRUPT};
+    }
+    return payload;
+}
+
+inline void Hive::Replay(std::vector<winreg::MappedFile> logs)
+{
+    using namespace details;
+
+    // The logs with a valid base block, oldest first: where two logs hold an
+    // entry with the same sequence number, the newer one wins
+    std::vector<const winreg::MappedFile *> order;
+    for (const auto &log : logs)
+    {
+        const BYTE *data = log.Data();
+        if (log.Size() < kLogBaseBlockSize || std::memcmp(data, "regf", 4) != 0 ||
+            ReadU32(data + 508) != BaseBlockChecksum(data))
+        {
+            continue;
+        }
+        if (ReadU32(data + 28) != kFileTypeLog)
+        {
+            throw RegException{"Unsupported transaction log format: only logs written since Windows 8.1 can be replayed.",
+                               ERROR_NOT_SUPPORTED};
+        }
+        order.push_back(&log);
+    }
+    std::sort(order.begin(), order.end(), [](const winreg::MappedFile *a, const winreg::MappedFile *b) {
+        return ReadU32(a->Data() + 4) < ReadU32(b->Data() + 4);
+    });
+
+    // The valid entries of each log, up to the first one damaged or out of
+    // sequence (a log is reused from its start, so the tail may be stale)
+    struct LogEntry
+    {
+        DWORD binsSize;
+        DWORD pageCount;
+        const BYTE *pageRefs;
+        const BYTE *pages;
+    };
+    std::map<DWORD, LogEntry> entries;
+    for (const winreg::MappedFile *log : order)
+    {
+        const BYTE *data = log->Data();
+        const std::size_t size = log->Size();
+        bool first = true;
+        DWORD previous = 0;
+        for (std::size_t pos = kLogBaseBlockSize; pos + kLogEntryHeaderSize <= size;)
+        {
+            const BYTE *entry = data + pos;
+            const DWORD entrySize = ReadU32(entry + 4);
+            if (std::memcmp(entry, "HvLE", 4) != 0 || entrySize < kLogEntryHeaderSize || entrySize % 512 != 0 ||
+                entrySize > size - pos)
+            {
+                break;
+            }
+            const DWORD sequence = ReadU32(entry + 12);
+            const DWORD binsSize = ReadU32(entry + 16);
+            const DWORD pageCount = ReadU32(entry + 20);
+            const std::size_t bodySize = entrySize - kLogEntryHeaderSize;
+            if ((!first && sequence != previous + 1) || pageCount > bodySize / 8 || binsSize % kPageSize != 0 ||
+                Marvin32(entry, 32) != ReadU64(entry + 32) ||
+                Marvin32(entry + kLogEntryHeaderSize, bodySize) != ReadU64(entry + 24))
+            {
+                break;
+            }
+
+            const BYTE *pageRefs = entry + kLogEntryHeaderSize;
+            std::size_t pagesSize = 0;
+            bool valid = true;
+            for (DWORD i = 0; i < pageCount && valid; i++)
+            {
+                const DWORD pageOffset = ReadU32(pageRefs + i * 8);
+                const DWORD pageSize = ReadU32(pageRefs + i * 8 + 4);
+                valid = pageOffset % kPageSize == 0 && pageSize % kPageSize == 0 &&
+                        static_cast<std::size_t>(pageOffset) + pageSize <= binsSize;
+                pagesSize += pageSize;
+            }
+            if (!valid || pagesSize > bodySize - pageCount * 8)
+                break;
+
+            entries[sequence] = LogEntry{binsSize, pageCount, pageRefs, pageRefs + pageCount * 8};
+            first = false;
+            previous = sequence;
+            pos += entrySize;
+        }
+    }
+
+    // The entries that continue the file, without a gap
+    const BYTE *base = m_bins - kBaseBlockSize;
+    std::vector<const LogEntry *> replay;
+    for (auto it = entries.find(ReadU32(base + 8)); it != entries.end(); ++it)
+    {
+        if (!replay.empty() && it->first != std::prev(it)->first + 1)
+            break;
+        replay.push_back(&it->second);
+    }
+    if (replay.empty())
+        return;
+
+    // Every page of the replayed hive, from the file or the last log entry
+    // rewriting it
+    const std::size_t binsSize = replay.back()->binsSize;
+    std::vector<const BYTE *> pages(binsSize / kPageSize, nullptr);
+    for (std::size_t i = 0; i < pages.size() && (i + 1) * kPageSize <= m_binsSize; i++)
+        pages[i] = m_bins + i * kPageSize;
+    for (const LogEntry *entry : replay)
+    {
+        const BYTE *page = entry->pages;
+        for (DWORD i = 0; i < entry->pageCount; i++)
+        {
+            const std::size_t first = ReadU32(entry->pageRefs + i * 8) / kPageSize;
+            const std::size_t count = ReadU32(entry->pageRefs + i * 8 + 4) / kPageSize;
+            // An earlier entry may rewrite pages the hive has since shrunk past
+            for (std::size_t j = first; j < first + count; j++, page += kPageSize)
+            {
+                if (j < pages.size())
+                    pages[j] = page;
+            }
+        }
+    }
+
+    // Walk the bins; a bin whose pages aren't contiguous in memory is copied
+    std::vector<BinView> pageBins(pages.size());
+    std::vector<std::unique_ptr<BYTE[]>> copiedBins;
+    for (std::size_t offset = 0; offset < binsSize;)
+    {
+        const std::size_t first = offset / kPageSize;
+        const BYTE *bin = pages[first];
+        const DWORD size = bin ? ReadU32(bin + 8) : 0;
+        if (!bin || std::memcmp(bin, "hbin", 4) != 0 || ReadU32(bin + 4) != offset || size == 0 ||
+            size % kPageSize != 0 || size > binsSize - offset)
+        {
+            throw RegException{"Hive is corrupt: bad hive bin after replaying the transaction logs.",
+                               ERROR_REGISTRY_CORRUPT};
+        }
+
+        const std::size_t count = size / kPageSize;
+        bool contiguous = true;
+        for (std::size_t i = 1; i < count && contiguous; i++)
+        {
+            contiguous = reinterpret_cast<std::uintptr_t>(pages[first + i]) ==
+                         reinterpret_cast<std::uintptr_t>(bin) + i * kPageSize;
+        }
+        if (!contiguous)
+        {
+            auto copy = std::make_unique<BYTE[]>(size);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (!pages[first + i])
+                {
+                    throw RegException{"Hive is corrupt: missing page after replaying the transaction logs.",
+                                       ERROR_REGISTRY_CORRUPT};
+                }
+                std::memcpy(copy.get() + i * kPageSize, pages[first + i], kPageSize);
+            }
+            bin = copy.get();
+            copiedBins.push_back(std::move(copy));
+        }
+        for (std::size_t i = 0; i < count; i++)
+            pageBins[first + i] = BinView{bin, static_cast<DWORD>(offset), size};
+        offset += size;
+    }
+
+    m_logs = std::move(logs);
+    m_pageBins = std::move(pageBins);
+    m_copiedBins = std::move(copiedBins);
+    m_binsSize = binsSize;
+    m_sequence = ReadU32(base + 8) + static_cast<DWORD>(replay.size());
+    m_dirty = false;
+    m_logEntriesReplayed = replay.size();
+}
+
+inline RegKey Hive::Root() const
+{
+    RegKey root{shared_from_this(), m_rootCell};
+
+    // Validate the root cell right away
+    root.KeyCell();
+    return root;
+}
+
+//------------------------------------------------------------------------------
+//                          RegKey Inline Methods
+//------------------------------------------------------------------------------
+
+inline const BYTE *RegKey::KeyCell() const
+{
+    if (!IsValid())
+    {
+        throw RegException{"Invalid hive key.", ERROR_INVALID_HANDLE};
+    }
+    return KeyCellAt(*m_hive, m_cell);
+}
+
+inline const BYTE *RegKey::KeyCellAt(const Hive &hive, const DWORD cell)
+{
+    DWORD size = 0;
+    const BYTE *nk = hive.Cell(cell, size);
+    if (size < 76 || !details::HasSignature(nk, "nk") || 76u + details::ReadU16(nk + 72) > size)
+    {
+        throw RegException{"Hive is corrupt: bad key node.", ERROR_REGISTRY_CORRUPT};
+    }
+    return nk;
+}
+
+template <typename F>
+inline void RegKey::ForEachInList(const DWORD listOffset, F &&f, const int depth) const
+{
+    using namespace details;
+
+    DWORD size = 0;
+    const BYTE *list = m_hive->Cell(listOffset, size);
+    if (size < 4)
+    {
+        throw RegException{"Hive is corrupt: bad subkey list.", ERROR_REGISTRY_CORRUPT};
+    }
+
+    const DWORD count = ReadU16(list + 2);
+    const bool isIndexRoot = HasSignature(list, "ri");
+    const DWORD stride = (isIndexRoot || HasSignature(list, "li")) ? 4 : 8;
+    if (!isIndexRoot && !HasSignature(list, "li") && !HasSignature(list, "lf") && !HasSignature(list, "lh"))
+    {
+        throw RegException{"Hive is corrupt: unknown subkey list type.", ERROR_REGISTRY_CORRUPT};
+    }
+    if (4 + count * stride > size || (isIndexRoot && depth > 0))
+    {
+        throw RegException{"Hive is corrupt: bad subkey list.", ERROR_REGISTRY_CORRUPT};
+    }
+
+    for (DWORD i = 0; i < count; ++i)
+    {
+        const DWORD offset = ReadU32(list + 4 + i * stride);
+        if (isIndexRoot)
+        {
+            ForEachInList(offset, f, depth + 1);
+        }
+        else
+        {
+            f(offset);
+        }
+    }
+}
+
+inline DWORD RegKey::FindInList(
+    const Hive &hive, const DWORD listOffset,
+    const wchar_t *const name, const std::size_t nameLen, const int depth)
+{
+    using namespace details;
+
+    DWORD size = 0;
+    const BYTE *list = hive.Cell(listOffset, size);
+    if (size < 4)
+    {
+        throw RegException{"Hive is corrupt: bad subkey list.", ERROR_REGISTRY_CORRUPT};
+    }
+
+    const DWORD count = ReadU16(list + 2);
+    const bool isIndexRoot = HasSignature(list, "ri");
+    const DWORD stride = (isIndexRoot || HasSignature(list, "li")) ? 4 : 8;
+    if (4 + count * stride > size || (isIndexRoot && depth > 0))
+    {
+        throw RegException{"Hive is corrupt: bad subkey list.", ERROR_REGISTRY_CORRUPT};
+    }
+
+    // Compare the name with the subkey at the given list entry
+    const auto compareAt = [&](const DWORD nkOffset) {
+        const BYTE *nk = KeyCellAt(hive, nkOffset);
+        return CompareName(name, nameLen, nk + 76, ReadU16(nk + 72), (ReadU16(nk + 2) & kKeyCompressedName) != 0);
+    };
+
+    if (isIndexRoot)
+    {
+        // Sublists are sorted too: the name can only be in the first
+        // sublist whose last entry is not smaller than the name
+        for (DWORD i = 0; i < count; ++i)
+        {
+            const DWORD subListOffset = ReadU32(list + 4 + i * 4);
+            const BYTE *subList = hive.CellAtLeast(subListOffset, 4);
+            const DWORD subCount = ReadU16(subList + 2);
+            if (subCount == 0)
+            {
+                continue;
+            }
+
+            const DWORD subStride = HasSignature(subList, "li") ? 4 : 8;
+            const BYTE *last = hive.CellAtLeast(subListOffset, 4 + subCount * subStride) + 4 + (subCount - 1) * subStride;
+            if (compareAt(ReadU32(last)) <= 0)
+            {
+                return FindInList(hive, subListOffset, name, nameLen, depth + 1);
+            }
+        }
+        return Hive::kNoCell;
+    }
+
+    if (!HasSignature(list, "li") && !HasSignature(list, "lf") && !HasSignature(list, "lh"))
+    {
+        throw RegException{"Hive is corrupt: unknown subkey list type.", ERROR_REGISTRY_CORRUPT};
+    }
+
+    // Subkey lists are sorted by upper-cased name: binary search in place
+    DWORD lo = 0;
+    DWORD hi = count;
+    while (lo < hi)
+    {
+        const DWORD mid = lo + (hi - lo) / 2;
+        const DWORD nkOffset = ReadU32(list + 4 + mid * stride);
+        const int cmp = compareAt(nkOffset);
+        if (cmp == 0)
+        {
+            return nkOffset;
+        }
+        if (cmp < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return Hive::kNoCell;
+}
+
+inline DWORD RegKey::FindSubKey(
+    const Hive &hive, const BYTE *const nk, const wchar_t *const name, const std::size_t nameLen)
+{
+    if (details::ReadU32(nk + 20) == 0)
+    {
+        return Hive::kNoCell;
+    }
+    return FindInList(hive, details::ReadU32(nk + 28), name, nameLen, 0);
+}
+
+inline void RegKey::Open(const RegKey &parent, const std::wstring &subKey)
+{
+    // Walk a local copy, so that *this is untouched on failure
+    // (and Open(*this, ...) works)
+    DWORD cell = parent.m_cell;
+    const BYTE *nk = parent.KeyCell();
+
+    std::size_t pos = 0;
+    while (pos < subKey.size())
+    {
+        std::size_t end = subKey.find(L'\\', pos);
+        if (end == std::wstring::npos)
+        {
+            end = subKey.size();
+        }
+
+        if (end > pos)
+        {
+            cell = FindSubKey(*parent.m_hive, nk, subKey.data() + pos, end - pos);
+            if (cell == Hive::kNoCell)
+            {
+                throw RegException{"Cannot open hive key: subkey not found.", ERROR_FILE_NOT_FOUND};
+            }
+
+            nk = KeyCellAt(*parent.m_hive, cell);
+        }
+        pos = end + 1;
+    }
+
+    m_hive = parent.m_hive;
+    m_cell = cell;
+}
+
+template <typename F>
+inline void RegKey::ForEachValue(F &&f) const
+{
+    using namespace details;
+
+    const BYTE *nk = KeyCell();
+    const DWORD valueCount = ReadU32(nk + 36);
+    if (valueCount == 0)
+    {
+        return;
+    }
+
+    const BYTE *list = m_hive->CellAtLeast(ReadU32(nk + 40), std::size_t{valueCount} * 4);
+    for (DWORD i = 0; i < valueCount; ++i)
+    {
+        DWORD vkSize = 0;
+        const BYTE *vk = m_hive->Cell(ReadU32(list + i * 4), vkSize);
+        if (vkSize < 20 || !HasSignature(vk, "vk") || 20u + ReadU16(vk + 2) > vkSize)
+        {
+            throw RegException{"Hive is corrupt: bad value node.", ERROR_REGISTRY_CORRUPT};
+        }
+        if (f(vk))
+        {
+            return;
+        }
+    }
+}
+
+inline const BYTE *RegKey::FindValue(const std::wstring &valueName) const
+{
+    using namespace details;
+
+    const BYTE *found = nullptr;
+    ForEachValue([&](const BYTE *vk) {
+        const bool compressed = (ReadU16(vk + 16) & kValueCompressedName) != 0;
+        if (CompareName(valueName.data(), valueName.size(), vk + 20, ReadU16(vk + 2), compressed) == 0)
+        {
+            found = vk;
+            return true;
+        }
+        return false;
+    });
+    return found;
+}
+
+inline details::ValueView RegKey::ReadValue(const BYTE *const vk, std::vector<BYTE> &scratch) const
+{
+    using namespace details;
+
+    ValueView value;
+    value.type = ReadU32(vk + 12);
+
+    const DWORD rawSize = ReadU32(vk + 4);
+    const DWORD dataOffset = ReadU32(vk + 8);
+
+    // Data of up to 4 bytes is stored in the offset field itself
+    if (rawSize & 0x80000000)
+    {
+        value.size = rawSize & 0x7FFFFFFF;
+        if (value.size > 4)
+        {
+            throw RegException{"Hive is corrupt: bad resident value size.", ERROR_REGISTRY_CORRUPT};
+        }
+        value.data = vk + 8;
+        return value;
+    }
+
+    value.size = rawSize;
+    if (value.size == 0)
+    {
+        return value;
+    }
+
+    DWORD cellSize = 0;
+    const BYTE *cell = m_hive->Cell(dataOffset, cellSize);
+
+    // Large values (format 1.4 and later) are split across segments,
+    // referenced by a big data cell
+    if (value.size > kBigDataSegmentSize && m_hive->MinorVersion() >= 4 && cellSize >= 8 && HasSignature(cell, "db"))
+    {
+        const DWORD segmentCount = ReadU16(cell + 2);
+        const BYTE *segments = m_hive->CellAtLeast(ReadU32(cell + 4), std::size_t{segmentCount} * 4);
+        if (value.size > std::size_t{segmentCount} * kBigDataSegmentSize)
+        {
+            throw RegException{"Hive is corrupt: truncated big data value.", ERROR_REGISTRY_CORRUPT};
+        }
+
+        scratch.clear();
+        scratch.reserve(value.size);
+        for (DWORD i = 0; i < segmentCount && scratch.size() < value.size; ++i)
+        {
+            DWORD segmentSize = 0;
+            const BYTE *segment = m_hive->Cell(ReadU32(segments + i * 4), segmentSize);
+            const std::size_t take = std::min<std::size_t>({segmentSize, kBigDataSegmentSize, value.size - scratch.size()});
+            scratch.insert(scratch.end(), segment, segment + take);
+        }
+        if (scratch.size() != value.size)
+        {
+            throw RegException{"Hive is corrupt: truncated big data value.", ERROR_REGISTRY_CORRUPT};
+        }
+
+        value.data = scratch.data();
+        return value;
+    }
+
+    if (value.size > cellSize)
+    {
+        throw RegException{"Hive is corrupt: value data exceeds its cell.", ERROR_REGISTRY_CORRUPT};
+    }
+    value.data = cell;
+    return value;
+}
+
+inline details::ValueView RegKey::GetTypedValue(
+    const std::wstring &valueName,
+    const DWORD expectedType,
+    const DWORD altType,
+    std::vector<BYTE> &scratch,
+    const char *const what) const
+{
+    const BYTE *vk = FindValue(valueName);
+    if (vk == nullptr)
+    {
+        throw RegException{std::string{"Cannot get "} + what + " value: value not found in hive.", ERROR_FILE_NOT_FOUND};
+    }
+
+    const details::ValueView value = ReadValue(vk, scratch);
+    if (value.type != expectedType && value.type != altType)
+    {
+        throw RegException{std::string{"Cannot get "} + what + " value: unexpected value type.", ERROR_UNSUPPORTED_TYPE};
+    }
+    return value;
+}
+
+inline DWORD RegKey::GetDwordValue(const std::wstring &valueName) const
+{
+    std::vector<BYTE> scratch;
+    const auto value = GetTypedValue(valueName, REG_DWORD, REG_DWORD, scratch, "DWORD");
+    if (value.size != sizeof(DWORD))
+    {
+        throw RegException{"Cannot get DWORD value: unexpected data size.", ERROR_INVALID_DATA};
+    }
+    return details::ReadU32(value.data);
+}
+
+inline ULONGLONG RegKey::GetQwordValue(const std::wstring &valueName) const
+{
+    std::vector<BYTE> scratch;
+    const auto value = GetTypedValue(valueName, REG_QWORD, REG_QWORD, scratch, "QWORD");
+    if (value.size != sizeof(ULONGLONG))
+    {
+        throw RegException{"Cannot get QWORD value: unexpected data size.", ERROR_INVALID_DATA};
+    }
+    return details::ReadU64(value.data);
+}
+
+inline std::wstring RegKey::GetStringValue(const std::wstring &valueName) const
+{
+    std::vector<BYTE> scratch;
+    const auto value = GetTypedValue(valueName, REG_SZ, REG_EXPAND_SZ, scratch, "string");
+
+    // Like RegGetValue, drop the terminating NUL if the data has one
+    std::size_t count = value.size / 2;
+    if (count > 0 && details::ReadU16(value.data + 2 * (count - 1)) == 0)
+    {
+        --count;
+    }
+
+    std::wstring result;
+    details::AppendUtf16(result, value.data, count);
+    return result;
+}
+
+inline std::wstring RegKey::GetExpandStringValue(const std::wstring &valueName) const
+{
+    return GetStringValue(valueName);
+}
+
+inline std::vector<std::wstring> RegKey::GetMultiStringValue(const std::wstring &valueName) const
+{
+    std::vector<BYTE> scratch;
+    const auto value = GetTypedValue(valueName, REG_MULTI_SZ, REG_MULTI_SZ, scratch, "multi-string");
+
+    // Split at NULs; an empty string terminates the list
+    std::vector<std::wstring> result;
+    const std::size_t count = value.size / 2;
+    std::size_t start = 0;
+    for (std::size_t i = 0; i <= count; ++i)
+    {
+        if (i == count || details::ReadU16(value.data + 2 * i) == 0)
+        {
+            if (i == start)
+            {
+                break;
+            }
+            result.emplace_back();
+            details::AppendUtf16(result.back(), value.data + 2 * start, i - start);
+            start = i + 1;
+        }
+    }
+    return result;
+}
+
+inline std::vector<BYTE> RegKey::GetBinaryValue(const std::wstring &valueName) const
+{
+    std::vector<BYTE> scratch;
+    const auto value = GetTypedValue(valueName, REG_BINARY, REG_BINARY, scratch, "binary");
+    return std::vector<BYTE>(value.data, value.data + value.size);
+}
+
+inline void RegKey::QueryInfoKey(DWORD &subKeys, DWORD &values, FILETIME &lastWriteTime) const
+{
+    const BYTE *nk = KeyCell();
+    const ULONGLONG timestamp = details::ReadU64(nk + 4);
+
+    subKeys = details::ReadU32(nk + 20);
+    values = details::ReadU32(nk + 36);
+    lastWriteTime.dwLowDateTime = static_cast<DWORD>(timestamp);
+    lastWriteTime.dwHighDateTime = static_cast<DWORD>(timestamp >> 32);
+}
+
+inline DWORD RegKey::QueryValueType(const std::wstring &valueName) const
+{
+    const BYTE *vk = FindValue(valueName);
+    return vk != nullptr ? details::ReadU32(vk + 12) : REG_NONE;
+}
+
+inline std::vector<std::wstring> RegKey::EnumSubKeys() const
+{
+    using namespace details;
+
+    const BYTE *nk = KeyCell();
+    const DWORD subKeyCount = ReadU32(nk + 20);
+
+    std::vector<std::wstring> subkeyNames;
+    if (subKeyCount == 0)
+    {
+        return subkeyNames;
+    }
+
+    subkeyNames.reserve(subKeyCount);
+    ForEachInList(ReadU32(nk + 28), [&](const DWORD nkOffset) {
+        subkeyNames.push_back(RegKey{m_hive, nkOffset}.GetName());
+    });
+    return subkeyNames;
+}
+
+inline std::vector<std::pair<std::wstring, DWORD>> RegKey::EnumValues() const
+{
+    using namespace details;
+
+    std::vector<std::pair<std::wstring, DWORD>> valueInfo;
+    ForEachValue([&](const BYTE *vk) {
+        const bool compressed = (ReadU16(vk + 16) & kValueCompressedName) != 0;
+        valueInfo.emplace_back(DecodeName(vk + 20, ReadU16(vk + 2), compressed), ReadU32(vk + 12));
+        return false;
+    });
+    return valueInfo;
+}
+
+template <typename F>
+inline void RegKey::ForEachRawValue(F &&f) const
+{
+    using namespace details;
+
+    std::vector<BYTE> scratch;
+    ForEachValue([&](const BYTE *vk) {
+        const bool compressed = (ReadU16(vk + 16) & kValueCompressedName) != 0;
+        const ValueView value = ReadValue(vk, scratch);
+        f(DecodeName(vk + 20, ReadU16(vk + 2), compressed), value.type, value.data, value.size);
+        return false;
+    });
+}
+
+inline std::wstring RegKey::GetName() const
+{
+    const BYTE *nk = KeyCell();
+    const bool compressed = (details::ReadU16(nk + 2) & details::kKeyCompressedName) != 0;
+    return details::DecodeName(nk + 76, details::ReadU16(nk + 72), compressed);
+}
+
+} // namespace regf
+
+#endif // INCLUDE_WINREG_REGF_HPP
@@ -0,0 +1,715 @@
+#ifndef INCLUDE_WINREG_REGFCHECK_HPP
+#define INCLUDE_WINREG_REGFCHECK_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Integrity checks and cell carving for offline hive files.
+//
+// ScanHive() walks every hive bin of a hive file cell by cell and reports:
+//  - the allocated and free cells, allocated cells counted by signature
+//  - structural problems: bad bin headers, cell sizes that are misaligned or
+//    run past their bin, references to cells that aren't allocated
+//  - orphaned cells: allocated cells that no key of the tree leads to
+//  - carved cells: nk, vk, lf, lh and sk cells left in free space by deleted
+//    keys and values
+//
+// The walk runs in parallel over ranges of bins. A bin header holds its own
+// offset, so each thread finds the first bin of its range by looking at
+// page starts only; if the ranges don't join up (a damaged hive, or data
+// that looks like a bin header) the walk is done again on one thread.
+// Free cells are searched for signatures 16 or 32 bytes at a time with
+// SSE2/AVX2 on x86 and NEON on ARM64, with a scalar fallback elsewhere;
+// only the 8-byte aligned slots where a cell can start are considered.
+//
+// The file is scanned as it is on disk: transaction logs are not replayed.
+// Errors opening the file, and files that aren't hives, are signaled
+// throwing RegException; problems inside the hive are reported, not thrown.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "regf.hpp" // details::ReadU16, ReadU32, DecodeName, kBaseBlockSize, kPageSize
+
+#include <algorithm>  // std::min, std::max, std::stable_sort
+#include <array>      // std::array
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint64_t, SIZE_MAX
+#include <filesystem> // std::filesystem::path
+#include <iterator>   // std::back_inserter
+#include <string>     // std::string, std::wstring
+#include <thread>     // std::thread
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+
+// Define WINREG_REGF_SCALAR to leave out the SIMD code paths
+#if defined(WINREG_REGF_SCALAR)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define WINREG_REGF_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WINREG_REGF_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define WINREG_REGF_NEON 1
+#endif
+
+namespace regf
+{
+
+// Kinds of cells, by signature
+enum class CellKind : BYTE
+{
+    Key,       // nk
+    Value,     // vk
+    FastLeaf,  // lf
+    HashLeaf,  // lh
+    IndexLeaf, // li
+    IndexRoot, // ri
+    Security,  // sk
+    BigData,   // db
+    Data,      // no signature: value data and lists, class names...
+};
+
+constexpr std::size_t kCellKindCount = 9;
+
+// The signature of a kind ("nk", "vk"...), "data" for CellKind::Data
+const char *CellKindName(CellKind kind) noexcept;
+
+// A cell reported by ScanHive()
+struct HiveCell
+{
+    // Offset relative to the first hive bin, and size including the size field
+    DWORD offset;
+    DWORD size;
+    CellKind kind;
+
+    // Name of a key or value cell, empty for other kinds
+    std::wstring name;
+};
+
+struct HiveProblem
+{
+    // Offset relative to the first hive bin
+    DWORD offset;
+    std::string message;
+};
+
+struct HiveScanOptions
+{
+    // Threads walking the bins (0: one per CPU)
+    unsigned threads = 0;
+
+    // Walk the key tree from the root to find orphaned cells
+    bool findOrphans = true;
+
+    // Search free cells for deleted nk, vk, lf, lh and sk cells
+    bool carve = true;
+};
+
+struct HiveScanReport
+{
+    // The base block checksum matches, and its sequence numbers differ
+    bool checksumValid = false;
+    bool dirty = false;
+
+    std::size_t bins = 0;
+    std::size_t allocatedCells = 0;
+    std::size_t allocatedBytes = 0;
+    std::size_t freeCells = 0;
+    std::size_t freeBytes = 0;
+
+    // Allocated cells by kind, indexed by CellKind
+    std::array<std::size_t, kCellKindCount> cellsByKind{};
+
+    // In offset order
+    std::vector<HiveCell> orphaned;
+    std::vector<HiveCell> carved;
+    std::vector<HiveProblem> problems;
+
+    bool IsHealthy() const noexcept
+    {
+        return checksumValid && problems.empty() && orphaned.empty();
+    }
+};
+
+// Scan a hive file, in memory or from disk.
+// Throw RegException if the file can't be read or isn't a hive.
+HiveScanReport ScanHive(const BYTE *data, std::size_t size, const HiveScanOptions &options = {});
+HiveScanReport ScanHive(const std::filesystem::path &path, const HiveScanOptions &options = {});
+
+namespace details
+{
+
+// Split the bins into parts of at least this size (1 MB) between threads
+constexpr std::size_t kMinScanPart = 1 << 20;
+
+// Signatures as little-endian 16-bit words
+constexpr WORD Signature(const char (&signature)[3]) noexcept
+{
+    return static_cast<WORD>(static_cast<BYTE>(signature[0]) | (static_cast<BYTE>(signature[1]) << 8));
+}
+
+inline CellKind KindOf(const BYTE *payload, const std::size_t payloadSize) noexcept
+{
+    if (payloadSize < 2)
+        return CellKind::Data;
+    switch (ReadU16(payload))
+    {
+    case Signature("nk"):
+        return CellKind::Key;
+    case Signature("vk"):
+        return CellKind::Value;
+    case Signature("lf"):
+        return CellKind::FastLeaf;
+    case Signature("lh"):
+        return CellKind::HashLeaf;
+    case Signature("li"):
+        return CellKind::IndexLeaf;
+    case Signature("ri"):
+        return CellKind::IndexRoot;
+    case Signature("sk"):
+        return CellKind::Security;
+    case Signature("db"):
+        return CellKind::BigData;
+    default:
+        return CellKind::Data;
+    }
+}
+
+// Is the word one of the signatures carving looks for?
+inline bool IsCarvedSignature(const WORD word) noexcept
+{
+    return word == Signature("nk") || word == Signature("vk") || word == Signature("lf") ||
+           word == Signature("lh") || word == Signature("sk");
+}
+
+// The first 8-byte aligned slot in [pos, end) whose bytes 4 and 5 (where a
+// cell's signature follows its size) hold a carved signature; end if none.
+// pos and end are multiples of 8.
+inline std::size_t FindCarvedSignature(const BYTE *bins, std::size_t pos, const std::size_t end) noexcept
+{
+#if defined(WINREG_REGF_AVX2)
+    const __m256i nk = _mm256_set1_epi16(static_cast<short>(Signature("nk")));
+    const __m256i vk = _mm256_set1_epi16(static_cast<short>(Signature("vk")));
+    const __m256i lf = _mm256_set1_epi16(static_cast<short>(Signature("lf")));
+    const __m256i lh = _mm256_set1_epi16(static_cast<short>(Signature("lh")));
+    const __m256i sk = _mm256_set1_epi16(static_cast<short>(Signature("sk")));
+    for (; pos + 32 <= end; pos += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bins + pos));
+        const __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(v, nk), _mm256_cmpeq_epi16(v, vk)),
+                            _mm256_or_si256(_mm256_cmpeq_epi16(v, lf), _mm256_cmpeq_epi16(v, lh))),
+            _mm256_cmpeq_epi16(v, sk));
+        // Bytes 4 and 5 of each slot
+        const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(hits)) & 0x30303030u;
+        if (mask != 0)
+        {
+            for (std::size_t slot = 0; slot < 4; slot++)
+            {
+                if (mask & (0x30u << (slot * 8)))
+                    return pos + slot * 8;
+            }
+        }
+    }
+#elif defined(WINREG_REGF_SSE2)
+    const __m128i nk = _mm_set1_epi16(static_cast<short>(Signature("nk")));
+    const __m128i vk = _mm_set1_epi16(static_cast<short>(Signature("vk")));
+    const __m128i lf = _mm_set1_epi16(static_cast<short>(Signature("lf")));
+    const __m128i lh = _mm_set1_epi16(static_cast<short>(Signature("lh")));
+    const __m128i sk = _mm_set1_epi16(static_cast<short>(Signature("sk")));
+    for (; pos + 16 <= end; pos += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bins + pos));
+        const __m128i hits =
+            _mm_or_si128(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v, nk), _mm_cmpeq_epi16(v, vk)),
+                                      _mm_or_si128(_mm_cmpeq_epi16(v, lf), _mm_cmpeq_epi16(v, lh))),
+                         _mm_cmpeq_epi16(v, sk));
+        // Bytes 4 and 5 of each slot
+        const int mask = _mm_movemask_epi8(hits) & 0x3030;
+        if (mask != 0)
+            return (mask & 0x30) ? pos : pos + 8;
+    }
+#elif defined(WINREG_REGF_NEON)
+    const uint16x8_t nk = vdupq_n_u16(Signature("nk"));
+    const uint16x8_t vk = vdupq_n_u16(Signature("vk"));
+    const uint16x8_t lf = vdupq_n_u16(Signature("lf"));
+    const uint16x8_t lh = vdupq_n_u16(Signature("lh"));
+    const uint16x8_t sk = vdupq_n_u16(Signature("sk"));
+    for (; pos + 16 <= end; pos += 16)
+    {
+        const uint16x8_t v = vld1q_u16(reinterpret_cast<const std::uint16_t *>(bins + pos));
+        const uint16x8_t hits = vorrq_u16(vorrq_u16(vorrq_u16(vceqq_u16(v, nk), vceqq_u16(v, vk)),
+                                                    vorrq_u16(vceqq_u16(v, lf), vceqq_u16(v, lh))),
+                                          vceqq_u16(v, sk));
+        // A byte per 16-bit lane; lanes 2 and 6 are bytes 4 and 12
+        const std::uint64_t lanes = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(hits, 4)), 0);
+        if (lanes & 0x00FF000000FF0000ULL)
+            return (lanes & 0xFF0000ULL) ? pos : pos + 8;
+    }
+#endif
+    for (; pos < end; pos += 8)
+    {
+        if (IsCarvedSignature(ReadU16(bins + pos + 4)))
+            return pos;
+    }
+    return end;
+}
+
+// A set of 8-byte aligned cell offsets
+class CellSet
+{
+  public:
+    explicit CellSet(const std::size_t binsSize) : m_bits((binsSize / 8 + 63) / 64)
+    {
+    }
+
+    bool Contains(const std::size_t offset) const noexcept
+    {
+        return (m_bits[offset / 512] >> (offset / 8 % 64)) & 1;
+    }
+
+    // Threads may add cells of different pages at the same time (64 bits
+    // cover 512 bytes)
+    void Add(const std::size_t offset) noexcept
+    {
+        m_bits[offset / 512] |= std::uint64_t{1} << (offset / 8 % 64);
+    }
+
+    void Clear() noexcept
+    {
+        std::fill(m_bits.begin(), m_bits.end(), 0);
+    }
+
+    // Call f(offset) for the cells in this set and not in other, in order
+    template <typename F>
+    void ForEachNotIn(const CellSet &other, F &&f) const
+    {
+        for (std::size_t i = 0; i < m_bits.size(); i++)
+        {
+            for (std::uint64_t bits = m_bits[i] & ~other.m_bits[i]; bits != 0; bits &= bits - 1)
+            {
+                std::size_t bit = 0;
+                while (!((bits >> bit) & 1))
+                    bit++;
+                f(i * 512 + bit * 8);
+            }
+        }
+    }
+
+  private:
+    std::vector<std::uint64_t> m_bits;
+};
+
+// Walks the bins and cells of a hive
+class HiveScanner
+{
+  public:
+    HiveScanner(const BYTE *bins, const std::size_t binsSize, const bool carve)
+        : m_bins{bins}, m_binsSize{binsSize}, m_carve{carve}, m_allocated{binsSize}
+    {
+    }
+
+    // The bins starting in [begin, end), page offsets. Only the range at 0
+    // must start with a bin; in others a missing bin is a problem from the
+    // first bin found on. Return the end of the last bin, and the start of
+    // the first in firstBin (SIZE_MAX, and begin, if none started there).
+    std::size_t ScanRange(const std::size_t begin, const std::size_t end, std::size_t &firstBin,
+                          HiveScanReport &report)
+    {
+        std::size_t last = begin;
+        bool expectBin = begin == 0;
+        firstBin = SIZE_MAX;
+        for (std::size_t pos = begin; pos < end;)
+        {
+            const BYTE *bin = m_bins + pos;
+            if (pos + 32 <= m_binsSize && std::memcmp(bin, "hbin", 4) == 0 && ReadU32(bin + 4) == pos)
+            {
+                const DWORD size = ReadU32(bin + 8);
+                if (size >= kPageSize && size % kPageSize == 0 && size <= m_binsSize - pos)
+                {
+                    ScanBin(pos, pos + size, report);
+                    if (report.bins++ == 0)
+                        firstBin = pos;
+                    pos = last = pos + size;
+                    expectBin = true;
+                    continue;
+                }
+            }
+            if (expectBin)
+                report.problems.push_back({static_cast<DWORD>(pos), "Bad hive bin header."});
+            expectBin = false;
+            pos += kPageSize;
+        }
+        return last;
+    }
+
+    const CellSet &Allocated() const noexcept
+    {
+        return m_allocated;
+    }
+
+    void Reset() noexcept
+    {
+        m_allocated.Clear();
+    }
+
+  private:
+    void ScanBin(std::size_t pos, const std::size_t end, HiveScanReport &report)
+    {
+        for (pos += 32; pos < end;)
+        {
+            const auto raw = static_cast<LONG>(ReadU32(m_bins + pos));
+            const std::size_t size = raw < 0 ? static_cast<std::size_t>(-static_cast<long long>(raw))
+                                             : static_cast<std::size_t>(raw);
+            if (size < 8 || size % 8 != 0 || size > end - pos)
+            {
+                report.problems.push_back({static_cast<DWORD>(pos), "Bad cell size."});
+                return;
+            }
+
+            if (raw < 0)
+            {
+                report.allocatedCells++;
+                report.allocatedBytes += size;
+                report.cellsByKind[static_cast<std::size_t>(KindOf(m_bins + pos + 4, size - 4))]++;
+                m_allocated.Add(pos);
+            }
+            else
+            {
+                report.freeCells++;
+                report.freeBytes += size;
+                if (m_carve)
+                    Carve(pos, pos + size, report);
+            }
+            pos += size;
+        }
+    }
+
+    // Cells of deleted keys and values keep their contents, with a size
+    // field that may be stale: a candidate must fit in the free cell
+    void Carve(std::size_t pos, const std::size_t end, HiveScanReport &report)
+    {
+        while ((pos = FindCarvedSignature(m_bins, pos, end)) < end)
+        {
+            const BYTE *cell = m_bins + pos;
+            const auto raw = static_cast<LONG>(ReadU32(cell));
+            const std::size_t size = raw < 0 ? static_cast<std::size_t>(-static_cast<long long>(raw))
+                                             : static_cast<std::size_t>(raw);
+            const BYTE *payload = cell + 4;
+            const std::size_t payloadSize = size - 4;
+            const CellKind kind = KindOf(payload, 2);
+            bool valid = size >= 8 && size % 8 == 0 && size <= end - pos;
+            std::wstring name;
+            if (valid)
+            {
+                switch (kind)
+                {
+                case CellKind::Key:
+                    valid = payloadSize >= 76 && 76u + ReadU16(payload + 72) <= payloadSize;
+                    if (valid)
+                        name = DecodeName(payload + 76, ReadU16(payload + 72), (ReadU16(payload + 2) & kKeyCompressedName) != 0);
+                    break;
+                case CellKind::Value:
+                    valid = payloadSize >= 20 && 20u + ReadU16(payload + 2) <= payloadSize;
+                    if (valid)
+                        name = DecodeName(payload + 20, ReadU16(payload + 2), (ReadU16(payload + 16) & kValueCompressedName) != 0);
+                    break;
+                case CellKind::FastLeaf:
+                case CellKind::HashLeaf:
+                    valid = ReadU16(payload + 2) > 0 && 4u + ReadU16(payload + 2) * 8u <= payloadSize;
+                    break;
+                default:
+                    valid = payloadSize >= 20;
+                    break;
+                }
+            }
+            if (!valid)
+            {
+                pos += 8;
+                continue;
+            }
+            report.carved.push_back({static_cast<DWORD>(pos), static_cast<DWORD>(size), kind, std::move(name)});
+            pos += size;
+        }
+    }
+
+    const BYTE *m_bins;
+    std::size_t m_binsSize;
+    bool m_carve;
+    CellSet m_allocated;
+};
+
+// Walks the key tree from the root cell, marking every cell it reaches
+class HiveTreeWalker
+{
+  public:
+    HiveTreeWalker(const BYTE *bins, const std::size_t binsSize, const CellSet &allocated, const DWORD minorVersion)
+        : m_bins{bins}, m_binsSize{binsSize}, m_allocated{allocated}, m_reached{binsSize},
+          m_minorVersion{minorVersion}
+    {
+    }
+
+    void Walk(const DWORD rootCell, std::vector<HiveProblem> &problems)
+    {
+        m_problems = &problems;
+        std::vector<std::pair<DWORD, DWORD>> keys{{rootCell, rootCell}};
+        while (!keys.empty())
+        {
+            const auto [cell, from] = keys.back();
+            keys.pop_back();
+            std::size_t size = 0;
+            const BYTE *nk = Reach(cell, from, size);
+            if (!nk)
+                continue;
+            if (size < 76 || !HasSignature(nk, "nk"))
+            {
+                Problem(cell, "Key cell without an nk signature.");
+                continue;
+            }
+
+            WalkList(ReadU32(nk + 28), cell, keys, 0);
+
+            const DWORD values = ReadU32(nk + 36);
+            std::size_t listSize = 0;
+            if (const BYTE *list = values ? Reach(ReadU32(nk + 40), cell, listSize) : nullptr)
+            {
+                for (std::size_t i = 0; i < values && (i + 1) * 4 <= listSize; i++)
+                    WalkValue(ReadU32(list + i * 4), cell);
+            }
+
+            // Security cells are chained together
+            for (DWORD sk = ReadU32(nk + 44), skFrom = cell; sk != Hive::kNoCell;)
+            {
+                std::size_t skSize = 0;
+                const BYTE *p = Reach(sk, skFrom, skSize);
+                if (!p || skSize < 20 || !HasSignature(p, "sk"))
+                    break;
+                skFrom = sk;
+                sk = ReadU32(p + 4);
+            }
+
+            if (ReadU16(nk + 74) != 0)
+                Reach(ReadU32(nk + 48), cell, size);
+        }
+    }
+
+    const CellSet &Reached() const noexcept
+    {
+        return m_reached;
+    }
+
+  private:
+    // The payload of a cell referenced from another, the first time only
+    const BYTE *Reach(const DWORD cell, const DWORD from, std::size_t &payloadSize)
+    {
+        if (cell == Hive::kNoCell)
+            return nullptr;
+        if (cell % 8 != 0 || cell >= m_binsSize || !m_allocated.Contains(cell))
+        {
+            Problem(from, "Reference to a cell that isn't allocated.");
+            return nullptr;
+        }
+        if (m_reached.Contains(cell))
+            return nullptr;
+        m_reached.Add(cell);
+        const BYTE *p = m_bins + cell;
+        payloadSize = static_cast<std::size_t>(-static_cast<long long>(static_cast<LONG>(ReadU32(p)))) - 4;
+        return p + 4;
+    }
+
+    void WalkList(const DWORD cell, const DWORD from, std::vector<std::pair<DWORD, DWORD>> &keys, const int depth)
+    {
+        std::size_t size = 0;
+        const BYTE *list = Reach(cell, from, size);
+        if (!list || size < 4)
+            return;
+        const std::size_t count = ReadU16(list + 2);
+        if (HasSignature(list, "lf") || HasSignature(list, "lh"))
+        {
+            for (std::size_t i = 0; i < count && 4 + (i + 1) * 8 <= size; i++)
+                keys.emplace_back(ReadU32(list + 4 + i * 8), cell);
+        }
+        else if (HasSignature(list, "li"))
+        {
+            for (std::size_t i = 0; i < count && 4 + (i + 1) * 4 <= size; i++)
+                keys.emplace_back(ReadU32(list + 4 + i * 4), cell);
+        }
+        else if (HasSignature(list, "ri") && depth == 0)
+        {
+            for (std::size_t i = 0; i < count && 4 + (i + 1) * 4 <= size; i++)
+                WalkList(ReadU32(list + 4 + i * 4), cell, keys, depth + 1);
+        }
+        else
+        {
+            Problem(cell, "Subkey list without a known signature.");
+        }
+    }
+
+    void WalkValue(const DWORD cell, const DWORD from)
+    {
+        std::size_t size = 0;
+        const BYTE *vk = Reach(cell, from, size);
+        if (!vk)
+            return;
+        if (size < 20 || !HasSignature(vk, "vk"))
+        {
+            Problem(cell, "Value cell without a vk signature.");
+            return;
+        }
+        const DWORD dataSize = ReadU32(vk + 4);
+        if ((dataSize & 0x80000000) != 0 || dataSize == 0)
+            return;
+
+        std::size_t cellSize = 0;
+        const BYTE *data = Reach(ReadU32(vk + 8), cell, cellSize);
+        if (data && dataSize > kBigDataSegmentSize && m_minorVersion >= 4 && cellSize >= 8 &&
+            HasSignature(data, "db"))
+        {
+            const DWORD db = ReadU32(vk + 8);
+            const std::size_t segments = ReadU16(data + 2);
+            std::size_t listSize = 0;
+            if (const BYTE *list = Reach(ReadU32(data + 4), db, listSize))
+            {
+                for (std::size_t i = 0; i < segments && (i + 1) * 4 <= listSize; i++)
+                    Reach(ReadU32(list + i * 4), db, cellSize);
+            }
+        }
+    }
+
+    void Problem(const DWORD offset, const char *message)
+    {
+        m_problems->push_back({offset, message});
+    }
+
+    const BYTE *m_bins;
+    std::size_t m_binsSize;
+    const CellSet &m_allocated;
+    CellSet m_reached;
+    DWORD m_minorVersion;
+    std::vector<HiveProblem> *m_problems{nullptr};
+};
+
+inline HiveCell DescribeCell(const BYTE *bins, const DWORD offset)
+{
+    const BYTE *payload = bins + offset + 4;
+    const auto size = static_cast<DWORD>(-static_cast<LONG>(ReadU32(bins + offset)));
+    HiveCell cell{offset, size, KindOf(payload, size - 4), {}};
+    if (cell.kind == CellKind::Key && size - 4 >= 76 && 76u + ReadU16(payload + 72) <= size - 4)
+        cell.name = DecodeName(payload + 76, ReadU16(payload + 72), (ReadU16(payload + 2) & kKeyCompressedName) != 0);
+    else if (cell.kind == CellKind::Value && size - 4 >= 20 && 20u + ReadU16(payload + 2) <= size - 4)
+        cell.name = DecodeName(payload + 20, ReadU16(payload + 2), (ReadU16(payload + 16) & kValueCompressedName) != 0);
+    return cell;
+}
+
+} // namespace details
+
+inline const char *CellKindName(const CellKind kind) noexcept
+{
+    static const char *const names[kCellKindCount] = {"nk", "vk", "lf", "lh", "li", "ri", "sk", "db", "data"};
+    return names[static_cast<std::size_t>(kind)];
+}
+
+inline HiveScanReport ScanHive(const BYTE *const data, const std::size_t size, const HiveScanOptions &options)
+{
+    using namespace details;
+
+    if (size < kBaseBlockSize || std::memcmp(data, "regf", 4) != 0)
+    {
+        throw RegException{"Not a registry hive file: bad base block signature.", ERROR_BADDB};
+    }
+
+    HiveScanReport report;
+    report.checksumValid = ReadU32(data + 508) == BaseBlockChecksum(data);
+    report.dirty = ReadU32(data + 4) != ReadU32(data + 8);
+
+    // Trust the hive bins data size only as far as the file actually goes
+    const BYTE *bins = data + kBaseBlockSize;
+    const std::size_t binsSize = std::min<std::size_t>(ReadU32(data + 40), size - kBaseBlockSize) / 8 * 8;
+    if (binsSize < 32 || std::memcmp(bins, "hbin", 4) != 0)
+    {
+        throw RegException{"Not a registry hive file: missing first hive bin.", ERROR_BADDB};
+    }
+
+    // Split the bins into page-aligned ranges
+    unsigned threads = options.threads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, binsSize / kMinScanPart)));
+    std::vector<std::size_t> starts;
+    for (unsigned i = 0; i < threads; i++)
+        starts.push_back(binsSize / threads * i / kPageSize * kPageSize);
+    starts.push_back(binsSize);
+
+    HiveScanner scanner{bins, binsSize, options.carve};
+    std::vector<HiveScanReport> parts(threads);
+    std::vector<std::size_t> firsts(threads);
+    std::vector<std::size_t> ends(threads);
+    const auto scan = [&](const std::size_t i) {
+        ends[i] = scanner.ScanRange(starts[i], starts[i + 1], firsts[i], parts[i]);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; i++)
+        workers.emplace_back(scan, i);
+    scan(0);
+    for (auto &worker : workers)
+        worker.join();
+
+    // A range must start with the bin the chain of bins before it ends at,
+    // or lie inside the last bin of that chain
+    bool joined = true;
+    std::size_t chain = ends[0];
+    for (unsigned i = 1; i < threads && joined; i++)
+    {
+        if (chain >= starts[i + 1])
+            joined = parts[i].bins == 0;
+        else if (chain >= starts[i])
+            joined = firsts[i] == chain;
+        if (parts[i].bins != 0)
+            chain = ends[i];
+    }
+    if (!joined)
+    {
+        scanner.Reset();
+        parts.assign(1, HiveScanReport{});
+        std::size_t first = 0;
+        scanner.ScanRange(0, binsSize, first, parts[0]);
+    }
+
+    for (auto &part : parts)
+    {
+        report.bins += part.bins;
+        report.allocatedCells += part.allocatedCells;
+        report.allocatedBytes += part.allocatedBytes;
+        report.freeCells += part.freeCells;
+        report.freeBytes += part.freeBytes;
+        for (std::size_t kind = 0; kind < kCellKindCount; kind++)
+            report.cellsByKind[kind] += part.cellsByKind[kind];
+        std::move(part.carved.begin(), part.carved.end(), std::back_inserter(report.carved));
+        std::move(part.problems.begin(), part.problems.end(), std::back_inserter(report.problems));
+    }
+
+    if (options.findOrphans)
+    {
+        HiveTreeWalker walker{bins, binsSize, scanner.Allocated(), ReadU32(data + 24)};
+        walker.Walk(ReadU32(data + 36), report.problems);
+        scanner.Allocated().ForEachNotIn(walker.Reached(), [&](const std::size_t offset) {
+            report.orphaned.push_back(DescribeCell(bins, static_cast<DWORD>(offset)));
+        });
+
+        // The walk reports problems in tree order, after those of the bins
+        std::stable_sort(report.problems.begin(), report.problems.end(),
+                         [](const HiveProblem &a, const HiveProblem &b) { return a.offset < b.offset; });
+    }
+    return report;
+}
+
+inline HiveScanReport ScanHive(const std::filesystem::path &path, const HiveScanOptions &options)
+{
+    const winreg::MappedFile file{path};
+    return ScanHive(file.Data(), file.Size(), options);
+}
+
+} // namespace regf
+
+#endif // INCLUDE_WINREG_REGFCHECK_HPP
@@ -0,0 +1,317 @@
+#include <napi.h>
+
+#include "addon.hpp"
+#include "keycache.hpp"
+#include "regexport.hpp"
+#include "regimport.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+// hkey or HiveKey, path, options ({root, access}) to an exporter. root is the
+// path written in the file for the key, by default the predefined key name
+// (or the hive key name) and path. Throw RegException if the key can't be
+// opened; null, with a pending JS exception, on invalid arguments.
+static std::unique_ptr<winreg::RegExporter> NewExporter(
+    Napi::Env env, const char* usage, Napi::Value key, Napi::Value path,
+    Napi::Value options) {
+  const regf::RegKey* hiveKey = UnwrapHiveKey(key);
+  if ((!key.IsNumber() && hiveKey == nullptr) || !path.IsString() ||
+      !(options.IsUndefined() || options.IsNull() || options.IsObject())) {
+    Napi::Error::New(env, usage).ThrowAsJavaScriptException();
+    return nullptr;
+  }
+
+  std::wstring p = JsToWide(path);
+  toWindowSlashStyle(p);
+  std::wstring root;
+  REGSAM access = KEY_READ;
+  if (options.IsObject()) {
+    auto obj = options.As<Napi::Object>();
+    if (obj.Get("root").IsString()) {
+      root = JsToWide(obj.Get("root"));
+      toWindowSlashStyle(root);
+    }
+    if (obj.Get("access").IsNumber()) {
+      access = KEY_READ | obj.Get("access").As<Napi::Number>().Uint32Value();
+    }
+  }
+
+  if (hiveKey != nullptr) {
+    if (root.empty()) {
+      root = p.empty() ? hiveKey->GetName() : hiveKey->GetName() + L'\\' + p;
+    }
+    regf::RegKey subKey;
+    subKey.Open(*hiveKey, p);
+    return std::make_unique<winreg::RegExporter>(subKey, root);
+  }
+
+  HKEY hkey = (HKEY)key.As<Napi::Number>().Int64Value();
+  if (root.empty()) {
+    root = winreg::PredefinedKeyName(hkey);
+    if (!p.empty()) {
+      root = root.empty() ? p : root + L'\\' + p;
+    }
+  }
+  return std::make_unique<winreg::RegExporter>(hkey, p, root, access);
+}
+
+// hkey or HiveKey, path, file, options?
+// Export natively to a file, through a fixed-size buffer; return the number
+// of bytes written.
+Napi::Value RegExportRegFile(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  const char* usage = "exportReg - invalid arguments (hkey, path, file, options?)";
+  if (info.Length() < 3 || !info[2].IsString()) {
+    Napi::Error::New(env, usage).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  try {
+    auto exporter = NewExporter(env, usage, info[0], info[1], info[3]);
+    if (!exporter) {
+      return env.Undefined();
+    }
+
+    std::string file = info[2].As<Napi::String>();
+    std::ofstream out(std::filesystem::u8path(file),
+                      std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::runtime_error("Cannot create " + file);
+    }
+    double written = 0;
+    winreg::RegFileWriter writer{[&](const BYTE* data, size_t size) {
+      out.write(reinterpret_cast<const char*>(data), size);
+      if (!out) {
+        throw std::runtime_error("Cannot write " + file);
+      }
+      written += size;
+    }};
+    while (exporter->Next(writer)) {
+    }
+    writer.Finish();
+    return Napi::Number::New(env, written);
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// JavaScript wrapper of winreg::RegExporter: the .reg file of a subtree,
+// produced as it is read (see exportRegStream in index.js).
+class RegFileExporter : public Napi::ObjectWrap<RegFileExporter> {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+  // hkey or HiveKey, path, options?
+  RegFileExporter(const Napi::CallbackInfo& info);
+
+  Napi::Value Read(const Napi::CallbackInfo& info);
+
+ private:
+  std::unique_ptr<winreg::RegExporter> _exporter;
+  std::unique_ptr<winreg::RegFileWriter> _writer;
+
+  // Flushed by the writer, not yet read
+  std::vector<BYTE> _pending;
+  bool _done = false;
+};
+
+Napi::Object RegFileExporter::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func =
+      DefineClass(env, "RegFileExporter",
+                  {InstanceMethod("read", &RegFileExporter::Read)});
+  exports.Set("RegFileExporter", func);
+  return exports;
+}
+
+RegFileExporter::RegFileExporter(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<RegFileExporter>(info) {
+  auto env = info.Env();
+  try {
+    _exporter = NewExporter(
+        env, "RegFileExporter - invalid arguments (hkey, path, options?)",
+        info[0], info[1], info[2]);
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return;
+  }
+  if (!_exporter) {
+    return;
+  }
+  _writer = std::make_unique<winreg::RegFileWriter>(
+      [this](const BYTE* data, size_t size) {
+        _pending.insert(_pending.end(), data, data + size);
+      });
+}
+
+// size?
+// The next chunk of the file (about size bytes or more), null at the end
+Napi::Value RegFileExporter::Read(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (!_exporter) {
+    return env.Null();
+  }
+  size_t size = winreg::RegFileWriter::kDefaultBufferSize;
+  if (info.Length() > 0 && info[0].IsNumber()) {
+    size = (size_t)std::max<int64_t>(1, info[0].As<Napi::Number>().Int64Value());
+  }
+
+  try {
+    while (!_done && _pending.size() < size) {
+      if (!_exporter->Next(*_writer)) {
+        _writer->Finish();
+        _done = true;
+      }
+    }
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  if (_pending.empty()) {
+    return env.Null();
+  }
+  auto chunk = Napi::Buffer<uint8_t>::Copy(env, _pending.data(), _pending.size());
+  _pending.clear();
+  return chunk;
+}
+
+// file or Buffer, options ({threads, access}) to a change set. threads: the
+// parser's pool (0, the default: one per CPU).
+static bool ParseImportArgs(const Napi::CallbackInfo& info, const char* usage,
+                            winreg::RegChangeSet& changes, REGSAM& access) {
+  auto env = info.Env();
+  Napi::Value options = info[1];
+  if (info.Length() < 1 || !(info[0].IsString() || info[0].IsBuffer()) ||
+      !(options.IsUndefined() || options.IsNull() || options.IsObject())) {
+    Napi::Error::New(env, usage).ThrowAsJavaScriptException();
+    return false;
+  }
+
+  unsigned threads = 0;
+  access = 0;
+  if (options.IsObject()) {
+    auto obj = options.As<Napi::Object>();
+    if (obj.Get("threads").IsNumber()) {
+      threads = obj.Get("threads").As<Napi::Number>().Uint32Value();
+    }
+    if (obj.Get("access").IsNumber()) {
+      access = obj.Get("access").As<Napi::Number>().Uint32Value();
+    }
+  }
+
+  if (info[0].IsBuffer()) {
+    auto buffer = info[0].As<Napi::Buffer<uint8_t>>();
+    changes = winreg::ParseRegFile(buffer.Data(), buffer.Length(), threads);
+  } else {
+    std::string file = info[0].As<Napi::String>();
+    changes = winreg::ParseRegFile(std::filesystem::u8path(file), threads);
+  }
+  return true;
+}
+
+// file or Buffer, options?
+// The changes of a .reg file, without applying them, a key before its
+// subkeys: [{path, deleteTree, create, values: [{name, type, value} or
+// {name, remove: true}]}]
+Napi::Value RegParseRegFile(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    winreg::RegChangeSet changes;
+    REGSAM access;
+    if (!ParseImportArgs(info, "parseReg - invalid arguments (file, options?)",
+                         changes, access)) {
+      return env.Undefined();
+    }
+
+    auto result = Napi::Array::New(env, changes.size());
+    std::wstring wide;
+    for (size_t i = 0; i < changes.size(); i++) {
+      const auto& key = changes[i];
+      auto values = Napi::Array::New(env, key.values.size());
+      for (size_t j = 0; j < key.values.size(); j++) {
+        const auto& value = key.values[j];
+        auto obj = Napi::Object::New(env);
+        obj.Set("name", WideToJs(env, value.name));
+        if (value.remove) {
+          obj.Set("remove", true);
+        } else {
+          const BYTE* data;
+          DWORD size;
+          winreg::details::NativeValueData(value, wide, data, size);
+          obj.Set("type", value.type);
+          obj.Set("value", ValueDataToJs(env, winreg::details::DecodeValueData(
+                                                  value.type, data, size)));
+        }
+        values.Set(j, obj);
+      }
+
+      auto obj = Napi::Object::New(env);
+      obj.Set("path", WideToJs(env, key.path));
+      obj.Set("deleteTree", key.deleteTree);
+      obj.Set("create", key.create);
+      obj.Set("values", values);
+      result.Set(i, obj);
+    }
+    return result;
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// file or Buffer, options?
+// Parse a .reg file and apply it, a key at a time: {keysWritten, keysDeleted,
+// valuesSet, valuesDeleted}. access is added to the access of the keys
+// written, e.g. KEY_WOW64_32KEY.
+Napi::Value RegImportRegFile(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    winreg::RegChangeSet changes;
+    REGSAM access;
+    if (!ParseImportArgs(info, "importReg - invalid arguments (file, options?)",
+                         changes, access)) {
+      return env.Undefined();
+    }
+
+    // Cached handles of the deleted keys would only fail from now on
+    for (const auto& key : changes) {
+      if (key.deleteTree) {
+        winreg::KeyCache::Instance().Invalidate(key.root, key.subKey);
+      }
+    }
+    const winreg::RegImportStats stats = winreg::ApplyRegChanges(changes, access);
+
+    auto result = Napi::Object::New(env);
+    result.Set("keysWritten", (double)stats.keysWritten);
+    result.Set("keysDeleted", (double)stats.keysDeleted);
+    result.Set("valuesSet", (double)stats.valuesSet);
+    result.Set("valuesDeleted", (double)stats.valuesDeleted);
+    return result;
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+Napi::Object InitRegFile(Napi::Env env, Napi::Object exports) {
+  exports.Set("exportRegFile", Napi::Function::New(env, RegExportRegFile));
+  exports.Set("parseReg", Napi::Function::New(env, RegParseRegFile));
+  exports.Set("importReg", Napi::Function::New(env, RegImportRegFile));
+  return RegFileExporter::Init(env, exports);
+}
@@ -0,0 +1,428 @@
+#ifndef INCLUDE_WINREG_REGFIND_HPP
+#define INCLUDE_WINREG_REGFIND_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Searching registry subtrees for values, by key path pattern, value name,
+// type and data.
+//
+// Key patterns are paths relative to the searched key, with glob segments:
+// in a segment, '*' matches any run of characters and '?' any one character;
+// a "**" segment matches any number of keys, including none. So
+// "Software\*\Uninstall\*" matches every key under an Uninstall key one
+// level below Software. Matching is case-insensitive, like the registry.
+//
+// Patterns are compiled once; the walk carries the set of pattern positions
+// each key can be at, and never opens a subkey that can't lead to a match.
+// Segments without wildcards are opened directly by name, without
+// enumerating their parent.
+//
+// Errors are signaled throwing RegException, like in winreg.hpp. Subkeys
+// that disappear or can't be opened during the search are skipped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "regwalk.hpp" // details::UpperCase, details::ChildPath
+#include "winreg.hpp"
+
+#include <algorithm> // std::sort, std::unique
+#include <cstdint>   // std::uint32_t
+#include <cwctype>   // std::towupper
+#include <regex>     // std::wregex
+#include <string>    // std::wstring
+#include <utility>   // std::pair, std::move
+#include <variant>   // std::get_if
+#include <vector>    // std::vector
+
+namespace winreg
+{
+
+//------------------------------------------------------------------------------
+// What to look for in the keys matching the patterns
+//------------------------------------------------------------------------------
+struct FindOptions
+{
+    // Glob on value names (case-insensitive); empty matches every value
+    std::wstring valueName;
+
+    // ECMAScript regular expression searched, case-insensitive, in the data
+    // of string values (REG_SZ, REG_EXPAND_SZ, and each string of a
+    // REG_MULTI_SZ); empty: no filter. Other values never match it.
+    std::wstring dataRegex;
+
+    // Types of the values to find, as a mask of (1 << REG_xxx) bits;
+    // 0 finds values of any type
+    DWORD typeMask{0};
+
+    // Stop after this many matches; 0: no limit
+    size_t maxResults{0};
+
+    // Access used to open every key (e.g. KEY_READ | KEY_WOW64_32KEY)
+    REGSAM access{KEY_READ};
+};
+
+//------------------------------------------------------------------------------
+// A value found, with the path of its key relative to the searched key.
+// Path segments without wildcards are spelled as in the pattern.
+//------------------------------------------------------------------------------
+struct FindMatch
+{
+    std::wstring path;
+    RegValue value;
+};
+
+//------------------------------------------------------------------------------
+// Statistics of a search
+//------------------------------------------------------------------------------
+struct FindStats
+{
+    // Keys opened, and keys whose subkeys were enumerated
+    unsigned long long keysOpened{0};
+    unsigned long long keysEnumerated{0};
+};
+
+// Find the values of the keys under hKey matching any of the patterns, in
+// walk order. Throw RegException if hKey can't be read, std::regex_error if
+// the data regular expression is invalid.
+std::vector<FindMatch> Find(
+    HKEY hKey,
+    const std::vector<std::wstring> &patterns,
+    const FindOptions &options,
+    FindStats *stats = nullptr);
+
+namespace details
+{
+
+//------------------------------------------------------------------------------
+// A case-insensitive glob with '*' and '?', stored upper-case
+//------------------------------------------------------------------------------
+class Glob
+{
+  public:
+    explicit Glob(const std::wstring &pattern) : m_text{pattern}, m_upper{UpperCase(pattern)}
+    {
+        m_literal = m_upper.find_first_of(L"*?") == std::wstring::npos;
+    }
+
+    // As written, for opening a key or reading a value by name
+    const std::wstring &Text() const noexcept
+    {
+        return m_text;
+    }
+
+    const std::wstring &Upper() const noexcept
+    {
+        return m_upper;
+    }
+
+    bool IsLiteral() const noexcept
+    {
+        return m_literal;
+    }
+
+    bool Matches(const wchar_t *s, const size_t length) const noexcept
+    {
+        // Greedy match, backtracking to the last '*' only: linear for a
+        // single '*', O(pattern * length) at worst
+        const wchar_t *p = m_upper.data();
+        const size_t patternLength = m_upper.size();
+        size_t pi = 0;
+        size_t si = 0;
+        size_t starPattern = std::wstring::npos;
+        size_t starString = 0;
+        while (si < length)
+        {
+            if (pi < patternLength && p[pi] == L'*')
+            {
+                starPattern = pi++;
+                starString = si;
+            }
+            else if (pi < patternLength &&
+                     (p[pi] == L'?' || p[pi] == static_cast<wchar_t>(std::towupper(static_cast<wint_t>(s[si])))))
+            {
+                pi++;
+                si++;
+            }
+            else if (starPattern != std::wstring::npos)
+            {
+                pi = starPattern + 1;
+                si = ++starString;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        while (pi < patternLength && p[pi] == L'*')
+            pi++;
+        return pi == patternLength;
+    }
+
+  private:
+    std::wstring m_text;
+    std::wstring m_upper;
+    bool m_literal{true};
+};
+
+//------------------------------------------------------------------------------
+// A key path pattern: its segments, "**" ones matching any number of keys
+//------------------------------------------------------------------------------
+struct PathPattern
+{
+    struct Segment
+    {
+        Glob glob;
+        bool anyDepth;
+    };
+
+    std::vector<Segment> segments;
+
+    explicit PathPattern(const std::wstring &pattern)
+    {
+        size_t start = 0;
+        while (start <= pattern.size())
+        {
+            size_t end = pattern.find(L'\\', start);
+            if (end == std::wstring::npos)
+                end = pattern.size();
+            if (end > start)
+            {
+                const std::wstring segment = pattern.substr(start, end - start);
+                const bool anyDepth = segment == L"**";
+                // Consecutive "**" segments match the same as one
+                if (!(anyDepth && !segments.empty() && segments.back().anyDepth))
+                    segments.push_back(Segment{Glob{segment}, anyDepth});
+            }
+            start = end + 1;
+        }
+    }
+};
+
+class Finder
+{
+  public:
+    Finder(const std::vector<std::wstring> &patterns, const FindOptions &options, FindStats &stats)
+        : m_options{options}, m_valueName{options.valueName}, m_stats{stats}
+    {
+        m_patterns.reserve(patterns.size());
+        for (const auto &pattern : patterns)
+            m_patterns.emplace_back(pattern);
+        if (!options.dataRegex.empty())
+        {
+            m_dataRegex = std::wregex{options.dataRegex, std::regex::ECMAScript | std::regex::icase};
+            m_hasDataRegex = true;
+        }
+    }
+
+    std::vector<FindMatch> Run(const HKEY hKey)
+    {
+        RegKey key;
+        key.Open(hKey, L"", m_options.access);
+        m_stats.keysOpened++;
+
+        States states;
+        for (std::uint32_t i = 0; i < m_patterns.size(); i++)
+            Add(states, i, 0);
+        Normalize(states);
+        Search(key, L"", states);
+        return std::move(m_matches);
+    }
+
+  private:
+    // (pattern, segment) positions a key is at
+    using States = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+
+    // Add a position, and the ones after the "**" segments it can skip
+    void Add(States &states, const std::uint32_t pattern, std::uint32_t segment) const
+    {
+        const auto &segments = m_patterns[pattern].segments;
+        states.emplace_back(pattern, segment);
+        while (segment < segments.size() && segments[segment].anyDepth)
+            states.emplace_back(pattern, ++segment);
+    }
+
+    static void Normalize(States &states)
+    {
+        std::sort(states.begin(), states.end());
+        states.erase(std::unique(states.begin(), states.end()), states.end());
+    }
+
+    // Positions of a subkey with the given name, from those of its parent
+    States Advance(const States &states, const wchar_t *name, const size_t length) const
+    {
+        States next;
+        for (const auto &state : states)
+        {
+            const auto &segments = m_patterns[state.first].segments;
+            if (state.second >= segments.size())
+                continue;
+            const auto &segment = segments[state.second];
+            if (segment.anyDepth)
+                Add(next, state.first, state.second);
+            else if (segment.glob.Matches(name, length))
+                Add(next, state.first, state.second + 1);
+        }
+        Normalize(next);
+        return next;
+    }
+
+    bool Done() const noexcept
+    {
+        return m_options.maxResults != 0 && m_matches.size() >= m_options.maxResults;
+    }
+
+    void Search(RegKey &key, const std::wstring &path, const States &states)
+    {
+        bool matches = false;
+        bool descends = false;
+        // Subkey names to open directly, unless a segment ahead has wildcards
+        bool enumerate = false;
+        std::vector<const Glob *> literals;
+        for (const auto &state : states)
+        {
+            const auto &segments = m_patterns[state.first].segments;
+            if (state.second == segments.size())
+            {
+                matches = true;
+                continue;
+            }
+            descends = true;
+            const auto &segment = segments[state.second];
+            if (segment.anyDepth || !segment.glob.IsLiteral())
+                enumerate = true;
+            else
+                literals.push_back(&segment.glob);
+        }
+
+        if (matches)
+        {
+            FindValues(key, path);
+            if (Done())
+                return;
+        }
+        if (!descends)
+            return;
+
+        if (!enumerate)
+        {
+            std::sort(literals.begin(), literals.end(),
+                      [](const Glob *a, const Glob *b) { return a->Upper() < b->Upper(); });
+            for (size_t i = 0; i < literals.size() && !Done(); i++)
+            {
+                if (i > 0 && literals[i]->Upper() == literals[i - 1]->Upper())
+                    continue;
+                const std::wstring &name = literals[i]->Text();
+                SearchSubKey(key, path, name, Advance(states, name.data(), name.size()));
+            }
+            return;
+        }
+
+        NameList names;
+        key.EnumSubKeys(names);
+        m_stats.keysEnumerated++;
+        for (const auto item : names)
+        {
+            if (Done())
+                return;
+            States next = Advance(states, item.name.data(), item.name.size());
+            if (!next.empty())
+                SearchSubKey(key, path, std::wstring{item.name}, next);
+        }
+    }
+
+    void SearchSubKey(RegKey &key, const std::wstring &path, const std::wstring &name, const States &states)
+    {
+        RegKey subKey;
+        const RegResult opened = subKey.TryOpen(key.Get(), name, m_options.access);
+        if (opened.Failed())
+        {
+            // Missing, deleted meanwhile, or not readable by us
+            const LONG code = opened.Code();
+            if (code == ERROR_FILE_NOT_FOUND || code == ERROR_ACCESS_DENIED || code == ERROR_KEY_DELETED)
+                return;
+            opened.ThrowIfFailed();
+        }
+        m_stats.keysOpened++;
+        Search(subKey, ChildPath(path, name), states);
+    }
+
+    bool DataMatches(const RegValue &value) const
+    {
+        if (!m_hasDataRegex)
+            return true;
+        if (const auto *s = std::get_if<std::wstring>(&value.data))
+            return std::regex_search(*s, m_dataRegex);
+        if (const auto *strings = std::get_if<std::vector<std::wstring>>(&value.data))
+        {
+            for (const auto &s : *strings)
+            {
+                if (std::regex_search(s, m_dataRegex))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    void Found(const std::wstring &path, RegValue &value)
+    {
+        if (m_options.typeMask != 0 && (value.type >= 32 || !(m_options.typeMask & (1u << value.type))))
+            return;
+        if (!DataMatches(value))
+            return;
+        m_matches.push_back(FindMatch{path, std::move(value)});
+    }
+
+    void FindValues(RegKey &key, const std::wstring &path)
+    {
+        // A single value by name: one RegGetValue call
+        if (!m_valueName.Text().empty() && m_valueName.IsLiteral())
+        {
+            RegValue value;
+            auto data = key.TryGetValue(m_valueName.Text(), RegKey::ExpandStringOption::DontExpand, &value.type);
+            if (!data.IsValid())
+            {
+                const LONG code = data.GetError().Code();
+                if (code == ERROR_FILE_NOT_FOUND || code == ERROR_ACCESS_DENIED)
+                    return;
+                data.GetError().ThrowIfFailed();
+            }
+            value.name = m_valueName.Text();
+            value.data = std::move(data).GetValue();
+            Found(path, value);
+            return;
+        }
+
+        for (auto &value : key.EnumValuesWithData())
+        {
+            if (Done())
+                return;
+            if (m_valueName.Text().empty() || m_valueName.Matches(value.name.data(), value.name.size()))
+                Found(path, value);
+        }
+    }
+
+    const FindOptions &m_options;
+    std::vector<PathPattern> m_patterns;
+    Glob m_valueName;
+    std::wregex m_dataRegex;
+    bool m_hasDataRegex{false};
+    FindStats &m_stats;
+    std::vector<FindMatch> m_matches;
+};
+
+} // namespace details
+
+inline std::vector<FindMatch> Find(
+    const HKEY hKey,
+    const std::vector<std::wstring> &patterns,
+    const FindOptions &options,
+    FindStats *const stats)
+{
+    FindStats localStats;
+    details::Finder finder{patterns, options, stats != nullptr ? *stats : localStats};
+    return finder.Run(hKey);
+}
+
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_REGFIND_HPP
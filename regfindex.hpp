@@ -0,0 +1,393 @@
+#ifndef INCLUDE_WINREG_REGFINDEX_HPP
+#define INCLUDE_WINREG_REGFINDEX_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Path index of an offline hive: constant-time key lookups by full path.
+//
+// RegKey::Open walks a path a component at a time, searching the subkey
+// list of every key on the way. PathIndex::Build walks the whole tree once
+// instead and records, for every key, the hash of its upper-cased path
+// (relative to the key indexed) and the offset of its nk cell, in an
+// open-addressing hash table with linear probing. A lookup then hashes the
+// path, probes the table and checks the name of the one nk cell it lands on.
+//
+// The table is a flat little-endian image, saved next to the hive and
+// read in place from a memory mapping:
+//
+//   0   "rgpx", format version (1)
+//   8   sequence number and time stamp of the hive it was built from
+//   20  nk offset of the key indexed
+//   24  slot count (a power of 2), key count
+//   32  slots of 16 bytes: path hash (8), nk offset (4, kNoCell if the slot
+//       is empty), path length in UTF-16 code units (4)
+//
+// The table is kept at most 3/4 full. An index only fits the hive state it
+// was built from: opening keys through it checks the hive's sequence number
+// and time stamp, and the key indexed, and throws ERROR_INVALID_DATA if the
+// hive was written since.
+//
+// Errors are signaled throwing winreg::RegException; like regf.hpp, this
+// module has no dependency on the Windows registry APIs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "regf.hpp"      // Hive, RegKey, details::ReadU32, UpcaseChar
+#include "regfwrite.hpp" // details::WriteU32
+
+#include <cstddef>    // std::size_t
+#include <cstring>    // std::memcmp, std::memcpy
+#include <filesystem> // std::filesystem::path
+#include <string>     // std::wstring
+#include <utility>    // std::move
+#include <vector>     // std::vector
+
+namespace regf
+{
+
+namespace details
+{
+
+constexpr BYTE kPathIndexMagic[4] = {'r', 'g', 'p', 'x'};
+constexpr DWORD kPathIndexVersion = 1;
+constexpr std::size_t kPathIndexHeaderSize = 32;
+constexpr std::size_t kPathIndexSlotSize = 16;
+
+// Path hashes: FNV-1a over the upper-cased UTF-16 code units, components
+// separated by a backslash, and a final avalanche so that the low bits pick
+// the slot
+constexpr ULONGLONG kPathHashBasis = 0xCBF29CE484222325;
+
+inline ULONGLONG HashPathUnit(const ULONGLONG hash, const char16_t unit) noexcept
+{
+    return (hash ^ UpcaseChar(unit)) * 0x100000001B3;
+}
+
+inline ULONGLONG FinishPathHash(ULONGLONG hash) noexcept
+{
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCD;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Continue a path hash with the name of an nk cell, counting its code units
+inline ULONGLONG HashKeyName(ULONGLONG hash, const BYTE *nk, DWORD &length) noexcept
+{
+    const DWORD bytes = ReadU16(nk + 72);
+    const BYTE *name = nk + 76;
+    if (ReadU16(nk + 2) & kKeyCompressedName)
+    {
+        for (DWORD i = 0; i < bytes; ++i)
+            hash = HashPathUnit(hash, static_cast<char16_t>(name[i]));
+        length += bytes;
+    }
+    else
+    {
+        for (DWORD i = 0; i < bytes / 2; ++i)
+            hash = HashPathUnit(hash, static_cast<char16_t>(ReadU16(name + 2 * i)));
+        length += bytes / 2;
+    }
+    return hash;
+}
+
+} // namespace details
+
+//------------------------------------------------------------------------------
+// A path index of a hive key and its subtree.
+//
+// Movable, not copyable. An index loaded from memory reads it in place: the
+// caller must keep the memory alive as long as the index.
+//------------------------------------------------------------------------------
+class PathIndex
+{
+  public:
+    // Index every key under root (root itself is the empty path).
+    // Throw RegException on malformed cells.
+    static PathIndex Build(const RegKey &root);
+
+    // Map a saved index file read-only, or use a saved index already in memory.
+    // Throw RegException on failure, or ERROR_INVALID_DATA if it isn't an index.
+    static PathIndex Load(const std::filesystem::path &path);
+    static PathIndex FromMemory(const void *data, std::size_t size);
+
+    PathIndex(PathIndex &&) noexcept = default;
+    PathIndex &operator=(PathIndex &&) noexcept = default;
+
+    // Ban copy
+    PathIndex(const PathIndex &) = delete;
+    PathIndex &operator=(const PathIndex &) = delete;
+
+    // The index image, to be saved next to the hive
+    std::vector<BYTE> Save() const
+    {
+        return std::vector<BYTE>(m_data, m_data + m_size);
+    }
+
+    // Number of keys indexed
+    std::size_t KeyCount() const noexcept
+    {
+        return details::ReadU32(m_data + 28);
+    }
+
+    // Open the key at path (components separated by backslashes, compared
+    // case-insensitively, like RegKey::Open) under root, the key the index
+    // was built from. Return false if there's no such key.
+    // Throw RegException (ERROR_INVALID_DATA) if the index doesn't fit root
+    // and its hive.
+    bool TryOpen(const RegKey &root, const std::wstring &path, RegKey &key) const;
+
+    // Same as above, throwing RegException (ERROR_FILE_NOT_FOUND) if there's
+    // no such key
+    RegKey Open(const RegKey &root, const std::wstring &path) const;
+
+  private:
+    PathIndex() noexcept = default;
+
+    // Check the header and the size of the image in m_data
+    void Validate() const;
+
+    winreg::MappedFile m_file;
+    std::vector<BYTE> m_image;
+    const BYTE *m_data{nullptr};
+    std::size_t m_size{0};
+};
+
+//------------------------------------------------------------------------------
+//                          PathIndex Inline Methods
+//------------------------------------------------------------------------------
+
+inline PathIndex PathIndex::Build(const RegKey &root)
+{
+    using namespace details;
+
+    const BYTE *rootNk = root.KeyCell();
+    const Hive &hive = *root.m_hive;
+
+    struct Entry
+    {
+        ULONGLONG hash;
+        DWORD cell;
+        DWORD length;
+    };
+    std::vector<Entry> entries{{FinishPathHash(kPathHashBasis), root.m_cell, 0}};
+
+    // Keys to visit, with the unfinished hash of their parent's path. A cell
+    // is visited once: a damaged hive can list a key twice, or its ancestor.
+    std::vector<Entry> pending;
+    std::vector<bool> visited;
+    const auto visit = [&](const DWORD cell) {
+        const std::size_t bit = cell / 8;
+        if (bit >= visited.size())
+            visited.resize(bit + 1);
+        if (visited[bit])
+            return false;
+        visited[bit] = true;
+        return true;
+    };
+    const auto pushSubKeys = [&](const BYTE *nk, const ULONGLONG hash, const DWORD length) {
+        if (ReadU32(nk + 20) == 0)
+            return;
+        root.ForEachInList(ReadU32(nk + 28), [&](const DWORD cell) {
+            if (visit(cell))
+                pending.push_back(Entry{hash, cell, length});
+        });
+    };
+
+    visit(root.m_cell);
+    pushSubKeys(rootNk, kPathHashBasis, 0);
+    while (!pending.empty())
+    {
+        Entry key = pending.back();
+        pending.pop_back();
+
+        const BYTE *nk = RegKey::KeyCellAt(hive, key.cell);
+        if (key.length > 0)
+        {
+            key.hash = HashPathUnit(key.hash, u'\\');
+            key.length++;
+        }
+        key.hash = HashKeyName(key.hash, nk, key.length);
+        entries.push_back(Entry{FinishPathHash(key.hash), key.cell, key.length});
+        pushSubKeys(nk, key.hash, key.length);
+    }
+
+    std::size_t slots = 16;
+    while (slots * 3 < entries.size() * 4)
+        slots *= 2;
+
+    PathIndex index;
+    index.m_image.assign(kPathIndexHeaderSize + slots * kPathIndexSlotSize, 0);
+    BYTE *data = index.m_image.data();
+    const FILETIME written = hive.LastWriteTime();
+    std::memcpy(data, kPathIndexMagic, 4);
+    WriteU32(data + 4, kPathIndexVersion);
+    WriteU32(data + 8, hive.SequenceNumber());
+    WriteU32(data + 12, written.dwLowDateTime);
+    WriteU32(data + 16, written.dwHighDateTime);
+    WriteU32(data + 20, root.m_cell);
+    WriteU32(data + 24, static_cast<DWORD>(slots));
+
+    BYTE *table = data + kPathIndexHeaderSize;
+    for (std::size_t i = 0; i < slots; ++i)
+        WriteU32(table + i * kPathIndexSlotSize + 8, Hive::kNoCell);
+
+    DWORD keys = 0;
+    for (const Entry &entry : entries)
+    {
+        // Names are unique under a key, so an equal hash and length is a
+        // duplicate only in a damaged hive: the first one found is kept
+        std::size_t i = static_cast<std::size_t>(entry.hash) & (slots - 1);
+        BYTE *slot = table + i * kPathIndexSlotSize;
+        bool duplicate = false;
+        while (ReadU32(slot + 8) != Hive::kNoCell && !duplicate)
+        {
+            duplicate = ReadU64(slot) == entry.hash && ReadU32(slot + 12) == entry.length;
+            i = (i + 1) & (slots - 1);
+            slot = table + i * kPathIndexSlotSize;
+        }
+        if (duplicate)
+            continue;
+
+        WriteU32(slot, static_cast<DWORD>(entry.hash));
+        WriteU32(slot + 4, static_cast<DWORD>(entry.hash >> 32));
+        WriteU32(slot + 8, entry.cell);
+        WriteU32(slot + 12, entry.length);
+        keys++;
+    }
+    WriteU32(data + 28, keys);
+
+    index.m_data = data;
+    index.m_size = index.m_image.size();
+    return index;
+}
+
+inline PathIndex PathIndex::Load(const std::filesystem::path &path)
+{
+    PathIndex index;
+    index.m_file = winreg::MappedFile{path};
+    index.m_data = index.m_file.Data();
+    index.m_size = index.m_file.Size();
+    index.Validate();
+    return index;
+}
+
+inline PathIndex PathIndex::FromMemory(const void *const data, const std::size_t size)
+{
+    PathIndex index;
+    index.m_data = static_cast<const BYTE *>(data);
+    index.m_size = size;
+    index.Validate();
+    return index;
+}
+
+inline void PathIndex::Validate() const
+{
+    using namespace details;
+
+    if (m_size < kPathIndexHeaderSize || std::memcmp(m_data, kPathIndexMagic, 4) != 0 ||
+        ReadU32(m_data + 4) != kPathIndexVersion)
+    {
+        throw RegException{"Not a hive path index.", ERROR_INVALID_DATA};
+    }
+
+    const std::size_t slots = ReadU32(m_data + 24);
+    if (slots == 0 || (slots & (slots - 1)) != 0 ||
+        (m_size - kPathIndexHeaderSize) / kPathIndexSlotSize != slots ||
+        (m_size - kPathIndexHeaderSize) % kPathIndexSlotSize != 0 || ReadU32(m_data + 28) >= slots)
+    {
+        throw RegException{"Hive path index is corrupt: bad table size.", ERROR_INVALID_DATA};
+    }
+}
+
+inline bool PathIndex::TryOpen(const RegKey &root, const std::wstring &path, RegKey &key) const
+{
+    using namespace details;
+
+    root.KeyCell();
+    const Hive &hive = *root.m_hive;
+    const FILETIME written = hive.LastWriteTime();
+    if (ReadU32(m_data + 8) != hive.SequenceNumber() || ReadU32(m_data + 12) != written.dwLowDateTime ||
+        ReadU32(m_data + 16) != written.dwHighDateTime || ReadU32(m_data + 20) != root.m_cell)
+    {
+        throw RegException{"Hive path index doesn't match the hive key: rebuild it.", ERROR_INVALID_DATA};
+    }
+
+    // Hash the components, skipping empty ones like RegKey::Open does, and
+    // keep the last one to check against the key found
+    ULONGLONG hash = kPathHashBasis;
+    DWORD length = 0;
+    const wchar_t *last = nullptr;
+    std::size_t lastLen = 0;
+    for (std::size_t pos = 0; pos < path.size();)
+    {
+        std::size_t end = path.find(L'\\', pos);
+        if (end == std::wstring::npos)
+        {
+            end = path.size();
+        }
+
+        if (end > pos)
+        {
+            if (length > 0)
+            {
+                hash = HashPathUnit(hash, u'\\');
+                length++;
+            }
+            Utf16Reader reader{path.data() + pos, path.data() + end};
+            for (char16_t unit{}; reader.Next(unit); length++)
+                hash = HashPathUnit(hash, unit);
+            last = path.data() + pos;
+            lastLen = end - pos;
+        }
+        pos = end + 1;
+    }
+
+    if (last == nullptr)
+    {
+        key = root;
+        return true;
+    }
+
+    hash = FinishPathHash(hash);
+    const std::size_t mask = ReadU32(m_data + 24) - 1;
+    const BYTE *table = m_data + kPathIndexHeaderSize;
+    std::size_t i = static_cast<std::size_t>(hash) & mask;
+    for (std::size_t probes = 0; probes <= mask; ++probes, i = (i + 1) & mask)
+    {
+        const BYTE *slot = table + i * kPathIndexSlotSize;
+        const DWORD cell = ReadU32(slot + 8);
+        if (cell == Hive::kNoCell)
+        {
+            return false;
+        }
+        if (ReadU64(slot) != hash || ReadU32(slot + 12) != length)
+        {
+            continue;
+        }
+
+        const BYTE *nk = RegKey::KeyCellAt(hive, cell);
+        if (CompareName(last, lastLen, nk + 76, ReadU16(nk + 72), (ReadU16(nk + 2) & kKeyCompressedName) != 0) == 0)
+        {
+            key = RegKey{root.m_hive, cell};
+            return true;
+        }
+    }
+    return false;
+}
+
+inline RegKey PathIndex::Open(const RegKey &root, const std::wstring &path) const
+{
+    RegKey key;
+    if (!TryOpen(root, path, key))
+    {
+        throw RegException{"Cannot open hive key: subkey not found.", ERROR_FILE_NOT_FOUND};
+    }
+    return key;
+}
+
+} // namespace regf
+
+#endif // INCLUDE_WINREG_REGFINDEX_HPP
@@ -0,0 +1,509 @@
+#ifndef INCLUDE_WINREG_REGFWRITE_HPP
+#define INCLUDE_WINREG_REGFWRITE_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//          *** Portable writer of offline registry hive files ***
+//
+// WriteHive() lays out an in-memory key tree as a hive file in the "regf"
+// format that RegSaveKey writes and RegLoadKey (or regf::Hive) reads:
+//
+//  - a 4 KB base block, with its checksum, then hive bins ("hbin") of 4 KB,
+//    or of the multiple of 4 KB that a larger cell needs; the unused end of
+//    each bin is a free cell
+//  - an nk cell per key, with its subkeys in an lh list sorted by upper-cased
+//    name and hashed like Windows does; beyond kMaxLeafEntries subkeys, lh
+//    lists under an ri index
+//  - a vk cell per value, the data inline (up to 4 bytes), in a data cell,
+//    or beyond kBigDataSegmentSize bytes in big data (db) segments
+//  - one security (sk) cell shared by every key
+//
+// The tree is written in a single pass, appending cells to the file image:
+// the time and memory taken grow linearly with the number of keys and
+// values (sorting aside).
+//
+// Errors are signaled throwing winreg::RegException; like regf.hpp, this
+// module has no dependency on the Windows registry APIs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "regf.hpp" // details::UpcaseChar, Utf16Reader, BaseBlockChecksum, kBigDataSegmentSize
+
+#include <algorithm> // std::sort, std::max, std::adjacent_find
+#include <cstddef>   // std::size_t
+#include <cstring>   // std::memcpy
+#include <numeric>   // std::iota
+#include <string>    // std::wstring, std::u16string
+#include <utility>   // std::move
+#include <vector>    // std::vector
+
+namespace regf
+{
+
+//------------------------------------------------------------------------------
+// A key to write, with its values and subkeys
+//------------------------------------------------------------------------------
+struct KeyTree
+{
+    struct Value
+    {
+        std::wstring name;      // empty for the default value
+        DWORD type{REG_NONE};
+        std::vector<BYTE> data; // raw data, strings in UTF-16LE
+    };
+
+    std::wstring name;
+    FILETIME lastWriteTime{};
+    std::vector<Value> values;
+    std::vector<KeyTree> subKeys; // in any order; names must be unique, ignoring case
+};
+
+struct HiveWriteOptions
+{
+    // Self-relative security descriptor of every key; empty for the default:
+    // full control to SYSTEM and Administrators, read access to Users
+    std::vector<BYTE> securityDescriptor;
+};
+
+// The hive file of a tree, the root key first.
+// Throw RegException (ERROR_INVALID_PARAMETER) for duplicate subkey names
+// and names or data too long for the format.
+std::vector<BYTE> WriteHive(const KeyTree &root, const HiveWriteOptions &options = {});
+
+namespace details
+{
+
+constexpr std::size_t kHiveBinSize = 4096;
+constexpr std::size_t kHiveBinHeaderSize = 32;
+
+// Subkeys of an lh list; more go under an ri index of lh lists
+constexpr std::size_t kMaxLeafEntries = 1012;
+
+// nk cell flags of the root key: hive entry, can't be deleted
+constexpr WORD kKeyHiveEntry = 0x0004;
+constexpr WORD kKeyNoDelete = 0x0008;
+
+inline void WriteU16(BYTE *p, const WORD v) noexcept
+{
+    p[0] = static_cast<BYTE>(v);
+    p[1] = static_cast<BYTE>(v >> 8);
+}
+
+inline void WriteU32(BYTE *p, const DWORD v) noexcept
+{
+    WriteU16(p, static_cast<WORD>(v));
+    WriteU16(p + 2, static_cast<WORD>(v >> 16));
+}
+
+// A key or value name as stored: Latin-1 ("compressed") if it can be,
+// UTF-16LE otherwise
+struct StoredName
+{
+    std::vector<BYTE> bytes;
+    bool compressed{true};
+    std::size_t utf16Length{0};
+};
+
+inline StoredName EncodeName(const std::wstring &name)
+{
+    std::u16string units;
+    Utf16Reader reader{name.data(), name.data() + name.size()};
+    for (char16_t c{}; reader.Next(c);)
+        units.push_back(c);
+
+    StoredName stored;
+    stored.utf16Length = units.size();
+    stored.compressed = std::all_of(units.begin(), units.end(), [](const char16_t c) { return c < 0x100; });
+    for (const char16_t c : units)
+    {
+        stored.bytes.push_back(static_cast<BYTE>(c));
+        if (!stored.compressed)
+            stored.bytes.push_back(static_cast<BYTE>(c >> 8));
+    }
+    if (stored.bytes.size() > 0xFFFF)
+        throw RegException{"Name too long for a hive.", ERROR_INVALID_PARAMETER};
+    return stored;
+}
+
+// Upper-cased UTF-16 name, the sort key of subkey lists
+inline std::u16string UpcaseName(const std::wstring &name)
+{
+    std::u16string upper;
+    Utf16Reader reader{name.data(), name.data() + name.size()};
+    for (char16_t c{}; reader.Next(c);)
+        upper.push_back(UpcaseChar(c));
+    return upper;
+}
+
+// Hash of an lh list entry
+inline DWORD LhHash(const std::u16string &upper) noexcept
+{
+    DWORD hash = 0;
+    for (const char16_t c : upper)
+        hash = hash * 37 + c;
+    return hash;
+}
+
+// Full control to SYSTEM and Administrators, read to Users, inherited by
+// subkeys; owned by Administrators
+inline std::vector<BYTE> DefaultSecurityDescriptor()
+{
+    const auto sid = [](std::vector<BYTE> &out, const std::vector<DWORD> &subAuthorities) {
+        out.push_back(1); // revision
+        out.push_back(static_cast<BYTE>(subAuthorities.size()));
+        const BYTE ntAuthority[6] = {0, 0, 0, 0, 0, 5};
+        out.insert(out.end(), ntAuthority, ntAuthority + 6);
+        for (const DWORD subAuthority : subAuthorities)
+        {
+            BYTE bytes[4];
+            WriteU32(bytes, subAuthority);
+            out.insert(out.end(), bytes, bytes + 4);
+        }
+    };
+    const std::vector<DWORD> system{18}, administrators{32, 544}, users{32, 545};
+
+    std::vector<BYTE> aces;
+    const auto ace = [&](const DWORD mask, const std::vector<DWORD> &subAuthorities) {
+        std::vector<BYTE> sidBytes;
+        sid(sidBytes, subAuthorities);
+        BYTE header[8] = {0 /* ACCESS_ALLOWED_ACE_TYPE */, 0x02 /* CONTAINER_INHERIT_ACE */};
+        WriteU16(header + 2, static_cast<WORD>(8 + sidBytes.size()));
+        WriteU32(header + 4, mask);
+        aces.insert(aces.end(), header, header + 8);
+        aces.insert(aces.end(), sidBytes.begin(), sidBytes.end());
+    };
+    ace(0xF003F /* KEY_ALL_ACCESS */, system);
+    ace(0xF003F, administrators);
+    ace(0x20019 /* KEY_READ */, users);
+
+    std::vector<BYTE> sd(20);
+    sd[0] = 1;                        // revision
+    WriteU16(&sd[2], 0x8004);         // SE_SELF_RELATIVE | SE_DACL_PRESENT
+    WriteU32(&sd[16], 20);            // DACL offset
+    BYTE acl[8] = {2 /* ACL_REVISION */};
+    WriteU16(acl + 2, static_cast<WORD>(8 + aces.size()));
+    WriteU16(acl + 4, 3);
+    sd.insert(sd.end(), acl, acl + 8);
+    sd.insert(sd.end(), aces.begin(), aces.end());
+    WriteU32(&sd[4], static_cast<DWORD>(sd.size())); // owner
+    sid(sd, administrators);
+    WriteU32(&sd[8], static_cast<DWORD>(sd.size())); // group
+    sid(sd, system);
+    return sd;
+}
+
+//------------------------------------------------------------------------------
+// Appends cells to a hive image, bin by bin
+//------------------------------------------------------------------------------
+class HiveBuilder
+{
+  public:
+    HiveBuilder() : m_file(kBaseBlockSize)
+    {
+    }
+
+    // Allocate a cell; return its offset, relative to the first bin
+    DWORD Alloc(const std::size_t payloadSize)
+    {
+        const std::size_t size = (payloadSize + 4 + 7) & ~std::size_t{7};
+        if (size > 0x7FFFFFFF - kHiveBinHeaderSize)
+            throw RegException{"Cell too large for a hive.", ERROR_INVALID_PARAMETER};
+        if (m_binEnd - m_next < size)
+            NewBin(size);
+
+        const std::size_t offset = m_next;
+        WriteU32(&m_file[offset], static_cast<DWORD>(-static_cast<long long>(size)));
+        m_next += size;
+        if (m_next - kBaseBlockSize > 0xFFFFFFF0)
+            throw RegException{"Tree too large for a hive.", ERROR_INVALID_PARAMETER};
+        return static_cast<DWORD>(offset - kBaseBlockSize);
+    }
+
+    // Payload of a cell; valid until the next Alloc()
+    BYTE *Payload(const DWORD offset) noexcept
+    {
+        return &m_file[kBaseBlockSize + offset + 4];
+    }
+
+    // Close the last bin and fill in the base block
+    std::vector<BYTE> Finish(const DWORD rootCell, const FILETIME &timestamp)
+    {
+        CloseBin();
+
+        BYTE *base = m_file.data();
+        std::memcpy(base, "regf", 4);
+        WriteU32(base + 4, 1);  // primary sequence number
+        WriteU32(base + 8, 1);  // secondary sequence number: the same, clean
+        WriteU32(base + 12, timestamp.dwLowDateTime);
+        WriteU32(base + 16, timestamp.dwHighDateTime);
+        WriteU32(base + 20, 1); // major version
+        WriteU32(base + 24, 5); // minor version: big data cells
+        WriteU32(base + 28, 0); // primary file
+        WriteU32(base + 32, 1); // direct memory load
+        WriteU32(base + 36, rootCell);
+        WriteU32(base + 40, static_cast<DWORD>(m_file.size() - kBaseBlockSize));
+        WriteU32(base + 44, 1); // clustering factor
+
+        WriteU32(base + 508, BaseBlockChecksum(base));
+        return std::move(m_file);
+    }
+
+  private:
+    // The rest of the current bin becomes a free cell
+    void CloseBin() noexcept
+    {
+        if (m_binEnd > m_next)
+            WriteU32(&m_file[m_next], static_cast<DWORD>(m_binEnd - m_next));
+    }
+
+    void NewBin(const std::size_t cellSize)
+    {
+        CloseBin();
+        const std::size_t binSize =
+            (kHiveBinHeaderSize + cellSize + kHiveBinSize - 1) / kHiveBinSize * kHiveBinSize;
+        const std::size_t bin = m_file.size();
+        m_file.resize(bin + binSize);
+        std::memcpy(&m_file[bin], "hbin", 4);
+        WriteU32(&m_file[bin + 4], static_cast<DWORD>(bin - kBaseBlockSize));
+        WriteU32(&m_file[bin + 8], static_cast<DWORD>(binSize));
+        m_next = bin + kHiveBinHeaderSize;
+        m_binEnd = bin + binSize;
+    }
+
+    std::vector<BYTE> m_file;
+    std::size_t m_next{kBaseBlockSize};
+    std::size_t m_binEnd{kBaseBlockSize};
+};
+
+//------------------------------------------------------------------------------
+// Writes the cells of a tree
+//------------------------------------------------------------------------------
+class HiveWriter
+{
+  public:
+    std::vector<BYTE> Write(const KeyTree &root, const HiveWriteOptions &options)
+    {
+        const std::vector<BYTE> descriptor =
+            options.securityDescriptor.empty() ? DefaultSecurityDescriptor() : options.securityDescriptor;
+        m_security = m_builder.Alloc(20 + descriptor.size());
+        BYTE *sk = m_builder.Payload(m_security);
+        std::memcpy(sk, "sk", 2);
+        WriteU32(sk + 4, m_security); // the only one: its own previous and next
+        WriteU32(sk + 8, m_security);
+        WriteU32(sk + 16, static_cast<DWORD>(descriptor.size()));
+        std::memcpy(sk + 20, descriptor.data(), descriptor.size());
+
+        const DWORD rootCell = WriteKey(root, Hive::kNoCell, true);
+        WriteU32(m_builder.Payload(m_security) + 12, m_keys); // reference count
+        return m_builder.Finish(rootCell, root.lastWriteTime);
+    }
+
+  private:
+    struct ListEntry
+    {
+        DWORD cell;
+        DWORD hash;
+    };
+
+    DWORD WriteKey(const KeyTree &key, const DWORD parent, const bool isRoot)
+    {
+        const StoredName name = EncodeName(key.name);
+        const DWORD nkCell = m_builder.Alloc(76 + name.bytes.size());
+        BYTE *nk = m_builder.Payload(nkCell);
+        std::memcpy(nk, "nk", 2);
+        WriteU16(nk + 2, static_cast<WORD>((isRoot ? kKeyHiveEntry | kKeyNoDelete : 0) |
+                                           (name.compressed ? kKeyCompressedName : 0)));
+        WriteU32(nk + 4, key.lastWriteTime.dwLowDateTime);
+        WriteU32(nk + 8, key.lastWriteTime.dwHighDateTime);
+        WriteU32(nk + 16, parent);
+        WriteU32(nk + 28, Hive::kNoCell); // subkey list
+        WriteU32(nk + 32, Hive::kNoCell); // volatile subkey list
+        WriteU32(nk + 40, Hive::kNoCell); // value list
+        WriteU32(nk + 44, m_security);
+        WriteU32(nk + 48, Hive::kNoCell); // class name
+        WriteU16(nk + 72, static_cast<WORD>(name.bytes.size()));
+        if (!name.bytes.empty())
+            std::memcpy(nk + 76, name.bytes.data(), name.bytes.size());
+        m_keys++;
+
+        // Values
+        DWORD valueList = Hive::kNoCell;
+        DWORD maxValueName = 0;
+        DWORD maxValueData = 0;
+        if (!key.values.empty())
+        {
+            // Values keep their order, but names are unique case-insensitively too
+            std::vector<std::u16string> upper;
+            upper.reserve(key.values.size());
+            for (const auto &value : key.values)
+                upper.push_back(UpcaseName(value.name));
+            std::sort(upper.begin(), upper.end());
+            if (std::adjacent_find(upper.begin(), upper.end()) != upper.end())
+                throw RegException{"Duplicate value name.", ERROR_INVALID_PARAMETER};
+
+            std::vector<DWORD> cells;
+            cells.reserve(key.values.size());
+            for (const auto &value : key.values)
+            {
+                cells.push_back(WriteValue(value, maxValueName));
+                maxValueData = std::max(maxValueData, static_cast<DWORD>(value.data.size()));
+            }
+            valueList = m_builder.Alloc(cells.size() * 4);
+            BYTE *list = m_builder.Payload(valueList);
+            for (std::size_t i = 0; i < cells.size(); i++)
+                WriteU32(list + 4 * i, cells[i]);
+        }
+
+        // Subkeys, in upper-cased name order
+        DWORD subKeyList = Hive::kNoCell;
+        DWORD maxSubKeyName = 0;
+        if (!key.subKeys.empty())
+        {
+            std::vector<std::u16string> upper;
+            upper.reserve(key.subKeys.size());
+            for (const auto &subKey : key.subKeys)
+                upper.push_back(UpcaseName(subKey.name));
+
+            std::vector<std::size_t> order(key.subKeys.size());
+            std::iota(order.begin(), order.end(), std::size_t{0});
+            std::sort(order.begin(), order.end(), [&upper](const std::size_t a, const std::size_t b) {
+                return upper[a] < upper[b];
+            });
+
+            std::vector<ListEntry> entries;
+            entries.reserve(order.size());
+            for (std::size_t i = 0; i < order.size(); i++)
+            {
+                const std::u16string &subKeyName = upper[order[i]];
+                if (i > 0 && subKeyName == upper[order[i - 1]])
+                    throw RegException{"Duplicate subkey name.", ERROR_INVALID_PARAMETER};
+                maxSubKeyName = std::max(maxSubKeyName, static_cast<DWORD>(subKeyName.size() * 2));
+                entries.push_back(ListEntry{WriteKey(key.subKeys[order[i]], nkCell, false), LhHash(subKeyName)});
+            }
+            subKeyList = WriteSubKeyList(entries);
+        }
+
+        nk = m_builder.Payload(nkCell);
+        WriteU32(nk + 20, static_cast<DWORD>(key.subKeys.size()));
+        WriteU32(nk + 28, subKeyList);
+        WriteU32(nk + 36, static_cast<DWORD>(key.values.size()));
+        WriteU32(nk + 40, valueList);
+        WriteU32(nk + 52, maxSubKeyName);
+        WriteU32(nk + 60, maxValueName);
+        WriteU32(nk + 64, maxValueData);
+        return nkCell;
+    }
+
+    DWORD WriteValue(const KeyTree::Value &value, DWORD &maxName)
+    {
+        const StoredName name = EncodeName(value.name);
+        maxName = std::max(maxName, static_cast<DWORD>(name.utf16Length * 2));
+        if (value.data.size() >= 0x80000000)
+            throw RegException{"Value data too large for a hive.", ERROR_INVALID_PARAMETER};
+
+        const DWORD size = static_cast<DWORD>(value.data.size());
+        DWORD dataField = 0;
+        if (size <= 4)
+        {
+            // Inline, in the data offset field
+            BYTE inlineData[4] = {};
+            if (size > 0)
+                std::memcpy(inlineData, value.data.data(), size);
+            dataField = ReadU32(inlineData);
+        }
+        else
+        {
+            dataField = WriteData(value.data.data(), size);
+        }
+
+        const DWORD vkCell = m_builder.Alloc(20 + name.bytes.size());
+        BYTE *vk = m_builder.Payload(vkCell);
+        std::memcpy(vk, "vk", 2);
+        WriteU16(vk + 2, static_cast<WORD>(name.bytes.size()));
+        WriteU32(vk + 4, size <= 4 ? size | 0x80000000 : size);
+        WriteU32(vk + 8, dataField);
+        WriteU32(vk + 12, value.type);
+        WriteU16(vk + 16, name.compressed ? kValueCompressedName : 0);
+        if (!name.bytes.empty())
+            std::memcpy(vk + 20, name.bytes.data(), name.bytes.size());
+        return vkCell;
+    }
+
+    DWORD WriteData(const BYTE *data, const DWORD size)
+    {
+        if (size <= kBigDataSegmentSize)
+        {
+            const DWORD cell = m_builder.Alloc(size);
+            std::memcpy(m_builder.Payload(cell), data, size);
+            return cell;
+        }
+
+        // Big data: a db cell, its list of segments, the segments
+        const DWORD segments = (size + kBigDataSegmentSize - 1) / kBigDataSegmentSize;
+        if (segments > 0xFFFF)
+            throw RegException{"Value data too large for a hive.", ERROR_INVALID_PARAMETER};
+        std::vector<DWORD> cells;
+        for (DWORD offset = 0; offset < size; offset += kBigDataSegmentSize)
+            cells.push_back(WriteData(data + offset, std::min(kBigDataSegmentSize, size - offset)));
+
+        const DWORD list = m_builder.Alloc(cells.size() * 4);
+        for (std::size_t i = 0; i < cells.size(); i++)
+            WriteU32(m_builder.Payload(list) + 4 * i, cells[i]);
+
+        const DWORD db = m_builder.Alloc(8);
+        BYTE *p = m_builder.Payload(db);
+        std::memcpy(p, "db", 2);
+        WriteU16(p + 2, static_cast<WORD>(segments));
+        WriteU32(p + 4, list);
+        return db;
+    }
+
+    DWORD WriteLeaf(const ListEntry *entries, const std::size_t count)
+    {
+        const DWORD cell = m_builder.Alloc(4 + count * 8);
+        BYTE *lh = m_builder.Payload(cell);
+        std::memcpy(lh, "lh", 2);
+        WriteU16(lh + 2, static_cast<WORD>(count));
+        for (std::size_t i = 0; i < count; i++)
+        {
+            WriteU32(lh + 4 + i * 8, entries[i].cell);
+            WriteU32(lh + 8 + i * 8, entries[i].hash);
+        }
+        return cell;
+    }
+
+    DWORD WriteSubKeyList(const std::vector<ListEntry> &entries)
+    {
+        if (entries.size() <= kMaxLeafEntries)
+            return WriteLeaf(entries.data(), entries.size());
+
+        std::vector<DWORD> leaves;
+        for (std::size_t i = 0; i < entries.size(); i += kMaxLeafEntries)
+            leaves.push_back(WriteLeaf(entries.data() + i, std::min(kMaxLeafEntries, entries.size() - i)));
+        if (leaves.size() > 0xFFFF)
+            throw RegException{"Too many subkeys for a hive.", ERROR_INVALID_PARAMETER};
+
+        const DWORD cell = m_builder.Alloc(4 + leaves.size() * 4);
+        BYTE *ri = m_builder.Payload(cell);
+        std::memcpy(ri, "ri", 2);
+        WriteU16(ri + 2, static_cast<WORD>(leaves.size()));
+        for (std::size_t i = 0; i < leaves.size(); i++)
+            WriteU32(ri + 4 + i * 4, leaves[i]);
+        return cell;
+    }
+
+    HiveBuilder m_builder;
+    DWORD m_security{Hive::kNoCell};
+    DWORD m_keys{0};
+};
+
+} // namespace details
+
+inline std::vector<BYTE> WriteHive(const KeyTree &root, const HiveWriteOptions &options)
+{
+    return details::HiveWriter{}.Write(root, options);
+}
+
+} // namespace regf
+
+#endif // INCLUDE_WINREG_REGFWRITE_HPP
@@ -0,0 +1,721 @@
+#ifndef INCLUDE_WINREG_REGIMPORT_HPP
+#define INCLUDE_WINREG_REGIMPORT_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Parsing and import of .reg files: "Windows Registry Editor Version 5.00"
+// files in UTF-16LE (with a BOM, as regedit writes them) or UTF-8, and
+// "REGEDIT4" files.
+//
+// ParseRegFile() maps the file and splits it at the lines starting a key
+// section ("[HKEY_...]"), into about one part per thread. The parts are
+// parsed in parallel, each into its own list of sections, which are then
+// merged in file order into a change set: one entry per key, sorted so that
+// a key comes before its subkeys. ApplyRegChanges() creates each key once
+// and writes all its values through that handle.
+//
+// The file follows regedit's rules:
+//   [path]          create the key
+//   [-path]         delete the key and its subkeys; what earlier sections
+//                   did to them is dropped from the change set
+//   "name"=...      set a value, @ for the default value: "string",
+//                   dword:0000002a, hex:01,02 (REG_BINARY), hex(<type>):...
+//   "name"=-        delete a value
+// Hex data can span lines ending with "\"; lines starting with ";" are
+// comments. Value data is kept as regedit stores it, strings in UTF-16LE;
+// the string data of hex(1), hex(2) and hex(7) values in REGEDIT4 files is
+// 8-bit text, read as UTF-8 like the rest of 8-bit files.
+//
+// Errors are signaled throwing RegException, like in winreg.hpp; a file that
+// can't be parsed fails with ERROR_INVALID_DATA, giving the line.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mappedfile.hpp" // MappedFile
+#include "regexport.hpp"  // PredefinedKeyName, PredefinedKeyFromName
+#include "regwalk.hpp"    // details::UpperCase
+#include "utf.hpp"        // utf::Utf8ToWide
+#include "winreg.hpp"
+
+#include <algorithm>   // std::min, std::max
+#include <cstring>     // std::memchr
+#include <exception>   // std::exception_ptr
+#include <filesystem>  // std::filesystem::path
+#include <iterator>    // std::back_inserter
+#include <map>         // std::map
+#include <string>      // std::wstring, std::u16string, std::to_string
+#include <thread>      // std::thread
+#include <type_traits> // std::is_same_v
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+namespace winreg
+{
+
+// A value set or deleted by a .reg file
+struct RegFileValue
+{
+    std::wstring name;      // empty for the default value (@)
+    DWORD type{REG_NONE};
+    std::vector<BYTE> data; // raw data, strings in UTF-16LE
+    bool remove{false};     // "name"=-
+};
+
+// What a .reg file does to a key
+struct RegKeyChanges
+{
+    std::wstring path;      // full path, e.g. HKEY_CURRENT_USER\Software\MyApp
+    HKEY root{nullptr};     // the predefined key of the path
+    std::wstring subKey;    // the path below root
+    bool deleteTree{false}; // delete the key and its subkeys first
+    bool create{false};     // then create the key and write its values
+    std::vector<RegFileValue> values; // in file order
+};
+
+// The keys of a .reg file, each before its subkeys
+using RegChangeSet = std::vector<RegKeyChanges>;
+
+// Parse a .reg file, in memory or from disk, with a pool of threads (0: one
+// per CPU). Throw RegException if it can't be read or parsed.
+RegChangeSet ParseRegFile(const BYTE *data, size_t size, unsigned threads = 0);
+RegChangeSet ParseRegFile(const std::filesystem::path &path, unsigned threads = 0);
+
+// What ApplyRegChanges() did
+struct RegImportStats
+{
+    size_t keysWritten{0}; // created or opened to write values
+    size_t keysDeleted{0};
+    size_t valuesSet{0};
+    size_t valuesDeleted{0};
+};
+
+// Apply a change set in order, opening keys with KEY_SET_VALUE and access
+// (e.g. KEY_WOW64_32KEY). Deleting keys and values that don't exist
+// succeeds; other failures throw RegException, leaving the changes made so far.
+RegImportStats ApplyRegChanges(const RegChangeSet &changes, REGSAM access = 0);
+
+namespace details
+{
+
+// The parts of a file are at least this many code units: smaller files are
+// parsed by fewer threads
+constexpr size_t kMinRegFilePart = 256 * 1024;
+
+// A section of a .reg file, as parsed
+struct RegFileSection
+{
+    std::wstring path;
+    HKEY root;
+    std::wstring subKey;
+    bool remove;
+    std::vector<RegFileValue> values;
+};
+
+// The code units of a file: bytes of UTF-8 text, or UTF-16LE units
+struct Utf8Units
+{
+    using Char = char;
+
+    const BYTE *data;
+    size_t size;
+
+    char32_t operator[](const size_t i) const noexcept
+    {
+        return data[i];
+    }
+
+    // Position of the next c at or after pos; size if there is none
+    size_t Find(const size_t pos, const char32_t c) const noexcept
+    {
+        if (pos >= size)
+            return size;
+        const void *found = std::memchr(data + pos, static_cast<int>(c), size - pos);
+        return found == nullptr ? size : static_cast<size_t>(static_cast<const BYTE *>(found) - data);
+    }
+};
+
+struct Utf16Units
+{
+    using Char = char16_t;
+
+    const BYTE *data;
+    size_t size;
+
+    char32_t operator[](const size_t i) const noexcept
+    {
+        return static_cast<char32_t>(data[2 * i] | (data[2 * i + 1] << 8));
+    }
+
+    size_t Find(size_t pos, const char32_t c) const noexcept
+    {
+        while (pos < size && (*this)[pos] != c)
+            pos++;
+        return pos;
+    }
+};
+
+inline bool IsStringType(const DWORD type) noexcept
+{
+    return type == REG_SZ || type == REG_EXPAND_SZ || type == REG_MULTI_SZ;
+}
+
+inline int HexDigit(const char32_t c) noexcept
+{
+    if (c >= '0' && c <= '9')
+        return static_cast<int>(c - '0');
+    if (c >= 'a' && c <= 'f')
+        return static_cast<int>(c - 'a' + 10);
+    if (c >= 'A' && c <= 'F')
+        return static_cast<int>(c - 'A' + 10);
+    return -1;
+}
+
+inline void AppendUtf16(std::vector<BYTE> &out, const std::u16string &s)
+{
+    for (const char16_t c : s)
+    {
+        out.push_back(static_cast<BYTE>(c));
+        out.push_back(static_cast<BYTE>(c >> 8));
+    }
+}
+
+inline void Utf16ToWide(const std::u16string &s, std::wstring &out)
+{
+    out.clear();
+    for (size_t i = 0; i < s.size(); i++)
+    {
+        char32_t c = s[i];
+        if (sizeof(wchar_t) > 2 && c >= 0xD800 && c <= 0xDBFF && i + 1 < s.size() && s[i + 1] >= 0xDC00 &&
+            s[i + 1] <= 0xDFFF)
+        {
+            c = 0x10000 + ((c - 0xD800) << 10) + (s[++i] - 0xDC00);
+        }
+        out.push_back(static_cast<wchar_t>(c));
+    }
+}
+
+// The data of a value as RegSetValueEx takes it: strings in wchar_t units,
+// which are 32-bit outside Windows. wide is the buffer for the conversion.
+inline void NativeValueData(const RegFileValue &value, std::wstring &wide, const BYTE *&data, DWORD &size)
+{
+    data = value.data.data();
+    size = static_cast<DWORD>(value.data.size());
+    if (sizeof(wchar_t) != 2 && IsStringType(value.type))
+    {
+        wide.clear();
+        regf::details::AppendUtf16(wide, value.data.data(), value.data.size() / 2);
+        data = reinterpret_cast<const BYTE *>(wide.data());
+        size = static_cast<DWORD>(wide.size() * sizeof(wchar_t));
+    }
+}
+
+// Order of upper-cased key paths that puts a key right before its subkeys
+struct KeyPathLess
+{
+    bool operator()(const std::wstring &a, const std::wstring &b) const noexcept
+    {
+        const size_t n = std::min(a.size(), b.size());
+        for (size_t i = 0; i < n; i++)
+        {
+            if (a[i] != b[i])
+            {
+                if (a[i] == L'\\')
+                    return true;
+                if (b[i] == L'\\')
+                    return false;
+                return a[i] < b[i];
+            }
+        }
+        return a.size() < b.size();
+    }
+};
+
+// Is path (upper-cased) key or one of its subkeys?
+inline bool IsInSubtree(const std::wstring &path, const std::wstring &key) noexcept
+{
+    return path.size() >= key.size() && path.compare(0, key.size(), key) == 0 &&
+           (path.size() == key.size() || path[key.size()] == L'\\');
+}
+
+//------------------------------------------------------------------------------
+// Parses the sections of a .reg file. Copies share the file; each thread
+// parses with its own copy.
+//------------------------------------------------------------------------------
+template <typename Units>
+class RegFileParser
+{
+  public:
+    explicit RegFileParser(const Units units) noexcept : m_units{units}
+    {
+    }
+
+    // Check the header line; return where the sections begin
+    size_t Header()
+    {
+        const size_t lineEnd = m_units.Find(0, '\n');
+        const size_t end = TrimEnd(0, lineEnd);
+        if (Matches(0, end, "Windows Registry Editor Version 5.00"))
+            m_regedit4 = false;
+        else if (Matches(0, end, "REGEDIT4"))
+            m_regedit4 = true;
+        else
+        {
+            throw RegException{
+                "Not a .reg file: missing the \"Windows Registry Editor Version 5.00\" or \"REGEDIT4\" header.",
+                ERROR_INVALID_DATA};
+        }
+        return std::min(lineEnd + 1, m_units.size);
+    }
+
+    // Position of the first section starting at or after pos
+    size_t NextSection(size_t pos) const noexcept
+    {
+        while (pos < m_units.size && !(m_units[pos] == '[' && pos > 0 && m_units[pos - 1] == '\n'))
+        {
+            pos = m_units.Find(pos, '\n');
+            if (pos < m_units.size)
+                pos++;
+        }
+        return pos;
+    }
+
+    // Parse the sections starting in [begin, end); begin is the start of a line
+    void Parse(size_t pos, const size_t end, std::vector<RegFileSection> &sections)
+    {
+        while (pos < m_units.size)
+        {
+            const size_t lineEnd = m_units.Find(pos, '\n');
+            const size_t p = SkipBlanks(pos, lineEnd);
+            if (p == lineEnd || m_units[p] == ';')
+            {
+                pos = lineEnd + 1;
+                continue;
+            }
+
+            if (m_units[p] == '[')
+            {
+                if (p >= end)
+                    break;
+                sections.push_back(Section(p, lineEnd));
+                pos = lineEnd + 1;
+            }
+            else if (sections.empty())
+            {
+                Fail(p, "value outside of a key section");
+            }
+            else
+            {
+                pos = Value(p, lineEnd, sections.back().values);
+            }
+        }
+    }
+
+  private:
+    static bool IsBlank(const char32_t c) noexcept
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    size_t SkipBlanks(size_t pos, const size_t end) const noexcept
+    {
+        while (pos < end && IsBlank(m_units[pos]))
+            pos++;
+        return pos;
+    }
+
+    size_t TrimEnd(const size_t begin, size_t end) const noexcept
+    {
+        while (end > begin && IsBlank(m_units[end - 1]))
+            end--;
+        return end;
+    }
+
+    // Is [pos, end) the ASCII text s?
+    bool Matches(size_t pos, const size_t end, const char *s) const noexcept
+    {
+        for (; *s != '\0'; s++, pos++)
+        {
+            if (pos == end || m_units[pos] != static_cast<char32_t>(*s))
+                return false;
+        }
+        return pos == end;
+    }
+
+    // Does the text at pos start with s, ignoring case?
+    bool StartsWith(size_t pos, const size_t end, const char *s) const noexcept
+    {
+        for (; *s != '\0'; s++, pos++)
+        {
+            if (pos == end || (m_units[pos] | 0x20) != static_cast<char32_t>(*s))
+                return false;
+        }
+        return true;
+    }
+
+    [[noreturn]] void Fail(const size_t pos, const char *what) const
+    {
+        size_t line = 1;
+        for (size_t i = m_units.Find(0, '\n'); i < pos; i = m_units.Find(i + 1, '\n'))
+            line++;
+        throw RegException{"Invalid .reg file, line " + std::to_string(line) + ": " + what + ".", ERROR_INVALID_DATA};
+    }
+
+    // Decode [begin, end) to UTF-16
+    void Text(const size_t begin, const size_t end, std::u16string &out)
+    {
+        if constexpr (std::is_same_v<Units, Utf8Units>)
+        {
+            utf::Utf8ToWide(reinterpret_cast<const char *>(m_units.data + begin), end - begin, out);
+        }
+        else
+        {
+            out.clear();
+            for (size_t i = begin; i < end; i++)
+                out.push_back(static_cast<char16_t>(m_units[i]));
+        }
+    }
+
+    // [path] or [-path], from p to the end of the line
+    RegFileSection Section(const size_t p, const size_t lineEnd)
+    {
+        const size_t end = TrimEnd(p, lineEnd);
+        if (end - p < 2 || m_units[end - 1] != ']')
+            Fail(p, "missing ] after the key path");
+
+        RegFileSection section;
+        section.remove = m_units[p + 1] == '-';
+        size_t pathEnd = end - 1;
+        while (pathEnd > p + 1 && m_units[pathEnd - 1] == '\\')
+            pathEnd--;
+        Text(p + 1 + section.remove, pathEnd, m_text);
+        Utf16ToWide(m_text, section.path);
+
+        const size_t separator = section.path.find(L'\\');
+        section.root = PredefinedKeyFromName(std::wstring_view{section.path}.substr(0, separator));
+        if (section.root == nullptr)
+            Fail(p, "unknown root key");
+        if (separator != std::wstring::npos)
+            section.subKey = section.path.substr(separator + 1);
+        else if (section.remove)
+            Fail(p, "a root key can't be deleted");
+
+        // One spelling per key, whatever the file uses
+        section.path = PredefinedKeyName(section.root);
+        if (!section.subKey.empty())
+            section.path += L'\\' + section.subKey;
+        return section;
+    }
+
+    // A quoted string starting at p: unescape \\ and \" into m_text; return
+    // the position after the closing quote
+    size_t Quoted(size_t p, const size_t lineEnd)
+    {
+        m_raw.clear();
+        for (p++;; p++)
+        {
+            if (p == lineEnd)
+                Fail(p, "missing closing quote");
+            char32_t c = m_units[p];
+            if (c == '"')
+                break;
+            if (c == '\\' && p + 1 < lineEnd && (m_units[p + 1] == '\\' || m_units[p + 1] == '"'))
+                c = m_units[++p];
+            m_raw.push_back(static_cast<typename Units::Char>(c));
+        }
+
+        if constexpr (std::is_same_v<Units, Utf8Units>)
+            utf::Utf8ToWide(m_raw.data(), m_raw.size(), m_text);
+        else
+            m_text = m_raw;
+        return p + 1;
+    }
+
+    // Comma-separated hex bytes, from p, following "\" continuations; return
+    // the position after them, with lineEnd the end of their last line
+    size_t HexBytes(size_t p, size_t &lineEnd, std::vector<BYTE> &data)
+    {
+        for (;;)
+        {
+            p = SkipBlanks(p, lineEnd);
+            if (p == lineEnd)
+                return p;
+            if (m_units[p] == '\\')
+            {
+                if (SkipBlanks(p + 1, lineEnd) != lineEnd || lineEnd == m_units.size)
+                    Fail(p, "bad line continuation");
+                p = lineEnd + 1;
+                lineEnd = m_units.Find(p, '\n');
+                continue;
+            }
+
+            int byte = HexDigit(m_units[p]);
+            if (byte < 0)
+                Fail(p, "bad hex data");
+            if (++p < lineEnd && HexDigit(m_units[p]) >= 0)
+                byte = byte * 16 + HexDigit(m_units[p++]);
+            data.push_back(static_cast<BYTE>(byte));
+
+            p = SkipBlanks(p, lineEnd);
+            if (p == lineEnd || m_units[p] != ',')
+                return p;
+            p++;
+        }
+    }
+
+    // A value line starting at p; return the position after it
+    size_t Value(size_t p, size_t lineEnd, std::vector<RegFileValue> &values)
+    {
+        RegFileValue value;
+        if (m_units[p] == '@')
+        {
+            p++;
+        }
+        else if (m_units[p] == '"')
+        {
+            p = Quoted(p, lineEnd);
+            Utf16ToWide(m_text, value.name);
+        }
+        else
+        {
+            Fail(p, "expected a value name");
+        }
+
+        p = SkipBlanks(p, lineEnd);
+        if (p == lineEnd || m_units[p] != '=')
+            Fail(p, "expected = after the value name");
+        p = SkipBlanks(p + 1, lineEnd);
+
+        if (p < lineEnd && m_units[p] == '"')
+        {
+            p = Quoted(p, lineEnd);
+            value.type = REG_SZ;
+            AppendUtf16(value.data, m_text);
+            value.data.insert(value.data.end(), 2, 0);
+        }
+        else if (p < lineEnd && m_units[p] == '-')
+        {
+            value.remove = true;
+            p++;
+        }
+        else if (StartsWith(p, lineEnd, "dword:"))
+        {
+            DWORD n = 0;
+            int digits = 0;
+            for (p += 6; p < lineEnd && HexDigit(m_units[p]) >= 0; p++, digits++)
+                n = (n << 4) | static_cast<DWORD>(HexDigit(m_units[p]));
+            if (digits == 0 || digits > 8)
+                Fail(p, "bad dword data");
+            value.type = REG_DWORD;
+            for (int i = 0; i < 4; i++)
+                value.data.push_back(static_cast<BYTE>(n >> (8 * i)));
+        }
+        else if (StartsWith(p, lineEnd, "hex"))
+        {
+            value.type = REG_BINARY;
+            p += 3;
+            if (p < lineEnd && m_units[p] == '(')
+            {
+                DWORD type = 0;
+                int digits = 0;
+                for (p++; p < lineEnd && HexDigit(m_units[p]) >= 0; p++, digits++)
+                    type = (type << 4) | static_cast<DWORD>(HexDigit(m_units[p]));
+                if (digits == 0 || digits > 8 || p == lineEnd || m_units[p] != ')')
+                    Fail(p, "bad hex value type");
+                value.type = type;
+                p++;
+            }
+            if (p == lineEnd || m_units[p] != ':')
+                Fail(p, "expected : after hex");
+            p = HexBytes(p + 1, lineEnd, value.data);
+
+            if (m_regedit4 && IsStringType(value.type))
+            {
+                utf::Utf8ToWide(reinterpret_cast<const char *>(value.data.data()), value.data.size(), m_text);
+                value.data.clear();
+                AppendUtf16(value.data, m_text);
+            }
+        }
+        else
+        {
+            Fail(p, "unrecognized value data");
+        }
+
+        if (SkipBlanks(p, lineEnd) != lineEnd)
+            Fail(p, "unexpected text after the value");
+        values.push_back(std::move(value));
+        return lineEnd + 1;
+    }
+
+    Units m_units;
+    bool m_regedit4{false};
+
+    // Scratch buffers
+    std::basic_string<typename Units::Char> m_raw;
+    std::u16string m_text;
+};
+
+// Merge the sections of the parts, in file order, into one entry per key
+inline RegChangeSet MergeSections(std::vector<std::vector<RegFileSection>> &parts)
+{
+    std::map<std::wstring, RegKeyChanges, KeyPathLess> keys;
+    for (auto &part : parts)
+    {
+        for (auto &section : part)
+        {
+            std::wstring folded = UpperCase(section.path);
+            if (section.remove)
+            {
+                // The subtree goes: drop what earlier sections did to it
+                auto it = keys.lower_bound(folded);
+                while (it != keys.end() && IsInSubtree(it->first, folded))
+                    it = keys.erase(it);
+            }
+
+            auto [it, inserted] = keys.try_emplace(std::move(folded));
+            RegKeyChanges &key = it->second;
+            if (inserted)
+            {
+                key.path = std::move(section.path);
+                key.root = section.root;
+                key.subKey = std::move(section.subKey);
+            }
+
+            if (section.remove)
+            {
+                key.deleteTree = true;
+            }
+            else
+            {
+                key.create = true;
+                if (key.values.empty())
+                    key.values = std::move(section.values);
+                else
+                    std::move(section.values.begin(), section.values.end(), std::back_inserter(key.values));
+            }
+        }
+        part.clear();
+    }
+
+    RegChangeSet changes;
+    changes.reserve(keys.size());
+    for (auto &key : keys)
+        changes.push_back(std::move(key.second));
+    return changes;
+}
+
+template <typename Units>
+RegChangeSet ParseRegUnits(const Units units, unsigned threads)
+{
+    RegFileParser<Units> parser{units};
+    const size_t body = parser.Header();
+
+    // Split the sections into parts of about the same size
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t bodySize = units.size - body;
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, bodySize / kMinRegFilePart)));
+
+    std::vector<size_t> starts{body};
+    for (unsigned i = 1; i < threads; i++)
+    {
+        const size_t start = parser.NextSection(body + bodySize / threads * i);
+        if (start > starts.back() && start < units.size)
+            starts.push_back(start);
+    }
+
+    std::vector<std::vector<RegFileSection>> parts(starts.size());
+    std::vector<std::exception_ptr> errors(starts.size());
+    const auto parse = [&](const size_t i) {
+        try
+        {
+            RegFileParser<Units> partParser{parser};
+            partParser.Parse(starts[i], i + 1 < starts.size() ? starts[i + 1] : units.size, parts[i]);
+        }
+        catch (...)
+        {
+            errors[i] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < starts.size(); i++)
+        workers.emplace_back(parse, i);
+    parse(0);
+    for (auto &worker : workers)
+        worker.join();
+
+    // The first error in the file
+    for (const auto &error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+    return MergeSections(parts);
+}
+
+} // namespace details
+
+inline RegChangeSet ParseRegFile(const BYTE *const data, const size_t size, const unsigned threads)
+{
+    if (size >= 2 && data[0] == 0xFF && data[1] == 0xFE)
+        return details::ParseRegUnits(details::Utf16Units{data + 2, (size - 2) / 2}, threads);
+    if (size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF)
+        return details::ParseRegUnits(details::Utf8Units{data + 3, size - 3}, threads);
+    return details::ParseRegUnits(details::Utf8Units{data, size}, threads);
+}
+
+inline RegChangeSet ParseRegFile(const std::filesystem::path &path, const unsigned threads)
+{
+    const MappedFile file{path};
+    return ParseRegFile(file.Data(), file.Size(), threads);
+}
+
+inline RegImportStats ApplyRegChanges(const RegChangeSet &changes, const REGSAM access)
+{
+    RegImportStats stats;
+    std::wstring wide;
+    for (const auto &key : changes)
+    {
+        if (key.deleteTree)
+        {
+            RegKey root;
+            root.Open(key.root, L"", DELETE | KEY_ENUMERATE_SUB_KEYS | KEY_QUERY_VALUE | access);
+            const LONG code = ::RegDeleteTree(root.Get(), key.subKey.c_str());
+            if (code == ERROR_SUCCESS)
+                stats.keysDeleted++;
+            else if (code != ERROR_FILE_NOT_FOUND)
+                throw RegException{"Cannot delete key: RegDeleteTree failed.", code};
+        }
+        if (!key.create)
+            continue;
+
+        RegKey regKey;
+        regKey.Create(key.root, key.subKey, KEY_SET_VALUE | access);
+        stats.keysWritten++;
+        for (const auto &value : key.values)
+        {
+            if (value.remove)
+            {
+                const LONG code = ::RegDeleteValue(regKey.Get(), value.name.c_str());
+                if (code == ERROR_SUCCESS)
+                    stats.valuesDeleted++;
+                else if (code != ERROR_FILE_NOT_FOUND)
+                    throw RegException{"Cannot delete value: RegDeleteValue failed.", code};
+                continue;
+            }
+
+            const BYTE *data;
+            DWORD size;
+            details::NativeValueData(value, wide, data, size);
+            const LONG code = ::RegSetValueEx(regKey.Get(), value.name.c_str(), 0, value.type, data, size);
+            if (code != ERROR_SUCCESS)
+                throw RegException{"Cannot write value: RegSetValueEx failed.", code};
+            stats.valuesSet++;
+        }
+    }
+    return stats;
+}
+
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_REGIMPORT_HPP
@@ -0,0 +1,322 @@
+#ifndef INCLUDE_WINREG_REGSCAN_HPP
+#define INCLUDE_WINREG_REGSCAN_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Incremental re-scans of a live registry subtree, driven by the last write
+// times of the keys.
+//
+// A ScanState keeps what the previous scan saw: every key with its last
+// write time, its selected values and its subkeys. IncrementalScan() walks
+// the subtree again, updates the state and returns the keys added, removed
+// or whose values changed since.
+//
+// The registry updates the last write time of a key when its values change
+// or a direct subkey is added or removed, but not when something deeper
+// down changes. So a key whose time didn't move keeps its values and its
+// set of subkeys, and is not read again: its subkeys' times come with the
+// enumeration of its parent (RegEnumKeyEx), and it is only opened to check
+// the times of its own subkeys, if it has any. Re-scanning an unchanged key
+// with leaf subkeys costs one RegEnumKeyEx call per subkey.
+//
+// SaveScanState() and LoadScanState() turn a state into bytes and back, so
+// it can outlive the process.
+//
+// Errors are signaled throwing RegException, like in winreg.hpp.
+// Subkeys that disappear or can't be opened during the scan are skipped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "regstream.hpp" // details::ByteWriter, details::ByteReader
+#include "regwalk.hpp"   // WalkOptions, details::ReadValues, details::UpperCase
+#include "winreg.hpp"
+
+#include <cstdint>       // std::uint32_t, std::uint64_t
+#include <cstring>       // std::memcmp
+#include <string>        // std::wstring
+#include <unordered_map> // std::unordered_map
+#include <utility>       // std::move
+#include <vector>        // std::vector
+
+namespace winreg
+{
+
+//------------------------------------------------------------------------------
+// A key as seen by the previous scan; the root one is the whole state
+//------------------------------------------------------------------------------
+struct ScanState
+{
+    std::wstring name;
+
+    // FILETIME ticks; 0 for a key never scanned
+    ULONGLONG lastWriteTime{0};
+
+    std::vector<RegValue> values;
+    std::vector<ScanState> subKeys;
+};
+
+//------------------------------------------------------------------------------
+// The changes found by a scan. Paths are relative to the scanned key ("" for
+// the key itself); a subtree added or removed lists all of its keys, parents
+// first. The first scan of a state reports every key as added.
+//------------------------------------------------------------------------------
+struct ScanDelta
+{
+    struct Key
+    {
+        std::wstring path;
+
+        // The values as they are now
+        std::vector<RegValue> values;
+    };
+
+    std::vector<Key> added;
+    std::vector<Key> changed;
+    std::vector<std::wstring> removed;
+
+    // Keys opened and read during the scan
+    unsigned long long keysOpened{0};
+    unsigned long long keysRead{0};
+};
+
+// Scan the given key and its subtree, as selected by the options (the same
+// options must be used for every scan of a state), against the state of the
+// previous scan, and update it. If the key doesn't exist, every key of the
+// state is removed. Throw RegException if the key can't be opened or read.
+ScanDelta IncrementalScan(
+    HKEY hKeyParent,
+    const std::wstring &subKey,
+    const WalkOptions &options,
+    ScanState &state);
+
+// Serialize a scan state, and read it back; LoadScanState() throws
+// RegException (ERROR_INVALID_DATA) on bytes that are not a saved state.
+std::vector<BYTE> SaveScanState(const ScanState &state);
+ScanState LoadScanState(const BYTE *data, size_t size);
+
+namespace details
+{
+
+inline ULONGLONG FileTimeTicks(const FILETIME &ft) noexcept
+{
+    return (static_cast<ULONGLONG>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+}
+
+inline bool SameValues(const std::vector<RegValue> &a, const std::vector<RegValue> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i].type != b[i].type || a[i].name != b[i].name || a[i].data != b[i].data)
+            return false;
+    }
+    return true;
+}
+
+class Scanner
+{
+  public:
+    Scanner(const WalkOptions &options, ScanDelta &delta) : m_options{options}, m_delta{delta}
+    {
+    }
+
+    // Rescan an open key, last written at the given time, into its state
+    void Scan(RegKey &key, const ULONGLONG lastWriteTime, ScanState &state, const std::wstring &path, const int depth)
+    {
+        const bool isNew = state.lastWriteTime == 0;
+        const bool moved = isNew || lastWriteTime != state.lastWriteTime;
+        if (moved)
+        {
+            std::vector<RegValue> values = ReadValues(key, m_options);
+            m_delta.keysRead++;
+            if (isNew)
+                m_delta.added.push_back(ScanDelta::Key{path, values});
+            else if (!SameValues(values, state.values))
+                m_delta.changed.push_back(ScanDelta::Key{path, values});
+            state.values = std::move(values);
+            state.lastWriteTime = lastWriteTime;
+        }
+
+        if (m_options.depth >= 0 && depth >= m_options.depth)
+            return;
+
+        // Same time: no subkey added or removed since, and none to look at
+        if (!moved && state.subKeys.empty())
+            return;
+
+        // The previous subkeys by name
+        std::unordered_map<std::wstring, size_t> previous;
+        previous.reserve(state.subKeys.size());
+        for (size_t i = 0; i < state.subKeys.size(); i++)
+            previous.emplace(UpperCase(state.subKeys[i].name), i);
+        std::vector<bool> seen(state.subKeys.size());
+
+        const SubKeyDetails subKeys = key.EnumSubKeysDetailed();
+        std::vector<ScanState> next;
+        next.reserve(subKeys.names.size());
+        for (size_t i = 0; i < subKeys.names.size(); i++)
+        {
+            std::wstring name{subKeys.names[i].name};
+            const ULONGLONG subKeyTime = FileTimeTicks(subKeys.lastWriteTimes[i]);
+
+            ScanState subKeyState;
+            const auto found = previous.find(UpperCase(name));
+            if (found != previous.end())
+            {
+                seen[found->second] = true;
+                subKeyState = std::move(state.subKeys[found->second]);
+            }
+            subKeyState.name = std::move(name);
+
+            // Unchanged, and nothing below it to check
+            const bool atDepth = m_options.depth >= 0 && depth + 1 >= m_options.depth;
+            if (subKeyState.lastWriteTime == subKeyTime && (atDepth || subKeyState.subKeys.empty()))
+            {
+                next.push_back(std::move(subKeyState));
+                continue;
+            }
+
+            RegKey subKey;
+            const RegResult opened = subKey.TryOpen(key.Get(), subKeyState.name, m_options.access);
+            if (opened.Failed())
+            {
+                // Deleted meanwhile, or not readable by us: gone from the state
+                const LONG code = opened.Code();
+                if (code == ERROR_FILE_NOT_FOUND || code == ERROR_ACCESS_DENIED || code == ERROR_KEY_DELETED)
+                {
+                    if (subKeyState.lastWriteTime != 0)
+                        Removed(subKeyState, ChildPath(path, subKeyState.name));
+                    continue;
+                }
+                opened.ThrowIfFailed();
+            }
+            m_delta.keysOpened++;
+
+            Scan(subKey, subKeyTime, subKeyState, ChildPath(path, subKeyState.name), depth + 1);
+            next.push_back(std::move(subKeyState));
+        }
+
+        for (size_t i = 0; i < state.subKeys.size(); i++)
+        {
+            if (!seen[i])
+                Removed(state.subKeys[i], ChildPath(path, state.subKeys[i].name));
+        }
+        state.subKeys = std::move(next);
+    }
+
+    // Report a key and its subtree as removed
+    void Removed(const ScanState &state, const std::wstring &path)
+    {
+        m_delta.removed.push_back(path);
+        for (const auto &subKey : state.subKeys)
+            Removed(subKey, ChildPath(path, subKey.name));
+    }
+
+  private:
+    const WalkOptions &m_options;
+    ScanDelta &m_delta;
+};
+
+//------------------------------------------------------------------------------
+// Saved state format (see regstream.hpp for numbers, strings and values):
+// "WRSS", a format version (DWORD), then the root key. A key is its name,
+// last write time (QWORD), value count (DWORD) and values, subkey count
+// (DWORD) and subkeys.
+//------------------------------------------------------------------------------
+constexpr BYTE kScanStateMagic[4] = {'W', 'R', 'S', 'S'};
+constexpr std::uint32_t kScanStateVersion = 1;
+
+inline void WriteScanKey(ByteWriter &writer, const ScanState &state)
+{
+    writer.String(state.name);
+    writer.Number(state.lastWriteTime, 8);
+    writer.Number(state.values.size(), 4);
+    for (const auto &value : state.values)
+        writer.Value(value);
+    writer.Number(state.subKeys.size(), 4);
+    for (const auto &subKey : state.subKeys)
+        WriteScanKey(writer, subKey);
+}
+
+inline void ReadScanKey(ByteReader &reader, ScanState &state, const int depth)
+{
+    // Deeper than any registry tree (512 levels)
+    if (depth > 512)
+        reader.Corrupt();
+    reader.String(state.name);
+    state.lastWriteTime = reader.Number(8);
+    state.values.resize(reader.Count(4 + 4 + 1));
+    for (auto &value : state.values)
+        reader.Value(value);
+    state.subKeys.resize(reader.Count(4 + 8 + 4 + 4));
+    for (auto &subKey : state.subKeys)
+        ReadScanKey(reader, subKey, depth + 1);
+}
+
+} // namespace details
+
+inline ScanDelta IncrementalScan(
+    const HKEY hKeyParent,
+    const std::wstring &subKey,
+    const WalkOptions &options,
+    ScanState &state)
+{
+    ScanDelta delta;
+    details::Scanner scanner{options, delta};
+
+    RegKey key;
+    const RegResult opened = key.TryOpen(hKeyParent, subKey, options.access);
+    if (opened.Code() == ERROR_FILE_NOT_FOUND)
+    {
+        if (state.lastWriteTime != 0)
+            scanner.Removed(state, L"");
+        state = ScanState{};
+        return delta;
+    }
+    opened.ThrowIfFailed();
+    delta.keysOpened++;
+
+    DWORD subKeys = 0;
+    DWORD values = 0;
+    FILETIME lastWriteTime{};
+    key.QueryInfoKey(subKeys, values, lastWriteTime);
+
+    if (state.lastWriteTime == 0)
+    {
+        const size_t slash = subKey.find_last_of(L'\\');
+        state.name = slash == std::wstring::npos ? subKey : subKey.substr(slash + 1);
+    }
+    scanner.Scan(key, details::FileTimeTicks(lastWriteTime), state, L"", 0);
+    return delta;
+}
+
+inline std::vector<BYTE> SaveScanState(const ScanState &state)
+{
+    details::ByteWriter writer;
+    writer.Bytes(details::kScanStateMagic, sizeof(details::kScanStateMagic));
+    writer.Number(details::kScanStateVersion, 4);
+    details::WriteScanKey(writer, state);
+    return std::move(writer.Out());
+}
+
+inline ScanState LoadScanState(const BYTE *const data, const size_t size)
+{
+    details::ByteReader reader{data, size, "Not a saved scan state, or a corrupt one."};
+    const BYTE *magic = reader.Bytes(sizeof(details::kScanStateMagic));
+    if (std::memcmp(magic, details::kScanStateMagic, sizeof(details::kScanStateMagic)) != 0 ||
+        reader.Number(4) != details::kScanStateVersion)
+    {
+        reader.Corrupt();
+    }
+
+    ScanState state;
+    details::ReadScanKey(reader, state, 0);
+    if (!reader.AtEnd())
+        reader.Corrupt();
+    return state;
+}
+
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_REGSCAN_HPP
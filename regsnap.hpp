@@ -0,0 +1,513 @@
+#ifndef INCLUDE_WINREG_REGSNAP_HPP
+#define INCLUDE_WINREG_REGSNAP_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Snapshot files with Merkle hashes, and diffs between them.
+//
+// SaveSnapshot() stores a KeySnapshot (read by Snapshot() or
+// ParallelSnapshot() in regwalk.hpp) as a file where every key carries a
+// 128-bit hash of its values and of its subkeys' names and hashes. Two keys
+// with the same hash have the same values and the same subtree, so
+// DiffSnapshots() compares two files from the root down, skipping identical
+// subtrees: the cost is proportional to the keys that changed (and their
+// direct subkeys), not to the size of the snapshots.
+//
+// Files are read in place from a memory mapping (SnapshotFile::Open) or a
+// buffer (SnapshotFile::FromMemory), only touching the keys the diff visits.
+// Nothing here needs a live registry: snapshots taken on Windows can be
+// diffed anywhere.
+//
+// Errors are signaled throwing RegException; a file that is not a snapshot
+// or is corrupt throws ERROR_INVALID_DATA.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mappedfile.hpp" // winreg::MappedFile
+#include "regstream.hpp"  // details::ByteWriter, details::ByteReader
+#include "regwalk.hpp"    // KeySnapshot, details::UpperCase, details::ChildPath
+#include "winreg.hpp"
+
+#include <algorithm>     // std::sort
+#include <cstdint>       // std::uint64_t
+#include <cstring>       // std::memcmp, std::memcpy
+#include <filesystem>    // std::filesystem::path
+#include <string>        // std::wstring
+#include <unordered_map> // std::unordered_map
+#include <unordered_set> // std::unordered_set
+#include <utility>       // std::move
+#include <vector>        // std::vector
+
+namespace winreg
+{
+
+//------------------------------------------------------------------------------
+// Hash of a key in a snapshot file (MurmurHash3 x64 128 of its record)
+//------------------------------------------------------------------------------
+struct SnapshotHash
+{
+    BYTE bytes[16]{};
+
+    bool operator==(const SnapshotHash &other) const noexcept
+    {
+        return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+    }
+
+    bool operator!=(const SnapshotHash &other) const noexcept
+    {
+        return !(*this == other);
+    }
+};
+
+// Store a snapshot with the hashes of its keys, as the bytes of a file
+std::vector<BYTE> SaveSnapshot(const KeySnapshot &snapshot);
+
+namespace details
+{
+class SnapshotDiffer;
+}
+
+//------------------------------------------------------------------------------
+// A snapshot file, read in place
+//------------------------------------------------------------------------------
+class SnapshotFile
+{
+  public:
+    // Map a snapshot file. Throw RegException on failure.
+    static SnapshotFile Open(const std::filesystem::path &path);
+
+    // Use a snapshot in memory; the caller keeps the data alive
+    static SnapshotFile FromMemory(const void *data, size_t size);
+
+    const SnapshotHash &RootHash() const noexcept
+    {
+        return m_rootHash;
+    }
+
+    // Keys in the snapshot
+    std::uint64_t KeyCount() const noexcept
+    {
+        return m_keyCount;
+    }
+
+  private:
+    SnapshotFile(MappedFile file, const BYTE *data, size_t size);
+
+    friend class details::SnapshotDiffer;
+
+    MappedFile m_file;
+    const BYTE *m_data{nullptr};
+    size_t m_size{0};
+    SnapshotHash m_rootHash;
+    std::uint64_t m_rootOffset{0};
+    std::uint64_t m_keyCount{0};
+};
+
+//------------------------------------------------------------------------------
+// The differences between two snapshots. Paths are relative to the snapshot
+// root ("" for the root itself); a subtree added or removed lists all of its
+// keys, parents first.
+//------------------------------------------------------------------------------
+struct SnapshotDiff
+{
+    struct Key
+    {
+        std::wstring path;
+        std::vector<RegValue> values;
+    };
+
+    // A key whose values differ
+    struct Change
+    {
+        std::wstring path;
+        std::vector<RegValue> before;
+        std::vector<RegValue> after;
+    };
+
+    std::vector<Key> added;
+    std::vector<std::wstring> removed;
+    std::vector<Change> changed;
+
+    // Pairs of keys with different hashes that were compared
+    unsigned long long keysCompared{0};
+};
+
+SnapshotDiff DiffSnapshots(const SnapshotFile &before, const SnapshotFile &after);
+
+namespace details
+{
+
+//------------------------------------------------------------------------------
+// File format (see regstream.hpp for numbers, strings and values):
+//
+// Header: "WRMS", format version (DWORD), root key offset (QWORD), root key
+// hash (16 bytes), key count (QWORD).
+//
+// Key records follow, each subkey before its parent:
+//   byte size of the values part (DWORD)
+//   values part: value count (DWORD), values
+//   subkey count (DWORD), then per subkey its name and hash (16 bytes)
+//   per subkey, the offset of its record (QWORD)
+// Values and subkeys are sorted by upper-case name. The hash of a key covers
+// its record up to the subkey offsets, so it only depends on the content.
+//------------------------------------------------------------------------------
+constexpr BYTE kSnapshotMagic[4] = {'W', 'R', 'M', 'S'};
+constexpr std::uint32_t kSnapshotVersion = 1;
+constexpr size_t kSnapshotHeaderSize = 4 + 4 + 8 + 16 + 8;
+constexpr const char *kSnapshotCorrupt = "Not a snapshot file, or a corrupt one.";
+
+inline std::uint64_t Rotl64(const std::uint64_t x, const int r) noexcept
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t Fmix64(std::uint64_t k) noexcept
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+inline std::uint64_t Load64(const BYTE *p) noexcept
+{
+    std::uint64_t n = 0;
+    for (int i = 0; i < 8; i++)
+        n |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+    return n;
+}
+
+// MurmurHash3_x64_128 (public domain, Austin Appleby), seed 0
+inline SnapshotHash Murmur3(const BYTE *data, const size_t size) noexcept
+{
+    const std::uint64_t c1 = 0x87c37b91114253d5ULL;
+    const std::uint64_t c2 = 0x4cf5ad432745937fULL;
+    std::uint64_t h1 = 0;
+    std::uint64_t h2 = 0;
+
+    const size_t blocks = size / 16;
+    for (size_t i = 0; i < blocks; i++)
+    {
+        std::uint64_t k1 = Load64(data + 16 * i);
+        std::uint64_t k2 = Load64(data + 16 * i + 8);
+
+        k1 *= c1;
+        k1 = Rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = Rotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = Rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = Rotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const BYTE *tail = data + 16 * blocks;
+    const size_t rest = size & 15;
+    std::uint64_t k1 = 0;
+    std::uint64_t k2 = 0;
+    for (size_t i = rest; i > 8; i--)
+        k2 |= static_cast<std::uint64_t>(tail[i - 1]) << (8 * (i - 9));
+    if (rest > 8)
+    {
+        k2 *= c2;
+        k2 = Rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+    }
+    for (size_t i = rest < 8 ? rest : 8; i > 0; i--)
+        k1 |= static_cast<std::uint64_t>(tail[i - 1]) << (8 * (i - 1));
+    if (rest > 0)
+    {
+        k1 *= c1;
+        k1 = Rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    h1 ^= size;
+    h2 ^= size;
+    h1 += h2;
+    h2 += h1;
+    h1 = Fmix64(h1);
+    h2 = Fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    SnapshotHash hash;
+    for (int i = 0; i < 8; i++)
+    {
+        hash.bytes[i] = static_cast<BYTE>(h1 >> (8 * i));
+        hash.bytes[8 + i] = static_cast<BYTE>(h2 >> (8 * i));
+    }
+    return hash;
+}
+
+// Indexes of items sorted by upper-case name
+template <typename T, typename Name>
+std::vector<size_t> SortedByName(const std::vector<T> &items, Name &&name)
+{
+    std::vector<std::wstring> keys;
+    keys.reserve(items.size());
+    for (const auto &item : items)
+        keys.push_back(UpperCase(name(item)));
+    std::vector<size_t> order(items.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+    return order;
+}
+
+class SnapshotWriter
+{
+  public:
+    SnapshotWriter()
+    {
+        m_out.Bytes(kSnapshotMagic, sizeof(kSnapshotMagic));
+        m_out.Number(kSnapshotVersion, 4);
+        // Root offset, hash and key count, patched at the end
+        m_out.Bytes(std::vector<BYTE>(kSnapshotHeaderSize - 8).data(), kSnapshotHeaderSize - 8);
+    }
+
+    // Write a key and its subtree; return the offset of its record
+    std::uint64_t Key(const KeySnapshot &key, SnapshotHash &hash)
+    {
+        const auto subKeyOrder = SortedByName(key.subKeys, [](const KeySnapshot &k) { return k.name; });
+        std::vector<std::uint64_t> offsets(key.subKeys.size());
+        std::vector<SnapshotHash> hashes(key.subKeys.size());
+        for (size_t i = 0; i < subKeyOrder.size(); i++)
+            offsets[i] = Key(key.subKeys[subKeyOrder[i]], hashes[i]);
+
+        const size_t start = m_out.Size();
+        m_out.Number(0, 4);
+        const auto valueOrder = SortedByName(key.values, [](const RegValue &v) { return v.name; });
+        m_out.Number(key.values.size(), 4);
+        for (const size_t i : valueOrder)
+            m_out.Value(key.values[i]);
+        m_out.Patch(start, m_out.Size() - start - 4, 4);
+
+        m_out.Number(key.subKeys.size(), 4);
+        for (size_t i = 0; i < subKeyOrder.size(); i++)
+        {
+            m_out.String(key.subKeys[subKeyOrder[i]].name);
+            m_out.Bytes(hashes[i].bytes, sizeof(hashes[i].bytes));
+        }
+        hash = Murmur3(m_out.Out().data() + start, m_out.Size() - start);
+
+        for (const auto offset : offsets)
+            m_out.Number(offset, 8);
+        m_keyCount++;
+        return start;
+    }
+
+    std::vector<BYTE> Finish(const std::uint64_t rootOffset, const SnapshotHash &rootHash)
+    {
+        m_out.Patch(8, rootOffset, 8);
+        for (size_t i = 0; i < sizeof(rootHash.bytes); i++)
+            m_out.Patch(16 + i, rootHash.bytes[i], 1);
+        m_out.Patch(32, m_keyCount, 8);
+        return std::move(m_out.Out());
+    }
+
+  private:
+    ByteWriter m_out;
+    std::uint64_t m_keyCount{0};
+};
+
+// A key record of a snapshot file, read up to its subkey table
+struct SnapshotRecord
+{
+    struct SubKey
+    {
+        std::wstring name;
+        SnapshotHash hash;
+        std::uint64_t offset{0};
+    };
+
+    const BYTE *values{nullptr};
+    size_t valuesSize{0};
+    std::vector<SubKey> subKeys;
+};
+
+class SnapshotDiffer
+{
+  public:
+    SnapshotDiffer(const SnapshotFile &before, const SnapshotFile &after, SnapshotDiff &diff)
+        : m_before{before}, m_after{after}, m_diff{diff}
+    {
+    }
+
+    void Run()
+    {
+        if (m_before.m_rootHash != m_after.m_rootHash)
+            Compare(m_before.m_rootOffset, m_after.m_rootOffset, L"", 0);
+    }
+
+  private:
+    // Read a record of file, whose records read so far are in seen
+    static void ReadRecord(const SnapshotFile &file, std::unordered_set<std::uint64_t> &seen,
+                           const std::uint64_t offset, const int depth, SnapshotRecord &record)
+    {
+        ByteReader reader{file.m_data, file.m_size, kSnapshotCorrupt};
+        // Deeper than any registry tree (512 levels)
+        if (depth > 512)
+            reader.Corrupt();
+        // Each record has a single parent, and there are as many as keys:
+        // records shared by several parents would make the diff exponential
+        if (!seen.insert(offset).second || seen.size() > file.m_keyCount)
+            reader.Corrupt();
+        reader.Seek(offset);
+        record.valuesSize = static_cast<size_t>(reader.Number(4));
+        record.values = reader.Bytes(record.valuesSize);
+
+        record.subKeys.resize(reader.Count(4 + 16 + 8));
+        for (auto &subKey : record.subKeys)
+        {
+            reader.String(subKey.name);
+            std::memcpy(subKey.hash.bytes, reader.Bytes(sizeof(subKey.hash.bytes)), sizeof(subKey.hash.bytes));
+        }
+        for (auto &subKey : record.subKeys)
+        {
+            // Subkeys are written before their parent: this also rules out cycles
+            subKey.offset = reader.Number(8);
+            if (subKey.offset >= offset || subKey.offset < kSnapshotHeaderSize)
+                reader.Corrupt();
+        }
+    }
+
+    static std::vector<RegValue> ReadValues(const SnapshotRecord &record)
+    {
+        ByteReader reader{record.values, record.valuesSize, kSnapshotCorrupt};
+        std::vector<RegValue> values(reader.Count(4 + 4 + 1));
+        for (auto &value : values)
+            reader.Value(value);
+        return values;
+    }
+
+    void Compare(const std::uint64_t beforeOffset, const std::uint64_t afterOffset, const std::wstring &path,
+                 const int depth)
+    {
+        m_diff.keysCompared++;
+        SnapshotRecord before;
+        SnapshotRecord after;
+        ReadRecord(m_before, m_beforeSeen, beforeOffset, depth, before);
+        ReadRecord(m_after, m_afterSeen, afterOffset, depth, after);
+
+        if (before.valuesSize != after.valuesSize ||
+            std::memcmp(before.values, after.values, before.valuesSize) != 0)
+        {
+            m_diff.changed.push_back(SnapshotDiff::Change{path, ReadValues(before), ReadValues(after)});
+        }
+
+        std::unordered_map<std::wstring, size_t> beforeByName;
+        beforeByName.reserve(before.subKeys.size());
+        for (size_t i = 0; i < before.subKeys.size(); i++)
+            beforeByName.emplace(UpperCase(before.subKeys[i].name), i);
+        std::vector<bool> matched(before.subKeys.size());
+
+        for (const auto &subKey : after.subKeys)
+        {
+            const std::wstring subKeyPath = ChildPath(path, subKey.name);
+            const auto found = beforeByName.find(UpperCase(subKey.name));
+            if (found == beforeByName.end())
+            {
+                Added(subKey.offset, subKeyPath, depth + 1);
+                continue;
+            }
+            matched[found->second] = true;
+            const auto &previous = before.subKeys[found->second];
+            if (previous.hash != subKey.hash)
+                Compare(previous.offset, subKey.offset, subKeyPath, depth + 1);
+        }
+
+        for (size_t i = 0; i < before.subKeys.size(); i++)
+        {
+            if (!matched[i])
+                Removed(before.subKeys[i].offset, ChildPath(path, before.subKeys[i].name), depth + 1);
+        }
+    }
+
+    void Added(const std::uint64_t offset, const std::wstring &path, const int depth)
+    {
+        SnapshotRecord record;
+        ReadRecord(m_after, m_afterSeen, offset, depth, record);
+        m_diff.added.push_back(SnapshotDiff::Key{path, ReadValues(record)});
+        for (const auto &subKey : record.subKeys)
+            Added(subKey.offset, ChildPath(path, subKey.name), depth + 1);
+    }
+
+    void Removed(const std::uint64_t offset, const std::wstring &path, const int depth)
+    {
+        SnapshotRecord record;
+        ReadRecord(m_before, m_beforeSeen, offset, depth, record);
+        m_diff.removed.push_back(path);
+        for (const auto &subKey : record.subKeys)
+            Removed(subKey.offset, ChildPath(path, subKey.name), depth + 1);
+    }
+
+    const SnapshotFile &m_before;
+    const SnapshotFile &m_after;
+    SnapshotDiff &m_diff;
+    std::unordered_set<std::uint64_t> m_beforeSeen;
+    std::unordered_set<std::uint64_t> m_afterSeen;
+};
+
+} // namespace details
+
+inline std::vector<BYTE> SaveSnapshot(const KeySnapshot &snapshot)
+{
+    details::SnapshotWriter writer;
+    SnapshotHash rootHash;
+    const std::uint64_t rootOffset = writer.Key(snapshot, rootHash);
+    return writer.Finish(rootOffset, rootHash);
+}
+
+inline SnapshotFile SnapshotFile::Open(const std::filesystem::path &path)
+{
+    MappedFile file{path};
+    const BYTE *data = file.Data();
+    const size_t size = file.Size();
+    return SnapshotFile{std::move(file), data, size};
+}
+
+inline SnapshotFile SnapshotFile::FromMemory(const void *const data, const size_t size)
+{
+    return SnapshotFile{MappedFile{}, static_cast<const BYTE *>(data), size};
+}
+
+inline SnapshotFile::SnapshotFile(MappedFile file, const BYTE *const data, const size_t size)
+    : m_file{std::move(file)}, m_data{data}, m_size{size}
+{
+    details::ByteReader reader{data, size, details::kSnapshotCorrupt};
+    const BYTE *magic = reader.Bytes(sizeof(details::kSnapshotMagic));
+    if (std::memcmp(magic, details::kSnapshotMagic, sizeof(details::kSnapshotMagic)) != 0 ||
+        reader.Number(4) != details::kSnapshotVersion)
+    {
+        reader.Corrupt();
+    }
+    m_rootOffset = reader.Number(8);
+    std::memcpy(m_rootHash.bytes, reader.Bytes(sizeof(m_rootHash.bytes)), sizeof(m_rootHash.bytes));
+    m_keyCount = reader.Number(8);
+    if (m_rootOffset < details::kSnapshotHeaderSize || m_rootOffset >= size)
+        reader.Corrupt();
+}
+
+inline SnapshotDiff DiffSnapshots(const SnapshotFile &before, const SnapshotFile &after)
+{
+    SnapshotDiff diff;
+    details::SnapshotDiffer differ{before, after, diff};
+    differ.Run();
+    return diff;
+}
+
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_REGSNAP_HPP
@@ -0,0 +1,268 @@
+#ifndef INCLUDE_WINREG_REGSTREAM_HPP
+#define INCLUDE_WINREG_REGSTREAM_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Little-endian byte streams of the files this library saves (scan states,
+// snapshot files), so they can be moved between machines and builds.
+//
+// Numbers are 1, 2, 4 or 8 bytes. Strings are a length (DWORD) and that many
+// UTF-16 code units, whatever the size of wchar_t. A value is its name, type
+// (DWORD), the index of its RegValueData alternative (BYTE) and its data:
+// DWORD and QWORD as numbers, a string, a string count (DWORD) and strings,
+// or a byte count (DWORD) and bytes.
+//
+// ByteReader checks every read against the end of its input and throws
+// RegException (ERROR_INVALID_DATA) with the message it was given instead of
+// reading past it or allocating for counts larger than the input.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "winreg.hpp"
+
+#include <cstdint>     // std::uint16_t, std::uint64_t
+#include <string>      // std::wstring, std::u16string
+#include <type_traits> // std::is_same_v
+#include <variant>     // std::visit
+#include <vector>      // std::vector
+
+#ifndef _WIN32
+#include "utf.hpp" // utf::Utf32ToUtf16, utf::Utf16ToUtf32
+#endif
+
+namespace winreg
+{
+namespace details
+{
+
+class ByteWriter
+{
+  public:
+    void Number(const std::uint64_t n, const int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+            m_out.push_back(static_cast<BYTE>(n >> (8 * i)));
+    }
+
+    void Bytes(const BYTE *data, const size_t size)
+    {
+        m_out.insert(m_out.end(), data, data + size);
+    }
+
+    void String(const std::wstring &s)
+    {
+        String(s.data(), s.size());
+    }
+
+    void String(const wchar_t *s, const size_t size)
+    {
+#ifdef _WIN32
+        const wchar_t *units = s;
+        const size_t length = size;
+#else
+        m_utf16.resize(2 * size);
+        const size_t length = utf::Utf32ToUtf16(s, size, &m_utf16[0]);
+        const char16_t *units = m_utf16.data();
+#endif
+        Number(length, 4);
+        for (size_t i = 0; i < length; i++)
+            Number(static_cast<std::uint16_t>(units[i]), 2);
+    }
+
+    void Value(const RegValue &value)
+    {
+        String(value.name);
+        Number(value.type, 4);
+        Number(value.data.index(), 1);
+        std::visit(
+            [this](const auto &v) {
+                using T = std::decay_t<decltype(v)>;
+                if constexpr (std::is_same_v<T, DWORD>)
+                {
+                    Number(v, 4);
+                }
+                else if constexpr (std::is_same_v<T, ULONGLONG>)
+                {
+                    Number(v, 8);
+                }
+                else if constexpr (std::is_same_v<T, std::wstring>)
+                {
+                    String(v);
+                }
+                else if constexpr (std::is_same_v<T, std::vector<std::wstring>>)
+                {
+                    Number(v.size(), 4);
+                    for (const auto &s : v)
+                        String(s);
+                }
+                else
+                {
+                    Number(v.size(), 4);
+                    Bytes(v.data(), v.size());
+                }
+            },
+            value.data);
+    }
+
+    // Overwrite bytes already written, e.g. a header field known at the end
+    void Patch(const size_t offset, const std::uint64_t n, const int bytes) noexcept
+    {
+        for (int i = 0; i < bytes; i++)
+            m_out[offset + i] = static_cast<BYTE>(n >> (8 * i));
+    }
+
+    size_t Size() const noexcept
+    {
+        return m_out.size();
+    }
+
+    std::vector<BYTE> &Out() noexcept
+    {
+        return m_out;
+    }
+
+  private:
+    std::vector<BYTE> m_out;
+#ifndef _WIN32
+    std::u16string m_utf16;
+#endif
+};
+
+class ByteReader
+{
+  public:
+    // corruptMessage: the message of the exception thrown on bad input
+    ByteReader(const BYTE *data, const size_t size, const char *corruptMessage) noexcept
+        : m_data{data}, m_size{size}, m_corruptMessage{corruptMessage}
+    {
+    }
+
+    std::uint64_t Number(const int bytes)
+    {
+        Need(bytes);
+        std::uint64_t n = 0;
+        for (int i = 0; i < bytes; i++)
+            n |= static_cast<std::uint64_t>(m_data[m_pos + i]) << (8 * i);
+        m_pos += bytes;
+        return n;
+    }
+
+    const BYTE *Bytes(const size_t size)
+    {
+        Need(size);
+        const BYTE *bytes = m_data + m_pos;
+        m_pos += size;
+        return bytes;
+    }
+
+    // An element count, checked against the bytes left for elements of at
+    // least minSize bytes each before anything is allocated
+    size_t Count(const size_t minSize)
+    {
+        const auto count = static_cast<size_t>(Number(4));
+        if (count > (m_size - m_pos) / minSize)
+            Corrupt();
+        return count;
+    }
+
+    void String(std::wstring &s)
+    {
+        const size_t length = Count(2);
+        const BYTE *bytes = Bytes(2 * length);
+        m_utf16.resize(length);
+        for (size_t i = 0; i < length; i++)
+            m_utf16[i] = static_cast<char16_t>(bytes[2 * i] | (bytes[2 * i + 1] << 8));
+#ifdef _WIN32
+        s.assign(m_utf16.begin(), m_utf16.end());
+#else
+        s.resize(length);
+        s.resize(utf::Utf16ToUtf32(m_utf16.data(), length, &s[0]));
+#endif
+    }
+
+    // Skip a string
+    void SkipString()
+    {
+        Bytes(2 * Count(2));
+    }
+
+    void Value(RegValue &value)
+    {
+        String(value.name);
+        value.type = static_cast<DWORD>(Number(4));
+        switch (Number(1))
+        {
+        case 0:
+        {
+            const size_t size = Count(1);
+            const BYTE *bytes = Bytes(size);
+            value.data = std::vector<BYTE>(bytes, bytes + size);
+            break;
+        }
+        case 1:
+            value.data = static_cast<DWORD>(Number(4));
+            break;
+        case 2:
+            value.data = static_cast<ULONGLONG>(Number(8));
+            break;
+        case 3:
+        {
+            std::wstring s;
+            String(s);
+            value.data = std::move(s);
+            break;
+        }
+        case 4:
+        {
+            std::vector<std::wstring> strings(Count(4));
+            for (auto &s : strings)
+                String(s);
+            value.data = std::move(strings);
+            break;
+        }
+        default:
+            Corrupt();
+        }
+    }
+
+    // Move to an absolute offset of the input
+    void Seek(const std::uint64_t offset)
+    {
+        if (offset > m_size)
+            Corrupt();
+        m_pos = static_cast<size_t>(offset);
+    }
+
+    size_t Position() const noexcept
+    {
+        return m_pos;
+    }
+
+    bool AtEnd() const noexcept
+    {
+        return m_pos == m_size;
+    }
+
+    [[noreturn]] void Corrupt() const
+    {
+        throw RegException{m_corruptMessage, ERROR_INVALID_DATA};
+    }
+
+  private:
+    void Need(const size_t size) const
+    {
+        if (size > m_size - m_pos)
+            Corrupt();
+    }
+
+    const BYTE *m_data;
+    size_t m_size;
+    size_t m_pos{0};
+    const char *m_corruptMessage;
+    std::u16string m_utf16;
+};
+
+} // namespace details
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_REGSTREAM_HPP
@@ -0,0 +1,489 @@
+#ifndef INCLUDE_WINREG_REGWALK_HPP
+#define INCLUDE_WINREG_REGWALK_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Recursive walks over live registry subtrees, built on winreg::RegKey.
+//
+// Snapshot() reads a key with its values and subkeys, recursively, into a
+// plain in-memory tree, so callers (like the Node addon) can convert the
+// result in one go instead of opening and querying every key themselves.
+//
+// ParallelWalk() and ParallelSnapshot() do the same walk with a pool of
+// worker threads. Each worker opens (and closes) its own key handles and
+// keeps a deque of subtrees still to walk: it takes work from the back of
+// its own deque, depth-first, and when that runs dry it steals from the
+// front of another worker's deque, where the largest pending subtrees are.
+//
+// Errors are signaled throwing RegException, like in winreg.hpp.
+// Subkeys that disappear or can't be opened during the walk are skipped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "winreg.hpp"
+
+#include <algorithm> // std::remove_if
+#include <atomic>    // std::atomic
+#include <chrono>    // std::chrono
+#include <cwctype>   // std::towupper
+#include <deque>     // std::deque
+#include <exception> // std::exception_ptr
+#include <functional> // std::function
+#include <memory>    // std::unique_ptr
+#include <mutex>     // std::mutex
+#include <string>    // std::wstring
+#include <thread>    // std::thread
+#include <vector>    // std::vector
+
+namespace winreg
+{
+
+//------------------------------------------------------------------------------
+// What to read during a walk
+//------------------------------------------------------------------------------
+struct WalkOptions
+{
+    // Levels of subkeys to descend into: 0 reads the key itself only,
+    // a negative value means no limit
+    int depth{-1};
+
+    // Names of the values to read (case-insensitive); empty reads all values
+    std::vector<std::wstring> valueNames;
+
+    // Types of the values to read, as a mask of (1 << REG_xxx) bits;
+    // 0 reads values of any type
+    DWORD typeMask{0};
+
+    // Access used to open every key (e.g. KEY_READ | KEY_WOW64_32KEY)
+    REGSAM access{KEY_READ};
+};
+
+//------------------------------------------------------------------------------
+// A key read by Snapshot(): its values and, recursively, its subkeys
+//------------------------------------------------------------------------------
+struct KeySnapshot
+{
+    std::wstring name;
+    std::vector<RegValue> values;
+    std::vector<KeySnapshot> subKeys;
+};
+
+// Read the given key and its subtree, as selected by the options.
+// Throw RegException if the key itself can't be opened or read.
+KeySnapshot Snapshot(HKEY hKeyParent, const std::wstring &subKey, const WalkOptions &options);
+
+//------------------------------------------------------------------------------
+// Statistics of a parallel walk
+//------------------------------------------------------------------------------
+struct WalkStats
+{
+    // Keys read
+    unsigned long long keys{0};
+
+    // Subtrees a worker took from another worker's deque
+    unsigned long long steals{0};
+};
+
+// Called by ParallelWalk() for every key it reads, concurrently from the
+// worker threads, with the key path relative to the walk root ("" for the
+// root itself), its depth and its selected values.
+using KeyVisitor = std::function<void(const std::wstring &path, int depth, std::vector<RegValue> &values)>;
+
+// Walk the given key and its subtree with a pool of worker threads
+// (0 threads: one per hardware thread), calling visit for every key.
+// The first error other than a vanished or inaccessible subkey stops the
+// walk and is rethrown.
+WalkStats ParallelWalk(
+    HKEY hKeyParent,
+    const std::wstring &subKey,
+    const WalkOptions &options,
+    unsigned threads,
+    const KeyVisitor &visit);
+
+// Same result as Snapshot(), read with the thread pool of ParallelWalk()
+KeySnapshot ParallelSnapshot(
+    HKEY hKeyParent,
+    const std::wstring &subKey,
+    const WalkOptions &options,
+    unsigned threads,
+    WalkStats *stats = nullptr);
+
+namespace details
+{
+
+inline bool EqualsNoCase(const std::wstring &a, const std::wstring &b) noexcept
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i] != b[i] &&
+            std::towupper(static_cast<wint_t>(a[i])) != std::towupper(static_cast<wint_t>(b[i])))
+            return false;
+    }
+    return true;
+}
+
+// Upper-case form of a key or value name, for case-insensitive lookups
+inline std::wstring UpperCase(const std::wstring &s)
+{
+    std::wstring upper{s};
+    for (auto &c : upper)
+        c = static_cast<wchar_t>(std::towupper(static_cast<wint_t>(c)));
+    return upper;
+}
+
+// Path of a subkey, relative to the walk root ("" for the root itself)
+inline std::wstring ChildPath(const std::wstring &path, const std::wstring &name)
+{
+    return path.empty() ? name : path + L'\\' + name;
+}
+
+// Does the value pass the name and type filters of the options?
+inline bool IsSelected(const RegValue &value, const WalkOptions &options) noexcept
+{
+    if (options.typeMask != 0 && (value.type >= 32 || !(options.typeMask & (1u << value.type))))
+        return false;
+    if (options.valueNames.empty())
+        return true;
+    for (const auto &name : options.valueNames)
+    {
+        if (EqualsNoCase(name, value.name))
+            return true;
+    }
+    return false;
+}
+
+// Read the selected values of an open key
+inline std::vector<RegValue> ReadValues(RegKey &key, const WalkOptions &options)
+{
+    std::vector<RegValue> values = key.EnumValuesWithData();
+    if (options.typeMask != 0 || !options.valueNames.empty())
+    {
+        std::vector<RegValue> selected;
+        for (auto &value : values)
+        {
+            if (IsSelected(value, options))
+                selected.push_back(std::move(value));
+        }
+        values.swap(selected);
+    }
+    return values;
+}
+
+// Is code the failure of a subkey deleted or locked while we walk?
+inline bool IsSkippedKeyError(const LONG code) noexcept
+{
+    return code == ERROR_FILE_NOT_FOUND || code == ERROR_ACCESS_DENIED || code == ERROR_KEY_DELETED;
+}
+
+inline void SnapshotKey(RegKey &key, KeySnapshot &snapshot, const WalkOptions &options, const int depth)
+{
+    snapshot.values = ReadValues(key, options);
+    if (options.depth >= 0 && depth >= options.depth)
+        return;
+
+    for (auto &name : key.EnumSubKeys())
+    {
+        RegKey subKey;
+        const RegResult opened = subKey.TryOpen(key.Get(), name, options.access);
+        if (opened.Failed())
+        {
+            if (IsSkippedKeyError(opened.Code()))
+                continue;
+            opened.ThrowIfFailed();
+        }
+
+        KeySnapshot child;
+        child.name = std::move(name);
+        try
+        {
+            SnapshotKey(subKey, child, options, depth + 1);
+        }
+        catch (const RegException &e)
+        {
+            // Deleted or locked after we opened it: skipped like the parallel walk
+            if (IsSkippedKeyError(e.ErrorCode()))
+                continue;
+            throw;
+        }
+        snapshot.subKeys.push_back(std::move(child));
+    }
+}
+
+// A subtree waiting to be walked by ParallelWalker
+struct WalkTask
+{
+    // Key path relative to the walk root
+    std::wstring path;
+    int depth{0};
+
+    // Where ParallelSnapshot() stores the key; nullptr for ParallelWalk()
+    KeySnapshot *node{nullptr};
+};
+
+// Pending tasks of one worker: the owner pushes and pops at the back,
+// thieves take from the front
+class WorkDeque
+{
+  public:
+    void Push(WalkTask &&task)
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_tasks.push_back(std::move(task));
+    }
+
+    bool Pop(WalkTask &task)
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (m_tasks.empty())
+            return false;
+        task = std::move(m_tasks.back());
+        m_tasks.pop_back();
+        return true;
+    }
+
+    bool Steal(WalkTask &task)
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (m_tasks.empty())
+            return false;
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        return true;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::deque<WalkTask> m_tasks;
+};
+
+class ParallelWalker
+{
+  public:
+    ParallelWalker(const HKEY hKeyParent, const std::wstring &subKey, const WalkOptions &options, unsigned threads)
+        : m_options{options}
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        m_deques.resize(threads);
+        for (auto &deque : m_deques)
+            deque = std::make_unique<WorkDeque>();
+
+        // The root handle is the only one shared by the workers;
+        // every key below it is opened relative to it
+        m_root.Open(hKeyParent, subKey, options.access);
+    }
+
+    // Walk from the root; with a null visitor, fill the root snapshot node
+    WalkStats Run(const KeyVisitor *visit, KeySnapshot *root)
+    {
+        m_visit = visit;
+        m_pending = 1;
+        m_deques[0]->Push(WalkTask{std::wstring{}, 0, root});
+
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < m_deques.size(); i++)
+            workers.emplace_back([this, i]() { Work(i); });
+        Work(0);
+        for (auto &worker : workers)
+            worker.join();
+
+        if (m_error)
+            std::rethrow_exception(m_error);
+
+        WalkStats stats;
+        stats.keys = m_keys;
+        stats.steals = m_steals;
+        return stats;
+    }
+
+  private:
+    void Work(const unsigned self)
+    {
+        WalkTask task;
+        unsigned idleRounds = 0;
+        while (!m_stop)
+        {
+            if (m_deques[self]->Pop(task) || Steal(self, task))
+            {
+                idleRounds = 0;
+                Process(self, task);
+                m_pending--;
+                continue;
+            }
+
+            if (m_pending == 0)
+                break;
+
+            // Others are still reading keys that may add work: back off
+            if (++idleRounds < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds{50});
+        }
+    }
+
+    bool Steal(const unsigned self, WalkTask &task)
+    {
+        const auto count = static_cast<unsigned>(m_deques.size());
+        for (unsigned i = 1; i < count; i++)
+        {
+            if (m_deques[(self + i) % count]->Steal(task))
+            {
+                m_steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Process(const unsigned self, WalkTask &task)
+    {
+        std::vector<RegValue> values;
+        std::vector<std::wstring> subKeys;
+        try
+        {
+            RegKey key;
+            key.Open(m_root.Get(), task.path, m_options.access);
+            values = ReadValues(key, m_options);
+            if (m_options.depth < 0 || task.depth < m_options.depth)
+                subKeys = key.EnumSubKeys();
+            m_keys++;
+        }
+        catch (const RegException &e)
+        {
+            // A subkey deleted or locked while we walk is skipped
+            if (task.depth > 0 && IsSkippedKeyError(e.ErrorCode()))
+            {
+                if (task.node != nullptr)
+                    task.node->name.clear();
+            }
+            else
+            {
+                Fail();
+            }
+            return;
+        }
+        catch (...)
+        {
+            Fail();
+            return;
+        }
+
+        try
+        {
+            if (task.node != nullptr)
+            {
+                task.node->values = std::move(values);
+                task.node->subKeys.resize(subKeys.size());
+            }
+            else
+            {
+                (*m_visit)(task.path, task.depth, values);
+            }
+
+            // Queue the children; the owner pops them depth-first
+            m_pending += static_cast<long long>(subKeys.size());
+            for (size_t i = subKeys.size(); i-- > 0;)
+            {
+                WalkTask child;
+                child.path = task.path.empty() ? subKeys[i] : task.path + L'\\' + subKeys[i];
+                child.depth = task.depth + 1;
+                if (task.node != nullptr)
+                {
+                    child.node = &task.node->subKeys[i];
+                    child.node->name = std::move(subKeys[i]);
+                }
+                m_deques[self]->Push(std::move(child));
+            }
+        }
+        catch (...)
+        {
+            Fail();
+        }
+    }
+
+    // Record the first error and stop all the workers
+    void Fail()
+    {
+        std::lock_guard<std::mutex> lock{m_errorMutex};
+        if (!m_error)
+            m_error = std::current_exception();
+        m_stop = true;
+    }
+
+    const WalkOptions &m_options;
+    RegKey m_root;
+    const KeyVisitor *m_visit{nullptr};
+    std::vector<std::unique_ptr<WorkDeque>> m_deques;
+
+    // Tasks queued or being processed; the walk is over when it drops to 0
+    std::atomic<long long> m_pending{0};
+    std::atomic<bool> m_stop{false};
+    std::atomic<unsigned long long> m_keys{0};
+    std::atomic<unsigned long long> m_steals{0};
+
+    std::mutex m_errorMutex;
+    std::exception_ptr m_error;
+};
+
+// Drop the placeholders of subkeys skipped by ParallelWalker (empty names)
+inline void PruneSkipped(KeySnapshot &snapshot)
+{
+    auto &subKeys = snapshot.subKeys;
+    subKeys.erase(
+        std::remove_if(subKeys.begin(), subKeys.end(), [](const KeySnapshot &k) { return k.name.empty(); }),
+        subKeys.end());
+    for (auto &subKey : subKeys)
+        PruneSkipped(subKey);
+}
+
+} // namespace details
+
+inline KeySnapshot Snapshot(const HKEY hKeyParent, const std::wstring &subKey, const WalkOptions &options)
+{
+    RegKey key;
+    key.Open(hKeyParent, subKey, options.access);
+
+    KeySnapshot snapshot;
+    const size_t slash = subKey.find_last_of(L'\\');
+    snapshot.name = slash == std::wstring::npos ? subKey : subKey.substr(slash + 1);
+    details::SnapshotKey(key, snapshot, options, 0);
+    return snapshot;
+}
+
+inline WalkStats ParallelWalk(
+    const HKEY hKeyParent,
+    const std::wstring &subKey,
+    const WalkOptions &options,
+    const unsigned threads,
+    const KeyVisitor &visit)
+{
+    details::ParallelWalker walker{hKeyParent, subKey, options, threads};
+    return walker.Run(&visit, nullptr);
+}
+
+inline KeySnapshot ParallelSnapshot(
+    const HKEY hKeyParent,
+    const std::wstring &subKey,
+    const WalkOptions &options,
+    const unsigned threads,
+    WalkStats *const stats)
+{
+    details::ParallelWalker walker{hKeyParent, subKey, options, threads};
+
+    KeySnapshot snapshot;
+    const size_t slash = subKey.find_last_of(L'\\');
+    snapshot.name = slash == std::wstring::npos ? subKey : subKey.substr(slash + 1);
+    const WalkStats walkStats = walker.Run(nullptr, &snapshot);
+    details::PruneSkipped(snapshot);
+
+    if (stats != nullptr)
+        *stats = walkStats;
+    return snapshot;
+}
+
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_REGWALK_HPP
@@ -0,0 +1,152 @@
+#include <napi.h>
+
+#include "addon.hpp"
+
+// Outside Windows the live registry functions run against the in-memory
+// stand-in of memreg.hpp. reg.standin exposes its test knobs:
+//
+//   reset()            drop all keys and values
+//   setLatency(ms)     sleep this long in every registry API call
+//   callCounts()       { RegOpenKeyEx: n, ... } since the last reset
+//   resetCallCounts()
+//   setTime(date)      fixed last-write time for changed keys (null: now)
+//
+// and probes of the UTF-8 transcoder of utf.hpp, for its unit and fuzz tests:
+//
+//   utf8ToWide(buffer, unitSize)   { valid, wide: Buffer of 2 or 4 byte units }
+//   wideToUtf8(buffer, unitSize)   { valid, utf8: Buffer }
+#ifndef _WIN32
+
+#include "memreg.hpp"
+#include "utf.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+
+static Napi::Value Reset(const Napi::CallbackInfo& info) {
+  memreg::Registry::Instance().Reset();
+  memreg::Registry::Instance().ResetCallCounts();
+  return info.Env().Undefined();
+}
+
+static Napi::Value SetLatency(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 1 || !info[0].IsNumber()) {
+    Napi::Error::New(env, "setLatency - invalid arguments (ms)")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  const double ms = info[0].As<Napi::Number>().DoubleValue();
+  memreg::Registry::Instance().SetLatency(
+      std::chrono::microseconds{static_cast<long long>(std::llround(ms * 1000))});
+  return env.Undefined();
+}
+
+static Napi::Value CallCounts(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  const auto& registry = memreg::Registry::Instance();
+  auto obj = Napi::Object::New(env);
+  for (int i = 0; i < static_cast<int>(memreg::Api::Count); ++i) {
+    const auto api = static_cast<memreg::Api>(i);
+    obj.Set(memreg::ApiName(api),
+            Napi::Number::New(env, static_cast<double>(registry.CallCount(api))));
+  }
+  return obj;
+}
+
+static Napi::Value ResetCallCounts(const Napi::CallbackInfo& info) {
+  memreg::Registry::Instance().ResetCallCounts();
+  return info.Env().Undefined();
+}
+
+static Napi::Value SetTime(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  ULONGLONG fileTime = 0;
+  if (info.Length() > 0 && info[0].IsDate()) {
+    const double ms = info[0].As<Napi::Date>().ValueOf();
+    fileTime = static_cast<ULONGLONG>(ms * 10000.0) + 116444736000000000ULL;
+  } else if (info.Length() > 0 && !info[0].IsNull() && !info[0].IsUndefined()) {
+    Napi::Error::New(env, "setTime - invalid arguments (date)")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  memreg::Registry::Instance().SetClock(fileTime);
+  return env.Undefined();
+}
+
+static bool ParseTranscodeArgs(const Napi::CallbackInfo& info, const char* name,
+                               Napi::Buffer<uint8_t>& buffer, uint32_t& unitSize) {
+  unitSize = 2;
+  if (info.Length() > 1 && info[1].IsNumber()) {
+    unitSize = info[1].As<Napi::Number>().Uint32Value();
+  }
+  if (info.Length() < 1 || !info[0].IsBuffer() || (unitSize != 2 && unitSize != 4)) {
+    Napi::Error::New(info.Env(), std::string(name) + " - invalid arguments (buffer, unitSize?)")
+        .ThrowAsJavaScriptException();
+    return false;
+  }
+  buffer = info[0].As<Napi::Buffer<uint8_t>>();
+  return true;
+}
+
+template <typename Char>
+static Napi::Value ToWide(Napi::Env env, const Napi::Buffer<uint8_t>& buffer) {
+  std::basic_string<Char> wide;
+  const bool valid = winreg::utf::Utf8ToWide(
+      reinterpret_cast<const char*>(buffer.Data()), buffer.Length(), wide);
+  auto obj = Napi::Object::New(env);
+  obj.Set("valid", Napi::Boolean::New(env, valid));
+  obj.Set("wide", Napi::Buffer<uint8_t>::Copy(
+      env, reinterpret_cast<const uint8_t*>(wide.data()), wide.size() * sizeof(Char)));
+  return obj;
+}
+
+template <typename Char>
+static Napi::Value FromWide(Napi::Env env, const Napi::Buffer<uint8_t>& buffer) {
+  std::basic_string<Char> wide(buffer.Length() / sizeof(Char), Char{});
+  std::memcpy(&wide[0], buffer.Data(), wide.size() * sizeof(Char));
+  std::string utf8;
+  const bool valid = winreg::utf::WideToUtf8(wide.data(), wide.size(), utf8);
+  auto obj = Napi::Object::New(env);
+  obj.Set("valid", Napi::Boolean::New(env, valid));
+  obj.Set("utf8", Napi::Buffer<uint8_t>::Copy(
+      env, reinterpret_cast<const uint8_t*>(utf8.data()), utf8.size()));
+  return obj;
+}
+
+static Napi::Value Utf8ToWide(const Napi::CallbackInfo& info) {
+  Napi::Buffer<uint8_t> buffer;
+  uint32_t unitSize;
+  if (!ParseTranscodeArgs(info, "utf8ToWide", buffer, unitSize)) {
+    return info.Env().Undefined();
+  }
+  return unitSize == 2 ? ToWide<char16_t>(info.Env(), buffer)
+                       : ToWide<char32_t>(info.Env(), buffer);
+}
+
+static Napi::Value WideToUtf8(const Napi::CallbackInfo& info) {
+  Napi::Buffer<uint8_t> buffer;
+  uint32_t unitSize;
+  if (!ParseTranscodeArgs(info, "wideToUtf8", buffer, unitSize)) {
+    return info.Env().Undefined();
+  }
+  return unitSize == 2 ? FromWide<char16_t>(info.Env(), buffer)
+                       : FromWide<char32_t>(info.Env(), buffer);
+}
+
+Napi::Object InitStandIn(Napi::Env env, Napi::Object exports) {
+  auto standin = Napi::Object::New(env);
+  standin.Set("reset", Napi::Function::New(env, Reset));
+  standin.Set("setLatency", Napi::Function::New(env, SetLatency));
+  standin.Set("callCounts", Napi::Function::New(env, CallCounts));
+  standin.Set("resetCallCounts", Napi::Function::New(env, ResetCallCounts));
+  standin.Set("setTime", Napi::Function::New(env, SetTime));
+  standin.Set("utf8ToWide", Napi::Function::New(env, Utf8ToWide));
+  standin.Set("wideToUtf8", Napi::Function::New(env, WideToUtf8));
+  exports.Set("standin", standin);
+  return exports;
+}
+
+#endif // _WIN32
@@ -0,0 +1,196 @@
+var assert = require("assert");
+var reg = require("..");
+var { describeStandIn } = require("./fixtures/standin");
+
+const HKCU = reg.HKEY_CURRENT_USER;
+const KEY = "Software/winreg-async";
+
+// Longest time the event loop went without a turn while fn() ran
+async function maxLoopGap(fn) {
+  let last = Date.now();
+  let maxGap = 0;
+  let running = true;
+  const tick = () => {
+    const now = Date.now();
+    maxGap = Math.max(maxGap, now - last);
+    last = now;
+    if (running) setImmediate(tick);
+  };
+  setImmediate(tick);
+  await fn();
+  running = false;
+  tick();
+  return maxGap;
+}
+
+describeStandIn("async registry functions", function() {
+  beforeEach(() => {
+    reg.standin.reset();
+    reg.set(HKCU, KEY, "Name", "中文 value");
+    reg.set(HKCU, KEY, "Count", 42);
+  });
+
+  afterEach(() => {
+    reg.standin.setLatency(0);
+  });
+
+  it("queryValueAsync", async function() {
+    const p = reg.queryValueAsync(HKCU, KEY, "Name");
+    assert.ok(p instanceof Promise);
+    assert.equal(await p, "中文 value");
+    assert.equal(await reg.queryValueAsync(HKCU, KEY, "Count"), 42);
+    assert.equal(await reg.queryValueAsync(HKCU, KEY, "NonExists"), null);
+    assert.equal(await reg.queryValueAsync(HKCU, KEY + "/NonExists", "Name"), null);
+  });
+
+  it("setAsync and deleteAsync", async function() {
+    assert.equal(await reg.setAsync(HKCU, KEY + "/Sub", "Str", "abc"), true);
+    assert.equal(await reg.setAsync(HKCU, KEY + "/Sub", "Num", 7), true);
+    assert.equal(reg.queryValue(HKCU, KEY + "/Sub", "Str"), "abc");
+    assert.equal(reg.queryValue(HKCU, KEY + "/Sub", "Num"), 7);
+
+    assert.equal(await reg.deleteAsync(HKCU, KEY + "/Sub", "Str"), true);
+    assert.equal(reg.queryValue(HKCU, KEY + "/Sub", "Str"), null);
+    assert.equal(await reg.deleteAsync(HKCU, KEY + "/Sub"), true);
+    assert.equal(reg.queryValue(HKCU, KEY + "/Sub", "Num"), null);
+    assert.equal(await reg.deleteAsync(HKCU, KEY + "/Sub"), true);
+  });
+
+  it("RegKey value methods", async function() {
+    const key = new reg.RegKey(HKCU, KEY);
+    const p = key.queryValueAsync("Name");
+    assert.ok(p instanceof Promise);
+    assert.equal(await p, "中文 value");
+    assert.equal(await key.queryValueAsync("NonExists"), null);
+
+    assert.equal(await key.setValueAsync("Str", "abc"), true);
+    assert.equal(await key.setValueAsync("Num", 7), true);
+    assert.equal(reg.queryValue(HKCU, KEY, "Str"), "abc");
+    assert.equal(await key.queryValueAsync("Num"), 7);
+
+    assert.equal(await key.deleteValueAsync("Str"), true);
+    assert.equal(await key.queryValueAsync("Str"), null);
+    assert.equal(await key.deleteValueAsync("Str"), true);
+
+    key.close();
+    assert.throws(() => key.queryValueAsync("Name"), /the key is closed/);
+  });
+
+  it("close() keeps the handle open until pending methods settle", async function() {
+    reg.standin.setLatency(20);
+    const key = new reg.RegKey(HKCU, KEY);
+    const read = key.queryValueAsync("Name");
+    const write = key.setValueAsync("Str", "abc");
+    reg.standin.resetCallCounts();
+    key.close();
+    assert.ok(!key.isValid);
+    assert.throws(() => key.queryValueAsync("Name"), /the key is closed/);
+    assert.equal(reg.standin.callCounts().RegCloseKey, 0);
+
+    assert.equal(await read, "中文 value");
+    assert.equal(await write, true);
+    assert.equal(reg.standin.callCounts().RegCloseKey, 1);
+    assert.equal(reg.queryValue(HKCU, KEY, "Str"), "abc");
+  });
+
+  it("rejects with RegError", async function() {
+    const ERROR_INVALID_HANDLE = 6;
+    assert.throws(() => reg.queryValue(12345, KEY, "Name"),
+                  (e) => e.name === "RegError" && e.code === ERROR_INVALID_HANDLE);
+    await assert.rejects(reg.queryValueAsync(12345, KEY, "Name"),
+                         (e) => e.name === "RegError" && e.code === ERROR_INVALID_HANDLE);
+    await assert.rejects(reg.setAsync(12345, KEY, "Name", "x"),
+                         (e) => e.code === ERROR_INVALID_HANDLE);
+  });
+
+  it("makes the same registry calls as the sync version", async function() {
+    reg.standin.resetCallCounts();
+    reg.queryValue(HKCU, KEY, "Name");
+    const sync = reg.standin.callCounts();
+    reg.standin.resetCallCounts();
+    await reg.queryValueAsync(HKCU, KEY, "Name");
+    assert.deepEqual(reg.standin.callCounts(), sync);
+  });
+
+  it("does not block the event loop", async function() {
+    const latency = 50;
+    reg.standin.setLatency(latency);
+
+    const syncGap = await maxLoopGap(async () => {
+      assert.equal(reg.queryValue(HKCU, KEY, "Name"), "中文 value");
+    });
+    const asyncGap = await maxLoopGap(async () => {
+      assert.equal(await reg.queryValueAsync(HKCU, KEY, "Name"), "中文 value");
+    });
+
+    // open + type + value + close, each sleeping `latency` ms
+    assert.ok(syncGap >= 3 * latency, `sync gap ${syncGap}ms`);
+    assert.ok(asyncGap < latency, `async gap ${asyncGap}ms`);
+  });
+
+  it("runs concurrent requests in parallel", async function() {
+    const latency = 50;
+    reg.standin.setLatency(latency);
+
+    let start = Date.now();
+    await reg.queryValueAsync(HKCU, KEY, "Count");
+    const single = Date.now() - start;
+
+    start = Date.now();
+    const values = await Promise.all(
+        [1, 2, 3, 4].map(() => reg.queryValueAsync(HKCU, KEY, "Count")));
+    const four = Date.now() - start;
+
+    assert.deepEqual(values, [42, 42, 42, 42]);
+    assert.ok(four < 2 * single, `4 requests took ${four}ms, 1 took ${single}ms`);
+  });
+
+  describe("subKeys", function() {
+    let key;
+    const names = [];
+
+    beforeEach(() => {
+      key = new reg.RegKey(HKCU, KEY + "/Wide");
+      names.length = 0;
+      for (let i = 0; i < 25; i++) {
+        names.push(`Sub${String(i).padStart(2, "0")}`);
+        new reg.RegKey(HKCU, KEY + "/Wide/" + names[i]).close();
+      }
+    });
+
+    afterEach(() => {
+      key.close();
+    });
+
+    it("iterates every subkey a page at a time", async function() {
+      reg.standin.resetCallCounts();
+      const seen = [];
+      for await (const name of key.subKeys({ pageSize: 10 })) seen.push(name);
+      assert.deepEqual(seen, names);
+      // 25 subkeys and the end of the last page, no up-front count
+      assert.equal(reg.standin.callCounts().RegEnumKeyEx, 26);
+      assert.equal(reg.standin.callCounts().RegQueryInfoKey, 0);
+    });
+
+    it("stops fetching when the loop breaks", async function() {
+      reg.standin.resetCallCounts();
+      for await (const name of key.subKeys({ pageSize: 10 })) {
+        if (name === "Sub03") break;
+      }
+      // The first page and the one prefetched meanwhile
+      await new Promise((resolve) => setTimeout(resolve, 10));
+      assert.equal(reg.standin.callCounts().RegEnumKeyEx, 20);
+    });
+
+    it("enumSubKeysAsync pages", async function() {
+      assert.deepEqual(await key.enumSubKeysAsync(20, 10), names.slice(20));
+      assert.deepEqual(await key.enumSubKeysAsync(30, 10), []);
+    });
+
+    it("an empty key", async function() {
+      const empty = new reg.RegKey(HKCU, KEY + "/Empty");
+      for await (const name of empty.subKeys()) assert.fail(name);
+      empty.close();
+    });
+  });
+});
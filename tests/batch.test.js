@@ -0,0 +1,54 @@
+var assert = require("assert");
+var reg = require("..");
+var { describeStandIn } = require("./fixtures/standin");
+
+const HKCU = reg.HKEY_CURRENT_USER;
+const KEY = "Software/winreg-batch";
+
+describeStandIn("queryValues", function() {
+  beforeEach(() => {
+    reg.standin.reset();
+    reg.set(HKCU, KEY + "/A", "Name", "a name");
+    reg.set(HKCU, KEY + "/A", "Count", 1);
+    reg.set(HKCU, KEY + "/B", "Name", "😀 b");
+    reg.set(HKCU, KEY + "/B", "Long", "x".repeat(5000));
+  });
+
+  it("returns the values in request order", function() {
+    const result = reg.queryValues(HKCU, [
+      [KEY + "/A", "Name"],
+      [KEY + "/B", "Name"],
+      [KEY + "\\A", "Count"],
+      [KEY + "/B", "Long"],
+    ]);
+    assert.deepEqual(result, ["a name", "😀 b", 1, "x".repeat(5000)]);
+  });
+
+  it("matches queryValue, with null for missing keys and values", function() {
+    const requests = [
+      [KEY + "/A", "Name"],
+      [KEY + "/A", "Missing"],
+      [KEY + "/Missing", "Name"],
+      [KEY + "/B", "Long"],
+    ];
+    assert.deepEqual(reg.queryValues(HKCU, requests),
+                     requests.map(([p, v]) => reg.queryValue(HKCU, p, v)));
+    assert.deepEqual(reg.queryValues(HKCU, []), []);
+  });
+
+  it("opens each key once", function() {
+    reg.standin.resetCallCounts();
+    reg.queryValues(HKCU, [
+      [KEY + "/A", "Name"], [KEY + "/B", "Name"], [KEY + "/A", "Count"],
+    ]);
+    const calls = reg.standin.callCounts();
+    assert.equal(calls.RegOpenKeyEx, 2);
+    assert.equal(calls.RegGetValue, 3);
+  });
+
+  it("invalid arguments", function() {
+    assert.throws(() => reg.queryValues(HKCU), /invalid arguments/);
+    assert.throws(() => reg.queryValues(HKCU, ["not a pair"]), /\[path, value\]/);
+    assert.throws(() => reg.queryValues(12345, [[KEY, "Name"]]), (e) => e.code === 6);
+  });
+});
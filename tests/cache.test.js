@@ -0,0 +1,121 @@
+var assert = require("assert");
+var reg = require("..");
+var { describeStandIn } = require("./fixtures/standin");
+
+const HKCU = reg.HKEY_CURRENT_USER;
+const KEY = "Software/winreg-cache";
+
+describeStandIn("key handle cache", function() {
+  beforeEach(() => {
+    reg.standin.reset();
+    reg.set(HKCU, KEY + "/A", "Name", "a name");
+    reg.set(HKCU, KEY + "/A", "Count", 1);
+    reg.set(HKCU, KEY + "/B", "Name", "b name");
+    reg.set(HKCU, KEY + "/C", "Name", "c name");
+    reg.cache.enable();
+    reg.standin.resetCallCounts();
+  });
+
+  afterEach(() => {
+    reg.cache.disable();
+  });
+
+  it("does nothing when disabled", function() {
+    reg.cache.disable();
+    assert.equal(reg.cache.stats().enabled, false);
+    reg.queryValue(HKCU, KEY + "/A", "Name");
+    reg.queryValue(HKCU, KEY + "/A", "Name");
+    assert.equal(reg.standin.callCounts().RegOpenKeyEx, 2);
+    assert.equal(reg.cache.stats().size, 0);
+  });
+
+  it("opens a polled key once", function() {
+    for (let i = 0; i < 10; i++) {
+      assert.equal(reg.queryValue(HKCU, KEY + "/A", "Name"), "a name");
+      assert.equal(reg.queryValue(HKCU, KEY + "\\a", "Count"), 1);
+    }
+    const calls = reg.standin.callCounts();
+    assert.equal(calls.RegOpenKeyEx, 1);
+    assert.equal(calls.RegCloseKey, 0);
+    const stats = reg.cache.stats();
+    assert.equal(stats.size, 1);
+    assert.equal(stats.hits, 19);
+    assert.equal(stats.misses, 1);
+  });
+
+  it("halves the registry calls of a cached query", function() {
+    reg.queryValue(HKCU, KEY + "/A", "Count");
+    reg.standin.resetCallCounts();
+    reg.queryValue(HKCU, KEY + "/A", "Count");
+    const cached = Object.values(reg.standin.callCounts()).reduce((a, b) => a + b);
+
+    reg.cache.disable();
+    reg.standin.resetCallCounts();
+    reg.queryValue(HKCU, KEY + "/A", "Count");
+    const uncached = Object.values(reg.standin.callCounts()).reduce((a, b) => a + b);
+    assert.ok(cached * 2 <= uncached, `${cached} calls cached, ${uncached} uncached`);
+  });
+
+  it("keys entries by access and view", function() {
+    reg.queryValue(HKCU, KEY + "/A", "Name");
+    reg.queryValue(HKCU, KEY + "/A", "Name", reg.KEY_WOW64_32KEY);
+    reg.set(HKCU, KEY + "/A", "Name", "renamed");
+    assert.equal(reg.cache.stats().size, 3);
+    assert.equal(reg.queryValue(HKCU, KEY + "/A", "Name"), "renamed");
+    assert.equal(reg.standin.callCounts().RegOpenKeyEx, 2);
+    assert.equal(reg.standin.callCounts().RegCreateKeyEx, 1);
+  });
+
+  it("evicts the least recently used handles", function() {
+    reg.cache.enable(2);
+    reg.queryValue(HKCU, KEY + "/A", "Name");
+    reg.queryValue(HKCU, KEY + "/B", "Name");
+    reg.queryValue(HKCU, KEY + "/A", "Name");
+    reg.queryValue(HKCU, KEY + "/C", "Name");
+    let stats = reg.cache.stats();
+    assert.equal(stats.size, 2);
+    assert.equal(stats.evictions, 1);
+    assert.equal(reg.standin.callCounts().RegCloseKey, 1);
+
+    // B went out, A stayed
+    reg.standin.resetCallCounts();
+    reg.queryValue(HKCU, KEY + "/A", "Name");
+    assert.equal(reg.standin.callCounts().RegOpenKeyEx, 0);
+    reg.queryValue(HKCU, KEY + "/B", "Name");
+    assert.equal(reg.standin.callCounts().RegOpenKeyEx, 1);
+
+    reg.cache.enable(0);
+    assert.equal(reg.cache.stats().size, 0);
+  });
+
+  it("clear closes the cached handles", function() {
+    reg.queryValue(HKCU, KEY + "/A", "Name");
+    reg.queryValue(HKCU, KEY + "/B", "Name");
+    reg.cache.clear();
+    assert.equal(reg.cache.stats().size, 0);
+    assert.equal(reg.standin.callCounts().RegCloseKey, 2);
+    assert.equal(reg.queryValue(HKCU, KEY + "/A", "Name"), "a name");
+  });
+
+  it("sees deleted and recreated keys", function() {
+    assert.equal(reg.queryValue(HKCU, KEY + "/A", "Name"), "a name");
+    assert.equal(reg.delete(HKCU, KEY), true);
+    assert.equal(reg.queryValue(HKCU, KEY + "/A", "Name"), null);
+    reg.set(HKCU, KEY + "/A", "Name", "again");
+    assert.equal(reg.queryValue(HKCU, KEY + "/A", "Name"), "again");
+
+    // Deleted behind the cache's back
+    reg.standin.reset();
+    reg.set(HKCU, KEY + "/A", "Name", "after reset");
+    assert.equal(reg.queryValue(HKCU, KEY + "/A", "Name"), "after reset");
+  });
+
+  it("serves queryValues and the async functions", async function() {
+    assert.deepEqual(reg.queryValues(HKCU, [[KEY + "/A", "Name"], [KEY + "/B", "Name"]]),
+                     ["a name", "b name"]);
+    assert.equal(await reg.queryValueAsync(HKCU, KEY + "/A", "Count"), 1);
+    assert.equal(await reg.setAsync(HKCU, KEY + "/B", "Count", 2), true);
+    assert.equal(await reg.queryValueAsync(HKCU, KEY + "/B", "Count"), 2);
+    assert.equal(reg.standin.callCounts().RegOpenKeyEx, 2);
+  });
+});
@@ -0,0 +1,290 @@
+// Minimal regf hive and transaction log builder for the offline reader tests.
+//
+// A tree is described as
+//   { values: { name: { type, data } }, keys: { name: tree }, lastWriteTime }
+// with data given as a string (REG_SZ, REG_EXPAND_SZ), an array of strings
+// (REG_MULTI_SZ), a number (REG_DWORD), a BigInt (REG_QWORD) or a Buffer.
+
+const REG_SZ = 1, REG_EXPAND_SZ = 2, REG_BINARY = 3, REG_DWORD = 4;
+const REG_MULTI_SZ = 7, REG_QWORD = 11;
+
+const BIG_DATA_SEGMENT = 16344;
+const FILETIME_UNIX_EPOCH = 116444736000000000n;
+
+// Upper-case like regf.hpp: simple mappings within the BMP, less non-ASCII
+// letters to ASCII, the micro sign and Georgian Mkhedruli to Mtavruli
+function upcase(s) {
+  let out = "";
+  for (const c of s) {
+    const u = c.toUpperCase();
+    const code = u.charCodeAt(0);
+    const keep = c.length > 1 || u.length !== 1 || c === "\u00b5" ||
+                 (c.charCodeAt(0) >= 0x80 && code < 0x80) || (code >= 0x1c90 && code <= 0x1cbf);
+    out += keep ? c : u;
+  }
+  return out;
+}
+
+function compareNames(a, b) {
+  const ua = upcase(a), ub = upcase(b);
+  return ua < ub ? -1 : ua > ub ? 1 : 0;
+}
+
+function lhHash(name) {
+  let h = 0;
+  const u = upcase(name);
+  for (let i = 0; i < u.length; i++) {
+    h = (Math.imul(h, 37) + u.charCodeAt(i)) >>> 0;
+  }
+  return h;
+}
+
+function encodeName(name) {
+  const compressed = [...name].every((c) => c.charCodeAt(0) < 256);
+  return compressed ? { buf: Buffer.from(name, "latin1"), compressed }
+                    : { buf: Buffer.from(name, "utf16le"), compressed };
+}
+
+function encodeData(type, data) {
+  if (Buffer.isBuffer(data)) return data;
+  switch (type) {
+    case REG_SZ:
+    case REG_EXPAND_SZ:
+      return Buffer.from(data + "\0", "utf16le");
+    case REG_MULTI_SZ:
+      return Buffer.from(data.map((s) => s + "\0").join("") + "\0", "utf16le");
+    case REG_DWORD: {
+      const b = Buffer.alloc(4);
+      b.writeUInt32LE(data >>> 0);
+      return b;
+    }
+    case REG_QWORD: {
+      const b = Buffer.alloc(8);
+      b.writeBigUInt64LE(BigInt(data));
+      return b;
+    }
+    default:
+      return Buffer.from(data);
+  }
+}
+
+function toFiletime(date) {
+  return BigInt(date.getTime()) * 10000n + FILETIME_UNIX_EPOCH;
+}
+
+// options.subkeysPerList: split subkey lists into an ri index of lh lists
+function buildHive(tree, options = {}) {
+  const cells = [];
+  let next = 32; // first cell after the hbin header
+
+  const alloc = (payloadSize) => {
+    const size = (payloadSize + 4 + 7) & ~7;
+    const buf = Buffer.alloc(size);
+    buf.writeInt32LE(-size, 0);
+    const cell = { offset: next, buf, payload: buf.subarray(4) };
+    cells.push(cell);
+    next += size;
+    return cell;
+  };
+
+  const writeData = (bytes) => {
+    if (bytes.length <= BIG_DATA_SEGMENT) {
+      const cell = alloc(bytes.length);
+      bytes.copy(cell.payload);
+      return cell.offset;
+    }
+    const segments = [];
+    for (let i = 0; i < bytes.length; i += BIG_DATA_SEGMENT) {
+      segments.push(writeData(bytes.subarray(i, i + BIG_DATA_SEGMENT)));
+    }
+    const list = alloc(segments.length * 4);
+    segments.forEach((off, i) => list.payload.writeUInt32LE(off, i * 4));
+    const db = alloc(8);
+    db.payload.write("db", 0, "latin1");
+    db.payload.writeUInt16LE(segments.length, 2);
+    db.payload.writeUInt32LE(list.offset, 4);
+    return db.offset;
+  };
+
+  const writeValue = (name, { type, data }) => {
+    const n = encodeName(name);
+    const bytes = encodeData(type, data);
+    const vk = alloc(20 + n.buf.length);
+    const p = vk.payload;
+    p.write("vk", 0, "latin1");
+    p.writeUInt16LE(n.buf.length, 2);
+    if (bytes.length <= 4) {
+      p.writeUInt32LE((bytes.length | 0x80000000) >>> 0, 4);
+      bytes.copy(p, 8);
+    } else {
+      p.writeUInt32LE(bytes.length, 4);
+      p.writeUInt32LE(writeData(bytes), 8);
+    }
+    p.writeUInt32LE(type, 12);
+    p.writeUInt16LE(n.compressed ? 1 : 0, 16);
+    n.buf.copy(p, 20);
+    return { offset: vk.offset, nameLen: name.length, dataLen: bytes.length };
+  };
+
+  const writeList = (children) => {
+    const leaf = (items) => {
+      const lh = alloc(4 + items.length * 8);
+      lh.payload.write("lh", 0, "latin1");
+      lh.payload.writeUInt16LE(items.length, 2);
+      items.forEach((c, i) => {
+        lh.payload.writeUInt32LE(c.offset, 4 + i * 8);
+        lh.payload.writeUInt32LE(lhHash(c.name), 8 + i * 8);
+      });
+      return lh.offset;
+    };
+    const per = options.subkeysPerList;
+    if (!per || children.length <= per) return leaf(children);
+    const lists = [];
+    for (let i = 0; i < children.length; i += per) {
+      lists.push(leaf(children.slice(i, i + per)));
+    }
+    const ri = alloc(4 + lists.length * 4);
+    ri.payload.write("ri", 0, "latin1");
+    ri.payload.writeUInt16LE(lists.length, 2);
+    lists.forEach((off, i) => ri.payload.writeUInt32LE(off, 4 + i * 4));
+    return ri.offset;
+  };
+
+  const writeKey = (name, node, parent, isRoot) => {
+    const n = encodeName(name);
+    const nk = alloc(76 + n.buf.length);
+    const p = nk.payload;
+    p.write("nk", 0, "latin1");
+    p.writeUInt16LE((isRoot ? 0x2c : 0) | (n.compressed ? 0x20 : 0), 2);
+    p.writeBigUInt64LE(toFiletime(node.lastWriteTime || new Date(0)), 4);
+    p.writeUInt32LE(parent, 16);
+    p.writeUInt32LE(0xffffffff, 28);
+    p.writeUInt32LE(0xffffffff, 32);
+    p.writeUInt32LE(0xffffffff, 40);
+    p.writeUInt32LE(0xffffffff, 44);
+    p.writeUInt32LE(0xffffffff, 48);
+    p.writeUInt16LE(n.buf.length, 72);
+    n.buf.copy(p, 76);
+
+    const names = Object.keys(node.keys || {}).sort(compareNames);
+    const children = names.map((k) => ({
+      name: k,
+      offset: writeKey(k, node.keys[k], nk.offset, false),
+    }));
+    if (children.length) {
+      p.writeUInt32LE(children.length, 20);
+      p.writeUInt32LE(writeList(children), 28);
+      p.writeUInt32LE(Math.max(...names.map((k) => k.length * 2)), 52);
+    }
+
+    const values = Object.entries(node.values || {}).map(([k, v]) => writeValue(k, v));
+    if (values.length) {
+      const list = alloc(values.length * 4);
+      values.forEach((v, i) => list.payload.writeUInt32LE(v.offset, i * 4));
+      p.writeUInt32LE(values.length, 36);
+      p.writeUInt32LE(list.offset, 40);
+      p.writeUInt32LE(Math.max(...values.map((v) => v.nameLen * 2)), 60);
+      p.writeUInt32LE(Math.max(...values.map((v) => v.dataLen)), 64);
+    }
+    return nk.offset;
+  };
+
+  const root = writeKey(options.rootName || "ROOT", tree, 0xffffffff, true);
+
+  // One hive bin holding all cells, padded with a free cell
+  const used = next;
+  const binSize = Math.max(4096, Math.ceil((used + 8) / 4096) * 4096);
+  const bin = Buffer.alloc(binSize);
+  bin.write("hbin", 0, "latin1");
+  bin.writeUInt32LE(0, 4);
+  bin.writeUInt32LE(binSize, 8);
+  for (const c of cells) c.buf.copy(bin, c.offset);
+  bin.writeInt32LE(binSize - used, used);
+
+  const base = Buffer.alloc(4096);
+  base.write("regf", 0, "latin1");
+  base.writeUInt32LE(options.dirty ? 2 : 1, 4);
+  base.writeUInt32LE(1, 8);
+  base.writeUInt32LE(1, 20);
+  base.writeUInt32LE(5, 24);
+  base.writeUInt32LE(0, 28);
+  base.writeUInt32LE(1, 32);
+  base.writeUInt32LE(root, 36);
+  base.writeUInt32LE(binSize, 40);
+  base.writeUInt32LE(1, 44);
+  let checksum = 0;
+  for (let i = 0; i < 508; i += 4) checksum ^= base.readUInt32LE(i);
+  base.writeUInt32LE(checksum >>> 0, 508);
+
+  return Buffer.concat([base, bin]);
+}
+
+// Marvin32 with the seed of transaction log entries, as a BigInt
+function marvin32(buf) {
+  let lo = 0x7a4e55c5;
+  let hi = 0x82ef4d88;
+  const rotl = (x, n) => ((x << n) | (x >>> (32 - n))) >>> 0;
+  const block = () => {
+    hi = (hi ^ lo) >>> 0;
+    lo = (rotl(lo, 20) + hi) >>> 0;
+    hi = rotl(hi, 9);
+    hi = (hi ^ lo) >>> 0;
+    lo = (rotl(lo, 27) + hi) >>> 0;
+    hi = rotl(hi, 19);
+  };
+  let i = 0;
+  for (; i + 4 <= buf.length; i += 4) {
+    lo = (lo + buf.readUInt32LE(i)) >>> 0;
+    block();
+  }
+  let last = 0x80;
+  for (let j = buf.length - 1; j >= i; j--) last = ((last << 8) | buf[j]) >>> 0;
+  lo = (lo + last) >>> 0;
+  block();
+  block();
+  return (BigInt(hi) << 32n) | BigInt(lo);
+}
+
+// A transaction log (new format): the first sector of the base block of
+// `hive` with the given sequence number, then entries
+//   { sequence, hive, pages: [[offset, size]] }
+// rewriting the pages (relative to the first hive bin) with those of their hive
+function buildLog(sequence, hive, entries) {
+  const base = Buffer.from(hive.subarray(0, 512));
+  base.writeUInt32LE(sequence, 4);
+  base.writeUInt32LE(sequence, 8);
+  base.writeUInt32LE(6, 28);
+  let checksum = 0;
+  for (let i = 0; i < 508; i += 4) checksum ^= base.readUInt32LE(i);
+  base.writeUInt32LE(checksum >>> 0, 508);
+
+  const parts = [base];
+  for (const entry of entries) {
+    const refs = Buffer.alloc(entry.pages.length * 8);
+    entry.pages.forEach(([offset, size], i) => {
+      refs.writeUInt32LE(offset, i * 8);
+      refs.writeUInt32LE(size, i * 8 + 4);
+    });
+    const data = entry.pages.map(([offset, size]) => entry.hive.subarray(4096 + offset, 4096 + offset + size));
+    const body = Buffer.concat([refs, ...data]);
+    const size = Math.ceil((40 + body.length) / 512) * 512;
+    const buf = Buffer.alloc(size);
+    buf.write("HvLE", 0, "latin1");
+    buf.writeUInt32LE(size, 4);
+    buf.writeUInt32LE(entry.sequence, 12);
+    buf.writeUInt32LE(entry.hive.length - 4096, 16);
+    buf.writeUInt32LE(entry.pages.length, 20);
+    body.copy(buf, 40);
+    buf.writeBigUInt64LE(marvin32(buf.subarray(40)), 24);
+    buf.writeBigUInt64LE(marvin32(buf.subarray(0, 32)), 32);
+    parts.push(buf);
+  }
+  return Buffer.concat(parts);
+}
+
+module.exports = {
+  buildHive,
+  buildLog,
+  marvin32,
+  REG_SZ, REG_EXPAND_SZ, REG_BINARY, REG_DWORD, REG_MULTI_SZ, REG_QWORD,
+};
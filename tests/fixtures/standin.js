@@ -0,0 +1,9 @@
+// Outside Windows the addon runs against the in-memory stand-in registry,
+// which the tests drive through reg.standin (reset, latency, call counts).
+// describeStandIn declares a suite that only runs there.
+
+const reg = require("../..");
+
+const describeStandIn = reg.standin ? describe : describe.skip;
+
+module.exports = { describeStandIn };
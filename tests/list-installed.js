@@ -22,15 +22,14 @@ function getInstalledApplications() {
         return;
       }
 
-      const values = ksub.enumValues();
-      if ('DisplayName' in values) {
+      // The REG_SZ values only: a string may also be a REG_EXPAND_SZ
+      const types = ksub.enumValues();
+      if ('DisplayName' in types) {
+        const values = ksub.enumValues({ data: true });
         const info = {};
-        for (const n of Object.keys(values)) {
-          if (values[n] == 1) {
-            const value = ksub.getString(n)
-            if (value) {
-              info[n] = value;
-            }
+        for (const n of Object.keys(types)) {
+          if (types[n] == 1 && values[n]) {
+            info[n] = values[n];
           }
         }
         products.push(info);
@@ -0,0 +1,538 @@
+var assert = require("assert");
+var fs = require("fs");
+var os = require("os");
+var path = require("path");
+var reg = require("..");
+var hive = require("./fixtures/regf");
+
+function manyKeys(n) {
+  const keys = {};
+  for (let i = 0; i < n; i++) {
+    keys["Key" + String(i).padStart(4, "0")] = {
+      values: { Index: { type: hive.REG_DWORD, data: i } },
+    };
+  }
+  return keys;
+}
+
+const tree = {
+  values: { "": { type: hive.REG_SZ, data: "root default" } },
+  keys: {
+    Software: {
+      lastWriteTime: new Date(Date.UTC(2021, 7, 24, 10, 30)),
+      keys: {
+        Vendor: {
+          values: {
+            DisplayName: { type: hive.REG_SZ, data: "中文 Виктор 😀" },
+            Version: { type: hive.REG_DWORD, data: 0xdeadbeef },
+            Path: { type: hive.REG_EXPAND_SZ, data: "%SystemRoot%\\system32" },
+            Names: { type: hive.REG_MULTI_SZ, data: ["a", "bb", "ccc"] },
+            Small: { type: hive.REG_DWORD, data: 7 },
+            Blob: { type: hive.REG_BINARY, data: Buffer.alloc(40000, 0x5a) },
+            Large: { type: hive.REG_SZ, data: "x".repeat(20000) },
+          },
+        },
+        Many: { keys: manyKeys(300) },
+        "Ключ": { values: { "Значение": { type: hive.REG_SZ, data: "ok" } } },
+      },
+    },
+  },
+};
+
+// The nk or vk cell of a key or value, by its (ASCII) name
+function keyCell(buf, name) {
+  const at = buf.indexOf(Buffer.from(name, "latin1"), 4096 + 32);
+  assert.equal(buf.toString("latin1", at - 76, at - 74), "nk");
+  return at - 80;
+}
+
+function valueCell(buf, name) {
+  const at = buf.indexOf(Buffer.from(name, "latin1"), 4096 + 32);
+  assert.equal(buf.toString("latin1", at - 20, at - 18), "vk");
+  return at - 24;
+}
+
+describe("offline hive", function() {
+  const file = path.join(os.tmpdir(), `winreg-regf-${process.pid}.hiv`);
+
+  beforeAll(() => {
+    fs.writeFileSync(file, hive.buildHive(tree, { subkeysPerList: 64 }));
+  });
+
+  afterAll(() => {
+    fs.unlinkSync(file);
+  });
+
+  it("open root", function() {
+    const root = reg.openHive(file);
+    assert.ok(root.isValid);
+    assert.equal(root.name, "ROOT");
+    assert.equal(root.getString(""), "root default");
+    assert.deepEqual(root.enumSubKeys(), ["Software"]);
+    root.close();
+    assert.ok(!root.isValid);
+  });
+
+  it("not a hive", function() {
+    assert.throws(() => reg.openHive(__filename), /bad base block signature/);
+    assert.throws(() => reg.openHive(file + ".missing"), (e) => e.code === 2);
+  });
+
+  it("open is case-insensitive", function() {
+    const root = reg.openHive(file);
+    assert.ok(root.open("software\\VENDOR"));
+    assert.ok(root.open("SOFTWARE/vendor"));
+    assert.equal(root.open("Software\\ключ").name, "Ключ");
+    assert.equal(root.open("Software\\Nope"), null);
+    assert.equal(root.open("Software\\Vendor\\Nope"), null);
+  });
+
+  it("open folds case beyond Latin-1", function() {
+    const names = ["ÿes", "Źle", "άλφα", "έψιλον", "ώρα", "ϊώτα", "Ωmega", "ǆemal", "ⅻ", "ｆｕｌｌ", "Ἀθῆναι"];
+    const others = ["Ÿes", "źLE", "ΆΛΦΑ", "ΈΨΙΛΟΝ", "ΏΡΑ", "ΪΏΤΑ", "ωMEGA", "Ǆemal", "Ⅻ", "ＦＵＬＬ", "ἈΘῆΝΑΙ"];
+    const keys = manyKeys(40);
+    for (const name of names) keys[name] = {};
+    keys.Iota = {};
+    for (const buf of [hive.buildHive({ keys }), reg.writeHive({ keys })]) {
+      const file = path.join(os.tmpdir(), `winreg-regf-${process.pid}-case.hiv`);
+      fs.writeFileSync(file, buf);
+      const root = reg.openHive(file);
+      others.forEach((name, i) => assert.equal(root.open(name).name, names[i]));
+      assert.equal(root.open("iota").name, "Iota");
+      assert.equal(root.open("ıota"), null);
+      fs.unlinkSync(file);
+    }
+  });
+
+  it("values", function() {
+    const k = reg.openHive(file).open("Software\\Vendor");
+    assert.equal(k.getString("DisplayName"), "中文 Виктор 😀");
+    assert.equal(k.getString("displayname"), "中文 Виктор 😀");
+    assert.equal(k.getDword("Version"), 0xdeadbeef);
+    assert.equal(k.getDword("Small"), 7);
+    assert.equal(k.getExpandString("Path"), "%SystemRoot%\\system32");
+    assert.deepEqual(k.getMultiString("Names"), ["a", "bb", "ccc"]);
+    assert.equal(k.getString("Large"), "x".repeat(20000));
+    assert.equal(k.getValueType("Blob"), hive.REG_BINARY);
+    assert.equal(k.getValueType("NonExists"), 0);
+  });
+
+  it("value defaults and errors", function() {
+    const k = reg.openHive(file).open("Software\\Vendor");
+    assert.equal(k.getString("NonExists", "Default"), "Default");
+    assert.equal(k.getDword("NonExists", 12345), 12345);
+    assert.throws(() => k.getString("NonExists"), (e) => e.code === 2);
+    assert.throws(() => k.getDword("DisplayName"), /unexpected value type/);
+  });
+
+  it("enumValues", function() {
+    const k = reg.openHive(file).open("Software\\Vendor");
+    const values = k.enumValues();
+    assert.equal(values.DisplayName, hive.REG_SZ);
+    assert.equal(values.Names, hive.REG_MULTI_SZ);
+    assert.equal(values.Blob, hive.REG_BINARY);
+    assert.equal(Object.keys(values).length, 7);
+  });
+
+  it("enumSubKeys over an index root", function() {
+    const many = reg.openHive(file).open("Software\\Many");
+    const keys = many.enumSubKeys();
+    assert.equal(keys.length, 300);
+    assert.equal(keys[0], "Key0000");
+    assert.equal(keys[299], "Key0299");
+    for (const i of [0, 63, 64, 150, 299]) {
+      const name = "Key" + String(i).padStart(4, "0");
+      assert.equal(many.open(name.toLowerCase()).getDword("Index"), i);
+    }
+    assert.equal(many.open("Key0300"), null);
+    assert.equal(many.open("Key"), null);
+  });
+
+  it("corrupt counts and sizes", function() {
+    const healthy = fs.readFileSync(file);
+    const rootCell = 4096 + healthy.readUInt32LE(36);
+    const isCorrupt = (e) => e.code === 1015;
+    const check = (name, damage, read) => {
+      const buf = Buffer.from(healthy);
+      damage(buf);
+      const corrupt = path.join(os.tmpdir(), `winreg-regf-${process.pid}-${name}.hiv`);
+      fs.writeFileSync(corrupt, buf);
+      const root = reg.openHive(corrupt);
+      assert.throws(() => read(root), isCorrupt);
+      root.close();
+      fs.unlinkSync(corrupt);
+    };
+
+    // A value count whose list size overflows 32 bits
+    check("count", (buf) => buf.writeUInt32LE(0x40000001, keyCell(buf, "Vendor") + 4 + 36),
+          (root) => root.open("Software\\Vendor").enumValues());
+    // A subkey list entry pointing at a cell too small for a key
+    check("list", (buf) => {
+      const list = 4096 + buf.readUInt32LE(rootCell + 4 + 28);
+      buf.writeUInt32LE(valueCell(buf, "Small") - 4096, list + 4 + 4);
+    }, (root) => root.open("Software"));
+    // A big data value claiming more than its segments hold
+    check("size", (buf) => buf.writeUInt32LE(0x7ffffff0, valueCell(buf, "Blob") + 4 + 4),
+          (root) => root.open("Software\\Vendor").getBinary("Blob"));
+  });
+
+  it("queryInfoKey", function() {
+    const info = reg.openHive(file).open("Software").queryInfoKey();
+    assert.equal(info.subKeys, 3);
+    assert.equal(info.values, 0);
+    assert.equal(info.lastWriteTime.getTime(), Date.UTC(2021, 7, 24, 10, 30));
+  });
+});
+
+describe("writeHive", function() {
+  let dir;
+
+  beforeAll(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), "winreg-hive-write-"));
+  });
+
+  afterAll(() => {
+    fs.rmSync(dir, { recursive: true });
+  });
+
+  function openWritten(name, t, options) {
+    const file = path.join(dir, name);
+    fs.writeFileSync(file, reg.writeHive(t, options));
+    return reg.openHive(file);
+  }
+
+  function exportTo(name, root) {
+    const file = path.join(dir, name);
+    reg.exportReg(root, "", file, { root: "HKEY_LOCAL_MACHINE\\ROOT" });
+    return fs.readFileSync(file);
+  }
+
+  it("reads back like the fixture writer's hive", function() {
+    const expected = path.join(dir, "fixture.hiv");
+    fs.writeFileSync(expected, hive.buildHive(tree));
+    assert.deepEqual(exportTo("written.reg", openWritten("written.hiv", tree)),
+                     exportTo("fixture.reg", reg.openHive(expected)));
+
+    const k = reg.openHive(path.join(dir, "written.hiv")).open("software\\VENDOR");
+    assert.equal(k.getString("Large"), "x".repeat(20000));
+    assert.deepEqual(k.getMultiString("Names"), ["a", "bb", "ccc"]);
+    assert.equal(reg.openHive(path.join(dir, "written.hiv")).open("Software").queryInfoKey()
+                   .lastWriteTime.getTime(), Date.UTC(2021, 7, 24, 10, 30));
+  });
+
+  it("base block and hive bins", function() {
+    const buf = reg.writeHive(tree, { rootName: "Hive" });
+    assert.equal(buf.toString("latin1", 0, 4), "regf");
+    assert.equal(buf.readUInt32LE(4), buf.readUInt32LE(8));
+    assert.equal(buf.readUInt32LE(0x28), buf.length - 4096);
+    let checksum = 0;
+    for (let i = 0; i < 508; i += 4) checksum ^= buf.readUInt32LE(i);
+    assert.equal(buf.readUInt32LE(508), checksum >>> 0);
+
+    for (let off = 4096; off < buf.length;) {
+      assert.equal(buf.toString("latin1", off, off + 4), "hbin");
+      assert.equal(buf.readUInt32LE(off + 4), off - 4096);
+      const size = buf.readUInt32LE(off + 8);
+      assert.ok(size > 0 && size % 4096 === 0);
+      off += size;
+    }
+    assert.equal(openWritten("named.hiv", tree, { rootName: "Hive" }).name, "Hive");
+  });
+
+  it("subkey lists over 1012 entries get an index root", function() {
+    const many = openWritten("many.hiv", { keys: manyKeys(3000) });
+    const keys = many.enumSubKeys();
+    assert.equal(keys.length, 3000);
+    assert.equal(keys[0], "Key0000");
+    assert.equal(keys[2999], "Key2999");
+    for (const i of [0, 1011, 1012, 2023, 2999]) {
+      const name = "Key" + String(i).padStart(4, "0");
+      assert.equal(many.open(name.toLowerCase()).getDword("Index"), i);
+    }
+    assert.equal(many.open("Key3000"), null);
+  });
+
+  it("invalid trees", function() {
+    assert.throws(() => reg.writeHive(null), /writeHive - invalid arguments/);
+    assert.throws(() => reg.writeHive({ keys: { A: { values: { Bad: 1 } } } }),
+                  /writeHive - invalid tree\\A value "Bad"/);
+    assert.throws(() => reg.writeHive({ keys: { Name: {}, NAME: {} } }),
+                  (e) => e.name === "RegError" && e.code === 87);
+    const value = { type: hive.REG_DWORD, data: 1 };
+    assert.throws(() => reg.writeHive({ keys: { A: { values: { Ab: value, aB: value } } } }),
+                  (e) => e.name === "RegError" && e.code === 87 && /Duplicate value name/.test(e.message));
+  });
+});
+
+describe("transaction logs", function() {
+  let dir;
+  let file;
+
+  // The tree after the changes the logs hold
+  const changed = {
+    values: tree.values,
+    keys: {
+      Software: {
+        lastWriteTime: tree.keys.Software.lastWriteTime,
+        keys: {
+          ...tree.keys.Software.keys,
+          Vendor: {
+            values: {
+              ...tree.keys.Software.keys.Vendor.values,
+              Version: { type: hive.REG_DWORD, data: 2 },
+              Added: { type: hive.REG_SZ, data: "y".repeat(9000) },
+            },
+          },
+          Added: { keys: manyKeys(100) },
+        },
+      },
+    },
+  };
+
+  // The runs of 4 KB pages of hive b that differ from hive a
+  function dirtyPages(a, b) {
+    const runs = [];
+    for (let offset = 0; offset < b.length - 4096; offset += 4096) {
+      const page = b.subarray(4096 + offset, 8192 + offset);
+      if (page.equals(a.subarray(4096 + offset, 8192 + offset))) continue;
+      const last = runs[runs.length - 1];
+      if (last && last[0] + last[1] === offset) last[1] += 4096;
+      else runs.push([offset, 4096]);
+    }
+    return runs;
+  }
+
+  let before;
+  let after;
+  beforeAll(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), "winreg-hive-logs-"));
+    file = path.join(dir, "SOFTWARE");
+    // Sequence numbers 2 and 1: the file is as of sequence number 1
+    before = hive.buildHive(tree, { dirty: true });
+    after = hive.buildHive(changed);
+    fs.writeFileSync(file, before);
+  });
+
+  afterAll(() => {
+    fs.rmSync(dir, { recursive: true });
+  });
+
+  it("marvin32", function() {
+    assert.equal(hive.marvin32(Buffer.alloc(0)), 0xb39efca403966e08n);
+    assert.equal(hive.marvin32(Buffer.from([0, 1, 2, 3, 4, 5, 6])), 0x48c4f4d47d17eb8bn);
+  });
+
+  it("replays the entries of both logs in sequence order", function() {
+    const pages = dirtyPages(before, after).flatMap(([offset, size]) =>
+      Array.from({ length: size / 4096 }, (_, i) => [offset + i * 4096, 4096]));
+    const split = [pages.slice(0, pages.length >> 1), pages.slice(pages.length >> 1)];
+    assert.ok(split[0].length > 0);
+    // .LOG1: a stale entry, then sequence number 1; .LOG2: sequence number 2
+    fs.writeFileSync(file + ".LOG1", hive.buildLog(1, before, [
+      { sequence: 0, hive: before, pages: [[0, 4096]] },
+      { sequence: 1, hive: after, pages: split[0] },
+    ]));
+    fs.writeFileSync(file + ".LOG2", hive.buildLog(2, before, [
+      { sequence: 2, hive: after, pages: split[1] },
+    ]));
+
+    const vendor = reg.openHive(file, { logs: true }).open("Software\\Vendor");
+    assert.equal(vendor.getDword("Version"), 2);
+    assert.equal(vendor.getString("Added"), "y".repeat(9000));
+    assert.equal(vendor.getString("Large"), "x".repeat(20000));
+    const added = reg.openHive(file, { logs: [file + ".LOG2", file + ".LOG1"] }).open("Software\\Added");
+    assert.equal(added.enumSubKeys().length, 100);
+    assert.equal(added.open("Key0099").getDword("Index"), 99);
+
+    // Without the logs, the file as it is
+    assert.equal(reg.openHive(file).open("Software\\Vendor").getDword("Version"), 0xdeadbeef);
+    assert.equal(fs.readFileSync(file).compare(before), 0);
+  });
+
+  it("skips the pages of an entry past the final bins size", function() {
+    // Sequence number 1 rewrites a page the hive drops at sequence number 2,
+    // before the pages that stay
+    const grown = Buffer.concat([after, Buffer.alloc(4096, 0xee)]);
+    fs.writeFileSync(file + ".LOG1", hive.buildLog(1, before, [
+      { sequence: 1, hive: grown, pages: [[after.length - 4096, 4096], ...dirtyPages(before, after)] },
+      { sequence: 2, hive: after, pages: [] },
+    ]));
+    fs.writeFileSync(file + ".LOG2", Buffer.alloc(0));
+
+    const root = reg.openHive(file, { logs: true });
+    assert.equal(root.open("Software\\Vendor").getDword("Version"), 2);
+    assert.equal(root.open("Software\\Vendor").getString("Added"), "y".repeat(9000));
+    assert.equal(root.open("Software\\Added").enumSubKeys().length, 100);
+  });
+
+  it("ignores empty, stale and damaged logs", function() {
+    const stale = hive.buildLog(1, before, [{ sequence: 0, hive: after, pages: [[0, 4096]] }]);
+    const damaged = hive.buildLog(1, before, [{ sequence: 1, hive: after, pages: dirtyPages(before, after) }]);
+    damaged[600] ^= 1;
+    fs.writeFileSync(file + ".LOG1", stale);
+    fs.writeFileSync(file + ".LOG2", damaged);
+    fs.writeFileSync(path.join(dir, "empty.LOG"), Buffer.alloc(0));
+    assert.equal(reg.openHive(file, { logs: true }).open("Software\\Vendor").getDword("Version"), 0xdeadbeef);
+    const root = reg.openHive(file, { logs: [path.join(dir, "empty.LOG")] });
+    assert.equal(root.open("Software\\Added"), null);
+  });
+
+  it("errors", function() {
+    const old = hive.buildLog(1, before, []);
+    old.writeUInt32LE(1, 28);
+    let checksum = 0;
+    for (let i = 0; i < 508; i += 4) checksum ^= old.readUInt32LE(i);
+    old.writeUInt32LE(checksum >>> 0, 508);
+    fs.writeFileSync(path.join(dir, "old.LOG"), old);
+    assert.throws(() => reg.openHive(file, { logs: [path.join(dir, "old.LOG")] }), (e) => e.code === 50);
+    assert.throws(() => reg.openHive(file, { logs: [path.join(dir, "missing.LOG")] }), (e) => e.code === 2);
+    assert.throws(() => reg.openHive(file, 1), /openHive - invalid arguments/);
+  });
+});
+
+describe("scanHive", function() {
+  const healthy = hive.buildHive(tree);
+  const rootCell = 4096 + healthy.readUInt32LE(36);
+
+  it("a healthy hive", function() {
+    const report = reg.scanHive(healthy);
+    assert.ok(report.checksumValid);
+    assert.ok(!report.dirty);
+    assert.equal(report.bins, 1);
+    assert.equal(report.kinds.nk, 305);
+    assert.equal(report.kinds.vk, 309);
+    assert.equal(report.kinds.lh, 3);
+    assert.equal(report.kinds.db, 2);
+    assert.equal(report.allocated.bytes + report.free.bytes, healthy.length - 4096 - 32);
+    assert.deepEqual(report.orphaned, []);
+    assert.deepEqual(report.carved, []);
+    assert.deepEqual(report.problems, []);
+
+    const file = path.join(os.tmpdir(), `winreg-scan-${process.pid}.hiv`);
+    fs.writeFileSync(file, healthy);
+    assert.deepEqual(reg.scanHive(file), report);
+    fs.unlinkSync(file);
+  });
+
+  it("threads report the same", function() {
+    const big = reg.writeHive({ keys: manyKeys(20000) });
+    const report = reg.scanHive(big, { threads: 1 });
+    assert.ok(report.bins > 100);
+    assert.equal(report.kinds.nk, 20001);
+    assert.deepEqual(reg.scanHive(big, { threads: 4 }), report);
+  });
+
+  it("orphaned cells", function() {
+    const buf = Buffer.from(healthy);
+    // The root loses its subkey list
+    buf.writeUInt32LE(0, rootCell + 4 + 20);
+    buf.writeUInt32LE(0xffffffff, rootCell + 4 + 28);
+    const report = reg.scanHive(buf);
+    assert.deepEqual(report.problems, []);
+    const keys = report.orphaned.filter((cell) => cell.kind === "nk").map((cell) => cell.name);
+    assert.equal(keys.length, 304);
+    assert.ok(keys.includes("Software") && keys.includes("Vendor") && keys.includes("Key0299"));
+    assert.equal(reg.scanHive(buf, { orphans: false }).orphaned.length, 0);
+  });
+
+  it("carves deleted cells from free space", function() {
+    const buf = Buffer.from(healthy);
+    const vendor = keyCell(buf, "Vendor");
+    buf.writeInt32LE(-buf.readInt32LE(vendor), vendor);
+    const report = reg.scanHive(buf);
+    assert.deepEqual(report.carved, [{ offset: vendor - 4096, size: buf.readInt32LE(vendor), kind: "nk", name: "Vendor" }]);
+    assert.equal(report.kinds.nk, 304);
+    assert.ok(/isn't allocated/.test(report.problems[0].message));
+    // Its values are left without a key
+    assert.equal(report.orphaned.filter((cell) => cell.kind === "vk").length, 7);
+    assert.deepEqual(reg.scanHive(buf, { carve: false }).carved, []);
+  });
+
+  it("damaged hives", function() {
+    const buf = Buffer.from(healthy);
+    buf.writeUInt32LE(12, keyCell(buf, "Vendor"));
+    buf.writeUInt32LE(3, 4);
+    const report = reg.scanHive(buf);
+    assert.ok(!report.checksumValid);
+    assert.ok(report.dirty);
+    assert.equal(report.problems[0].message, "Bad cell size.");
+
+    // References past the end of the bins
+    const far = Buffer.from(healthy);
+    far.writeUInt32LE(0x7ffffff8, rootCell + 4 + 28);
+    const farReport = reg.scanHive(far);
+    assert.deepEqual(farReport.problems, [
+      { offset: rootCell - 4096, message: "Reference to a cell that isn't allocated." },
+    ]);
+    assert.equal(farReport.orphaned.filter((cell) => cell.kind === "nk").length, 304);
+    far.writeUInt32LE(0x7ffffff8, 36);
+    assert.deepEqual(reg.scanHive(far).problems,
+                     [{ offset: 0x7ffffff8, message: "Reference to a cell that isn't allocated." }]);
+
+    assert.throws(() => reg.scanHive(Buffer.alloc(8192)), (e) => e.code === 1009);
+    assert.throws(() => reg.scanHive(__filename), /bad base block signature/);
+    assert.throws(() => reg.scanHive(42), /scanHive - invalid arguments/);
+  });
+});
+
+describe("path index", function() {
+  const image = hive.buildHive(tree, { subkeysPerList: 64 });
+  const file = path.join(os.tmpdir(), `winreg-index-${process.pid}.hiv`);
+
+  beforeAll(() => {
+    fs.writeFileSync(file, image);
+  });
+
+  afterAll(() => {
+    fs.unlinkSync(file);
+    if (fs.existsSync(file + ".idx")) fs.unlinkSync(file + ".idx");
+  });
+
+  it("opens the same keys as open", function() {
+    const root = reg.openHive(file);
+    const index = reg.buildHiveIndex(root);
+    assert.equal(index.keyCount, 305);
+    for (const p of ["Software\\Vendor", "software/VENDOR", "Software\\ключ", "\\Software\\Many\\key0299\\"]) {
+      const key = index.open(root, p);
+      assert.equal(key.name, root.open(p).name);
+      assert.deepEqual(key.enumValues(), root.open(p).enumValues());
+    }
+    assert.equal(index.open(root, "").name, "ROOT");
+    assert.equal(index.open(root, "Software\\Many\\Key0300"), null);
+    assert.equal(index.open(root, "Software\\Vendor\\Nope"), null);
+    assert.equal(index.open(root, "Vendor"), null);
+  });
+
+  it("persists next to the hive", function() {
+    const root = reg.openHive(file);
+    fs.writeFileSync(file + ".idx", reg.buildHiveIndex(root).save());
+    const loaded = reg.loadHiveIndex(file + ".idx");
+    assert.equal(loaded.keyCount, 305);
+    assert.equal(loaded.open(root, "Software\\Many\\Key0150").getDword("Index"), 150);
+    const fromBuffer = reg.loadHiveIndex(fs.readFileSync(file + ".idx"));
+    assert.equal(fromBuffer.open(root, "software\\many\\KEY0063").getDword("Index"), 63);
+  });
+
+  it("indexes a subtree", function() {
+    const many = reg.openHive(file).open("Software\\Many");
+    const index = reg.buildHiveIndex(many);
+    assert.equal(index.keyCount, 301);
+    assert.equal(index.open(many, "Key0007").getDword("Index"), 7);
+    assert.throws(() => index.open(reg.openHive(file), "Key0007"), (e) => e.code === 13);
+  });
+
+  it("stale and invalid indexes", function() {
+    const index = reg.buildHiveIndex(reg.openHive(file));
+    const changed = Buffer.from(image);
+    changed.writeUInt32LE(changed.readUInt32LE(4) + 1, 4);
+    changed.writeUInt32LE(changed.readUInt32LE(8) + 1, 8);
+    const other = path.join(os.tmpdir(), `winreg-index-${process.pid}-changed.hiv`);
+    fs.writeFileSync(other, changed);
+    assert.throws(() => index.open(reg.openHive(other), "Software"), (e) => e.name === "RegError" && e.code === 13);
+    fs.unlinkSync(other);
+
+    assert.throws(() => reg.loadHiveIndex(Buffer.from("not an index")), (e) => e.code === 13);
+    assert.throws(() => reg.loadHiveIndex(index.save().subarray(0, 100)), (e) => e.code === 13);
+    assert.throws(() => reg.buildHiveIndex(42), /buildHiveIndex - invalid arguments/);
+  });
+});
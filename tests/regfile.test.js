@@ -0,0 +1,248 @@
+var assert = require("assert");
+var fs = require("fs");
+var os = require("os");
+var path = require("path");
+var { Writable } = require("stream");
+var reg = require("..");
+var hive = require("./fixtures/regf");
+var { describeStandIn } = require("./fixtures/standin");
+
+const HKCU = reg.HKEY_CURRENT_USER;
+const ROOT = "Software\\winreg-export";
+const ROOT_PATH = "HKEY_CURRENT_USER\\" + ROOT;
+
+// The tree of fixtures/export.reg, written by regedit's rules: every value
+// type, quoting, a default value, wrapped hex lines and hex(1) for a string
+// that can't be quoted
+const golden = fs.readFileSync(path.join(__dirname, "fixtures", "export.reg"));
+const blob = Buffer.from([...Array(100).keys()]);
+
+const tree = {
+  values: {
+    "": { type: hive.REG_SZ, data: 'C:\\Program Files\\App "quoted"' },
+    Count: { type: hive.REG_DWORD, data: 42 },
+    Big: { type: hive.REG_QWORD, data: 0x1122334455667788n },
+    Path: { type: hive.REG_EXPAND_SZ, data: "%SystemRoot%\\system32" },
+    List: { type: hive.REG_MULTI_SZ, data: ["one", "two", "中文"] },
+    Blob: { type: hive.REG_BINARY, data: blob },
+    'Say "hi"': { type: hive.REG_SZ, data: "😀 Виктор" },
+    Lines: { type: hive.REG_SZ, data: "one\ntwo" },
+  },
+  keys: {
+    Child: {
+      values: { Empty: { type: hive.REG_BINARY, data: Buffer.alloc(0) } },
+      keys: { Grand: { values: { Name: { type: hive.REG_SZ, data: "grand" } } } },
+    },
+    Other: {},
+  },
+};
+
+function buildLive() {
+  const k = new reg.RegKey(HKCU, ROOT);
+  k.setString("", 'C:\\Program Files\\App "quoted"');
+  k.setDword("Count", 42);
+  k.setQword("Big", 0x1122334455667788n);
+  k.setExpandString("Path", "%SystemRoot%\\system32");
+  k.setMultiString("List", ["one", "two", "中文"]);
+  k.setBinary("Blob", blob);
+  k.setString('Say "hi"', "😀 Виктор");
+  k.setString("Lines", "one\ntwo");
+  k.close();
+  new reg.RegKey(HKCU, ROOT + "\\Child").setBinary("Empty", Buffer.alloc(0));
+  new reg.RegKey(HKCU, ROOT + "\\Child\\Grand").setString("Name", "grand");
+  new reg.RegKey(HKCU, ROOT + "\\Other").close();
+}
+
+function collect() {
+  const chunks = [];
+  const stream = new Writable({
+    write(chunk, encoding, callback) {
+      chunks.push(chunk);
+      callback();
+    },
+  });
+  stream.chunks = chunks;
+  return stream;
+}
+
+let dir;
+beforeAll(() => {
+  dir = fs.mkdtempSync(path.join(os.tmpdir(), "winreg-export-"));
+});
+
+afterAll(() => {
+  fs.rmSync(dir, { recursive: true });
+});
+
+describeStandIn("exportReg (live key)", function() {
+  beforeEach(() => {
+    reg.standin.reset();
+    buildLive();
+  });
+
+  it("writes the golden file", function() {
+    const file = path.join(dir, "live.reg");
+    assert.equal(reg.exportReg(HKCU, ROOT, file), golden.length);
+    assert.deepEqual(fs.readFileSync(file), golden);
+  });
+
+  it("streams the same bytes", async function() {
+    const stream = collect();
+    await reg.exportReg(HKCU, ROOT, stream);
+    assert.deepEqual(Buffer.concat(stream.chunks), golden);
+  });
+
+  it("root path option", function() {
+    const file = path.join(dir, "root.reg");
+    reg.exportReg(HKCU, ROOT + "\\Child\\Grand", file, { root: "HKEY_LOCAL_MACHINE\\Grand" });
+    const text = fs.readFileSync(file).toString("utf16le");
+    assert.equal(text, "\ufeffWindows Registry Editor Version 5.00\r\n\r\n" +
+                       "[HKEY_LOCAL_MACHINE\\Grand]\r\n\"Name\"=\"grand\"\r\n\r\n");
+  });
+
+  it("chunks stay bounded whatever the tree size", function() {
+    for (let i = 0; i < 2000; i++) reg.set(HKCU, `${ROOT}\\Many\\Key${i}`, "Value", `value ${i}`);
+    const exporter = new reg.RegFileExporter(HKCU, ROOT);
+    const chunks = [];
+    for (let chunk; (chunk = exporter.read(1)) !== null;) chunks.push(chunk);
+    assert.ok(chunks.length > 2);
+    assert.ok(chunks.every((chunk) => chunk.length <= 64 * 1024));
+    assert.ok(Buffer.concat(chunks).toString("utf16le").includes(`[${ROOT_PATH}\\Many\\Key1999]\r\n"Value"="value 1999"\r\n`));
+  });
+
+  it("writes data as stored, past empty strings and NULs", function() {
+    const values = {
+      List: { type: hive.REG_MULTI_SZ, data: ["one", "", "three"] },
+      Nul: { type: hive.REG_SZ, data: "a\0b" },
+    };
+    const k = new reg.RegKey(HKCU, ROOT + "\\Raw");
+    k.setMultiString("List", values.List.data);
+    k.setString("Nul", values.Nul.data);
+    k.close();
+    const live = path.join(dir, "raw-live.reg");
+    reg.exportReg(HKCU, ROOT + "\\Raw", live, { root: "HKEY_CURRENT_USER\\Raw" });
+
+    const hiveFile = path.join(dir, "raw.hiv");
+    fs.writeFileSync(hiveFile, hive.buildHive({ values }));
+    const offline = path.join(dir, "raw-hive.reg");
+    reg.exportReg(reg.openHive(hiveFile), "", offline, { root: "HKEY_CURRENT_USER\\Raw" });
+
+    const text = fs.readFileSync(live);
+    assert.deepEqual(text, fs.readFileSync(offline));
+    assert.ok(text.toString("utf16le").includes(
+      '"List"=hex(7):6f,00,6e,00,65,00,00,00,00,00,74,00,68,00,72,00,65,00,65,00,00,\\\r\n  00,00,00\r\n' +
+      '"Nul"=hex(1):61,00,00,00,62,00,00,00\r\n'));
+  });
+
+  it("missing key", function() {
+    assert.throws(() => reg.exportReg(HKCU, ROOT + "\\Missing", path.join(dir, "missing.reg")),
+                  (e) => e.name === "RegError" && e.code === 2);
+  });
+});
+
+describe("exportReg (offline hive)", function() {
+  it("writes the same file as the live key", function() {
+    const hiveFile = path.join(dir, "export.hiv");
+    fs.writeFileSync(hiveFile, hive.buildHive(tree));
+    const root = reg.openHive(hiveFile);
+    const file = path.join(dir, "hive.reg");
+    reg.exportReg(root, "", file, { root: ROOT_PATH });
+    assert.deepEqual(fs.readFileSync(file), golden);
+    root.close();
+  });
+});
+
+describeStandIn("importReg", function() {
+  beforeEach(() => {
+    reg.standin.reset();
+  });
+
+  it("imports the golden file back to the same tree", function() {
+    const stats = reg.importReg(path.join(__dirname, "fixtures", "export.reg"));
+    assert.deepEqual(stats, { keysWritten: 4, keysDeleted: 0, valuesSet: 10, valuesDeleted: 0 });
+    const file = path.join(dir, "reimported.reg");
+    reg.exportReg(HKCU, ROOT, file);
+    assert.deepEqual(fs.readFileSync(file), golden);
+  });
+
+  it("parses REGEDIT4 and UTF-8 files, a key before its subkeys", function() {
+    const text = [
+      "REGEDIT4",
+      "",
+      "[HKEY_CURRENT_USER\\Software\\Import\\B]",
+      '"Name"="b é"',
+      "; comment",
+      "[HKCU\\Software\\Import\\A\\Sub]",
+      '"Gone"="x"',
+      "[HKEY_CURRENT_USER\\Software\\Import\\A]",
+      '@="default"',
+      '"Path"=hex(2):25,54,45,4d,50,25,00',
+      '"Bits"=hex:01,02,\\',
+      "  03",
+      "[-HKEY_CURRENT_USER\\Software\\Import\\A\\Sub]",
+      "[hkey_current_user\\Software\\Import\\A]",
+      '"Count"=dword:0000002a',
+      '"Old"=-',
+      "",
+    ].join("\r\n");
+    assert.deepEqual(reg.parseReg(Buffer.from(text)), [
+      {
+        path: "HKEY_CURRENT_USER\\Software\\Import\\A",
+        deleteTree: false,
+        create: true,
+        values: [
+          { name: "", type: hive.REG_SZ, value: "default" },
+          { name: "Path", type: hive.REG_EXPAND_SZ, value: "%TEMP%" },
+          { name: "Bits", type: hive.REG_BINARY, value: Buffer.from([1, 2, 3]) },
+          { name: "Count", type: hive.REG_DWORD, value: 42 },
+          { name: "Old", remove: true },
+        ],
+      },
+      { path: "HKEY_CURRENT_USER\\Software\\Import\\A\\Sub", deleteTree: true, create: false, values: [] },
+      {
+        path: "HKEY_CURRENT_USER\\Software\\Import\\B",
+        deleteTree: false,
+        create: true,
+        values: [{ name: "Name", type: hive.REG_SZ, value: "b é" }],
+      },
+    ]);
+  });
+
+  it("deletes keys and values", function() {
+    reg.set(HKCU, "Software\\Import\\Old\\Sub", "Name", "x");
+    reg.set(HKCU, "Software\\Import\\Keep", "Old", "x");
+    const text = [
+      "Windows Registry Editor Version 5.00",
+      "[-HKEY_CURRENT_USER\\Software\\Import\\Old]",
+      "[-HKEY_CURRENT_USER\\Software\\Import\\Missing]",
+      "[HKEY_CURRENT_USER\\Software\\Import\\Keep]",
+      '"Old"=-',
+      '"Missing"=-',
+      '"New"="😀"',
+    ].join("\n");
+    const file = path.join(dir, "delete.reg");
+    fs.writeFileSync(file, Buffer.concat([Buffer.from([0xff, 0xfe]), Buffer.from(text, "utf16le")]));
+    assert.deepEqual(reg.importReg(file), { keysWritten: 1, keysDeleted: 1, valuesSet: 1, valuesDeleted: 1 });
+    assert.equal(reg.openKey(HKCU, "Software\\Import\\Old").isValid, false);
+    assert.deepEqual(reg.openKey(HKCU, "Software\\Import\\Keep").enumValues({ data: true }), { New: "😀" });
+  });
+
+  it("parses in parallel", function() {
+    const lines = ["Windows Registry Editor Version 5.00"];
+    for (let i = 0; i < 20000; i++) {
+      lines.push("", `[HKEY_LOCAL_MACHINE\\Software\\Import\\K${i % 500}\\S${i}]`, `"Value"="value ${i}"`);
+    }
+    const buffer = Buffer.from(lines.join("\r\n"));
+    const changes = reg.parseReg(buffer, { threads: 1 });
+    assert.equal(changes.length, 20000);
+    assert.deepEqual(reg.parseReg(buffer, { threads: 4 }), changes);
+  });
+
+  it("invalid files", function() {
+    assert.throws(() => reg.parseReg(Buffer.from("not a .reg file")),
+                  (e) => e.name === "RegError" && e.code === 13);
+    assert.throws(() => reg.parseReg(Buffer.from('REGEDIT4\n[HKCU\\x]\n"a"=dword:zz\n')),
+                  (e) => e.code === 13 && /line 3: bad dword data/.test(e.message));
+    assert.throws(() => reg.importReg(path.join(dir, "missing.reg")), (e) => e.code === 2);
+  });
+});
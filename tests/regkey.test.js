@@ -0,0 +1,320 @@
+var assert = require("assert");
+var reg = require("..");
+var { describeStandIn } = require("./fixtures/standin");
+
+const HKCU = reg.HKEY_CURRENT_USER;
+const KEY = "Software\\winreg-regkey";
+
+describeStandIn("RegKey (stand-in registry)", function() {
+  let k;
+
+  beforeEach(() => {
+    reg.standin.reset();
+    k = new reg.RegKey(HKCU, KEY);
+    k.setString("Name", "中文 Виктор 😀");
+    k.setDword("Count", 0xdeadbeef);
+    k.setExpandString("Path", "%SystemRoot%\\system32");
+  });
+
+  afterEach(() => {
+    k.close();
+  });
+
+  describe("enumValues", function() {
+    it("types", function() {
+      assert.deepEqual(k.enumValues(), { Name: 1, Count: 4, Path: 2 });
+    });
+
+    it("with data", function() {
+      assert.deepEqual(k.enumValues({ data: true }), {
+        Name: "中文 Виктор 😀",
+        Count: 0xdeadbeef,
+        Path: "%SystemRoot%\\system32",
+      });
+      assert.deepEqual(k.enumValues({ data: false }), { Name: 1, Count: 4, Path: 2 });
+    });
+
+    it("with data in one pass", function() {
+      reg.standin.resetCallCounts();
+      k.enumValues({ data: true });
+      const calls = reg.standin.callCounts();
+      assert.equal(calls.RegQueryInfoKey, 1);
+      assert.equal(calls.RegEnumValue, 3);
+      assert.equal(calls.RegGetValue, 0);
+    });
+
+    it("empty key", function() {
+      const empty = new reg.RegKey(HKCU, KEY + "\\Empty");
+      assert.deepEqual(empty.enumValues({ data: true }), {});
+      empty.close();
+    });
+  });
+
+  describe("enumSubKeys", function() {
+    it("names of any length", function() {
+      const names = ["a", "Ünïcode 😀", "x".repeat(255)];
+      for (let i = 0; i < 100; i++) names.push(`Sub${i}`);
+      for (const name of names) new reg.RegKey(HKCU, KEY + "\\" + name).close();
+      assert.deepEqual(k.enumSubKeys().sort(), names.sort());
+    });
+
+    it("one registry call per subkey", function() {
+      for (let i = 0; i < 3; i++) new reg.RegKey(HKCU, KEY + `\\Sub${i}`).close();
+      reg.standin.resetCallCounts();
+      assert.deepEqual(k.enumSubKeys(), ["Sub0", "Sub1", "Sub2"]);
+      const calls = reg.standin.callCounts();
+      assert.equal(calls.RegQueryInfoKey, 1);
+      assert.equal(calls.RegEnumKeyEx, 4);
+    });
+
+    it("a page at a time", function() {
+      for (let i = 0; i < 5; i++) new reg.RegKey(HKCU, KEY + `\\Sub${i}`).close();
+      assert.deepEqual(k.enumSubKeys(1, 2), ["Sub1", "Sub2"]);
+      assert.deepEqual(k.enumSubKeys(3, 10), ["Sub3", "Sub4"]);
+      assert.deepEqual(k.enumSubKeys(5, 10), []);
+      assert.deepEqual(k.enumSubKeys(2), ["Sub2", "Sub3", "Sub4"]);
+    });
+  });
+
+  describe("enumSubKeysDetailed", function() {
+    const t1 = new Date("2024-01-02T03:04:05.006Z");
+    const t2 = new Date("2024-06-07T08:09:10.011Z");
+
+    beforeEach(() => {
+      reg.standin.setTime(t1);
+      const a = new reg.RegKey(HKCU, KEY + "\\A");
+      a.setDword("x", 1);
+      a.setDword("y", 2);
+      new reg.RegKey(HKCU, KEY + "\\A\\Sub").close();
+      new reg.RegKey(HKCU, KEY + "\\B").close();
+      reg.standin.setTime(t2);
+      a.setDword("x", 3);
+      a.close();
+      reg.standin.setTime(null);
+    });
+
+    it("records with last write times", function() {
+      const subKeys = k.enumSubKeysDetailed();
+      assert.deepEqual(subKeys, [
+        { name: "A", lastWriteTime: t2 },
+        { name: "B", lastWriteTime: t1 },
+      ]);
+    });
+
+    it("counts", function() {
+      const subKeys = k.enumSubKeysDetailed({ counts: true });
+      assert.deepEqual(subKeys.map((s) => [s.name, s.subKeys, s.values]),
+                       [["A", 1, 2], ["B", 0, 0]]);
+    });
+
+    it("parallel typed arrays", function() {
+      const subKeys = k.enumSubKeysDetailed({ typed: true, counts: true });
+      assert.deepEqual(subKeys.names, ["A", "B"]);
+      assert.ok(subKeys.lastWriteTimes instanceof Float64Array);
+      assert.deepEqual(Array.from(subKeys.lastWriteTimes), [t2.getTime(), t1.getTime()]);
+      assert.deepEqual(Array.from(subKeys.subKeys), [1, 0]);
+      assert.deepEqual(Array.from(subKeys.values), [2, 0]);
+      assert.equal(k.enumSubKeysDetailed({ typed: true }).subKeys, undefined);
+    });
+
+    it("one registry call per subkey without counts", function() {
+      reg.standin.resetCallCounts();
+      k.enumSubKeysDetailed();
+      const calls = reg.standin.callCounts();
+      assert.equal(calls.RegEnumKeyEx, 3);
+      assert.equal(calls.RegOpenKeyEx, 0);
+      assert.equal(calls.RegQueryInfoKey, 1);
+    });
+  });
+
+  describe("value reads", function() {
+    it("short values in a single call", function() {
+      reg.standin.resetCallCounts();
+      assert.equal(k.getString("Name"), "中文 Виктор 😀");
+      assert.equal(k.getExpandString("Path", false), "%SystemRoot%\\system32");
+      assert.equal(reg.standin.callCounts().RegGetValue, 2);
+    });
+
+    it("long values", function() {
+      for (const length of [0, 100, 127, 128, 255, 256, 10000]) {
+        const value = "ab😀".repeat(length).slice(0, length);
+        k.setString("Long", value);
+        reg.standin.resetCallCounts();
+        assert.equal(k.getString("Long"), value);
+        assert.ok(reg.standin.callCounts().RegGetValue <= 2);
+      }
+    });
+  });
+
+  describe("typed values", function() {
+    beforeEach(() => {
+      k.setQword("Qword", 2n ** 60n + 1n);
+      k.setBinary("Blob", Buffer.from([1, 2, 3]));
+      k.setMultiString("Multi", ["a", "中文 😀", "c"]);
+    });
+
+    it("get", function() {
+      assert.equal(k.get("Name"), "中文 Виктор 😀");
+      assert.strictEqual(k.get("Count"), 0xdeadbeef);
+      assert.equal(k.get("Path"), "%SystemRoot%\\system32");
+      assert.strictEqual(k.get("Qword"), 2n ** 60n + 1n);
+      assert.deepEqual(k.get("Blob"), Buffer.from([1, 2, 3]));
+      assert.deepEqual(k.get("Multi"), ["a", "中文 😀", "c"]);
+      assert.equal(k.get("Missing", "def"), "def");
+      assert.throws(() => k.get("Missing"), (e) => e.code === 2);
+    });
+
+    it("long values", function() {
+      const long = "x".repeat(5000);
+      k.setString("Long", long);
+      k.setMultiString("LongMulti", [long, long]);
+      assert.equal(k.get("Long"), long);
+      assert.deepEqual(k.get("LongMulti"), [long, long]);
+    });
+
+    it("one registry call per value", function() {
+      const names = ["Name", "Count", "Path", "Qword", "Blob", "Multi"];
+      reg.standin.resetCallCounts();
+      names.forEach((name) => k.get(name));
+      names.forEach((name) => reg.queryValue(HKCU, KEY, name));
+      const calls = reg.standin.callCounts();
+      assert.equal(calls.RegGetValue, 2 * names.length);
+      assert.equal(calls.RegQueryValueEx, 0);
+    });
+
+    it("queryValue", function() {
+      assert.equal(reg.queryValue(HKCU, KEY, "Name"), "中文 Виктор 😀");
+      assert.strictEqual(reg.queryValue(HKCU, KEY, "Count"), 0xdeadbeef);
+      assert.strictEqual(reg.queryValue(HKCU, KEY, "Qword"), 2n ** 60n + 1n);
+      assert.deepEqual(reg.queryValue(HKCU, KEY, "Blob"), Buffer.from([1, 2, 3]));
+      assert.deepEqual(reg.queryValue(HKCU, KEY, "Multi"), ["a", "中文 😀", "c"]);
+      assert.deepEqual(reg.queryValues(HKCU, [[KEY, "Qword"], [KEY, "Multi"]]),
+                       [2n ** 60n + 1n, ["a", "中文 😀", "c"]]);
+    });
+
+    it("queryValue expands REG_EXPAND_SZ", function() {
+      process.env.WINREG_TEST_DIR = "C:\\Test";
+      k.setExpandString("Dir", "%WINREG_TEST_DIR%\\bin");
+      assert.equal(reg.queryValue(HKCU, KEY, "Dir"), "C:\\Test\\bin");
+      assert.deepEqual(reg.queryValues(HKCU, [[KEY, "Dir"]]), ["C:\\Test\\bin"]);
+      assert.equal(k.get("Dir"), "%WINREG_TEST_DIR%\\bin");
+      delete process.env.WINREG_TEST_DIR;
+    });
+  });
+
+  describe("misses", function() {
+    it("defaults", function() {
+      assert.equal(k.getString("Missing", "def"), "def");
+      assert.equal(k.getExpandString("Missing", false, "def"), "def");
+      assert.deepEqual(k.getMultiString("Missing", []), []);
+      assert.equal(k.getDword("Missing", 7), 7);
+      assert.equal(reg.queryValue(HKCU, KEY, "Missing"), null);
+      assert.equal(reg.queryValue(HKCU, KEY + "\\Missing", "Name"), null);
+      assert.deepEqual(reg.queryValues(HKCU, [[KEY, "Missing"], [KEY + "\\Missing", "Name"]]),
+                       [null, null]);
+    });
+
+    it("open of a missing key", function() {
+      const probe = new reg.RegKey();
+      assert.strictEqual(probe.open(HKCU, KEY + "\\Missing"), false);
+      assert.equal(probe.isValid, false);
+      assert.strictEqual(probe.open(HKCU, KEY), probe);
+      assert.equal(probe.getDword("Count"), 0xdeadbeef);
+      probe.close();
+    });
+
+    it("other errors are still thrown", function() {
+      assert.throws(() => k.getString("Missing"),
+                    (e) => e.name === "RegError" && e.code === 2 &&
+                           /Cannot get string value: RegGetValue failed/.test(e.message));
+      assert.throws(() => k.getDword("Name", 7),
+                    (e) => e.code === 1630 && /Cannot get DWORD value/.test(e.message));
+      assert.throws(() => k.getString("Count", "def"), (e) => e.code === 1630);
+    });
+  });
+
+  describe("binary values", function() {
+    it("round trip", function() {
+      const data = Buffer.from([0, 1, 2, 0xfe, 0xff]);
+      assert.strictEqual(k.setBinary("Blob", data), k);
+      const read = k.getBinary("Blob");
+      assert.ok(Buffer.isBuffer(read));
+      assert.deepEqual(read, data);
+      assert.equal(k.enumValues().Blob, 3);
+    });
+
+    it("empty and large", function() {
+      k.setBinary("Empty", Buffer.alloc(0));
+      assert.equal(k.getBinary("Empty").length, 0);
+
+      const big = Buffer.alloc(4 * 1024 * 1024);
+      for (let i = 0; i < big.length; i += 4093) {
+        big[i] = i & 0xff;
+      }
+      k.setBinary("Big", big);
+      assert.ok(k.getBinary("Big").equals(big));
+    });
+
+    it("typed array and DataView views", function() {
+      const bytes = new Uint8Array([9, 9, 1, 2, 3, 4, 9, 9]);
+      k.setBinary("Sub", bytes.subarray(2, 6));
+      assert.deepEqual([...k.getBinary("Sub")], [1, 2, 3, 4]);
+
+      k.setBinary("Words", new Uint16Array([0x0201, 0x0403]));
+      assert.deepEqual([...k.getBinary("Words")], [1, 2, 3, 4]);
+
+      k.setBinary("View", new DataView(bytes.buffer, 1, 3));
+      assert.deepEqual([...k.getBinary("View")], [9, 1, 2]);
+
+      k.setBinary("Whole", bytes.buffer);
+      assert.equal(k.getBinary("Whole").length, 8);
+    });
+
+    it("one size query and one read", function() {
+      k.setBinary("Blob", Buffer.alloc(1000, 7));
+      reg.standin.resetCallCounts();
+      k.getBinary("Blob");
+      assert.equal(reg.standin.callCounts().RegGetValue, 2);
+    });
+
+    it("default value and errors", function() {
+      assert.equal(k.getBinary("NonExists", null), null);
+      assert.throws(() => k.getBinary("NonExists"), /RegGetValue failed/);
+      assert.throws(() => k.getBinary("Count"), /RegGetValue failed/);
+      assert.throws(() => k.setBinary("Blob", "not bytes"), /Invalid argment/);
+      assert.throws(() => k.setBinary("Blob", [1, 2]), /Invalid argment/);
+    });
+  });
+
+  describe("QWORD values", function() {
+    it("round trip as BigInt", function() {
+      k.setQword("Max", 0xffffffffffffffffn);
+      assert.strictEqual(k.getQword("Max"), 0xffffffffffffffffn);
+      k.setQword("Big", 2n ** 53n + 1n);
+      assert.strictEqual(k.getQword("Big"), 2n ** 53n + 1n);
+      assert.equal(k.enumValues().Max, 11);
+    });
+
+    it("accepts safe integers", function() {
+      k.setQword("Small", 42);
+      assert.strictEqual(k.getQword("Small"), 42n);
+      k.setQword("Safe", Number.MAX_SAFE_INTEGER);
+      assert.strictEqual(k.getQword("Safe"), BigInt(Number.MAX_SAFE_INTEGER));
+    });
+
+    it("rejects values out of range", function() {
+      assert.throws(() => k.setQword("Q", -1n), /Invalid argment/);
+      assert.throws(() => k.setQword("Q", 2n ** 64n), /Invalid argment/);
+      assert.throws(() => k.setQword("Q", -1), /Invalid argment/);
+      assert.throws(() => k.setQword("Q", 1.5), /Invalid argment/);
+      assert.throws(() => k.setQword("Q", 2 ** 53), /Invalid argment/);
+      assert.throws(() => k.setQword("Q", "1"), /Invalid argment/);
+    });
+
+    it("default value and errors", function() {
+      assert.equal(k.getQword("NonExists", 0n), 0n);
+      assert.throws(() => k.getQword("NonExists"), /RegGetValue failed/);
+      assert.throws(() => k.getQword("Count"), /RegGetValue failed/);
+    });
+  });
+});
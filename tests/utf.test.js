@@ -0,0 +1,173 @@
+var assert = require("assert");
+var reg = require("..");
+
+// The transcoder probes are part of the stand-in registry's test hooks
+var { describeStandIn } = require("./fixtures/standin");
+
+const HKCU = reg.HKEY_CURRENT_USER;
+const KEY = "Software/winreg-utf";
+
+// Reference conversions: WHATWG decoding, U+FFFD for ill-formed input
+const decoder = new TextDecoder("utf-8");
+const strictDecoder = new TextDecoder("utf-8", { fatal: true });
+
+function isWellFormed(bytes) {
+  try {
+    strictDecoder.decode(bytes);
+    return true;
+  } catch (e) {
+    return false;
+  }
+}
+
+function toUnits(str, unitSize) {
+  if (unitSize === 2) {
+    return Buffer.from(str, "utf16le");
+  }
+  const codePoints = Array.from(str, (c) => c.codePointAt(0));
+  return Buffer.from(new Uint32Array(codePoints).buffer);
+}
+
+function expectUtf8ToWide(bytes, unitSize) {
+  const result = reg.standin.utf8ToWide(Buffer.from(bytes), unitSize);
+  assert.deepEqual(result.wide, toUnits(decoder.decode(Buffer.from(bytes)), unitSize),
+                   `${Buffer.from(bytes).toString("hex")} as ${unitSize} byte units`);
+  assert.equal(result.valid, isWellFormed(Buffer.from(bytes)));
+}
+
+// Deterministic PRNG, so failures can be reproduced
+function random(seed) {
+  let state = seed >>> 0;
+  return (n) => {
+    state = (Math.imul(state, 1664525) + 1013904223) >>> 0;
+    return state % n;
+  };
+}
+
+function randomString(rand, length) {
+  let str = "";
+  for (let i = 0; i < length; i++) {
+    const r = rand(10);
+    if (r < 6) {
+      str += String.fromCharCode(rand(0x80));
+    } else if (r < 7) {
+      str += String.fromCharCode(0x80 + rand(0x780));
+    } else if (r < 9) {
+      str += String.fromCharCode(0x800 + rand(0xF800)); // may be a lone surrogate
+    } else {
+      str += String.fromCodePoint(0x10000 + rand(0x100000));
+    }
+  }
+  return str;
+}
+
+describeStandIn("UTF-8 transcoder", function() {
+  it("converts ASCII across SIMD block boundaries", function() {
+    for (let length = 0; length < 100; length++) {
+      for (const tail of ["", "é", "中", "😀"]) {
+        const str = "abcdefghijklmnopqrstuvwxyz0123456789".repeat(3).slice(0, length) + tail;
+        for (const unitSize of [2, 4]) {
+          expectUtf8ToWide(Buffer.from(str), unitSize);
+          const back = reg.standin.wideToUtf8(toUnits(str, unitSize), unitSize);
+          assert.equal(back.utf8.toString(), str);
+          assert.equal(back.valid, true);
+        }
+      }
+    }
+  });
+
+  it("converts multi-byte sequences and surrogate pairs", function() {
+    for (const str of ["ü", "Приложение", "中文 value", "😀 b", "a\u0000b", "￿\u{10FFFF}"]) {
+      expectUtf8ToWide(Buffer.from(str), 2);
+      expectUtf8ToWide(Buffer.from(str), 4);
+    }
+    assert.deepEqual(reg.standin.utf8ToWide(Buffer.from("😀"), 2).wide,
+                     Buffer.from([0x3D, 0xD8, 0x00, 0xDE]));
+  });
+
+  it("replaces ill-formed UTF-8 like WHATWG decoders", function() {
+    const cases = [
+      [0x80], [0xBF, 0x41], [0xC0, 0xAF], [0xC1, 0xBF], [0xC2], [0xC2, 0x41],
+      [0xE0, 0x80, 0x80], [0xE0, 0xA0], [0xED, 0xA0, 0x80], [0xED, 0x9F, 0xBF],
+      [0xEF, 0xBF], [0xF0, 0x8F, 0xBF, 0xBF], [0xF0, 0x90, 0x80], [0xF4, 0x90, 0x80, 0x80],
+      [0xF5, 0x80], [0xFF], [0x41, 0xE2, 0x82, 0x42, 0xE2, 0x82, 0xAC],
+      Array(40).fill(0x41).concat([0xE2, 0x28, 0xA1]).concat(Array(40).fill(0x42)),
+    ];
+    for (const bytes of cases) {
+      expectUtf8ToWide(bytes, 2);
+      expectUtf8ToWide(bytes, 4);
+    }
+  });
+
+  it("replaces lone surrogates and out of range code points", function() {
+    const units = [0x41, 0xD800, 0x42, 0xDC00, 0xD83D, 0xDE00, 0xDBFF];
+    let result = reg.standin.wideToUtf8(Buffer.from(new Uint16Array(units).buffer), 2);
+    assert.equal(result.utf8.toString(), "A�B�😀�");
+    assert.equal(result.valid, false);
+
+    const codePoints = [0x41, 0xD800, 0x10FFFF, 0x110000, 0xFFFFFFFF];
+    result = reg.standin.wideToUtf8(Buffer.from(new Uint32Array(codePoints).buffer), 4);
+    assert.equal(result.utf8.toString(), "A�\u{10FFFF}��");
+    assert.equal(result.valid, false);
+  });
+
+  it("fuzz: UTF-8 to wide matches TextDecoder", function() {
+    const rand = random(0x5EED);
+    for (let n = 0; n < 3000; n++) {
+      const bytes = Buffer.from(randomString(rand, rand(70)));
+      // Corrupt some inputs: drop, insert or overwrite bytes
+      for (let k = n % 3 === 0 ? 0 : 1 + rand(3); k > 0 && bytes.length > 0; k--) {
+        bytes[rand(bytes.length)] = rand(256);
+      }
+      const cut = n % 5 === 0 ? rand(bytes.length + 1) : bytes.length;
+      expectUtf8ToWide(bytes.subarray(0, cut), 2);
+      expectUtf8ToWide(bytes.subarray(0, cut), 4);
+    }
+  });
+
+  it("fuzz: wide to UTF-8 matches Buffer.from", function() {
+    const rand = random(0xC0FFEE);
+    for (let n = 0; n < 3000; n++) {
+      const str = randomString(rand, rand(70));
+      const result = reg.standin.wideToUtf8(toUnits(str, 2), 2);
+      assert.deepEqual(result.utf8, Buffer.from(str), JSON.stringify(str));
+      assert.equal(result.valid, str.isWellFormed ? str.isWellFormed()
+                                                  : !/[\uD800-\uDFFF]/u.test(str));
+    }
+  });
+
+});
+
+describeStandIn("string marshalling", function() {
+  it("round-trips names and values through the registry", function() {
+    reg.standin.reset();
+    const rand = random(42);
+    for (let n = 0; n < 200; n++) {
+      // Lone surrogates too: strings travel as UTF-16, never as UTF-8
+      const str = randomString(rand, rand(70)).replace(/[\u0000\\/]/g, "x");
+      reg.set(HKCU, `${KEY}/${str}`, str, str);
+      assert.equal(reg.queryValue(HKCU, `${KEY}/${str}`, str), str);
+    }
+  });
+
+  it("round-trips RegKey names and values", function() {
+    reg.standin.reset();
+    const names = ["plain", "中文", "😀 emoji", "lone \uD800 high", "lone \uDC00 low", "a".repeat(200)];
+    const key = new reg.RegKey(HKCU, KEY + "/RegKey");
+    for (const name of names) {
+      key.setString(name, name + "=" + name);
+      key.setExpandString(name + "%", "%" + name);
+      new reg.RegKey(HKCU, `${KEY}/RegKey/${name}`).close();
+    }
+    for (const name of names) {
+      assert.equal(key.getString(name), name + "=" + name);
+      assert.equal(key.getExpandString(name + "%"), "%" + name);
+    }
+    assert.deepEqual(key.enumSubKeys().sort(), names.slice().sort());
+    const values = key.enumValues({ data: true });
+    for (const name of names) {
+      assert.equal(values[name], name + "=" + name);
+    }
+    key.close();
+  });
+});
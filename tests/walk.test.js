@@ -0,0 +1,306 @@
+var assert = require("assert");
+var fs = require("fs");
+var os = require("os");
+var path = require("path");
+var reg = require("..");
+var { describeStandIn } = require("./fixtures/standin");
+
+const HKCU = reg.HKEY_CURRENT_USER;
+const REG_SZ = 1, REG_DWORD = 4;
+const UNINSTALL = "Software\\winreg-walk\\Uninstall";
+
+describeStandIn("snapshot", function() {
+  beforeEach(() => {
+    reg.standin.reset();
+    for (const [id, name, version] of [["{A}", "App A", 1], ["{B}", "Приложение B", 2]]) {
+      reg.set(HKCU, `${UNINSTALL}\\${id}`, "DisplayName", name);
+      reg.set(HKCU, `${UNINSTALL}\\${id}`, "Version", version);
+      reg.set(HKCU, `${UNINSTALL}\\${id}\\Nested`, "Level", 2);
+    }
+    reg.set(HKCU, UNINSTALL, "Count", 2);
+  });
+
+  it("whole subtree", function() {
+    assert.deepEqual(reg.snapshot(HKCU, UNINSTALL), {
+      values: { Count: 2 },
+      keys: {
+        "{A}": {
+          values: { DisplayName: "App A", Version: 1 },
+          keys: { Nested: { values: { Level: 2 }, keys: {} } },
+        },
+        "{B}": {
+          values: { DisplayName: "Приложение B", Version: 2 },
+          keys: { Nested: { values: { Level: 2 }, keys: {} } },
+        },
+      },
+    });
+  });
+
+  it("depth", function() {
+    assert.deepEqual(reg.snapshot(HKCU, UNINSTALL, { depth: 0 }), {
+      values: { Count: 2 }, keys: {},
+    });
+    const s = reg.snapshot(HKCU, UNINSTALL, { depth: 1 });
+    assert.deepEqual(Object.keys(s.keys), ["{A}", "{B}"]);
+    assert.deepEqual(s.keys["{A}"].keys, {});
+  });
+
+  it("value filters", function() {
+    const byName = reg.snapshot(HKCU, UNINSTALL, { depth: 1, valueFilter: ["displayname"] });
+    assert.deepEqual(byName.values, {});
+    assert.deepEqual(byName.keys["{B}"].values, { DisplayName: "Приложение B" });
+    assert.deepEqual(reg.snapshot(HKCU, UNINSTALL + "/{A}", { valueFilter: "Version" }).values,
+                     { Version: 1 });
+
+    const byType = reg.snapshot(HKCU, UNINSTALL, { types: [REG_SZ] });
+    assert.deepEqual(byType.values, {});
+    assert.deepEqual(byType.keys["{A}"].values, { DisplayName: "App A" });
+    assert.deepEqual(reg.snapshot(HKCU, UNINSTALL, { types: [REG_DWORD] }).keys["{A}"].values,
+                     { Version: 1 });
+  });
+
+  it("missing key", function() {
+    assert.equal(reg.snapshot(HKCU, UNINSTALL + "\\Nope"), null);
+    assert.throws(() => reg.snapshot(HKCU), /invalid arguments/);
+  });
+
+  it("opens each key once", function() {
+    reg.standin.resetCallCounts();
+    reg.snapshot(HKCU, UNINSTALL);
+    assert.equal(reg.standin.callCounts().RegOpenKeyEx, 5);
+  });
+
+  it("parallel walk gives the same tree", function() {
+    for (let i = 0; i < 20; i++) {
+      for (let j = 0; j < 5; j++) {
+        reg.set(HKCU, `${UNINSTALL}\\Many\\K${i}\\S${j}`, "Value", i * 10 + j);
+      }
+    }
+    const serial = reg.snapshot(HKCU, UNINSTALL);
+    for (const threads of [0, 1, 2, 4, 8]) {
+      assert.deepEqual(reg.snapshot(HKCU, UNINSTALL, { threads }), serial);
+    }
+    assert.deepEqual(reg.snapshot(HKCU, UNINSTALL, { threads: 4, depth: 1, valueFilter: "Count" }),
+                     reg.snapshot(HKCU, UNINSTALL, { depth: 1, valueFilter: "Count" }));
+    assert.equal(reg.snapshot(HKCU, UNINSTALL + "\\Nope", { threads: 4 }), null);
+  });
+});
+
+describeStandIn("Scanner", function() {
+  const minutes = (n) => new Date(Date.UTC(2024, 0, 1, 0, n));
+
+  beforeEach(() => {
+    reg.standin.reset();
+    reg.standin.setTime(minutes(0));
+    for (const [id, name, version] of [["{A}", "App A", 1], ["{B}", "App B", 2], ["{C}", "App C", 3]]) {
+      reg.set(HKCU, `${UNINSTALL}\\${id}`, "DisplayName", name);
+      reg.set(HKCU, `${UNINSTALL}\\${id}`, "Version", version);
+    }
+    reg.set(HKCU, `${UNINSTALL}\\{A}\\Nested`, "Level", 2);
+  });
+
+  afterEach(() => {
+    reg.standin.setTime(null);
+  });
+
+  const paths = (keys) => keys.map((k) => k.path);
+
+  it("first scan adds every key", function() {
+    const delta = new reg.Scanner(HKCU, UNINSTALL).scan();
+    assert.deepEqual(paths(delta.added), ["", "{A}", "{A}\\Nested", "{B}", "{C}"]);
+    assert.deepEqual(delta.added[3].values, { DisplayName: "App B", Version: 2 });
+    assert.deepEqual(delta.changed, []);
+    assert.deepEqual(delta.removed, []);
+  });
+
+  it("reports added, removed and changed keys", function() {
+    const scanner = new reg.Scanner(HKCU, UNINSTALL);
+    scanner.scan();
+
+    reg.standin.setTime(minutes(5));
+    reg.set(HKCU, `${UNINSTALL}\\{B}`, "Version", 20);
+    reg.set(HKCU, `${UNINSTALL}\\{A}\\Nested`, "Level", 3);
+    reg.delete(HKCU, `${UNINSTALL}\\{C}`);
+    reg.set(HKCU, `${UNINSTALL}\\{D}\\Sub`, "Name", "D");
+
+    const delta = scanner.scan();
+    assert.deepEqual(paths(delta.added), ["{D}", "{D}\\Sub"]);
+    assert.deepEqual(delta.added[1].values, { Name: "D" });
+    assert.deepEqual(paths(delta.changed), ["{A}\\Nested", "{B}"]);
+    assert.deepEqual(delta.changed[1].values, { DisplayName: "App B", Version: 20 });
+    assert.deepEqual(delta.removed, ["{C}"]);
+  });
+
+  it("skips keys whose last write time did not move", function() {
+    const scanner = new reg.Scanner(HKCU, UNINSTALL);
+    scanner.scan();
+
+    reg.standin.resetCallCounts();
+    const delta = scanner.scan();
+    assert.deepEqual([delta.added, delta.changed, delta.removed], [[], [], []]);
+    // The root and {A}, which has a subkey; no value is read again
+    assert.equal(delta.keysOpened, 2);
+    assert.equal(delta.keysRead, 0);
+    assert.equal(reg.standin.callCounts().RegEnumValue, 0);
+
+    // A value rewritten with the same data moves the time but is no change
+    reg.standin.setTime(minutes(5));
+    reg.set(HKCU, `${UNINSTALL}\\{C}`, "Version", 3);
+    const same = scanner.scan();
+    assert.equal(same.keysRead, 1);
+    assert.deepEqual(same.changed, []);
+  });
+
+  it("state survives save and reload", function() {
+    const first = new reg.Scanner(HKCU, UNINSTALL, { depth: 1 });
+    first.scan();
+    const state = first.save();
+    assert.ok(Buffer.isBuffer(state));
+
+    reg.standin.setTime(minutes(5));
+    reg.set(HKCU, `${UNINSTALL}\\{A}`, "Version", 10);
+
+    const second = new reg.Scanner(HKCU, UNINSTALL, { depth: 1 }, state);
+    const delta = second.scan();
+    assert.deepEqual(paths(delta.changed), ["{A}"]);
+    assert.deepEqual([delta.added, delta.removed], [[], []]);
+    assert.deepEqual(second.save(), new reg.Scanner(HKCU, UNINSTALL, { depth: 1 }, second.save()).save());
+
+    assert.throws(() => new reg.Scanner(HKCU, UNINSTALL, {}, state.subarray(0, 10)),
+                  (e) => e.name === "RegError" && e.code === 13);
+  });
+
+  it("missing key removes everything", function() {
+    const scanner = new reg.Scanner(HKCU, UNINSTALL);
+    scanner.scan();
+    reg.delete(HKCU, UNINSTALL);
+    assert.equal(scanner.scan().removed.length, 5);
+    assert.deepEqual(scanner.scan().removed, []);
+  });
+});
+
+describeStandIn("snapshot files", function() {
+  beforeEach(() => {
+    reg.standin.reset();
+    for (let i = 0; i < 20; i++) {
+      reg.set(HKCU, `${UNINSTALL}\\{${i}}`, "DisplayName", `App ${i}`);
+      reg.set(HKCU, `${UNINSTALL}\\{${i}}\\Nested`, "Level", i);
+    }
+  });
+
+  it("same tree, same bytes", function() {
+    const saved = reg.saveSnapshot(HKCU, UNINSTALL);
+    assert.ok(Buffer.isBuffer(saved));
+    assert.deepEqual(reg.saveSnapshot(HKCU, UNINSTALL, { threads: 4 }), saved);
+    assert.equal(reg.saveSnapshot(HKCU, UNINSTALL + "\\Missing"), null);
+
+    const diff = reg.diffSnapshots(saved, saved);
+    assert.deepEqual([diff.added, diff.changed, diff.removed], [[], [], []]);
+    assert.equal(diff.keysCompared, 0);
+  });
+
+  it("diff only compares the changed subtrees", function() {
+    const before = reg.saveSnapshot(HKCU, UNINSTALL);
+    reg.set(HKCU, `${UNINSTALL}\\{3}\\Nested`, "Level", 30);
+    reg.delete(HKCU, `${UNINSTALL}\\{5}`);
+    reg.set(HKCU, `${UNINSTALL}\\{NEW}\\Sub`, "Name", "new");
+    const after = reg.saveSnapshot(HKCU, UNINSTALL);
+
+    const diff = reg.diffSnapshots(before, after);
+    assert.deepEqual(diff.added.map((k) => k.path), ["{NEW}", "{NEW}\\Sub"]);
+    assert.deepEqual(diff.added[1].values, { Name: "new" });
+    assert.deepEqual(diff.changed, [{ path: "{3}\\Nested", before: { Level: 3 }, after: { Level: 30 } }]);
+    assert.deepEqual(diff.removed, ["{5}", "{5}\\Nested"]);
+    // The root, {3} and {3}\Nested; the 18 other entries are skipped by hash
+    assert.equal(diff.keysCompared, 3);
+  });
+
+  it("diff of files", function() {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), "winreg-snapshot-"));
+    const before = path.join(dir, "before.snap");
+    const after = path.join(dir, "after.snap");
+    try {
+      fs.writeFileSync(before, reg.saveSnapshot(HKCU, UNINSTALL));
+      reg.set(HKCU, UNINSTALL, "Count", 20);
+      fs.writeFileSync(after, reg.saveSnapshot(HKCU, UNINSTALL));
+
+      const diff = reg.diffSnapshots(before, after);
+      assert.deepEqual(diff.changed, [{ path: "", before: {}, after: { Count: 20 } }]);
+      assert.deepEqual(reg.diffSnapshots(after, before).changed[0].before, { Count: 20 });
+    } finally {
+      fs.rmSync(dir, { recursive: true });
+    }
+  });
+
+  it("rejects corrupt snapshots", function() {
+    const saved = reg.saveSnapshot(HKCU, UNINSTALL);
+    const isCorrupt = (e) => e.name === "RegError" && e.code === 13;
+    assert.throws(() => reg.diffSnapshots(saved, saved.subarray(0, 20)), isCorrupt);
+    assert.throws(() => reg.diffSnapshots(saved, Buffer.from("not a snapshot")), isCorrupt);
+
+    // Deeper than any registry tree: the stand-in has no depth limit
+    reg.set(HKCU, UNINSTALL + "\\Deep" + "\\k".repeat(600), "Name", "x");
+    const deep = reg.saveSnapshot(HKCU, UNINSTALL);
+    assert.throws(() => reg.diffSnapshots(saved, deep), isCorrupt);
+    assert.throws(() => reg.diffSnapshots(deep, saved), isCorrupt);
+
+    // The root record comes last, ending with the offsets of its 20 subkeys:
+    // all of them pointing at the same record
+    const shared = Buffer.from(saved);
+    const offsets = shared.length - 20 * 8;
+    for (let i = 1; i < 20; i++) shared.copy(shared, offsets + i * 8, offsets, offsets + 8);
+    const other = reg.saveSnapshot(HKCU, UNINSTALL + "\\{0}");
+    assert.throws(() => reg.diffSnapshots(other, shared), isCorrupt);
+  });
+});
+
+describeStandIn("find", function() {
+  const FIND = "Software\\winreg-walk\\Find";
+  const VIEWS = [`${FIND}\\Microsoft\\Uninstall`, `${FIND}\\WOW6432Node\\Microsoft\\Uninstall`];
+
+  beforeEach(() => {
+    reg.standin.reset();
+    for (const view of VIEWS) {
+      for (const id of ["A", "B", "C"]) {
+        reg.set(HKCU, `${view}\\{${id}}`, "DisplayName", `App ${id}`);
+        if (id !== "B") reg.set(HKCU, `${view}\\{${id}}`, "InstallLocation", `C:\\Apps\\${id}`);
+      }
+    }
+    for (let i = 0; i < 20; i++) reg.set(HKCU, `${FIND}\\Noise\\Key${i}`, "Level", i);
+  });
+
+  it("values by name, in both views", function() {
+    const found = reg.find(HKCU, VIEWS.map((view) => view + "\\*"), { valueName: "InstallLocation" });
+    assert.deepEqual(found.map((m) => m.path),
+                     [`${VIEWS[0]}\\{A}`, `${VIEWS[0]}\\{C}`, `${VIEWS[1]}\\{A}`, `${VIEWS[1]}\\{C}`]);
+    assert.deepEqual(found[1], { path: `${VIEWS[0]}\\{C}`, name: "InstallLocation", type: REG_SZ, value: "C:\\Apps\\C" });
+
+    const anyDepth = reg.find(HKCU, `${FIND}\\**\\Uninstall\\*`, { valueName: "InstallLocation" });
+    assert.deepEqual(anyDepth, found);
+  });
+
+  it("only opens keys that can match", function() {
+    reg.standin.resetCallCounts();
+    reg.find(HKCU, VIEWS.map((view) => view + "\\*"), { valueName: "InstallLocation" });
+    const calls = reg.standin.callCounts();
+    // Literal segments are opened by name: only the Uninstall keys are enumerated
+    assert.equal(calls.RegQueryInfoKey, 2);
+    assert.equal(calls.RegOpenKeyEx, 15);
+    // A value name without wildcards is read directly
+    assert.equal(calls.RegEnumValue, 0);
+  });
+
+  it("globs, data and type filters", function() {
+    const found = reg.find(HKCU, `${FIND}\\*\\microsoft\\uninstall\\{?}`, { valueName: "*name", dataRegex: /app [ab]$/ });
+    // Segments with wildcards have the names of the keys, the others are as written
+    assert.deepEqual(found.map((m) => [m.path, m.value]), [
+      [`${FIND}\\WOW6432Node\\microsoft\\uninstall\\{A}`, "App A"],
+      [`${FIND}\\WOW6432Node\\microsoft\\uninstall\\{B}`, "App B"],
+    ]);
+
+    assert.equal(reg.find(HKCU, `${FIND}\\**`, { types: [REG_DWORD] }).length, 20);
+    assert.equal(reg.find(HKCU, `${FIND}\\**`, { types: [REG_DWORD], maxResults: 5 }).length, 5);
+    assert.deepEqual(reg.find(HKCU, `${FIND}\\Missing\\*`), []);
+    assert.throws(() => reg.find(HKCU, FIND, { dataRegex: "(" }));
+  });
+});
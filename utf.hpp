@@ -0,0 +1,584 @@
+#ifndef INCLUDE_WINREG_UTF_HPP
+#define INCLUDE_WINREG_UTF_HPP
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// UTF-8 <-> wide string transcoding in a single pass.
+//
+// "Wide" strings use 16-bit code units (UTF-16: char16_t, and wchar_t on
+// Windows) or 32-bit code units (UTF-32: char32_t, and wchar_t elsewhere).
+//
+// Utf8ToWide() and WideToUtf8() validate and convert at the same time,
+// writing into a caller-provided buffer sized with MaxWideLength() /
+// MaxUtf8Length(), so there is no size-probing pass and callers can reuse
+// their buffers. Runs of ASCII are converted 16 or 32 characters at a time
+// with SSE2/AVX2 on x86 and NEON on ARM64, with a scalar fallback elsewhere.
+//
+// Utf16ToUtf32() and Utf32ToUtf16() move wide strings between the two code
+// unit sizes, e.g. wchar_t strings outside Windows to and from UTF-16 APIs.
+//
+// Invalid input never fails the conversion: like MultiByteToWideChar and
+// WideCharToMultiByte, ill-formed sequences (invalid or truncated UTF-8,
+// lone surrogates, code points past U+10FFFF) are replaced with U+FFFD,
+// following the WHATWG "maximal subpart" rule, and reported as not valid.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint8_t, std::uint32_t
+#include <string>      // std::basic_string
+#include <type_traits> // std::make_unsigned_t
+
+// Define WINREG_UTF_SCALAR to leave out the SIMD code paths
+#if defined(WINREG_UTF_SCALAR)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define WINREG_UTF_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WINREG_UTF_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define WINREG_UTF_NEON 1
+#endif
+
+namespace winreg
+{
+namespace utf
+{
+
+// Largest number of wide code units Utf8ToWide() writes for len bytes
+constexpr std::size_t MaxWideLength(const std::size_t utf8Length) noexcept
+{
+    return utf8Length;
+}
+
+// Largest number of bytes WideToUtf8() writes for len code units
+template <typename Char>
+constexpr std::size_t MaxUtf8Length(const std::size_t wideLength) noexcept
+{
+    return wideLength * (sizeof(Char) == 2 ? 3 : 4);
+}
+
+// Convert len bytes of UTF-8 into dst, which must have room for
+// MaxWideLength(len) code units. Return the number of code units written;
+// *valid (if given) tells whether the input was well-formed.
+template <typename Char>
+std::size_t Utf8ToWide(const char *src, std::size_t len, Char *dst, bool *valid = nullptr) noexcept;
+
+// Convert len wide code units into dst, which must have room for
+// MaxUtf8Length<Char>(len) bytes. Return the number of bytes written;
+// *valid (if given) tells whether the input was well-formed.
+template <typename Char>
+std::size_t WideToUtf8(const Char *src, std::size_t len, char *dst, bool *valid = nullptr) noexcept;
+
+// Convert into out, reusing its capacity. Return whether the input was
+// well-formed.
+template <typename Char>
+bool Utf8ToWide(const char *src, std::size_t len, std::basic_string<Char> &out);
+
+template <typename Char>
+bool WideToUtf8(const Char *src, std::size_t len, std::string &out);
+
+// UTF-16 <-> UTF-32, for wide strings that are UTF-32 (wchar_t outside
+// Windows) meeting UTF-16 APIs. Lone surrogates are passed through as they
+// are, so every string round-trips unchanged. dst needs room for len code
+// units (UTF-16 to UTF-32) or 2 * len code units (UTF-32 to UTF-16).
+template <typename Char16, typename Char32>
+std::size_t Utf16ToUtf32(const Char16 *src, std::size_t len, Char32 *dst) noexcept;
+
+template <typename Char32, typename Char16>
+std::size_t Utf32ToUtf16(const Char32 *src, std::size_t len, Char16 *dst) noexcept;
+
+//------------------------------------------------------------------------------
+//                          Implementation Details
+//------------------------------------------------------------------------------
+
+namespace details
+{
+
+constexpr std::uint32_t kReplacement = 0xFFFD;
+
+template <typename Char>
+inline std::uint32_t Unit(const Char c) noexcept
+{
+    return static_cast<std::uint32_t>(static_cast<std::make_unsigned_t<Char>>(c));
+}
+
+// Widen the leading all-ASCII blocks of src into dst; return how many
+// characters were converted (a multiple of the block size)
+template <typename Char>
+inline std::size_t AsciiToWide(const std::uint8_t *src, const std::size_t len, Char *dst) noexcept
+{
+    std::size_t i = 0;
+#if defined(WINREG_UTF_AVX2)
+    for (; i + 32 <= len; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        if (_mm256_movemask_epi8(v) != 0)
+        {
+            break;
+        }
+        if constexpr (sizeof(Char) == 2)
+        {
+            auto out = reinterpret_cast<__m256i *>(dst + i);
+            _mm256_storeu_si256(out, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+            _mm256_storeu_si256(out + 1, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+        }
+        else
+        {
+            for (int part = 0; part < 4; ++part)
+            {
+                const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i + part * 8));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + part * 8), _mm256_cvtepu8_epi32(bytes));
+            }
+        }
+    }
+#elif defined(WINREG_UTF_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        if (_mm_movemask_epi8(v) != 0)
+        {
+            break;
+        }
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        auto out = reinterpret_cast<__m128i *>(dst + i);
+        if constexpr (sizeof(Char) == 2)
+        {
+            _mm_storeu_si128(out, lo);
+            _mm_storeu_si128(out + 1, hi);
+        }
+        else
+        {
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+        }
+    }
+#elif defined(WINREG_UTF_NEON)
+    for (; i + 16 <= len; i += 16)
+    {
+        const uint8x16_t v = vld1q_u8(src + i);
+        if (vmaxvq_u8(v) >= 0x80)
+        {
+            break;
+        }
+        const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        const uint16x8_t hi = vmovl_high_u8(v);
+        if constexpr (sizeof(Char) == 2)
+        {
+            auto out = reinterpret_cast<std::uint16_t *>(dst + i);
+            vst1q_u16(out, lo);
+            vst1q_u16(out + 8, hi);
+        }
+        else
+        {
+            auto out = reinterpret_cast<std::uint32_t *>(dst + i);
+            vst1q_u32(out, vmovl_u16(vget_low_u16(lo)));
+            vst1q_u32(out + 4, vmovl_high_u16(lo));
+            vst1q_u32(out + 8, vmovl_u16(vget_low_u16(hi)));
+            vst1q_u32(out + 12, vmovl_high_u16(hi));
+        }
+    }
+#else
+    // 8 bytes at a time
+    for (; i + 8 <= len; i += 8)
+    {
+        std::uint64_t word = 0;
+        for (int k = 0; k < 8; ++k)
+        {
+            word |= static_cast<std::uint64_t>(src[i + k]) << (k * 8);
+        }
+        if ((word & 0x8080808080808080ULL) != 0)
+        {
+            break;
+        }
+        for (int k = 0; k < 8; ++k)
+        {
+            dst[i + k] = static_cast<Char>(src[i + k]);
+        }
+    }
+#endif
+    return i;
+}
+
+// Narrow the leading all-ASCII blocks of src into dst; return how many
+// characters were converted (a multiple of the block size)
+template <typename Char>
+inline std::size_t WideToAscii(const Char *src, const std::size_t len, std::uint8_t *dst) noexcept
+{
+    std::size_t i = 0;
+#if defined(WINREG_UTF_AVX2)
+    for (; i + 32 <= len; i += 32)
+    {
+        auto in = reinterpret_cast<const __m256i *>(src + i);
+        __m256i packed;
+        if constexpr (sizeof(Char) == 2)
+        {
+            const __m256i a = _mm256_loadu_si256(in);
+            const __m256i b = _mm256_loadu_si256(in + 1);
+            const __m256i high = _mm256_and_si256(_mm256_or_si256(a, b), _mm256_set1_epi16(static_cast<short>(0xFF80)));
+            if (!_mm256_testz_si256(high, high))
+            {
+                break;
+            }
+            packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+        }
+        else
+        {
+            const __m256i a = _mm256_loadu_si256(in);
+            const __m256i b = _mm256_loadu_si256(in + 1);
+            const __m256i c = _mm256_loadu_si256(in + 2);
+            const __m256i d = _mm256_loadu_si256(in + 3);
+            const __m256i all = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+            const __m256i high = _mm256_and_si256(all, _mm256_set1_epi32(static_cast<int>(0xFFFFFF80)));
+            if (!_mm256_testz_si256(high, high))
+            {
+                break;
+            }
+            const __m256i ab = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+            const __m256i cd = _mm256_permute4x64_epi64(_mm256_packs_epi32(c, d), 0xD8);
+            packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(ab, cd), 0xD8);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+    }
+#elif defined(WINREG_UTF_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16)
+    {
+        auto in = reinterpret_cast<const __m128i *>(src + i);
+        __m128i packed;
+        if constexpr (sizeof(Char) == 2)
+        {
+            const __m128i a = _mm_loadu_si128(in);
+            const __m128i b = _mm_loadu_si128(in + 1);
+            const __m128i high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xFF80)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF)
+            {
+                break;
+            }
+            packed = _mm_packus_epi16(a, b);
+        }
+        else
+        {
+            const __m128i a = _mm_loadu_si128(in);
+            const __m128i b = _mm_loadu_si128(in + 1);
+            const __m128i c = _mm_loadu_si128(in + 2);
+            const __m128i d = _mm_loadu_si128(in + 3);
+            const __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+            const __m128i high = _mm_and_si128(all, _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, zero)) != 0xFFFF)
+            {
+                break;
+            }
+            packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+    }
+#elif defined(WINREG_UTF_NEON)
+    for (; i + 16 <= len; i += 16)
+    {
+        uint8x16_t packed;
+        if constexpr (sizeof(Char) == 2)
+        {
+            auto in = reinterpret_cast<const std::uint16_t *>(src + i);
+            const uint16x8_t a = vld1q_u16(in);
+            const uint16x8_t b = vld1q_u16(in + 8);
+            if (vmaxvq_u16(vorrq_u16(a, b)) >= 0x80)
+            {
+                break;
+            }
+            packed = vcombine_u8(vmovn_u16(a), vmovn_u16(b));
+        }
+        else
+        {
+            auto in = reinterpret_cast<const std::uint32_t *>(src + i);
+            const uint32x4_t a = vld1q_u32(in);
+            const uint32x4_t b = vld1q_u32(in + 4);
+            const uint32x4_t c = vld1q_u32(in + 8);
+            const uint32x4_t d = vld1q_u32(in + 12);
+            if (vmaxvq_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d))) >= 0x80)
+            {
+                break;
+            }
+            const uint16x8_t ab = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+            const uint16x8_t cd = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+            packed = vcombine_u8(vmovn_u16(ab), vmovn_u16(cd));
+        }
+        vst1q_u8(dst + i, packed);
+    }
+#else
+    for (; i + 8 <= len; i += 8)
+    {
+        std::uint32_t all = 0;
+        for (int k = 0; k < 8; ++k)
+        {
+            all |= Unit(src[i + k]);
+        }
+        if (all >= 0x80)
+        {
+            break;
+        }
+        for (int k = 0; k < 8; ++k)
+        {
+            dst[i + k] = static_cast<std::uint8_t>(src[i + k]);
+        }
+    }
+#endif
+    return i;
+}
+
+// Decode one code point starting at src[i] (not ASCII), advancing i past
+// the maximal subpart of an ill-formed sequence; return kReplacement and
+// clear valid for ill-formed input
+inline std::uint32_t DecodeUtf8(const std::uint8_t *src, const std::size_t len, std::size_t &i,
+                                bool &valid) noexcept
+{
+    const std::uint8_t lead = src[i++];
+    std::uint32_t cp;
+    int need;
+    std::uint8_t lower = 0x80;
+    std::uint8_t upper = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF)
+    {
+        cp = lead & 0x1F;
+        need = 1;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        cp = lead & 0x0F;
+        need = 2;
+        if (lead == 0xE0)
+        {
+            lower = 0xA0; // overlong
+        }
+        else if (lead == 0xED)
+        {
+            upper = 0x9F; // surrogates
+        }
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        cp = lead & 0x07;
+        need = 3;
+        if (lead == 0xF0)
+        {
+            lower = 0x90; // overlong
+        }
+        else if (lead == 0xF4)
+        {
+            upper = 0x8F; // past U+10FFFF
+        }
+    }
+    else
+    {
+        valid = false;
+        return kReplacement;
+    }
+
+    for (; need > 0; --need)
+    {
+        if (i == len || src[i] < lower || src[i] > upper)
+        {
+            valid = false;
+            return kReplacement;
+        }
+        cp = (cp << 6) | (src[i++] & 0x3F);
+        lower = 0x80;
+        upper = 0xBF;
+    }
+    return cp;
+}
+
+inline char *EncodeUtf8(const std::uint32_t cp, char *out) noexcept
+{
+    if (cp < 0x80)
+    {
+        *out++ = static_cast<char>(cp);
+    }
+    else if (cp < 0x800)
+    {
+        *out++ = static_cast<char>(0xC0 | (cp >> 6));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        *out++ = static_cast<char>(0xE0 | (cp >> 12));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        *out++ = static_cast<char>(0xF0 | (cp >> 18));
+        *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+} // namespace details
+
+//------------------------------------------------------------------------------
+//                          Inline Function Definitions
+//------------------------------------------------------------------------------
+
+template <typename Char>
+inline std::size_t Utf8ToWide(const char *src, const std::size_t len, Char *dst, bool *valid) noexcept
+{
+    static_assert(sizeof(Char) == 2 || sizeof(Char) == 4, "UTF-16 or UTF-32 code units expected");
+
+    auto in = reinterpret_cast<const std::uint8_t *>(src);
+    bool ok = true;
+    std::size_t i = 0;
+    Char *out = dst;
+    while (i < len)
+    {
+        const std::size_t ascii = details::AsciiToWide(in + i, len - i, out);
+        i += ascii;
+        out += ascii;
+
+        // The rest of the block, up to the next non-ASCII code point
+        for (; i < len && in[i] < 0x80; ++i)
+        {
+            *out++ = static_cast<Char>(in[i]);
+        }
+        if (i == len)
+        {
+            break;
+        }
+
+        const std::uint32_t cp = details::DecodeUtf8(in, len, i, ok);
+        if (sizeof(Char) == 2 && cp >= 0x10000)
+        {
+            *out++ = static_cast<Char>(0xD800 + ((cp - 0x10000) >> 10));
+            *out++ = static_cast<Char>(0xDC00 + (cp & 0x3FF));
+        }
+        else
+        {
+            *out++ = static_cast<Char>(cp);
+        }
+    }
+
+    if (valid)
+    {
+        *valid = ok;
+    }
+    return static_cast<std::size_t>(out - dst);
+}
+
+template <typename Char>
+inline std::size_t WideToUtf8(const Char *src, const std::size_t len, char *dst, bool *valid) noexcept
+{
+    static_assert(sizeof(Char) == 2 || sizeof(Char) == 4, "UTF-16 or UTF-32 code units expected");
+
+    bool ok = true;
+    std::size_t i = 0;
+    char *out = dst;
+    while (i < len)
+    {
+        const std::size_t ascii = details::WideToAscii(src + i, len - i, reinterpret_cast<std::uint8_t *>(out));
+        i += ascii;
+        out += ascii;
+
+        for (; i < len && details::Unit(src[i]) < 0x80; ++i)
+        {
+            *out++ = static_cast<char>(src[i]);
+        }
+        if (i == len)
+        {
+            break;
+        }
+
+        std::uint32_t cp = details::Unit(src[i++]);
+        if (sizeof(Char) == 2 && cp >= 0xD800 && cp <= 0xDBFF && i < len &&
+            details::Unit(src[i]) >= 0xDC00 && details::Unit(src[i]) <= 0xDFFF)
+        {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (details::Unit(src[i++]) - 0xDC00);
+        }
+        else if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+        {
+            ok = false;
+            cp = details::kReplacement;
+        }
+        out = details::EncodeUtf8(cp, out);
+    }
+
+    if (valid)
+    {
+        *valid = ok;
+    }
+    return static_cast<std::size_t>(out - dst);
+}
+
+template <typename Char16, typename Char32>
+inline std::size_t Utf16ToUtf32(const Char16 *src, const std::size_t len, Char32 *dst) noexcept
+{
+    static_assert(sizeof(Char16) == 2 && sizeof(Char32) == 4, "UTF-16 to UTF-32 code units expected");
+
+    Char32 *out = dst;
+    for (std::size_t i = 0; i < len; ++i)
+    {
+        std::uint32_t unit = details::Unit(src[i]);
+        if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < len && details::Unit(src[i + 1]) >= 0xDC00 &&
+            details::Unit(src[i + 1]) <= 0xDFFF)
+        {
+            unit = 0x10000 + ((unit - 0xD800) << 10) + (details::Unit(src[++i]) - 0xDC00);
+        }
+        *out++ = static_cast<Char32>(unit);
+    }
+    return static_cast<std::size_t>(out - dst);
+}
+
+template <typename Char32, typename Char16>
+inline std::size_t Utf32ToUtf16(const Char32 *src, const std::size_t len, Char16 *dst) noexcept
+{
+    static_assert(sizeof(Char32) == 4 && sizeof(Char16) == 2, "UTF-32 to UTF-16 code units expected");
+
+    Char16 *out = dst;
+    for (std::size_t i = 0; i < len; ++i)
+    {
+        const std::uint32_t cp = details::Unit(src[i]);
+        if (cp < 0x10000)
+        {
+            *out++ = static_cast<Char16>(cp);
+        }
+        else if (cp <= 0x10FFFF)
+        {
+            *out++ = static_cast<Char16>(0xD800 + ((cp - 0x10000) >> 10));
+            *out++ = static_cast<Char16>(0xDC00 + (cp & 0x3FF));
+        }
+        else
+        {
+            *out++ = static_cast<Char16>(details::kReplacement);
+        }
+    }
+    return static_cast<std::size_t>(out - dst);
+}
+
+template <typename Char>
+inline bool Utf8ToWide(const char *src, const std::size_t len, std::basic_string<Char> &out)
+{
+    bool valid = true;
+    out.resize(MaxWideLength(len));
+    out.resize(Utf8ToWide(src, len, &out[0], &valid));
+    return valid;
+}
+
+template <typename Char>
+inline bool WideToUtf8(const Char *src, const std::size_t len, std::string &out)
+{
+    bool valid = true;
+    out.resize(MaxUtf8Length<Char>(len));
+    out.resize(WideToUtf8(src, len, &out[0], &valid));
+    return valid;
+}
+
+} // namespace utf
+} // namespace winreg
+
+#endif // INCLUDE_WINREG_UTF_HPP
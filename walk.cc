@@ -0,0 +1,449 @@
+#include <napi.h>
+
+#include "addon.hpp"
+#include "regfind.hpp"
+#include "regscan.hpp"
+#include "regsnap.hpp"
+#include "regwalk.hpp"
+
+#include <algorithm>
+
+// {name: value} object of a key's values
+static Napi::Object ValuesToJs(Napi::Env env,
+                               const std::vector<winreg::RegValue>& values) {
+  auto obj = Napi::Object::New(env);
+  for (const auto& value : values) {
+    obj.Set(WideToJs(env, value.name), ValueDataToJs(env, value.data));
+  }
+  return obj;
+}
+
+// {values: {...}, keys: {name: {values, keys}, ...}}
+static Napi::Object SnapshotToJs(Napi::Env env,
+                                 const winreg::KeySnapshot& snapshot) {
+  auto keys = Napi::Object::New(env);
+  for (const auto& subKey : snapshot.subKeys) {
+    keys.Set(WideToJs(env, subKey.name), SnapshotToJs(env, subKey));
+  }
+
+  auto obj = Napi::Object::New(env);
+  obj.Set("values", ValuesToJs(env, snapshot.values));
+  obj.Set("keys", keys);
+  return obj;
+}
+
+// {depth, valueFilter, types, access, threads}
+// With threads, the walk uses a pool of that many worker threads (0: one
+// per CPU); without it, it runs on the calling thread.
+static bool ParseWalkOptions(Napi::Env env, Napi::Value value,
+                             winreg::WalkOptions& options, int& threads) {
+  if (value.IsUndefined() || value.IsNull()) {
+    return true;
+  }
+  if (!value.IsObject()) {
+    Napi::Error::New(env, "options must be an object")
+        .ThrowAsJavaScriptException();
+    return false;
+  }
+
+  auto obj = value.As<Napi::Object>();
+  auto depth = obj.Get("depth");
+  if (depth.IsNumber()) {
+    options.depth = depth.As<Napi::Number>().Int32Value();
+  }
+
+  // A value name or an array of names
+  auto filter = obj.Get("valueFilter");
+  if (filter.IsString()) {
+    options.valueNames.push_back(JsToWide(filter));
+  } else if (filter.IsArray()) {
+    auto names = filter.As<Napi::Array>();
+    for (uint32_t i = 0; i < names.Length(); ++i) {
+      options.valueNames.push_back(
+          JsToWide(names.Get(i)));
+    }
+  }
+
+  // An array of REG_xxx types
+  auto types = obj.Get("types");
+  if (types.IsArray()) {
+    auto arr = types.As<Napi::Array>();
+    for (uint32_t i = 0; i < arr.Length(); ++i) {
+      uint32_t type = arr.Get(i).As<Napi::Number>().Uint32Value();
+      if (type < 32) {
+        options.typeMask |= 1u << type;
+      }
+    }
+    // Only unknown types: select nothing
+    if (options.typeMask == 0 && arr.Length() > 0) {
+      options.typeMask = 1u << 31;
+    }
+  }
+
+  auto access = obj.Get("access");
+  if (access.IsNumber()) {
+    options.access = KEY_READ | access.As<Napi::Number>().Uint32Value();
+  }
+
+  auto threadCount = obj.Get("threads");
+  if (threadCount.IsNumber()) {
+    threads = std::max(0, threadCount.As<Napi::Number>().Int32Value());
+  }
+  return true;
+}
+
+// hkey, path, options?
+// The whole subtree is read natively, then converted to JS in one go;
+// null if the key doesn't exist.
+Napi::Value RegSnapshot(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsString()) {
+    Napi::Error::New(env, "snapshot - invalid arguments (hkey, path, options?)")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
+  std::wstring p = JsToWide(info[1]);
+  toWindowSlashStyle(p);
+  winreg::WalkOptions options;
+  int threads = -1;
+  if (!ParseWalkOptions(env, info[2], options, threads)) {
+    return env.Undefined();
+  }
+
+  try {
+    auto snapshot =
+        threads < 0
+            ? winreg::Snapshot(hkey, p, options)
+            : winreg::ParallelSnapshot(hkey, p, options, threads);
+    return SnapshotToJs(env, snapshot);
+  } catch (const winreg::RegException& e) {
+    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND) {
+      return env.Null();
+    }
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// {valueName, dataRegex, types, maxResults, access}
+static bool ParseFindOptions(Napi::Env env, Napi::Value value,
+                             winreg::FindOptions& options) {
+  if (value.IsUndefined() || value.IsNull()) {
+    return true;
+  }
+  if (!value.IsObject()) {
+    Napi::Error::New(env, "options must be an object")
+        .ThrowAsJavaScriptException();
+    return false;
+  }
+
+  auto obj = value.As<Napi::Object>();
+  auto valueName = obj.Get("valueName");
+  if (valueName.IsString()) {
+    options.valueName = JsToWide(valueName);
+  }
+
+  // A string or a RegExp, whose source is used; always case-insensitive
+  auto dataRegex = obj.Get("dataRegex");
+  if (dataRegex.IsString()) {
+    options.dataRegex = JsToWide(dataRegex);
+  } else if (dataRegex.IsObject() &&
+             dataRegex.As<Napi::Object>().Get("source").IsString()) {
+    options.dataRegex = JsToWide(dataRegex.As<Napi::Object>().Get("source"));
+  }
+
+  auto types = obj.Get("types");
+  if (types.IsArray()) {
+    auto arr = types.As<Napi::Array>();
+    for (uint32_t i = 0; i < arr.Length(); ++i) {
+      uint32_t type = arr.Get(i).As<Napi::Number>().Uint32Value();
+      if (type < 32) {
+        options.typeMask |= 1u << type;
+      }
+    }
+    // Only unknown types: find nothing
+    if (options.typeMask == 0 && arr.Length() > 0) {
+      options.typeMask = 1u << 31;
+    }
+  }
+
+  auto maxResults = obj.Get("maxResults");
+  if (maxResults.IsNumber()) {
+    options.maxResults = (size_t)std::max<int64_t>(
+        0, maxResults.As<Napi::Number>().Int64Value());
+  }
+
+  auto access = obj.Get("access");
+  if (access.IsNumber()) {
+    options.access = KEY_READ | access.As<Napi::Number>().Uint32Value();
+  }
+  return true;
+}
+
+// hkey, pattern (or an array of patterns), options?
+// [{path, name, type, value}] of the values found; patterns are compiled once
+// and matched during a native walk that skips subtrees that can't match.
+Napi::Value RegFind(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 2 || !info[0].IsNumber() ||
+      !(info[1].IsString() || info[1].IsArray())) {
+    Napi::Error::New(env, "find - invalid arguments (hkey, pattern, options?)")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
+  std::vector<std::wstring> patterns;
+  if (info[1].IsString()) {
+    patterns.push_back(JsToWide(info[1]));
+  } else {
+    auto arr = info[1].As<Napi::Array>();
+    for (uint32_t i = 0; i < arr.Length(); ++i) {
+      patterns.push_back(JsToWide(arr.Get(i)));
+    }
+  }
+  for (auto& pattern : patterns) {
+    toWindowSlashStyle(pattern);
+  }
+  winreg::FindOptions options;
+  if (!ParseFindOptions(env, info[2], options)) {
+    return env.Undefined();
+  }
+
+  try {
+    auto matches = winreg::Find(hkey, patterns, options);
+    auto arr = Napi::Array::New(env, matches.size());
+    for (size_t i = 0; i < matches.size(); ++i) {
+      auto obj = Napi::Object::New(env);
+      obj.Set("path", WideToJs(env, matches[i].path));
+      obj.Set("name", WideToJs(env, matches[i].value.name));
+      obj.Set("type", Napi::Number::New(env, matches[i].value.type));
+      obj.Set("value", ValueDataToJs(env, matches[i].value.data));
+      arr.Set(i, obj);
+    }
+    return arr;
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// hkey, path, options?
+// The subtree as a snapshot file with Merkle hashes, in a Buffer to write
+// to disk or pass to diffSnapshots(); null if the key doesn't exist.
+Napi::Value RegSaveSnapshot(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsString()) {
+    Napi::Error::New(env, "saveSnapshot - invalid arguments (hkey, path, options?)")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
+  std::wstring p = JsToWide(info[1]);
+  toWindowSlashStyle(p);
+  winreg::WalkOptions options;
+  int threads = -1;
+  if (!ParseWalkOptions(env, info[2], options, threads)) {
+    return env.Undefined();
+  }
+
+  try {
+    auto bytes = winreg::SaveSnapshot(
+        threads < 0 ? winreg::Snapshot(hkey, p, options)
+                    : winreg::ParallelSnapshot(hkey, p, options, threads));
+    return Napi::Buffer<uint8_t>::Copy(env, bytes.data(), bytes.size());
+  } catch (const winreg::RegException& e) {
+    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND) {
+      return env.Null();
+    }
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// A snapshot given as a file name (mapped) or a Buffer (read in place)
+static winreg::SnapshotFile OpenSnapshot(Napi::Value value) {
+  if (value.IsBuffer()) {
+    auto buffer = value.As<Napi::Buffer<uint8_t>>();
+    return winreg::SnapshotFile::FromMemory(buffer.Data(), buffer.Length());
+  }
+  std::string file = value.As<Napi::String>();
+  return winreg::SnapshotFile::Open(std::filesystem::u8path(file));
+}
+
+// before, after: file names or Buffers from saveSnapshot()
+// {added: [{path, values}], changed: [{path, before, after}], removed: [path],
+//  keysCompared}; subtrees with the same hash in both are not read.
+Napi::Value RegDiffSnapshots(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 2 || !(info[0].IsString() || info[0].IsBuffer()) ||
+      !(info[1].IsString() || info[1].IsBuffer())) {
+    Napi::Error::New(env, "diffSnapshots - invalid arguments (before, after)")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  try {
+    auto before = OpenSnapshot(info[0]);
+    auto after = OpenSnapshot(info[1]);
+    auto diff = winreg::DiffSnapshots(before, after);
+
+    auto added = Napi::Array::New(env, diff.added.size());
+    for (size_t i = 0; i < diff.added.size(); ++i) {
+      auto obj = Napi::Object::New(env);
+      obj.Set("path", WideToJs(env, diff.added[i].path));
+      obj.Set("values", ValuesToJs(env, diff.added[i].values));
+      added.Set(i, obj);
+    }
+
+    auto changed = Napi::Array::New(env, diff.changed.size());
+    for (size_t i = 0; i < diff.changed.size(); ++i) {
+      auto obj = Napi::Object::New(env);
+      obj.Set("path", WideToJs(env, diff.changed[i].path));
+      obj.Set("before", ValuesToJs(env, diff.changed[i].before));
+      obj.Set("after", ValuesToJs(env, diff.changed[i].after));
+      changed.Set(i, obj);
+    }
+
+    auto removed = Napi::Array::New(env, diff.removed.size());
+    for (size_t i = 0; i < diff.removed.size(); ++i) {
+      removed.Set(i, WideToJs(env, diff.removed[i]));
+    }
+
+    auto obj = Napi::Object::New(env);
+    obj.Set("added", added);
+    obj.Set("changed", changed);
+    obj.Set("removed", removed);
+    obj.Set("keysCompared", Napi::Number::New(env, (double)diff.keysCompared));
+    return obj;
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// [{path, values}, ...] of scan results
+static Napi::Array ScanKeysToJs(Napi::Env env,
+                                const std::vector<winreg::ScanDelta::Key>& keys) {
+  auto arr = Napi::Array::New(env, keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto obj = Napi::Object::New(env);
+    obj.Set("path", WideToJs(env, keys[i].path));
+    obj.Set("values", ValuesToJs(env, keys[i].values));
+    arr.Set(i, obj);
+  }
+  return arr;
+}
+
+// JavaScript wrapper of winreg::IncrementalScan(): a subtree with the state
+// of its previous scan.
+class Scanner : public Napi::ObjectWrap<Scanner> {
+ public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+  // hkey, path, options?, state? (a Buffer from save())
+  Scanner(const Napi::CallbackInfo& info);
+
+  Napi::Value Scan(const Napi::CallbackInfo& info);
+  Napi::Value Save(const Napi::CallbackInfo& info);
+
+ private:
+  HKEY _hkey = nullptr;
+  std::wstring _path;
+  winreg::WalkOptions _options;
+  winreg::ScanState _state;
+};
+
+Napi::Object Scanner::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func =
+      DefineClass(env, "Scanner",
+                  {InstanceMethod("scan", &Scanner::Scan),
+                   InstanceMethod("save", &Scanner::Save)});
+  exports.Set("Scanner", func);
+  return exports;
+}
+
+Scanner::Scanner(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<Scanner>(info) {
+  auto env = info.Env();
+  if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsString()) {
+    Napi::Error::New(env, "Scanner - invalid arguments (hkey, path, options?, state?)")
+        .ThrowAsJavaScriptException();
+    return;
+  }
+
+  _hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
+  _path = JsToWide(info[1]);
+  toWindowSlashStyle(_path);
+  int threads = -1;
+  if (!ParseWalkOptions(env, info[2], _options, threads)) {
+    return;
+  }
+
+  if (info.Length() > 3 && info[3].IsBuffer()) {
+    auto state = info[3].As<Napi::Buffer<uint8_t>>();
+    try {
+      _state = winreg::LoadScanState(state.Data(), state.Length());
+    } catch (const winreg::RegException& e) {
+      ThrowRegError(e);
+    }
+  }
+}
+
+// {added: [{path, values}], changed: [{path, values}], removed: [path],
+//  keysOpened, keysRead} since the previous scan
+Napi::Value Scanner::Scan(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    auto delta = winreg::IncrementalScan(_hkey, _path, _options, _state);
+
+    auto removed = Napi::Array::New(env, delta.removed.size());
+    for (size_t i = 0; i < delta.removed.size(); ++i) {
+      removed.Set(i, WideToJs(env, delta.removed[i]));
+    }
+
+    auto obj = Napi::Object::New(env);
+    obj.Set("added", ScanKeysToJs(env, delta.added));
+    obj.Set("changed", ScanKeysToJs(env, delta.changed));
+    obj.Set("removed", removed);
+    obj.Set("keysOpened", Napi::Number::New(env, (double)delta.keysOpened));
+    obj.Set("keysRead", Napi::Number::New(env, (double)delta.keysRead));
+    return obj;
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// The state of the last scan, as a Buffer to pass to new Scanner()
+Napi::Value Scanner::Save(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  auto bytes = winreg::SaveScanState(_state);
+  return Napi::Buffer<uint8_t>::Copy(env, bytes.data(), bytes.size());
+}
+
+Napi::Object InitWalk(Napi::Env env, Napi::Object exports) {
+  exports.Set("snapshot", Napi::Function::New(env, RegSnapshot));
+  exports.Set("saveSnapshot", Napi::Function::New(env, RegSaveSnapshot));
+  exports.Set("diffSnapshots", Napi::Function::New(env, RegDiffSnapshots));
+  exports.Set("find", Napi::Function::New(env, RegFind));
+  return Scanner::Init(env, exports);
+}
@@ -1,18 +1,21 @@
 #include <napi.h>
 #include <uv.h>
 
-#include "winreg.hpp"
+#include "addon.hpp"
 
-#include <codecvt>
-#include <locale>
 #include <algorithm>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
 
-std::wstring Utf8ToUtf16(const std::string& str);
-std::string Utf16ToUtf8(const std::wstring &wstr);
-
-#define ThrowRegError(e) MakeRegError(env, e).ThrowAsJavaScriptException()
+// Outside Windows, winreg.hpp runs against the in-memory stand-in registry
+// (memreg.hpp), which the tests drive through reg.standin.
+#include "winreg.hpp"
+#include "keycache.hpp"
+#include "utf.hpp"
 
-Napi::Error MakeRegError(Napi::Env env, const winreg::RegException& e);
+struct RegResult;
 
 class RegKey : public Napi::ObjectWrap<RegKey> {
  public:
@@ -28,16 +31,27 @@ class RegKey : public Napi::ObjectWrap<RegKey> {
   Napi::Value Close(const Napi::CallbackInfo& info);
   Napi::Value GetHandle(const Napi::CallbackInfo& info);
   Napi::Value GetValueType(const Napi::CallbackInfo& info);
+  Napi::Value GetValue(const Napi::CallbackInfo& info);
   Napi::Value GetString(const Napi::CallbackInfo& info);
   Napi::Value GetExpandString(const Napi::CallbackInfo& info);
   Napi::Value GetMultiString(const Napi::CallbackInfo& info);
   Napi::Value GetDword(const Napi::CallbackInfo& info);
+  Napi::Value GetQword(const Napi::CallbackInfo& info);
+  Napi::Value GetBinary(const Napi::CallbackInfo& info);
   Napi::Value SetString(const Napi::CallbackInfo& info);
   Napi::Value SetExpandString(const Napi::CallbackInfo& info);
+  Napi::Value SetMultiString(const Napi::CallbackInfo& info);
   Napi::Value SetDword(const Napi::CallbackInfo& info);
+  Napi::Value SetQword(const Napi::CallbackInfo& info);
+  Napi::Value SetBinary(const Napi::CallbackInfo& info);
   Napi::Value DeleteValue(const Napi::CallbackInfo& info);
   Napi::Value DeleteKey(const Napi::CallbackInfo& info);
   Napi::Value EnumSubKeys(const Napi::CallbackInfo& info);
+  Napi::Value EnumSubKeysAsync(const Napi::CallbackInfo& info);
+  Napi::Value QueryValueAsync(const Napi::CallbackInfo& info);
+  Napi::Value SetValueAsync(const Napi::CallbackInfo& info);
+  Napi::Value DeleteValueAsync(const Napi::CallbackInfo& info);
+  Napi::Value EnumSubKeysDetailed(const Napi::CallbackInfo& info);
   Napi::Value EnumValues(const Napi::CallbackInfo& info);
   Napi::Value IsValid(const Napi::CallbackInfo& info);
 
@@ -46,6 +60,15 @@ class RegKey : public Napi::ObjectWrap<RegKey> {
   }
  private:
   winreg::RegKey _key;
+
+  // Operations running on the thread pool with the handle of _key, and the
+  // handles closed or replaced meanwhile, which they may still be using
+  int _pending = 0;
+  std::vector<winreg::RegKey> _retired;
+
+  Napi::Value RunOnHandle(
+      Napi::Env env, std::function<winreg::RegResult(winreg::RegKey&, RegResult&)> fn);
+  void RetireHandle();
   Napi::Value createKey(const Napi::CallbackInfo& info);
   Napi::Value openKey(const Napi::CallbackInfo& info);
 };
@@ -58,38 +81,47 @@ Napi::Object RegKey::Init(Napi::Env env, Napi::Object exports) {
                    InstanceMethod("create", &RegKey::Create),
                    InstanceMethod("close", &RegKey::Close),
                    InstanceMethod("getValueType", &RegKey::GetValueType),
+                   InstanceMethod("get", &RegKey::GetValue),
                    InstanceMethod("getString", &RegKey::GetString),
                    InstanceMethod("handle", &RegKey::GetHandle),
                    InstanceMethod("getExpandString", &RegKey::GetExpandString),
                    InstanceMethod("getMultiString", &RegKey::GetMultiString),
                    InstanceMethod("getDword", &RegKey::GetDword),
+                   InstanceMethod("getQword", &RegKey::GetQword),
+                   InstanceMethod("getBinary", &RegKey::GetBinary),
                    InstanceMethod("setString", &RegKey::SetString),
                    InstanceMethod("setDword", &RegKey::SetDword),
+                   InstanceMethod("setQword", &RegKey::SetQword),
+                   InstanceMethod("setBinary", &RegKey::SetBinary),
                    InstanceMethod("setExpandString", &RegKey::SetExpandString),
+                   InstanceMethod("setMultiString", &RegKey::SetMultiString),
                    InstanceMethod("deleteValue", &RegKey::DeleteValue),
                    InstanceMethod("deleteKey", &RegKey::DeleteKey),
                    InstanceMethod("enumSubKeys", &RegKey::EnumSubKeys),
+                   InstanceMethod("enumSubKeysAsync", &RegKey::EnumSubKeysAsync),
+                   InstanceMethod("queryValueAsync", &RegKey::QueryValueAsync),
+                   InstanceMethod("setValueAsync", &RegKey::SetValueAsync),
+                   InstanceMethod("deleteValueAsync", &RegKey::DeleteValueAsync),
+                   InstanceMethod("enumSubKeysDetailed", &RegKey::EnumSubKeysDetailed),
                    InstanceMethod("enumValues", &RegKey::EnumValues),
                    InstanceAccessor("isValid", &RegKey::IsValid, nullptr)});
 
-  Napi::FunctionReference* constructor = new Napi::FunctionReference();
-  *constructor = Napi::Persistent(func);
-  env.SetInstanceData(constructor);
+  GetAddonData(env)->regKey = Napi::Persistent(func);
 
   exports.Set("RegKey", func);
   return exports;
 }
 
-void toWindowSlashStyle(std::string& path) {
-  std::transform(path.cbegin(), path.cend(), path.begin(), [](char c) {
-    return c == '/' ? '\\' : c;
+void toWindowSlashStyle(std::wstring& path) {
+  std::transform(path.cbegin(), path.cend(), path.begin(), [](wchar_t c) {
+    return c == L'/' ? L'\\' : c;
   });
 }
 
 Napi::Value RegKey::CreateKey(const Napi::CallbackInfo& info) {
   auto env = info.Env();
   Napi::EscapableHandleScope scope(env);
-  Napi::Object obj = env.GetInstanceData<Napi::FunctionReference>()->New({});
+  Napi::Object obj = GetAddonData(env)->regKey.New({});
   auto pRegKey = Unwrap(obj);
   if (info.Length() > 0) {
     try {
@@ -108,7 +140,7 @@ Napi::Value RegKey::CreateKey(const Napi::CallbackInfo& info) {
 Napi::Value RegKey::OpenKey(const Napi::CallbackInfo& info) {
   auto env = info.Env();
   Napi::EscapableHandleScope scope(env);
-  Napi::Object obj = env.GetInstanceData<Napi::FunctionReference>()->New({});
+  Napi::Object obj = GetAddonData(env)->regKey.New({});
   auto pRegKey = Unwrap(obj);
   if (info.Length() > 0) {
     pRegKey->openKey(info);
@@ -116,129 +148,477 @@ Napi::Value RegKey::OpenKey(const Napi::CallbackInfo& info) {
   return scope.Escape(napi_value(obj)).ToObject();
 }
 
+// Arguments of queryValue/set/delete, parsed on the main thread so the
+// registry calls can also run on the thread pool (the *Async variants).
+struct RegRequest {
+  HKEY hkey = nullptr;
+  std::wstring path;
+  std::wstring valueName;
+  bool hasValueName = false;
+  DWORD options = 0;
+
+  // Value to set: REG_SZ, REG_DWORD, or REG_NONE to only create the key
+  DWORD type = REG_NONE;
+  std::wstring str;
+  DWORD dword = 0;
+};
+
+// [name, ...] of a NameList
+static Napi::Array NamesToJs(Napi::Env env, const winreg::NameList& names) {
+  auto arr = Napi::Array::New(env, names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    auto name = names[i].name;
+    arr.Set(i, WideToJs(env, name.data(), name.size()));
+  }
+  return arr;
+}
+
+// Outcome of a registry operation, converted to JS on the main thread
+struct RegResult {
+  enum class Kind { Null, True, Value, Names };
+  Kind kind = Kind::Null;
+  winreg::RegValueData value;
+  winreg::NameList names;
+
+  Napi::Value ToJs(Napi::Env env) const {
+    switch (kind) {
+      case Kind::True:
+        return Napi::Boolean::New(env, true);
+      case Kind::Value:
+        return ValueDataToJs(env, value);
+      case Kind::Names:
+        return NamesToJs(env, names);
+      default:
+        return env.Null();
+    }
+  }
+};
+
 // hkey, path, value, options
-Napi::Value RegQuery(const Napi::CallbackInfo& info) {
+static bool ParseQuery(const Napi::CallbackInfo& info, RegRequest& req) {
   if (info.Length() < 3) {
     Napi::Error::New(
         info.Env(), Napi::String::New(info.Env(), "invalid arguments (hkey, path, value, options?)"))
         .ThrowAsJavaScriptException();
-    return info.Env().Undefined();
+    return false;
   }
 
-  auto env = info.Env();
-  HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
-  std::string p = info[1].As<Napi::String>();
-  std::string v = info[2].As<Napi::String>();
-  DWORD options = 0;
+  req.hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
+  JsToWide(info[1], req.path);
+  JsToWide(info[2], req.valueName);
   if (info.Length() > 3) {
-    options = (DWORD)info[3].As<Napi::Number>().Uint32Value();
+    req.options = (DWORD)info[3].As<Napi::Number>().Uint32Value();
   }
 
-  toWindowSlashStyle(p);
+  toWindowSlashStyle(req.path);
+  req.hasValueName = true;
+  return true;
+}
 
-  winreg::RegKey key;
-  try {
-    key.Open(hkey, Utf8ToUtf16(p), KEY_READ | options);
-    auto type = key.QueryValueType(Utf8ToUtf16(v));
-    if (type == REG_DWORD) {
-      return Napi::Number::New(env, key.GetDwordValue(Utf8ToUtf16(v)));
-    } else if (type == REG_SZ || type == REG_EXPAND_SZ) {
-      return Napi::String::New(env, Utf16ToUtf8(key.GetStringValue(Utf8ToUtf16(v))));
-    } else {
-      return env.Null();
-    }
-  } catch (const winreg::RegException& e) {
-    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND) {
-      return env.Null();
-    }
-    ThrowRegError(e);                                            
-    return env.Null(); 
-  } catch (const std::exception& e) {
-    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
-    return env.Null();
+// A string is set as REG_SZ and a number as REG_DWORD
+static void ParseSetValue(const Napi::Value& value, RegRequest& req) {
+  if (value.IsString()) {
+    req.type = REG_SZ;
+    JsToWide(value, req.str);
+  } else if (value.IsNumber()) {
+    req.type = REG_DWORD;
+    req.dword = value.ToNumber().Uint32Value();
   }
 }
 
-Napi::Value RegSet(const Napi::CallbackInfo& info) {
+// hkey, path, valueName, value, options
+static bool ParseSet(const Napi::CallbackInfo& info, RegRequest& req) {
   auto env = info.Env();
   if (info.Length() < 4) {
     Napi::Error::New(
         env, Napi::String::New(env, "invalid arguments (hkey, path, valueName, value, options?)"))
       .ThrowAsJavaScriptException();
-    return env.Undefined();
+    return false;
   }
 
-  HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
-  std::string p = info[1].As<Napi::String>();
-  std::string valName = info[2].As<Napi::String>();
+  req.hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
+  JsToWide(info[1], req.path);
+  JsToWide(info[2], req.valueName);
   Napi::Value value = info[3];
-  DWORD options = 0;
   if (info.Length() > 4) {
-    options = (DWORD)info[4].As<Napi::Number>().Uint32Value();
+    req.options = (DWORD)info[4].As<Napi::Number>().Uint32Value();
+  }
+  toWindowSlashStyle(req.path);
+  req.hasValueName = true;
+  ParseSetValue(value, req);
+  return true;
+}
+
+// hkey, path, value?, options?
+static bool ParseDelete(const Napi::CallbackInfo& info, RegRequest& req) {
+  auto env = info.Env();
+  if (info.Length() < 2) {
+    Napi::Error::New(
+        env, Napi::String::New(env, "invalid arguments (hkey, path, value?, options?)"))
+        .ThrowAsJavaScriptException();
+    return false;
   }
-  toWindowSlashStyle(p);
+
+  req.hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
+  JsToWide(info[1], req.path);
+  if (info.Length() > 2 && !info[2].IsNull() && !info[2].IsUndefined()) {
+    JsToWide(info[2], req.valueName);
+    req.hasValueName = true;
+  }
+  if (info.Length() > 3) {
+    req.options = (DWORD)info[3].As<Napi::Number>().Uint32Value();
+  }
+  toWindowSlashStyle(req.path);
+  return true;
+}
+
+// Run fn(key) -> winreg::RegResult on hkey\\path opened (or created) with
+// the given access, and return its result or the failure to open the key.
+// With reg.cache enabled, the handle is borrowed from the cache and stays
+// open afterwards; a cached handle whose key was deleted meanwhile is
+// dropped and the key opened again.
+template <typename Fn>
+static winreg::RegResult WithKey(HKEY hkey, const std::wstring& path, REGSAM access,
+                                 bool create, Fn&& fn) {
+  auto& cache = winreg::KeyCache::Instance();
+  if (auto cached = cache.Find(hkey, path, access)) {
+    winreg::RegResult result = fn(*cached);
+    if (result.Code() != ERROR_KEY_DELETED) {
+      return result;
+    }
+    cache.Remove(hkey, path, access);
+  }
+
+  auto key = std::make_shared<winreg::RegKey>();
+  winreg::RegResult opened = create ? key->TryCreate(hkey, path, access)
+                                    : key->TryOpen(hkey, path, access);
+  if (opened.Failed()) {
+    return opened;
+  }
+  cache.Insert(hkey, path, access, key);
+  return fn(*key);
+}
+
+// The value operations on an open key, shared by the functions taking
+// (hkey, path) and the *ValueAsync methods of RegKey
+static winreg::RegResult QueryIn(winreg::RegKey& key, const RegRequest& req, RegResult& result) {
+  // Type and data in one call; REG_EXPAND_SZ strings are expanded
+  auto value = key.TryGetValue(req.valueName, winreg::RegKey::ExpandStringOption::Expand);
+  if (!value) {
+    return value.GetError();
+  }
+  result.kind = RegResult::Kind::Value;
+  result.value = std::move(value).GetValue();
+  return winreg::RegResult{};
+}
+
+static winreg::RegResult SetIn(winreg::RegKey& key, const RegRequest& req) {
+  if (req.type == REG_SZ) {
+    return key.TrySetStringValue(req.valueName, req.str);
+  } else if (req.type == REG_DWORD) {
+    return key.TrySetDwordValue(req.valueName, req.dword);
+  }
+  return winreg::RegResult{};
+}
+
+static winreg::RegResult DeleteValueIn(winreg::RegKey& key, const RegRequest& req) {
+  return winreg::RegResult{RegDeleteValue(key.Get(), req.valueName.c_str()),
+                           "RegDeleteValue failed."};
+}
+
+// The registry side of queryValue/set/delete; no JS access, so these run on
+// either thread. Misses are returned by the Try* API rather than thrown;
+// errors other than "not found" are thrown as RegException.
+static RegResult DoQuery(const RegRequest& req) {
+  RegResult result;
+  auto status = WithKey(req.hkey, req.path, KEY_READ | req.options, false,
+                        [&](winreg::RegKey& key) {
+    return QueryIn(key, req, result);
+  });
+
+  // A missing key or value is null
+  if (status.Code() != ERROR_FILE_NOT_FOUND) {
+    status.ThrowIfFailed();
+  }
+  return result;
+}
+
+static RegResult DoSet(const RegRequest& req) {
+  auto status = WithKey(req.hkey, req.path, KEY_WRITE | req.options, true,
+                        [&](winreg::RegKey& key) {
+    return SetIn(key, req);
+  });
+  status.ThrowIfFailed();
+
+  RegResult result;
+  result.kind = RegResult::Kind::True;
+  return result;
+}
+
+static RegResult DoDelete(const RegRequest& req) {
+  RegResult result;
+  result.kind = RegResult::Kind::True;
+
+  winreg::RegResult status;
+  if (!req.hasValueName) {
+    status = WithKey(req.hkey, L"", DELETE | KEY_ENUMERATE_SUB_KEYS | KEY_QUERY_VALUE | req.options,
+                     false, [&](winreg::RegKey& key) {
+      return winreg::RegResult{RegDeleteTree(key.Get(), req.path.c_str()),
+                               "RegDeleteTree failed."};
+    });
+    // Cached handles of the deleted keys would only fail from now on
+    winreg::KeyCache::Instance().Invalidate(req.hkey, req.path);
+  } else {
+    status = WithKey(req.hkey, req.path, KEY_SET_VALUE | req.options, false,
+                     [&](winreg::RegKey& key) {
+      return DeleteValueIn(key, req);
+    });
+  }
+
+  // Deleting what doesn't exist succeeds
+  if (status.Code() != ERROR_FILE_NOT_FOUND) {
+    status.ThrowIfFailed();
+  }
+  return result;
+}
+
+// Run a request on the calling thread, converting errors to JS exceptions
+static Napi::Value RunSync(Napi::Env env, RegResult (*work)(const RegRequest&),
+                           const RegRequest& req) {
   try {
-    winreg::RegKey key;
-    key.Create(hkey, Utf8ToUtf16(p), KEY_WRITE | options);
-    if (value.IsString()) {
-      key.SetStringValue(Utf8ToUtf16(valName), Utf8ToUtf16(value.ToString()));
-    }  else if (value.IsNumber()) {
-      key.SetDwordValue(Utf8ToUtf16(valName), value.ToNumber().Uint32Value());
-    }
-    return Napi::Boolean::New(env, true);
+    return work(req).ToJs(env);
   } catch (const winreg::RegException& e) {
-    ThrowRegError(e);                                            
-    return env.Null(); 
+    ThrowRegError(e);
+    return env.Null();
   } catch (const std::exception& e) {
     Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
     return env.Null();
   }
 }
 
+// Runs a registry operation on the libuv thread pool and settles a Promise
+// with its result. Failures reject with the same RegError (name, code) the
+// synchronous functions throw.
+class RegWorker : public Napi::AsyncWorker {
+ public:
+  RegWorker(Napi::Env env, std::function<RegResult()> work,
+            std::function<void()> settled)
+      : Napi::AsyncWorker(env, "winreg"),
+        _deferred(Napi::Promise::Deferred::New(env)),
+        _work(std::move(work)),
+        _settled(std::move(settled)) {
+  }
+
+  // settled, if any, is called on the main thread before the Promise settles
+  static Napi::Value Run(Napi::Env env, std::function<RegResult()> work,
+                         std::function<void()> settled = nullptr) {
+    auto worker = new RegWorker(env, std::move(work), std::move(settled));
+    auto promise = worker->_deferred.Promise();
+    worker->Queue();
+    return promise;
+  }
+
+ protected:
+  void Execute() override {
+    try {
+      _result = _work();
+    } catch (const winreg::RegException& e) {
+      _regError.reset(new winreg::RegException(e));
+      SetError(e.what());
+    } catch (const std::exception& e) {
+      SetError(e.what());
+    }
+  }
+
+  void OnOK() override {
+    Settled();
+    _deferred.Resolve(_result.ToJs(Env()));
+  }
+
+  void OnError(const Napi::Error& e) override {
+    auto env = Env();
+    Settled();
+    _deferred.Reject(_regError ? MakeRegError(env, *_regError).Value() : e.Value());
+  }
+
+ private:
+  void Settled() {
+    if (_settled) {
+      _settled();
+    }
+  }
+
+  Napi::Promise::Deferred _deferred;
+  std::function<RegResult()> _work;
+  std::function<void()> _settled;
+  RegResult _result;
+  std::unique_ptr<winreg::RegException> _regError;
+};
+
+Napi::Value RegQuery(const Napi::CallbackInfo& info) {
+  RegRequest req;
+  if (!ParseQuery(info, req)) {
+    return info.Env().Undefined();
+  }
+  return RunSync(info.Env(), DoQuery, req);
+}
+
+Napi::Value RegSet(const Napi::CallbackInfo& info) {
+  RegRequest req;
+  if (!ParseSet(info, req)) {
+    return info.Env().Undefined();
+  }
+  return RunSync(info.Env(), DoSet, req);
+}
+
 Napi::Value RegDelete(const Napi::CallbackInfo& info) {
+  RegRequest req;
+  if (!ParseDelete(info, req)) {
+    return info.Env().Undefined();
+  }
+  return RunSync(info.Env(), DoDelete, req);
+}
+
+// Promise variants: the HKEY passed in must stay open until they settle.
+
+Napi::Value RegQueryAsync(const Napi::CallbackInfo& info) {
+  RegRequest req;
+  if (!ParseQuery(info, req)) {
+    return info.Env().Undefined();
+  }
+  return RegWorker::Run(info.Env(), [req] { return DoQuery(req); });
+}
+
+Napi::Value RegSetAsync(const Napi::CallbackInfo& info) {
+  RegRequest req;
+  if (!ParseSet(info, req)) {
+    return info.Env().Undefined();
+  }
+  return RegWorker::Run(info.Env(), [req] { return DoSet(req); });
+}
+
+Napi::Value RegDeleteAsync(const Napi::CallbackInfo& info) {
+  RegRequest req;
+  if (!ParseDelete(info, req)) {
+    return info.Env().Undefined();
+  }
+  return RegWorker::Run(info.Env(), [req] { return DoDelete(req); });
+}
+
+// reg.cache: opt-in cache of the key handles opened by queryValue(s), set
+// and delete (and their async variants), see keycache.hpp.
+//
+//   enable(maxHandles = 64)  start caching, keeping at most maxHandles open
+//   disable()                stop caching and close the cached handles
+//   clear()                  close the cached handles
+//   stats()                  { enabled, maxHandles, size, hits, misses, evictions }
+
+static Napi::Value CacheEnable(const Napi::CallbackInfo& info) {
   auto env = info.Env();
-  if (info.Length() < 2) {
+  uint32_t maxHandles = 64;
+  if (info.Length() > 0 && !info[0].IsUndefined()) {
+    if (!info[0].IsNumber() || info[0].As<Napi::Number>().DoubleValue() < 0) {
+      Napi::Error::New(env, "cache.enable - invalid arguments (maxHandles?)")
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+    maxHandles = info[0].As<Napi::Number>().Uint32Value();
+  }
+  winreg::KeyCache::Instance().Enable(maxHandles);
+  return env.Undefined();
+}
+
+static Napi::Value CacheDisable(const Napi::CallbackInfo& info) {
+  winreg::KeyCache::Instance().Disable();
+  return info.Env().Undefined();
+}
+
+static Napi::Value CacheClear(const Napi::CallbackInfo& info) {
+  winreg::KeyCache::Instance().Clear();
+  return info.Env().Undefined();
+}
+
+static Napi::Value CacheStats(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  const auto& cache = winreg::KeyCache::Instance();
+  const auto stats = cache.GetStats();
+  auto obj = Napi::Object::New(env);
+  obj.Set("enabled", Napi::Boolean::New(env, cache.IsEnabled()));
+  obj.Set("maxHandles", Napi::Number::New(env, static_cast<double>(cache.MaxHandles())));
+  obj.Set("size", Napi::Number::New(env, static_cast<double>(stats.size)));
+  obj.Set("hits", Napi::Number::New(env, static_cast<double>(stats.hits)));
+  obj.Set("misses", Napi::Number::New(env, static_cast<double>(stats.misses)));
+  obj.Set("evictions", Napi::Number::New(env, static_cast<double>(stats.evictions)));
+  return obj;
+}
+
+// hkey, [[path, value], ...], options
+// Like calling queryValue for each pair, but each distinct key is opened once.
+Napi::Value RegQueryValues(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsArray()) {
     Napi::Error::New(
-        env, Napi::String::New(env, "invalid arguments (hkey, path, value?, options?)"))
+        env, Napi::String::New(env, "invalid arguments (hkey, [[path, value], ...], options?)"))
         .ThrowAsJavaScriptException();
     return env.Undefined();
   }
 
   HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
-  std::string p = info[1].As<Napi::String>();
-  Napi::Value valueName;
+  auto items = info[1].As<Napi::Array>();
   DWORD options = 0;
   if (info.Length() > 2) {
-    valueName  = info[2];
+    options = (DWORD)info[2].As<Napi::Number>().Uint32Value();
   }
-  if (info.Length() > 3) {
-    options = (DWORD)info[3].As<Napi::Number>().Uint32Value();
+
+  // Group the requests by key path, keeping their positions in the result
+  const uint32_t count = items.Length();
+  std::vector<std::wstring> names(count);
+  std::unordered_map<std::wstring, std::vector<uint32_t>> byPath;
+  std::wstring path;
+  for (uint32_t i = 0; i < count; ++i) {
+    Napi::Value item = items.Get(i);
+    if (!item.IsArray()) {
+      Napi::Error::New(env, "queryValues - each item must be [path, value]")
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+    auto pair = item.As<Napi::Array>();
+    JsToWide(pair.Get(0u), path);
+    JsToWide(pair.Get(1u), names[i]);
+    toWindowSlashStyle(path);
+    byPath[path].push_back(i);
   }
-  toWindowSlashStyle(p);
-  winreg::RegKey key;
+
+  auto results = Napi::Array::New(env, count);
   try {
-    if (valueName.IsNull() || valueName.IsUndefined()) {
-      key.Open(hkey, L"", DELETE | KEY_ENUMERATE_SUB_KEYS | KEY_QUERY_VALUE | options);
-      auto status = RegDeleteTree(key.Get(), Utf8ToUtf16(p).c_str());
-      if (!(status == ERROR_SUCCESS || status == ERROR_FILE_NOT_FOUND)) {
-          throw winreg::RegException{"RegDeleteTree failed.", status};
+    for (const auto& group : byPath) {
+      auto status = WithKey(hkey, group.first, KEY_READ | options, false,
+                            [&](winreg::RegKey& key) -> winreg::RegResult {
+        for (auto i : group.second) {
+          // Read as queryValue does: REG_EXPAND_SZ expanded, null if missing
+          auto value = key.TryGetValue(names[i], winreg::RegKey::ExpandStringOption::Expand);
+          if (value) {
+            results.Set(i, ValueDataToJs(env, value.GetValue()));
+          } else if (value.GetError().Code() == ERROR_FILE_NOT_FOUND) {
+            results.Set(i, env.Null());
+          } else {
+            return value.GetError();
+          }
+        }
+        return winreg::RegResult{};
+      });
+      if (status.Code() == ERROR_FILE_NOT_FOUND) {
+        for (auto i : group.second) {
+          results.Set(i, env.Null());
+        }
+      } else {
+        status.ThrowIfFailed();
       }
-      return Napi::Boolean::New(env, true);
-    } else {
-      std::string v = valueName.As<Napi::String>();
-      key.Open(hkey, Utf8ToUtf16(p), KEY_SET_VALUE | options);
-      auto status = RegDeleteValue(key.Get(), Utf8ToUtf16(v).c_str());
-      if (!(status == ERROR_SUCCESS || status == ERROR_FILE_NOT_FOUND)) {
-          throw winreg::RegException{"RegDeleteValue failed.", status};
-      }
-      return Napi::Boolean::New(env, true);
     }
+    return results;
   } catch (const winreg::RegException& e) {
-    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND) {
-      return Napi::Boolean::New(env, true);
-    }
-    ThrowRegError(e);                                            
-    return env.Null(); 
+    ThrowRegError(e);
+    return env.Null();
   } catch (const std::exception& e) {
     Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
     return env.Null();
@@ -274,9 +654,10 @@ Napi::Value RegKey::createKey(const Napi::CallbackInfo& info) {
     }
 
     HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
-    std::string p = info[1].As<Napi::String>();
+    std::wstring p = JsToWide(info[1]);
     toWindowSlashStyle(p);
-    this->_key.Create(hkey, Utf8ToUtf16(p));
+    this->RetireHandle();
+    this->_key.Create(hkey, p);
     return info.This();
   } else if (info.Length() == 3) {
     if (!info[0].IsNumber() || !info[1].IsString() || !info[2].IsNumber()) {
@@ -287,10 +668,11 @@ Napi::Value RegKey::createKey(const Napi::CallbackInfo& info) {
       return info.Env().Null();
     }
     HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
-    std::string p = info[1].As<Napi::String>();
+    std::wstring p = JsToWide(info[1]);
     toWindowSlashStyle(p);
     DWORD access = (DWORD)info[2].As<Napi::Number>().Uint32Value();
-    this->_key.Create(hkey, Utf8ToUtf16(p), access);
+    this->RetireHandle();
+    this->_key.Create(hkey, p, access);
   } else if (info.Length() == 4) {
     if (!info[0].IsNumber() || !info[1].IsString() || !info[2].IsNumber() ||
         !info[3].IsNumber()) {
@@ -301,11 +683,12 @@ Napi::Value RegKey::createKey(const Napi::CallbackInfo& info) {
       return info.Env().Null();
     }
     HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
-    std::string p = info[1].As<Napi::String>();
+    std::wstring p = JsToWide(info[1]);
     toWindowSlashStyle(p);
     DWORD access = (DWORD)info[2].As<Napi::Number>().Uint32Value();
     DWORD options = (DWORD)info[3].As<Napi::Number>().Uint32Value();
-    this->_key.Create(hkey, Utf8ToUtf16(p), access, options, nullptr, nullptr);
+    this->RetireHandle();
+    this->_key.Create(hkey, p, access, options, nullptr, nullptr);
   } else {
     Napi::Error::New(
         info.Env(),
@@ -320,6 +703,7 @@ Napi::Value RegKey::createKey(const Napi::CallbackInfo& info) {
 
 Napi::Value RegKey::openKey(const Napi::CallbackInfo& info) {
   auto env = info.Env();
+  winreg::RegResult opened;
   if (info.Length() == 2) {
     if (!info[0].IsNumber() || !info[1].IsString()) {
       Napi::Error::New(
@@ -331,9 +715,10 @@ Napi::Value RegKey::openKey(const Napi::CallbackInfo& info) {
     }
 
     HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
-    std::string p = info[1].As<Napi::String>();
+    std::wstring p = JsToWide(info[1]);
     toWindowSlashStyle(p);
-    this->_key.Open(hkey, Utf8ToUtf16(p));
+    this->RetireHandle();
+    opened = this->_key.TryOpen(hkey, p);
   } else if (info.Length() == 3) {
     if (!info[0].IsNumber() || !info[1].IsString() || !info[2].IsNumber()) {
       Napi::Error::New(env,
@@ -342,16 +727,25 @@ Napi::Value RegKey::openKey(const Napi::CallbackInfo& info) {
       return env.Null();
     }
     HKEY hkey = (HKEY)info[0].As<Napi::Number>().Int64Value();
-    std::string p = info[1].As<Napi::String>();
+    std::wstring p = JsToWide(info[1]);
     toWindowSlashStyle(p);
     DWORD access = (DWORD)info[2].As<Napi::Number>().Uint32Value();
-    this->_key.Open(hkey, Utf8ToUtf16(p), access);
+    this->RetireHandle();
+    opened = this->_key.TryOpen(hkey, p, access);
   } else {
     Napi::Error::New(env, Napi::String::New(env, "openKey - invalid arguments"))
         .ThrowAsJavaScriptException();
     return env.Null();
   }
 
+  // A missing key is false rather than an error
+  if (opened.Code() == ERROR_FILE_NOT_FOUND) {
+    return Napi::Boolean::New(env, false);
+  }
+  if (opened.Failed()) {
+    ThrowRegError(opened);
+    return env.Null();
+  }
   return info.This();
 }
 
@@ -388,6 +782,7 @@ Napi::Value RegKey::Open(const Napi::CallbackInfo& info) {
 Napi::Value RegKey::Close(const Napi::CallbackInfo& info) {
   auto env = info.Env();
   try {
+    this->RetireHandle();
     this->_key.Close();
     return info.This();
   } catch (const winreg::RegException& e) {
@@ -411,8 +806,8 @@ Napi::Value RegKey::GetHandle(const Napi::CallbackInfo& info) {
 Napi::Value RegKey::GetValueType(const Napi::CallbackInfo& info) {
   auto env = info.Env();
   try {
-    std::string p = info[0].As<Napi::String>();
-    auto dwType = this->_key.QueryValueType(Utf8ToUtf16(p));
+    std::wstring p = JsToWide(info[0]);
+    auto dwType = this->_key.QueryValueType(p);
     return Napi::Number::New(env, dwType);
   } catch (const winreg::RegException& e) {
     ThrowRegError(e);
@@ -423,18 +818,51 @@ Napi::Value RegKey::GetValueType(const Napi::CallbackInfo& info) {
   }
 }
 
-Napi::Value RegKey::GetString(const Napi::CallbackInfo& info) {
+// The value read by a Try* getter, converted by toJs; if there is no such
+// value, info[defval] when a default was passed (defval > 0), else the
+// RegError thrown to JS.
+template <typename T, typename ToJs>
+static Napi::Value ValueOrDefault(const Napi::CallbackInfo& info,
+                                  winreg::RegExpected<T>&& value, int defval,
+                                  ToJs&& toJs) {
   auto env = info.Env();
-  try {
-    std::string p = info[0].As<Napi::String>();
-    auto v = this->_key.GetStringValue(Utf8ToUtf16(p));
-    return Napi::String::New(env, Utf16ToUtf8(v));
-  } catch (const winreg::RegException& e) {
-    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND && info.Length() > 1) {
-      return info[1];
+  if (!value) {
+    const auto& error = value.GetError();
+    if (error.Code() == ERROR_FILE_NOT_FOUND && defval > 0) {
+      return info[defval];
     }
-    ThrowRegError(e);
+    ThrowRegError(error);
+    return env.Null();
+  }
+  return toJs(env, std::move(value).GetValue());
+}
+
+// name, default?
+// A value of any type, typed as by ValueDataToJs; REG_EXPAND_SZ strings are
+// not expanded, as with enumValues({data: true}).
+Napi::Value RegKey::GetValue(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    std::wstring p = JsToWide(info[0]);
+    return ValueOrDefault(info, this->_key.TryGetValue(p), info.Length() > 1 ? 1 : -1,
+                          [](Napi::Env env, const winreg::RegValueData& v) {
+      return ValueDataToJs(env, v);
+    });
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
     return env.Null();
+  }
+}
+
+// name, default?
+Napi::Value RegKey::GetString(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    std::wstring p = JsToWide(info[0]);
+    return ValueOrDefault(info, this->_key.TryGetStringValue(p), info.Length() > 1 ? 1 : -1,
+                          [](Napi::Env env, const std::wstring& v) {
+      return WideToJs(env, v);
+    });
   } catch (const std::exception& e) {
     Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
     return env.Null();
@@ -444,21 +872,65 @@ Napi::Value RegKey::GetString(const Napi::CallbackInfo& info) {
 Napi::Value RegKey::GetDword(const Napi::CallbackInfo& info) {
   auto env = info.Env();
   try {
-    std::string p = info[0].As<Napi::String>();
-    auto v = this->_key.GetDwordValue(Utf8ToUtf16(p));
-    return Napi::Number::New(env, (uint32_t)v);
-  } catch (const winreg::RegException& e) {
-    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND && info.Length() > 1) {
-      return info[1];
-    }
+    std::wstring p = JsToWide(info[0]);
+    return ValueOrDefault(info, this->_key.TryGetDwordValue(p), info.Length() > 1 ? 1 : -1,
+                          [](Napi::Env env, DWORD v) {
+      return Napi::Number::New(env, (uint32_t)v);
+    });
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
 
-    ThrowRegError(e);
+Napi::Value RegKey::GetQword(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    std::wstring p = JsToWide(info[0]);
+    return ValueOrDefault(info, this->_key.TryGetQwordValue(p), info.Length() > 1 ? 1 : -1,
+                          [](Napi::Env env, ULONGLONG v) {
+      return Napi::BigInt::New(env, static_cast<uint64_t>(v));
+    });
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
     return env.Null();
+  }
+}
+
+// The data is read straight into the memory of the returned Buffer
+Napi::Value RegKey::GetBinary(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    std::wstring p = JsToWide(info[0]);
+    for (;;) {
+      auto size = this->_key.TryGetBinaryValueSize(p);
+      if (!size) {
+        return ValueOrDefault(info, std::move(size), info.Length() > 1 ? 1 : -1,
+                              [](Napi::Env env, DWORD) { return env.Null(); });
+      }
+      auto buffer = Napi::Buffer<uint8_t>::New(env, size.GetValue());
+      auto read = this->_key.TryGetBinaryValue(p, buffer.Data(), size.GetValue());
+      if (!read && read.GetError().Code() == ERROR_MORE_DATA) {
+        continue; // the value grew since the size query
+      }
+      if (!read) {
+        return ValueOrDefault(info, std::move(read), info.Length() > 1 ? 1 : -1,
+                              [](Napi::Env env, DWORD) { return env.Null(); });
+      }
+      if (read.GetValue() == size.GetValue()) {
+        return buffer;
+      }
+      // The value shrank since the size query: a view of the bytes read
+      return buffer.Get("subarray").As<Napi::Function>().Call(
+          buffer, {Napi::Number::New(env, 0), Napi::Number::New(env, read.GetValue())});
+    }
   } catch (const std::exception& e) {
     Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
   }
 }
 
+// name, expand?, default?
 Napi::Value RegKey::GetExpandString(const Napi::CallbackInfo& info) {
   auto option = winreg::RegKey::ExpandStringOption::DontExpand;
   int defval = -1;
@@ -479,15 +951,11 @@ Napi::Value RegKey::GetExpandString(const Napi::CallbackInfo& info) {
 
   auto env = info.Env();
   try {
-    std::string p = info[0].As<Napi::String>();
-    auto v = this->_key.GetExpandStringValue(Utf8ToUtf16(p), option);
-    return Napi::String::New(env, Utf16ToUtf8(v));
-  } catch (const winreg::RegException& e) {
-    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND && defval > 0) {
-      return info[defval];
-    }
-    ThrowRegError(e);
-    return env.Null();
+    std::wstring p = JsToWide(info[0]);
+    return ValueOrDefault(info, this->_key.TryGetExpandStringValue(p, option), defval,
+                          [](Napi::Env env, const std::wstring& v) {
+      return WideToJs(env, v);
+    });
   } catch (const std::exception& e) {
     Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
     return env.Null();
@@ -497,20 +965,15 @@ Napi::Value RegKey::GetExpandString(const Napi::CallbackInfo& info) {
 Napi::Value RegKey::GetMultiString(const Napi::CallbackInfo& info) {
   auto env = info.Env();
   try {
-    std::string p = info[0].As<Napi::String>();
-    auto vec = this->_key.GetMultiStringValue(Utf8ToUtf16(p));
-    auto arr = Napi::Array::New(env, vec.size());
-    for (size_t i = 0; i < vec.size(); ++i) {
-      (arr).Set(i, Napi::String::New(env, Utf16ToUtf8(vec[i])));
-    }
-    return arr;
-  } catch (const winreg::RegException& e) {
-    if (e.ErrorCode() == ERROR_FILE_NOT_FOUND && info.Length() > 1) {
-      return info[1];
-    }
-
-    ThrowRegError(e);
-    return env.Null();
+    std::wstring p = JsToWide(info[0]);
+    return ValueOrDefault(info, this->_key.TryGetMultiStringValue(p), info.Length() > 1 ? 1 : -1,
+                          [](Napi::Env env, const std::vector<std::wstring>& vec) {
+      auto arr = Napi::Array::New(env, vec.size());
+      for (size_t i = 0; i < vec.size(); ++i) {
+        arr.Set(i, WideToJs(env, vec[i]));
+      }
+      return arr;
+    });
   } catch (const std::exception& e) {
     Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
     return env.Null();
@@ -528,9 +991,7 @@ Napi::Value RegKey::SetString(const Napi::CallbackInfo& info) {
       return env.Null();
     }
 
-    std::string name = info[0].As<Napi::String>();
-    std::string value = info[1].As<Napi::String>();
-    this->_key.SetStringValue(Utf8ToUtf16(name), Utf8ToUtf16(value));
+    this->_key.SetStringValue(JsToWide(info[0]), JsToWide(info[1]));
     return Napi::Number::New(env, 0);
   } catch (const winreg::RegException& e) {
     ThrowRegError(e);
@@ -552,9 +1013,34 @@ Napi::Value RegKey::SetExpandString(const Napi::CallbackInfo& info) {
       return env.Null();
     }
 
-    auto name = info[0].As<Napi::String>();
-    auto value = info[1].As<Napi::String>();
-    this->_key.SetExpandStringValue(Utf8ToUtf16(name), Utf8ToUtf16(value));
+    this->_key.SetExpandStringValue(JsToWide(info[0]), JsToWide(info[1]));
+    return info.This();
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+Napi::Value RegKey::SetMultiString(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    if (info.Length() != 2 || !info[0].IsString() || !info[1].IsArray()) {
+      Napi::Error::New(
+          env, Napi::String::New(
+                   env, "Invalid argment: name(string), value(string[]) required"))
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+
+    auto arr = info[1].As<Napi::Array>();
+    std::vector<std::wstring> strings(arr.Length());
+    for (uint32_t i = 0; i < arr.Length(); ++i) {
+      JsToWide(arr.Get(i), strings[i]);
+    }
+    this->_key.SetMultiStringValue(JsToWide(info[0]), strings);
     return info.This();
   } catch (const winreg::RegException& e) {
     ThrowRegError(e);
@@ -576,8 +1062,7 @@ Napi::Value RegKey::SetDword(const Napi::CallbackInfo& info) {
           .ThrowAsJavaScriptException();
       return env.Null();
     }
-    std::string name = info[0].As<Napi::String>();
-    this->_key.SetDwordValue(Utf8ToUtf16(name),
+    this->_key.SetDwordValue(JsToWide(info[0]),
                              info[1].As<Napi::Number>().Uint32Value());
     return info.This();
   } catch (const winreg::RegException& e) {
@@ -588,6 +1073,85 @@ Napi::Value RegKey::SetDword(const Napi::CallbackInfo& info) {
     return env.Null();
   }
 }
+Napi::Value RegKey::SetQword(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    uint64_t value = 0;
+    bool valid = info.Length() == 2 && info[0].IsString();
+    if (valid && info[1].IsBigInt()) {
+      value = info[1].As<Napi::BigInt>().Uint64Value(&valid);
+    } else if (valid && info[1].IsNumber()) {
+      const double number = info[1].As<Napi::Number>().DoubleValue();
+      valid = number >= 0 && number <= 9007199254740991.0 && number == static_cast<double>(static_cast<uint64_t>(number));
+      value = valid ? static_cast<uint64_t>(number) : 0;
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      Napi::Error::New(
+          env,
+          Napi::String::New(
+              env, "Invalid argment: name(string), value(bigint or integer, 0 to 2^64-1) required"))
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    this->_key.SetQwordValue(JsToWide(info[0]), value);
+    return info.This();
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// The bytes of a Buffer, TypedArray, DataView or ArrayBuffer, in place
+static bool GetBytes(const Napi::Value& value, const uint8_t*& data, size_t& size) {
+  if (value.IsTypedArray()) {
+    auto array = value.As<Napi::TypedArray>();
+    data = static_cast<const uint8_t*>(array.ArrayBuffer().Data()) + array.ByteOffset();
+    size = array.ByteLength();
+  } else if (value.IsDataView()) {
+    auto view = value.As<Napi::DataView>();
+    data = static_cast<const uint8_t*>(view.ArrayBuffer().Data()) + view.ByteOffset();
+    size = view.ByteLength();
+  } else if (value.IsArrayBuffer()) {
+    auto buffer = value.As<Napi::ArrayBuffer>();
+    data = static_cast<const uint8_t*>(buffer.Data());
+    size = buffer.ByteLength();
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// The data is written from the memory of the view passed in, without a copy
+Napi::Value RegKey::SetBinary(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  try {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    if (info.Length() != 2 || !info[0].IsString() || !GetBytes(info[1], data, size) ||
+        static_cast<DWORD>(size) != size) {
+      Napi::Error::New(
+          env,
+          Napi::String::New(
+              env, "Invalid argment: name(string), value(Buffer, TypedArray, DataView or ArrayBuffer) required"))
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    this->_key.SetBinaryValue(JsToWide(info[0]), data, static_cast<DWORD>(size));
+    return info.This();
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
 Napi::Value RegKey::DeleteValue(const Napi::CallbackInfo& info) {
   auto env = info.Env();
   try {
@@ -599,8 +1163,7 @@ Napi::Value RegKey::DeleteValue(const Napi::CallbackInfo& info) {
       return env.Null();
     }
 
-    auto s = info[0].As<Napi::String>();
-    this->_key.DeleteValue(Utf8ToUtf16(s));
+    this->_key.DeleteValue(JsToWide(info[0]));
     return info.This();
   } catch (const winreg::RegException& e) {
     ThrowRegError(e);
@@ -621,8 +1184,7 @@ Napi::Value RegKey::DeleteKey(const Napi::CallbackInfo& info) {
       return env.Null();
     }
 
-    std::string s = info[0].As<Napi::String>();
-    this->_key.DeleteKey(Utf8ToUtf16(s),
+    this->_key.DeleteKey(JsToWide(info[0]),
                          info[1].As<Napi::Number>().Uint32Value());
     return info.This();
   } catch (const winreg::RegException& e) {
@@ -634,13 +1196,231 @@ Napi::Value RegKey::DeleteKey(const Napi::CallbackInfo& info) {
   }
 }
 
+// start?, count?: a page of at most count names from the index start on
+static void ParsePage(const Napi::CallbackInfo& info, DWORD& start,
+                      DWORD& count) {
+  start = 0;
+  count = ~DWORD{0};
+  if (info.Length() > 0 && info[0].IsNumber()) {
+    start = info[0].As<Napi::Number>().Uint32Value();
+  }
+  if (info.Length() > 1 && info[1].IsNumber()) {
+    count = info[1].As<Napi::Number>().Uint32Value();
+  }
+}
+
 Napi::Value RegKey::EnumSubKeys(const Napi::CallbackInfo& info) {
   auto env = info.Env();
   try {
-    auto v = this->_key.EnumSubKeys();
-    auto arr = Napi::Array::New(env, v.size());
-    for (size_t i = 0; i < v.size(); ++i) {
-      arr.Set(i, Napi::String::New(env, Utf16ToUtf8(v[i])));
+    // The names share one buffer: no allocation per name before V8 copies
+    winreg::NameList names;
+    if (info.Length() > 0) {
+      DWORD start, count;
+      ParsePage(info, start, count);
+      this->_key.EnumSubKeys(start, count, names);
+    } else {
+      this->_key.EnumSubKeys(names);
+    }
+    return NamesToJs(env, names);
+  } catch (const winreg::RegException& e) {
+    ThrowRegError(e);
+    return env.Null();
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+}
+
+// start, count: a Promise of a page of subkey names, enumerated on the
+// thread pool
+Napi::Value RegKey::EnumSubKeysAsync(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (!this->_key.IsValid()) {
+    Napi::Error::New(env, "enumSubKeysAsync - the key is closed")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  DWORD start, count;
+  ParsePage(info, start, count);
+  return RunOnHandle(env, [start, count](winreg::RegKey& key, RegResult& result) {
+    result.kind = RegResult::Kind::Names;
+    return key.TryEnumSubKeys(start, count, result.names);
+  });
+}
+
+// Run fn(key, result) -> winreg::RegResult on the thread pool with the
+// handle of this key, settling with result. Until then the JS object is
+// referenced, so it can't be collected, and its handle stays open: close()
+// or open() meanwhile only retire it (see RetireHandle).
+Napi::Value RegKey::RunOnHandle(
+    Napi::Env env, std::function<winreg::RegResult(winreg::RegKey&, RegResult&)> fn) {
+  HKEY hkey = this->_key.Get();
+  auto promise = RegWorker::Run(
+      env,
+      [hkey, fn] {
+        // Borrow the handle of the JS key
+        winreg::RegKey key{hkey};
+        RegResult result;
+        auto status = fn(key, result);
+        key.Detach();
+        status.ThrowIfFailed();
+        return result;
+      },
+      [this] {
+        if (--this->_pending == 0) {
+          this->_retired.clear();
+        }
+        this->Unref();
+      });
+  this->Ref();
+  this->_pending++;
+  return promise;
+}
+
+// Called before the handle is closed or replaced: while operations on the
+// thread pool may still use it, it is kept open until they settle
+void RegKey::RetireHandle() {
+  if (this->_pending > 0 && this->_key.IsValid()) {
+    this->_retired.push_back(std::move(this->_key));
+  }
+}
+
+// A missing value is not an error: querying it gives null and deleting it
+// succeeds
+static winreg::RegResult IgnoreNotFound(winreg::RegResult status) {
+  return status.Code() == ERROR_FILE_NOT_FOUND ? winreg::RegResult{} : status;
+}
+
+// The value name of the *ValueAsync methods, or false after throwing
+static bool ParseValueAsync(const Napi::CallbackInfo& info, const winreg::RegKey& key,
+                            const char* method, size_t argc, RegRequest& req) {
+  auto env = info.Env();
+  if (!key.IsValid()) {
+    Napi::Error::New(env, std::string(method) + " - the key is closed")
+        .ThrowAsJavaScriptException();
+    return false;
+  }
+  if (info.Length() < argc || !info[0].IsString()) {
+    Napi::Error::New(env, std::string(method) + " - invalid arguments")
+        .ThrowAsJavaScriptException();
+    return false;
+  }
+  JsToWide(info[0], req.valueName);
+  req.hasValueName = true;
+  return true;
+}
+
+// name: a Promise of the value (null if missing), read on the thread pool
+Napi::Value RegKey::QueryValueAsync(const Napi::CallbackInfo& info) {
+  RegRequest req;
+  if (!ParseValueAsync(info, this->_key, "queryValueAsync", 1, req)) {
+    return info.Env().Undefined();
+  }
+  return RunOnHandle(info.Env(), [req](winreg::RegKey& key, RegResult& result) {
+    return IgnoreNotFound(QueryIn(key, req, result));
+  });
+}
+
+// name, value: a Promise of true once a string (REG_SZ) or a number
+// (REG_DWORD) is set
+Napi::Value RegKey::SetValueAsync(const Napi::CallbackInfo& info) {
+  RegRequest req;
+  if (!ParseValueAsync(info, this->_key, "setValueAsync", 2, req)) {
+    return info.Env().Undefined();
+  }
+  ParseSetValue(info[1], req);
+  return RunOnHandle(info.Env(), [req](winreg::RegKey& key, RegResult& result) {
+    result.kind = RegResult::Kind::True;
+    return SetIn(key, req);
+  });
+}
+
+// name: a Promise of true once the value is deleted or found missing
+Napi::Value RegKey::DeleteValueAsync(const Napi::CallbackInfo& info) {
+  RegRequest req;
+  if (!ParseValueAsync(info, this->_key, "deleteValueAsync", 1, req)) {
+    return info.Env().Undefined();
+  }
+  return RunOnHandle(info.Env(), [req](winreg::RegKey& key, RegResult& result) {
+    result.kind = RegResult::Kind::True;
+    return IgnoreNotFound(DeleteValueIn(key, req));
+  });
+}
+
+double FileTimeToJsTime(const FILETIME& ft) {
+  const ULONGLONG ticks =
+      (static_cast<ULONGLONG>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+  // Subtract in integers: ticks exceed the 53-bit precision of a double
+  const auto since1970 = static_cast<int64_t>(ticks - 116444736000000000ULL);
+  return static_cast<double>(since1970) / 10000.0;
+}
+
+Napi::Value FileTimeToDate(Napi::Env env, const FILETIME& ft) {
+  return Napi::Date::New(env, FileTimeToJsTime(ft));
+}
+
+FILETIME JsTimeToFileTime(double ms) {
+  const auto ticks = static_cast<ULONGLONG>(
+      static_cast<int64_t>(ms * 10000.0) + 116444736000000000LL);
+  FILETIME ft;
+  ft.dwLowDateTime = static_cast<DWORD>(ticks);
+  ft.dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+  return ft;
+}
+
+// options?: {counts: true} adds the subkey and value counts of each subkey;
+// {typed: true} returns parallel arrays {names, lastWriteTimes (a
+// Float64Array of ms since 1970), subKeys?, values? (Uint32Arrays)} instead
+// of [{name, lastWriteTime (a Date), subKeys?, values?}, ...]
+Napi::Value RegKey::EnumSubKeysDetailed(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  bool counts = false;
+  bool typed = false;
+  if (info.Length() > 0 && info[0].IsObject()) {
+    auto options = info[0].As<Napi::Object>();
+    counts = options.Get("counts").ToBoolean();
+    typed = options.Get("typed").ToBoolean();
+  }
+
+  try {
+    auto details = this->_key.EnumSubKeysDetailed(
+        counts ? winreg::RegKey::SubKeyCountsOption::Query
+               : winreg::RegKey::SubKeyCountsOption::Skip);
+    const size_t size = details.names.size();
+
+    if (typed) {
+      auto times = Napi::Float64Array::New(env, size);
+      for (size_t i = 0; i < size; ++i) {
+        times[i] = FileTimeToJsTime(details.lastWriteTimes[i]);
+      }
+      auto obj = Napi::Object::New(env);
+      obj.Set("names", NamesToJs(env, details.names));
+      obj.Set("lastWriteTimes", times);
+      if (counts) {
+        auto subKeys = Napi::Uint32Array::New(env, size);
+        auto values = Napi::Uint32Array::New(env, size);
+        for (size_t i = 0; i < size; ++i) {
+          subKeys[i] = details.subKeyCounts[i];
+          values[i] = details.valueCounts[i];
+        }
+        obj.Set("subKeys", subKeys);
+        obj.Set("values", values);
+      }
+      return obj;
+    }
+
+    auto arr = Napi::Array::New(env, size);
+    for (size_t i = 0; i < size; ++i) {
+      auto name = details.names[i].name;
+      auto record = Napi::Object::New(env);
+      record.Set("name", WideToJs(env, name.data(), name.size()));
+      record.Set("lastWriteTime", FileTimeToDate(env, details.lastWriteTimes[i]));
+      if (counts) {
+        record.Set("subKeys", Napi::Number::New(env, details.subKeyCounts[i]));
+        record.Set("values", Napi::Number::New(env, details.valueCounts[i]));
+      }
+      arr.Set(i, record);
     }
     return arr;
   } catch (const winreg::RegException& e) {
@@ -652,14 +1432,48 @@ Napi::Value RegKey::EnumSubKeys(const Napi::CallbackInfo& info) {
   }
 }
 
+// JS value for decoded registry value data
+Napi::Value ValueDataToJs(Napi::Env env, const winreg::RegValueData& data) {
+  return std::visit([env](const auto& v) -> Napi::Value {
+    using T = std::decay_t<decltype(v)>;
+    if constexpr (std::is_same_v<T, DWORD>) {
+      return Napi::Number::New(env, v);
+    } else if constexpr (std::is_same_v<T, ULONGLONG>) {
+      return Napi::BigInt::New(env, static_cast<uint64_t>(v));
+    } else if constexpr (std::is_same_v<T, std::wstring>) {
+      return WideToJs(env, v);
+    } else if constexpr (std::is_same_v<T, std::vector<std::wstring>>) {
+      auto arr = Napi::Array::New(env, v.size());
+      for (size_t i = 0; i < v.size(); ++i) {
+        arr.Set(i, WideToJs(env, v[i]));
+      }
+      return arr;
+    } else {
+      return Napi::Buffer<BYTE>::Copy(env, v.data(), v.size());
+    }
+  }, data);
+}
+
+// options?: {data: true} maps names to typed values instead of types
 Napi::Value RegKey::EnumValues(const Napi::CallbackInfo& info) {
   auto env = info.Env();
   try {
-    auto v = this->_key.EnumValues();
     auto obj = Napi::Object::New(env);
-    for (size_t i = 0; i < v.size(); ++i) {
-      obj.Set(Napi::String::New(env, Utf16ToUtf8(v[i].first)),
-              Napi::Number::New(env, (uint32_t)v[i].second));
+    if (info.Length() > 0 && info[0].IsObject() &&
+        info[0].As<Napi::Object>().Get("data").ToBoolean()) {
+      auto values = this->_key.EnumValuesWithData();
+      for (const auto& value : values) {
+        obj.Set(WideToJs(env, value.name),
+                ValueDataToJs(env, value.data));
+      }
+      return obj;
+    }
+
+    winreg::NameList values;
+    this->_key.EnumValues(values);
+    for (const auto& value : values) {
+      obj.Set(WideToJs(env, value.name.data(), value.name.size()),
+              Napi::Number::New(env, (uint32_t)value.type));
     }
     return obj;
   } catch (const winreg::RegException& e) {
@@ -671,6 +1485,15 @@ Napi::Value RegKey::EnumValues(const Napi::CallbackInfo& info) {
   }
 }
 
+AddonData* GetAddonData(Napi::Env env) {
+  auto data = env.GetInstanceData<AddonData>();
+  if (data == nullptr) {
+    data = new AddonData();
+    env.SetInstanceData(data);
+  }
+  return data;
+}
+
 Napi::Error MakeRegError(Napi::Env env, const winreg::RegException& e) {
   auto err = Napi::Error::New(env, e.what());
   err.Set("name", "RegError");
@@ -678,23 +1501,65 @@ Napi::Error MakeRegError(Napi::Env env, const winreg::RegException& e) {
   return err;
 }
 
-std::wstring Utf8ToUtf16(const std::string &str) {
-    if( str.empty() ) return std::wstring();
-    int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
-    std::wstring wstrTo( size_needed, 0 );
-    MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
-    return wstrTo;
+// The same error for a failure returned by the Try* API
+Napi::Error MakeRegError(Napi::Env env, const winreg::RegResult& result) {
+  return MakeRegError(env, winreg::RegException{result.Message(), result.Code()});
+}
+
+// JS strings go to and from the registry through the UTF-16 Node-API
+// functions, without a detour through UTF-8. On Windows, wchar_t strings
+// are UTF-16 and are copied as they are; elsewhere they are UTF-32 and are
+// widened or narrowed on the way (utf.hpp).
+
+void JsToWide(const Napi::Value& value, std::wstring& out) {
+  napi_env env = value.Env();
+  size_t length = 0;
+  napi_status status = napi_get_value_string_utf16(env, value, nullptr, 0, &length);
+  NAPI_THROW_IF_FAILED_VOID(env, status);
+#ifdef _WIN32
+  out.resize(length);
+  status = napi_get_value_string_utf16(
+      env, value, reinterpret_cast<char16_t*>(&out[0]), length + 1, &length);
+  NAPI_THROW_IF_FAILED_VOID(env, status);
+#else
+  thread_local std::u16string utf16;
+  utf16.resize(length);
+  status = napi_get_value_string_utf16(env, value, &utf16[0], length + 1, &length);
+  NAPI_THROW_IF_FAILED_VOID(env, status);
+  out.resize(length);
+  out.resize(winreg::utf::Utf16ToUtf32(utf16.data(), length, &out[0]));
+#endif
 }
 
-std::string Utf16ToUtf8(const std::wstring &wstr) {
-    if( wstr.empty() ) return std::string();
-    int size_needed = WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), NULL, 0, NULL, NULL);
-    std::string strTo( size_needed, 0 );
-    WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
-    return strTo;
+std::wstring JsToWide(const Napi::Value& value) {
+  std::wstring out;
+  JsToWide(value, out);
+  return out;
+}
+
+Napi::String WideToJs(Napi::Env env, const wchar_t* str, size_t len) {
+#ifdef _WIN32
+  return Napi::String::New(env, reinterpret_cast<const char16_t*>(str), len);
+#else
+  thread_local std::u16string utf16;
+  utf16.resize(2 * len);
+  utf16.resize(winreg::utf::Utf32ToUtf16(str, len, &utf16[0]));
+  return Napi::String::New(env, utf16.data(), utf16.size());
+#endif
+}
+
+Napi::String WideToJs(Napi::Env env, const std::wstring& str) {
+  return WideToJs(env, str.data(), str.size());
 }
 
 Napi::Object InitModule(Napi::Env env, Napi::Object exports) {
+  InitHive(env, exports);
+  InitWalk(env, exports);
+  InitRegFile(env, exports);
+#ifndef _WIN32
+  InitStandIn(env, exports);
+#endif
+
   RegKey::Init(env, exports);
   exports.Set("HKEY_CLASSES_ROOT",
               Napi::Number::New(env, (uint32_t)(ULONG_PTR)HKEY_CLASSES_ROOT));
@@ -723,7 +1588,18 @@ Napi::Object InitModule(Napi::Env env, Napi::Object exports) {
 
   exports.Set("set", Napi::Function::New(env, RegSet));
   exports.Set("queryValue", Napi::Function::New(env, RegQuery));
+  exports.Set("queryValues", Napi::Function::New(env, RegQueryValues));
   exports.Set("delete", Napi::Function::New(env, RegDelete));
+  exports.Set("queryValueAsync", Napi::Function::New(env, RegQueryAsync));
+  exports.Set("setAsync", Napi::Function::New(env, RegSetAsync));
+  exports.Set("deleteAsync", Napi::Function::New(env, RegDeleteAsync));
+
+  auto cache = Napi::Object::New(env);
+  cache.Set("enable", Napi::Function::New(env, CacheEnable));
+  cache.Set("disable", Napi::Function::New(env, CacheDisable));
+  cache.Set("clear", Napi::Function::New(env, CacheClear));
+  cache.Set("stats", Napi::Function::New(env, CacheStats));
+  exports.Set("cache", cache);
 
   return exports;
 }
@@ -15,7 +15,12 @@
 // Registry key handles are safely and conveniently wrapped
 // in the RegKey resource manager C++ class.
 //
-// Errors are signaled throwing exceptions of class RegException.
+// Errors are signaled throwing exceptions of class RegException
+// (declared in regdefs.hpp, shared with the offline hive reader).
+// The Try* methods return them instead, as RegResult/RegExpected.
+//
+// Outside Windows, the registry C API is provided by the in-memory stand-in
+// in memreg.hpp.
 //
 // Unicode UTF-16 strings are represented using the std::wstring class;
 // ATL's CString is not used, to avoid dependencies from ATL or MFC.
@@ -51,18 +56,371 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-#include <Windows.h> // Windows Platform SDK
-#include <crtdbg.h>  // _ASSERTE
+#include "regdefs.hpp" // Windows Platform SDK, RegException
+#ifdef _WIN32
+#include <crtdbg.h>      // _ASSERTE
+#else
+#include "memreg.hpp"    // In-memory stand-in for the registry C API
+#endif
 
+#include <cstddef>   // std::ptrdiff_t
+#include <cstring>   // memcpy
+#include <iterator>  // std::forward_iterator_tag, std::size
 #include <memory>    // std::unique_ptr
-#include <stdexcept> // std::runtime_error
 #include <string>    // std::wstring
-#include <utility>   // std::swap, std::pair
+#include <string_view> // std::wstring_view
+#include <utility>   // std::swap, std::pair, std::forward
+#include <variant>   // std::variant
 #include <vector>    // std::vector
 
 namespace winreg
 {
 
+//------------------------------------------------------------------------------
+// Data of a registry value, decoded according to the value type:
+//
+//  REG_DWORD               -> DWORD
+//  REG_QWORD               -> ULONGLONG
+//  REG_SZ, REG_EXPAND_SZ   -> std::wstring (not expanded)
+//  REG_MULTI_SZ            -> std::vector<std::wstring>
+//  anything else           -> std::vector<BYTE> (the raw bytes)
+//
+// DWORD and QWORD values with a data size that doesn't match their type are
+// returned as raw bytes as well.
+//------------------------------------------------------------------------------
+using RegValueData = std::variant<
+    std::vector<BYTE>,
+    DWORD,
+    ULONGLONG,
+    std::wstring,
+    std::vector<std::wstring>>;
+
+// A registry value name with its type and decoded data
+struct RegValue
+{
+    std::wstring name;
+    DWORD type{REG_NONE};
+    RegValueData data;
+};
+
+//------------------------------------------------------------------------------
+// A list of subkey or value names stored back to back in one buffer, with an
+// index of (offset, length, type) entries: enumerating a key costs two
+// growing allocations rather than one per name. Names are accessed as
+// std::wstring_views into the buffer, valid until the list is changed.
+//------------------------------------------------------------------------------
+class NameList
+{
+  public:
+    struct Entry
+    {
+        DWORD offset; // in wchar_ts, into the name buffer
+        DWORD length; // in wchar_ts, without a terminating NUL
+        DWORD type;   // value type (REG_xxx); REG_NONE for subkeys
+    };
+
+    // An entry resolved against the name buffer
+    struct Item
+    {
+        std::wstring_view name;
+        DWORD type;
+    };
+
+    class const_iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Item;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Item;
+
+        const_iterator(const NameList *list, size_t index) noexcept
+            : m_list{list}, m_index{index}
+        {
+        }
+
+        Item operator*() const noexcept
+        {
+            return (*m_list)[m_index];
+        }
+
+        const_iterator &operator++() noexcept
+        {
+            ++m_index;
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept
+        {
+            const_iterator old = *this;
+            ++m_index;
+            return old;
+        }
+
+        bool operator==(const const_iterator &other) const noexcept
+        {
+            return m_index == other.m_index;
+        }
+
+        bool operator!=(const const_iterator &other) const noexcept
+        {
+            return m_index != other.m_index;
+        }
+
+      private:
+        const NameList *m_list;
+        size_t m_index;
+    };
+
+    size_t size() const noexcept
+    {
+        return m_entries.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return m_entries.empty();
+    }
+
+    Item operator[](const size_t index) const noexcept
+    {
+        const Entry &entry = m_entries[index];
+        return Item{std::wstring_view{m_chars.data() + entry.offset, entry.length}, entry.type};
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator{this, 0};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator{this, m_entries.size()};
+    }
+
+    // The raw index and name buffer
+    const std::vector<Entry> &Entries() const noexcept
+    {
+        return m_entries;
+    }
+
+    const std::vector<wchar_t> &Chars() const noexcept
+    {
+        return m_chars;
+    }
+
+    // Empty the list, keeping its memory for reuse
+    void Clear() noexcept
+    {
+        m_entries.clear();
+        m_chars.clear();
+    }
+
+    void Reserve(const size_t names, const size_t chars)
+    {
+        m_entries.reserve(names);
+        m_chars.reserve(chars);
+    }
+
+    void Append(const wchar_t *const name, const size_t length, const DWORD type = REG_NONE)
+    {
+        m_entries.push_back(Entry{static_cast<DWORD>(m_chars.size()), static_cast<DWORD>(length), type});
+        m_chars.insert(m_chars.end(), name, name + length);
+    }
+
+  private:
+    std::vector<Entry> m_entries;
+    std::vector<wchar_t> m_chars;
+};
+
+//------------------------------------------------------------------------------
+// Subkeys enumerated together with their metadata, as parallel arrays: the
+// i-th subkey is names[i], last written at lastWriteTimes[i]. The subkey and
+// value counts are only filled on request, and left empty otherwise.
+//------------------------------------------------------------------------------
+struct SubKeyDetails
+{
+    NameList names;
+    std::vector<FILETIME> lastWriteTimes;
+    std::vector<DWORD> subKeyCounts;
+    std::vector<DWORD> valueCounts;
+};
+
+//------------------------------------------------------------------------------
+// The outcome of a Try* method of RegKey: the error code returned by the
+// Windows registry API and, on failure, a static description of the call
+// that failed (the message of the RegException the throwing method throws).
+//------------------------------------------------------------------------------
+class RegResult
+{
+  public:
+    RegResult() noexcept = default;
+
+    explicit RegResult(const LONG errorCode, const char *const message = "") noexcept
+        : m_errorCode{errorCode}, m_message{message}
+    {
+    }
+
+    bool IsOk() const noexcept
+    {
+        return m_errorCode == ERROR_SUCCESS;
+    }
+
+    bool Failed() const noexcept
+    {
+        return m_errorCode != ERROR_SUCCESS;
+    }
+
+    // Same as IsOk(), to allow "if (result)"
+    explicit operator bool() const noexcept
+    {
+        return IsOk();
+    }
+
+    // Get the error code returned by Windows registry APIs
+    LONG Code() const noexcept
+    {
+        return m_errorCode;
+    }
+
+    const char *Message() const noexcept
+    {
+        return m_message;
+    }
+
+    // Throw a failure as RegException; do nothing on success
+    void ThrowIfFailed() const
+    {
+        if (Failed())
+        {
+            throw RegException{m_message, m_errorCode};
+        }
+    }
+
+  private:
+    LONG m_errorCode{ERROR_SUCCESS};
+    const char *m_message{""};
+};
+
+//------------------------------------------------------------------------------
+// The value of type T read by a Try* method of RegKey, or the RegResult of
+// its failure
+//------------------------------------------------------------------------------
+template <typename T>
+class RegExpected
+{
+  public:
+    RegExpected(const RegResult &error) noexcept
+        : m_result{error}
+    {
+        _ASSERTE(error.Failed());
+    }
+
+    RegExpected(T value)
+        : m_value{std::move(value)}
+    {
+    }
+
+    bool IsValid() const noexcept
+    {
+        return m_result.IsOk();
+    }
+
+    // Same as IsValid(), to allow "if (expected)"
+    explicit operator bool() const noexcept
+    {
+        return IsValid();
+    }
+
+    const RegResult &GetError() const noexcept
+    {
+        return m_result;
+    }
+
+    // The value; on failure, throw it as RegException
+    const T &GetValue() const &
+    {
+        m_result.ThrowIfFailed();
+        return m_value;
+    }
+
+    T GetValue() &&
+    {
+        m_result.ThrowIfFailed();
+        return std::move(m_value);
+    }
+
+  private:
+    RegResult m_result;
+    T m_value{};
+};
+
+namespace details
+{
+
+// Decode raw registry value data as described for RegValueData
+inline RegValueData DecodeValueData(const DWORD type, const BYTE *const data, const DWORD dataSize)
+{
+    switch (type)
+    {
+    case REG_DWORD:
+        if (dataSize == sizeof(DWORD))
+        {
+            DWORD value{};
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+        break;
+
+    case REG_QWORD:
+        if (dataSize == sizeof(ULONGLONG))
+        {
+            ULONGLONG value{};
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+        break;
+
+    case REG_SZ:
+    case REG_EXPAND_SZ:
+    {
+        // Stop at the first NUL; the data may or may not be terminated
+        const auto *chars = reinterpret_cast<const wchar_t *>(data);
+        const size_t count = dataSize / sizeof(wchar_t);
+        size_t length = 0;
+        while (length < count && chars[length] != L'\0')
+            length++;
+        return std::wstring{chars, length};
+    }
+
+    case REG_MULTI_SZ:
+    {
+        // Parse the double-NUL-terminated strings, tolerating missing terminators
+        const auto *chars = reinterpret_cast<const wchar_t *>(data);
+        const size_t count = dataSize / sizeof(wchar_t);
+        std::vector<std::wstring> strings;
+        size_t start = 0;
+        while (start < count && chars[start] != L'\0')
+        {
+            size_t end = start;
+            while (end < count && chars[end] != L'\0')
+                end++;
+            strings.push_back(std::wstring{chars + start, end - start});
+            start = end + 1;
+        }
+        return strings;
+    }
+
+    default:
+        break;
+    }
+
+    return std::vector<BYTE>(data, data + dataSize);
+}
+
+} // namespace details
+
 //------------------------------------------------------------------------------
 // Safe, efficient and convenient C++ wrapper around HKEY registry key handles.
 //
@@ -185,6 +543,29 @@ class RegKey
         const std::wstring &subKey,
         REGSAM desiredAccess = KEY_READ);
 
+    // Non-throwing versions of Create() and Open(), and of the setters,
+    // getters and enumerations below: they return a failure (e.g.
+    // ERROR_FILE_NOT_FOUND for a missing key or value) as a RegResult
+    // instead of throwing it, which is far cheaper when misses are common.
+    // The throwing methods are built on them.
+    RegResult TryCreate(
+        HKEY hKeyParent,
+        const std::wstring &subKey,
+        REGSAM desiredAccess = KEY_READ | KEY_WRITE);
+
+    RegResult TryCreate(
+        HKEY hKeyParent,
+        const std::wstring &subKey,
+        REGSAM desiredAccess,
+        DWORD options,
+        SECURITY_ATTRIBUTES *securityAttributes,
+        DWORD *disposition);
+
+    RegResult TryOpen(
+        HKEY hKeyParent,
+        const std::wstring &subKey,
+        REGSAM desiredAccess = KEY_READ);
+
     //
     // Registry Value Setters
     //
@@ -197,6 +578,14 @@ class RegKey
     void SetBinaryValue(const std::wstring &valueName, const std::vector<BYTE> &data);
     void SetBinaryValue(const std::wstring &valueName, const void *data, DWORD dataSize);
 
+    RegResult TrySetDwordValue(const std::wstring &valueName, DWORD data);
+    RegResult TrySetQwordValue(const std::wstring &valueName, const ULONGLONG &data);
+    RegResult TrySetStringValue(const std::wstring &valueName, const std::wstring &data);
+    RegResult TrySetExpandStringValue(const std::wstring &valueName, const std::wstring &data);
+    RegResult TrySetMultiStringValue(const std::wstring &valueName, const std::vector<std::wstring> &data);
+    RegResult TrySetBinaryValue(const std::wstring &valueName, const std::vector<BYTE> &data);
+    RegResult TrySetBinaryValue(const std::wstring &valueName, const void *data, DWORD dataSize);
+
     //
     // Registry Value Getters
     //
@@ -218,15 +607,52 @@ class RegKey
     std::vector<std::wstring> GetMultiStringValue(const std::wstring &valueName);
     std::vector<BYTE> GetBinaryValue(const std::wstring &valueName);
 
+    // Read a value of any type, reading its type and data with a single
+    // RegGetValue call; see RegValueData for how the data is decoded.
+    // With ExpandStringOption::Expand, REG_EXPAND_SZ values are expanded.
+    // If type is not null, it receives the REG_xxx type of the value.
+    RegValueData GetValue(
+        const std::wstring &valueName,
+        ExpandStringOption expandOption = ExpandStringOption::DontExpand,
+        DWORD *type = nullptr);
+
+    // Size in bytes of a REG_BINARY value, to size the buffer passed to the
+    // GetBinaryValue() overload below
+    DWORD GetBinaryValueSize(const std::wstring &valueName);
+
+    // Read a REG_BINARY value into a caller-provided buffer of bufferSize
+    // bytes, and return the number of bytes read.
+    // Throw RegException with ERROR_MORE_DATA if the buffer is too small.
+    DWORD GetBinaryValue(const std::wstring &valueName, void *buffer, DWORD bufferSize);
+
+    RegExpected<DWORD> TryGetDwordValue(const std::wstring &valueName);
+    RegExpected<ULONGLONG> TryGetQwordValue(const std::wstring &valueName);
+    RegExpected<std::wstring> TryGetStringValue(const std::wstring &valueName);
+    RegExpected<std::wstring> TryGetExpandStringValue(
+        const std::wstring &valueName,
+        ExpandStringOption expandOption = ExpandStringOption::DontExpand);
+    RegExpected<std::vector<std::wstring>> TryGetMultiStringValue(const std::wstring &valueName);
+    RegExpected<std::vector<BYTE>> TryGetBinaryValue(const std::wstring &valueName);
+    RegExpected<DWORD> TryGetBinaryValueSize(const std::wstring &valueName);
+    RegExpected<DWORD> TryGetBinaryValue(const std::wstring &valueName, void *buffer, DWORD bufferSize);
+    RegExpected<RegValueData> TryGetValue(
+        const std::wstring &valueName,
+        ExpandStringOption expandOption = ExpandStringOption::DontExpand,
+        DWORD *type = nullptr);
+
     //
     // Query Operations
     //
 
     void QueryInfoKey(DWORD &subKeys, DWORD &values, FILETIME &lastWriteTime);
 
-    // Return the DWORD type ID for the input registry value
+    // Return the DWORD type ID for the input registry value,
+    // REG_NONE if there is no such value
     DWORD QueryValueType(const std::wstring &valueName);
 
+    // Same, but ERROR_FILE_NOT_FOUND if there is no such value
+    RegExpected<DWORD> TryQueryValueType(const std::wstring &valueName);
+
     // Enumerate the subkeys of the registry key, using RegEnumKeyEx
     std::vector<std::wstring> EnumSubKeys();
 
@@ -235,6 +661,58 @@ class RegKey
     // the DWORD is the value type.
     std::vector<std::pair<std::wstring, DWORD>> EnumValues();
 
+    // Enumerate the values under the registry key together with their data,
+    // in a single RegEnumValue pass with one data buffer sized from
+    // RegQueryInfoKey (and grown if a value outgrows it, failing with
+    // ERROR_MORE_DATA if it keeps growing); see RegValueData for how the data
+    // is decoded.
+    std::vector<RegValue> EnumValuesWithData();
+
+    RegExpected<std::vector<std::wstring>> TryEnumSubKeys();
+    RegExpected<std::vector<std::pair<std::wstring, DWORD>>> TryEnumValues();
+    RegExpected<std::vector<RegValue>> TryEnumValuesWithData();
+
+    // Call f(name, type, data, size) for every value, in order, with its data
+    // as RegEnumValue returns it (strings in wchar_t, as stored: embedded or
+    // missing NULs are kept); data is only valid during the call. Same single
+    // pass as EnumValuesWithData.
+    template <typename F>
+    void ForEachRawValue(F &&f);
+
+    template <typename F>
+    RegResult TryForEachRawValue(F &&f);
+
+    // Enumerate the subkey names, or the value names and types, into a
+    // NameList (replacing its content): all the names share one buffer.
+    // Keys and values deleted or added while enumerating are tolerated.
+    void EnumSubKeys(NameList &subKeys);
+    void EnumValues(NameList &values);
+    RegResult TryEnumSubKeys(NameList &subKeys);
+    RegResult TryEnumValues(NameList &values);
+
+    // Enumerate at most count subkeys or values from the index start on, into
+    // a NameList (replacing its content); fewer are returned at the end.
+    // Paging through a key costs one registry call per entry and one list of
+    // memory, but indexes shift if the key changes between pages.
+    void EnumSubKeys(DWORD start, DWORD count, NameList &subKeys);
+    void EnumValues(DWORD start, DWORD count, NameList &values);
+    RegResult TryEnumSubKeys(DWORD start, DWORD count, NameList &subKeys);
+    RegResult TryEnumValues(DWORD start, DWORD count, NameList &values);
+
+    enum class SubKeyCountsOption
+    {
+        Skip,
+        Query
+    };
+
+    // Enumerate the subkeys with their last write times, which RegEnumKeyEx
+    // returns along with the names. With SubKeyCountsOption::Query, each
+    // subkey is also opened for its subkey and value counts (0 for subkeys
+    // deleted meanwhile or not readable).
+    SubKeyDetails EnumSubKeysDetailed(SubKeyCountsOption countsOption = SubKeyCountsOption::Skip);
+    RegExpected<SubKeyDetails> TryEnumSubKeysDetailed(
+        SubKeyCountsOption countsOption = SubKeyCountsOption::Skip);
+
     //
     // Misc Registry API Wrappers
     //
@@ -258,33 +736,23 @@ class RegKey
     //
 
   private:
-    // The wrapped registry key handle
-    HKEY m_hKey{nullptr};
-};
+    // Values up to this many bytes are read with a single RegGetValue call
+    static constexpr DWORD kScratchBufferSize = 512;
 
-//------------------------------------------------------------------------------
-// An exception representing an error with the registry operations
-//------------------------------------------------------------------------------
-class RegException
-    : public std::runtime_error
-{
-  public:
-    RegException(const std::string &message, LONG errorCode)
-        : std::runtime_error(""), m_message(message + " code=" + std::to_string(errorCode)), m_errorCode{errorCode}
-    {
-    }
+    // Entry count to page through a whole key
+    static constexpr DWORD kAllEntries = ~DWORD{0};
 
-    // Get the error code returned by Windows registry APIs
-    LONG ErrorCode() const noexcept
-    {
-        return m_errorCode;
-    }
+    // Read a value into data (a std::wstring or a std::vector of wchar_t or
+    // BYTE), sized to the number of bytes read, and its type into *type if
+    // not null. The value is first read into a scratch buffer on the stack;
+    // only if RegGetValue reports ERROR_MORE_DATA is data sized from the
+    // reported size and read again. Return the RegGetValue error code.
+    template <typename Container>
+    LONG GetValueData(const std::wstring &valueName, DWORD flags, Container &data,
+                      DWORD *type = nullptr);
 
-    virtual const char* what() const noexcept { return m_message.c_str(); }
-  private:
-    std::string m_message;
-    // Error code, as returned by Windows registry APIs
-    LONG m_errorCode;
+    // The wrapped registry key handle
+    HKEY m_hKey{nullptr};
 };
 
 //------------------------------------------------------------------------------
@@ -462,7 +930,20 @@ inline void RegKey::Create(
     );
 }
 
-inline void RegKey::Create(
+inline RegResult RegKey::TryCreate(
+    const HKEY hKeyParent,
+    const std::wstring &subKey,
+    const REGSAM desiredAccess)
+{
+    constexpr DWORD kDefaultOptions = REG_OPTION_NON_VOLATILE;
+
+    return TryCreate(hKeyParent, subKey, desiredAccess, kDefaultOptions,
+                     nullptr, // no security attributes,
+                     nullptr  // no disposition
+    );
+}
+
+inline RegResult RegKey::TryCreate(
     const HKEY hKeyParent,
     const std::wstring &subKey,
     const REGSAM desiredAccess,
@@ -483,7 +964,7 @@ inline void RegKey::Create(
         disposition);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"RegCreateKeyEx failed.", retCode};
+        return RegResult{retCode, "RegCreateKeyEx failed."};
     }
 
     // Safely close any previously opened key
@@ -491,9 +972,23 @@ inline void RegKey::Create(
 
     // Take ownership of the newly created key
     m_hKey = hKey;
+
+    return RegResult{};
 }
 
-inline void RegKey::Open(
+inline void RegKey::Create(
+    const HKEY hKeyParent,
+    const std::wstring &subKey,
+    const REGSAM desiredAccess,
+    const DWORD options,
+    SECURITY_ATTRIBUTES *const securityAttributes,
+    DWORD *const disposition)
+{
+    TryCreate(hKeyParent, subKey, desiredAccess, options, securityAttributes, disposition)
+        .ThrowIfFailed();
+}
+
+inline RegResult RegKey::TryOpen(
     const HKEY hKeyParent,
     const std::wstring &subKey,
     const REGSAM desiredAccess)
@@ -511,14 +1006,24 @@ inline void RegKey::Open(
         &hKey);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"RegOpenKeyEx failed.", retCode};
+        return RegResult{retCode, "RegOpenKeyEx failed."};
     }
 
     // Take ownership of the newly created key
     m_hKey = hKey;
+
+    return RegResult{};
 }
 
-inline void RegKey::SetDwordValue(const std::wstring &valueName, const DWORD data)
+inline void RegKey::Open(
+    const HKEY hKeyParent,
+    const std::wstring &subKey,
+    const REGSAM desiredAccess)
+{
+    TryOpen(hKeyParent, subKey, desiredAccess).ThrowIfFailed();
+}
+
+inline RegResult RegKey::TrySetDwordValue(const std::wstring &valueName, const DWORD data)
 {
     _ASSERTE(IsValid());
 
@@ -531,11 +1036,18 @@ inline void RegKey::SetDwordValue(const std::wstring &valueName, const DWORD dat
         sizeof(data));
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot write DWORD value: RegSetValueEx failed.", retCode};
+        return RegResult{retCode, "Cannot write DWORD value: RegSetValueEx failed."};
     }
+
+    return RegResult{};
 }
 
-inline void RegKey::SetQwordValue(const std::wstring &valueName, const ULONGLONG &data)
+inline void RegKey::SetDwordValue(const std::wstring &valueName, const DWORD data)
+{
+    TrySetDwordValue(valueName, data).ThrowIfFailed();
+}
+
+inline RegResult RegKey::TrySetQwordValue(const std::wstring &valueName, const ULONGLONG &data)
 {
     _ASSERTE(IsValid());
 
@@ -548,11 +1060,18 @@ inline void RegKey::SetQwordValue(const std::wstring &valueName, const ULONGLONG
         sizeof(data));
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot write QWORD value: RegSetValueEx failed.", retCode};
+        return RegResult{retCode, "Cannot write QWORD value: RegSetValueEx failed."};
     }
+
+    return RegResult{};
 }
 
-inline void RegKey::SetStringValue(const std::wstring &valueName, const std::wstring &data)
+inline void RegKey::SetQwordValue(const std::wstring &valueName, const ULONGLONG &data)
+{
+    TrySetQwordValue(valueName, data).ThrowIfFailed();
+}
+
+inline RegResult RegKey::TrySetStringValue(const std::wstring &valueName, const std::wstring &data)
 {
     _ASSERTE(IsValid());
 
@@ -568,11 +1087,18 @@ inline void RegKey::SetStringValue(const std::wstring &valueName, const std::wst
         dataSize);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot write string value: RegSetValueEx failed.", retCode};
+        return RegResult{retCode, "Cannot write string value: RegSetValueEx failed."};
     }
+
+    return RegResult{};
 }
 
-inline void RegKey::SetExpandStringValue(const std::wstring &valueName, const std::wstring &data)
+inline void RegKey::SetStringValue(const std::wstring &valueName, const std::wstring &data)
+{
+    TrySetStringValue(valueName, data).ThrowIfFailed();
+}
+
+inline RegResult RegKey::TrySetExpandStringValue(const std::wstring &valueName, const std::wstring &data)
 {
     _ASSERTE(IsValid());
 
@@ -588,8 +1114,15 @@ inline void RegKey::SetExpandStringValue(const std::wstring &valueName, const st
         dataSize);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot write expand string value: RegSetValueEx failed.", retCode};
+        return RegResult{retCode, "Cannot write expand string value: RegSetValueEx failed."};
     }
+
+    return RegResult{};
+}
+
+inline void RegKey::SetExpandStringValue(const std::wstring &valueName, const std::wstring &data)
+{
+    TrySetExpandStringValue(valueName, data).ThrowIfFailed();
 }
 
 namespace details
@@ -637,7 +1170,7 @@ inline std::vector<wchar_t> BuildMultiString(const std::vector<std::wstring> &da
 
 } // namespace details
 
-inline void RegKey::SetMultiStringValue(
+inline RegResult RegKey::TrySetMultiStringValue(
     const std::wstring &valueName,
     const std::vector<std::wstring> &data)
 {
@@ -658,11 +1191,20 @@ inline void RegKey::SetMultiStringValue(
         dataSize);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot write multi-string value: RegSetValueEx failed.", retCode};
+        return RegResult{retCode, "Cannot write multi-string value: RegSetValueEx failed."};
     }
+
+    return RegResult{};
 }
 
-inline void RegKey::SetBinaryValue(const std::wstring &valueName, const std::vector<BYTE> &data)
+inline void RegKey::SetMultiStringValue(
+    const std::wstring &valueName,
+    const std::vector<std::wstring> &data)
+{
+    TrySetMultiStringValue(valueName, data).ThrowIfFailed();
+}
+
+inline RegResult RegKey::TrySetBinaryValue(const std::wstring &valueName, const std::vector<BYTE> &data)
 {
     _ASSERTE(IsValid());
 
@@ -678,11 +1220,18 @@ inline void RegKey::SetBinaryValue(const std::wstring &valueName, const std::vec
         dataSize);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot write binary data value: RegSetValueEx failed.", retCode};
+        return RegResult{retCode, "Cannot write binary data value: RegSetValueEx failed."};
     }
+
+    return RegResult{};
 }
 
-inline void RegKey::SetBinaryValue(
+inline void RegKey::SetBinaryValue(const std::wstring &valueName, const std::vector<BYTE> &data)
+{
+    TrySetBinaryValue(valueName, data).ThrowIfFailed();
+}
+
+inline RegResult RegKey::TrySetBinaryValue(
     const std::wstring &valueName,
     const void *const data,
     const DWORD dataSize)
@@ -698,11 +1247,21 @@ inline void RegKey::SetBinaryValue(
         dataSize);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot write binary data value: RegSetValueEx failed.", retCode};
+        return RegResult{retCode, "Cannot write binary data value: RegSetValueEx failed."};
     }
+
+    return RegResult{};
 }
 
-inline DWORD RegKey::GetDwordValue(const std::wstring &valueName)
+inline void RegKey::SetBinaryValue(
+    const std::wstring &valueName,
+    const void *const data,
+    const DWORD dataSize)
+{
+    TrySetBinaryValue(valueName, data, dataSize).ThrowIfFailed();
+}
+
+inline RegExpected<DWORD> RegKey::TryGetDwordValue(const std::wstring &valueName)
 {
     _ASSERTE(IsValid());
 
@@ -720,13 +1279,18 @@ inline DWORD RegKey::GetDwordValue(const std::wstring &valueName)
         &dataSize);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot get DWORD value: RegGetValue failed.", retCode};
+        return RegResult{retCode, "Cannot get DWORD value: RegGetValue failed."};
     }
 
     return data;
 }
 
-inline ULONGLONG RegKey::GetQwordValue(const std::wstring &valueName)
+inline DWORD RegKey::GetDwordValue(const std::wstring &valueName)
+{
+    return TryGetDwordValue(valueName).GetValue();
+}
+
+inline RegExpected<ULONGLONG> RegKey::TryGetQwordValue(const std::wstring &valueName)
 {
     _ASSERTE(IsValid());
 
@@ -744,59 +1308,43 @@ inline ULONGLONG RegKey::GetQwordValue(const std::wstring &valueName)
         &dataSize);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot get QWORD value: RegGetValue failed.", retCode};
+        return RegResult{retCode, "Cannot get QWORD value: RegGetValue failed."};
     }
 
     return data;
 }
 
-inline std::wstring RegKey::GetStringValue(const std::wstring &valueName)
+inline ULONGLONG RegKey::GetQwordValue(const std::wstring &valueName)
 {
-    _ASSERTE(IsValid());
+    return TryGetQwordValue(valueName).GetValue();
+}
 
-    // Get the size of the result string
-    DWORD dataSize = 0; // size of data, in bytes
-    const DWORD flags = RRF_RT_REG_SZ;
-    LONG retCode = ::RegGetValue(
-        m_hKey,
-        nullptr, // no subkey
-        valueName.c_str(),
-        flags,
-        nullptr, // type not required
-        nullptr, // output buffer not needed now
-        &dataSize);
-    if (retCode != ERROR_SUCCESS)
-    {
-        throw RegException{"Cannot get size of string value: RegGetValue failed.", retCode};
-    }
+inline RegExpected<std::wstring> RegKey::TryGetStringValue(const std::wstring &valueName)
+{
+    _ASSERTE(IsValid());
 
-    // Allocate a string of proper size.
-    // Note that dataSize is in bytes and includes the terminating NUL;
-    // we have to convert the size from bytes to wchar_ts for wstring::resize.
     std::wstring result;
-    result.resize(dataSize / sizeof(wchar_t));
-
-    // Call RegGetValue for the second time to read the string's content
-    retCode = ::RegGetValue(
-        m_hKey,
-        nullptr, // no subkey
-        valueName.c_str(),
-        flags,
-        nullptr,    // type not required
-        &result[0], // output buffer
-        &dataSize);
+    LONG retCode = GetValueData(valueName, RRF_RT_REG_SZ, result);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot get string value: RegGetValue failed.", retCode};
+        return RegResult{retCode, "Cannot get string value: RegGetValue failed."};
     }
 
     // Remove the NUL terminator scribbled by RegGetValue from the wstring
-    result.resize((dataSize / sizeof(wchar_t)) - 1);
+    if (!result.empty())
+    {
+        result.pop_back();
+    }
 
     return result;
 }
 
-inline std::wstring RegKey::GetExpandStringValue(
+inline std::wstring RegKey::GetStringValue(const std::wstring &valueName)
+{
+    return TryGetStringValue(valueName).GetValue();
+}
+
+inline RegExpected<std::wstring> RegKey::TryGetExpandStringValue(
     const std::wstring &valueName,
     const ExpandStringOption expandOption)
 {
@@ -810,95 +1358,48 @@ inline std::wstring RegKey::GetExpandStringValue(
         flags |= RRF_NOEXPAND;
     }
 
-    // Get the size of the result string
-    DWORD dataSize = 0; // size of data, in bytes
-    LONG retCode = ::RegGetValueW(
-        m_hKey,
-        nullptr, // no subkey
-        valueName.c_str(),
-        flags,
-        nullptr, // type not required
-        nullptr, // output buffer not needed now
-        &dataSize);
-    if (retCode != ERROR_SUCCESS)
-    {
-        throw RegException{"Cannot get size of expand string value: RegGetValue failed.", retCode};
-    }
-
-    // Allocate a string of proper size.
-    // Note that dataSize is in bytes and includes the terminating NUL.
-    // We must convert from bytes to wchar_ts for wstring::resize.
     std::wstring result;
-    result.resize(dataSize / sizeof(wchar_t));
-
-    // Call RegGetValue for the second time to read the string's content
-    retCode = ::RegGetValueW(
-        m_hKey,
-        nullptr, // no subkey
-        valueName.c_str(),
-        flags,
-        nullptr,    // type not required
-        &result[0], // output buffer
-        &dataSize);
+    LONG retCode = GetValueData(valueName, flags, result);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot get expand string value: RegGetValue failed.", retCode};
+        return RegResult{retCode, "Cannot get expand string value: RegGetValue failed."};
     }
 
     // Remove the NUL terminator scribbled by RegGetValue from the wstring
-    result.resize((dataSize / sizeof(wchar_t)) - 1);
+    if (!result.empty())
+    {
+        result.pop_back();
+    }
 
     return result;
 }
 
-inline std::vector<std::wstring> RegKey::GetMultiStringValue(const std::wstring &valueName)
+inline std::wstring RegKey::GetExpandStringValue(
+    const std::wstring &valueName,
+    const ExpandStringOption expandOption)
 {
-    _ASSERTE(IsValid());
+    return TryGetExpandStringValue(valueName, expandOption).GetValue();
+}
 
-    // Request the size of the multi-string, in bytes
-    DWORD dataSize = 0;
-    const DWORD flags = RRF_RT_REG_MULTI_SZ;
-    LONG retCode = ::RegGetValue(
-        m_hKey,
-        nullptr, // no subkey
-        valueName.c_str(),
-        flags,
-        nullptr, // type not required
-        nullptr, // output buffer not needed now
-        &dataSize);
-    if (retCode != ERROR_SUCCESS)
-    {
-        throw RegException{"Cannot get size of multi-string value: RegGetValue failed.", retCode};
-    }
+inline RegExpected<std::vector<std::wstring>> RegKey::TryGetMultiStringValue(const std::wstring &valueName)
+{
+    _ASSERTE(IsValid());
 
-    // Allocate room for the result multi-string.
-    // Note that dataSize is in bytes, but our vector<wchar_t>::resize method requires size
-    // to be expressed in wchar_ts.
+    // Read the multi-string from the registry into a vector of wchar_ts
     std::vector<wchar_t> data;
-    data.resize(dataSize / sizeof(wchar_t));
-
-    // Read the multi-string from the registry into the vector object
-    retCode = ::RegGetValue(
-        m_hKey,
-        nullptr, // no subkey
-        valueName.c_str(),
-        flags,
-        nullptr,  // no type required
-        &data[0], // output buffer
-        &dataSize);
+    LONG retCode = GetValueData(valueName, RRF_RT_REG_MULTI_SZ, data);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot get multi-string value: RegGetValue failed.", retCode};
+        return RegResult{retCode, "Cannot get multi-string value: RegGetValue failed."};
     }
 
-    // Resize vector to the actual size returned by GetRegValue.
-    // Note that the vector is a vector of wchar_ts, instead the size returned by GetRegValue
-    // is in bytes, so we have to scale from bytes to wchar_t count.
-    data.resize(dataSize / sizeof(wchar_t));
-
     // Parse the double-NUL-terminated string into a vector<wstring>,
     // which will be returned to the caller
     std::vector<std::wstring> result;
+    if (data.empty())
+    {
+        return result;
+    }
     const wchar_t *currStringPtr = &data[0];
     while (*currStringPtr != L'\0')
     {
@@ -915,47 +1416,189 @@ inline std::vector<std::wstring> RegKey::GetMultiStringValue(const std::wstring
     return result;
 }
 
+inline std::vector<std::wstring> RegKey::GetMultiStringValue(const std::wstring &valueName)
+{
+    return TryGetMultiStringValue(valueName).GetValue();
+}
+
+inline RegExpected<std::vector<BYTE>> RegKey::TryGetBinaryValue(const std::wstring &valueName)
+{
+    _ASSERTE(IsValid());
+
+    std::vector<BYTE> data;
+    LONG retCode = GetValueData(valueName, RRF_RT_REG_BINARY, data);
+    if (retCode != ERROR_SUCCESS)
+    {
+        return RegResult{retCode, "Cannot get binary data: RegGetValue failed."};
+    }
+
+    return data;
+}
+
 inline std::vector<BYTE> RegKey::GetBinaryValue(const std::wstring &valueName)
+{
+    return TryGetBinaryValue(valueName).GetValue();
+}
+
+template <typename Container>
+inline LONG RegKey::GetValueData(
+    const std::wstring &valueName,
+    const DWORD flags,
+    Container &data,
+    DWORD *const type)
+{
+    using Unit = typename Container::value_type;
+
+    // Most values fit: read them with a single call
+    alignas(Unit) BYTE scratch[kScratchBufferSize];
+    DWORD dataSize = sizeof(scratch); // in: buffer size; out: size of data, in bytes
+    LONG retCode = ::RegGetValue(
+        m_hKey,
+        nullptr, // no subkey
+        valueName.c_str(),
+        flags,
+        type,
+        scratch,
+        &dataSize);
+    if (retCode == ERROR_SUCCESS)
+    {
+        const Unit *begin = reinterpret_cast<const Unit *>(scratch);
+        data.assign(begin, begin + dataSize / sizeof(Unit));
+        return retCode;
+    }
+
+    // Too large: dataSize is the size needed. Read straight into data, again
+    // if the value grew meanwhile; grow geometrically should the reported
+    // size be too small (e.g. for an expanded string).
+    DWORD bufferSize = sizeof(scratch);
+    while (retCode == ERROR_MORE_DATA)
+    {
+        bufferSize = dataSize > bufferSize ? dataSize : bufferSize * 2;
+        data.resize((bufferSize + sizeof(Unit) - 1) / sizeof(Unit));
+        dataSize = static_cast<DWORD>(data.size() * sizeof(Unit));
+        retCode = ::RegGetValue(
+            m_hKey,
+            nullptr, // no subkey
+            valueName.c_str(),
+            flags,
+            type,
+            &data[0], // output buffer
+            &dataSize);
+    }
+    if (retCode == ERROR_SUCCESS)
+    {
+        data.resize(dataSize / sizeof(Unit));
+    }
+
+    return retCode;
+}
+
+inline RegExpected<RegValueData> RegKey::TryGetValue(
+    const std::wstring &valueName,
+    const ExpandStringOption expandOption,
+    DWORD *const type)
+{
+    _ASSERTE(IsValid());
+
+    // Expanded REG_EXPAND_SZ values come back as REG_SZ, which RRF_RT_REG_SZ
+    // accepts: ask for REG_EXPAND_SZ only when not expanding
+    DWORD flags = RRF_RT_ANY;
+    if (expandOption == ExpandStringOption::DontExpand)
+    {
+        flags |= RRF_NOEXPAND;
+    }
+    else
+    {
+        flags &= ~RRF_RT_REG_EXPAND_SZ;
+    }
+
+    DWORD valueType = REG_NONE;
+    std::vector<BYTE> data;
+    LONG retCode = GetValueData(valueName, flags, data, &valueType);
+    if (retCode != ERROR_SUCCESS)
+    {
+        return RegResult{retCode, "Cannot get value: RegGetValue failed."};
+    }
+
+    if (type != nullptr)
+    {
+        *type = valueType;
+    }
+    return details::DecodeValueData(valueType, data.data(), static_cast<DWORD>(data.size()));
+}
+
+inline RegValueData RegKey::GetValue(
+    const std::wstring &valueName,
+    const ExpandStringOption expandOption,
+    DWORD *const type)
+{
+    return TryGetValue(valueName, expandOption, type).GetValue();
+}
+
+inline RegExpected<DWORD> RegKey::TryGetBinaryValueSize(const std::wstring &valueName)
 {
     _ASSERTE(IsValid());
 
-    // Get the size of the binary data
     DWORD dataSize = 0; // size of data, in bytes
-    const DWORD flags = RRF_RT_REG_BINARY;
     LONG retCode = ::RegGetValue(
         m_hKey,
         nullptr, // no subkey
         valueName.c_str(),
-        flags,
+        RRF_RT_REG_BINARY,
         nullptr, // type not required
         nullptr, // output buffer not needed now
         &dataSize);
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot get size of binary data: RegGetValue failed.", retCode};
+        return RegResult{retCode, "Cannot get size of binary data: RegGetValue failed."};
     }
 
-    // Allocate a buffer of proper size to store the binary data
-    std::vector<BYTE> data(dataSize);
+    return dataSize;
+}
 
-    // Call RegGetValue for the second time to read the data content
-    retCode = ::RegGetValue(
+inline DWORD RegKey::GetBinaryValueSize(const std::wstring &valueName)
+{
+    return TryGetBinaryValueSize(valueName).GetValue();
+}
+
+inline RegExpected<DWORD> RegKey::TryGetBinaryValue(
+    const std::wstring &valueName,
+    void *const buffer,
+    const DWORD bufferSize)
+{
+    _ASSERTE(IsValid());
+
+    DWORD dataSize = bufferSize; // in: buffer size; out: size of data, in bytes
+    LONG retCode = ::RegGetValue(
         m_hKey,
         nullptr, // no subkey
         valueName.c_str(),
-        flags,
-        nullptr,  // type not required
-        &data[0], // output buffer
+        RRF_RT_REG_BINARY,
+        nullptr, // type not required
+        bufferSize > 0 ? buffer : nullptr,
         &dataSize);
+    if (retCode == ERROR_SUCCESS && bufferSize == 0 && dataSize > 0)
+    {
+        // Without a buffer, RegGetValue only reports the size
+        retCode = ERROR_MORE_DATA;
+    }
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"Cannot get binary data: RegGetValue failed.", retCode};
+        return RegResult{retCode, "Cannot get binary data: RegGetValue failed."};
     }
 
-    return data;
+    return dataSize;
 }
 
-inline DWORD RegKey::QueryValueType(const std::wstring &valueName)
+inline DWORD RegKey::GetBinaryValue(
+    const std::wstring &valueName,
+    void *const buffer,
+    const DWORD bufferSize)
+{
+    return TryGetBinaryValue(valueName, buffer, bufferSize).GetValue();
+}
+
+inline RegExpected<DWORD> RegKey::TryQueryValueType(const std::wstring &valueName)
 {
     _ASSERTE(IsValid());
 
@@ -972,15 +1615,22 @@ inline DWORD RegKey::QueryValueType(const std::wstring &valueName)
 
     if (retCode != ERROR_SUCCESS)
     {
-        if (retCode == ERROR_FILE_NOT_FOUND) {
-          return REG_NONE;
-        }
-        throw RegException{"Cannot get the value type: RegQueryValueEx failed.", retCode};
+        return RegResult{retCode, "Cannot get the value type: RegQueryValueEx failed."};
     }
 
     return typeId;
 }
 
+inline DWORD RegKey::QueryValueType(const std::wstring &valueName)
+{
+    auto typeId = TryQueryValueType(valueName);
+    if (!typeId && typeId.GetError().Code() == ERROR_FILE_NOT_FOUND)
+    {
+        return REG_NONE;
+    }
+    return std::move(typeId).GetValue();
+}
+
 inline void RegKey::QueryInfoKey(DWORD &subKeys, DWORD &values, FILETIME &lastWriteTime)
 {
     _ASSERTE(IsValid());
@@ -1004,7 +1654,7 @@ inline void RegKey::QueryInfoKey(DWORD &subKeys, DWORD &values, FILETIME &lastWr
     }
 }
 
-inline std::vector<std::wstring> RegKey::EnumSubKeys()
+inline RegExpected<std::vector<std::wstring>> RegKey::TryEnumSubKeys()
 {
     _ASSERTE(IsValid());
 
@@ -1028,7 +1678,7 @@ inline std::vector<std::wstring> RegKey::EnumSubKeys()
     );
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{"RegQueryInfoKey failed while preparing for subkey enumeration.", retCode};
+        return RegResult{retCode, "RegQueryInfoKey failed while preparing for subkey enumeration."};
     }
 
     // NOTE: According to the MSDN documentation, the size returned for subkey name max length
@@ -1059,7 +1709,7 @@ inline std::vector<std::wstring> RegKey::EnumSubKeys()
         );
         if (retCode != ERROR_SUCCESS)
         {
-            throw RegException{"Cannot enumerate subkeys: RegEnumKeyEx failed.", retCode};
+            return RegResult{retCode, "Cannot enumerate subkeys: RegEnumKeyEx failed."};
         }
 
         // On success, the ::RegEnumKeyEx API writes the length of the
@@ -1072,7 +1722,12 @@ inline std::vector<std::wstring> RegKey::EnumSubKeys()
     return subkeyNames;
 }
 
-inline std::vector<std::pair<std::wstring, DWORD>> RegKey::EnumValues()
+inline std::vector<std::wstring> RegKey::EnumSubKeys()
+{
+    return TryEnumSubKeys().GetValue();
+}
+
+inline RegExpected<std::vector<std::pair<std::wstring, DWORD>>> RegKey::TryEnumValues()
 {
     _ASSERTE(IsValid());
 
@@ -1096,9 +1751,7 @@ inline std::vector<std::pair<std::wstring, DWORD>> RegKey::EnumValues()
     );
     if (retCode != ERROR_SUCCESS)
     {
-        throw RegException{
-            "RegQueryInfoKey failed while preparing for value enumeration.",
-            retCode};
+        return RegResult{retCode, "RegQueryInfoKey failed while preparing for value enumeration."};
     }
 
     // NOTE: According to the MSDN documentation, the size returned for value name max length
@@ -1130,7 +1783,7 @@ inline std::vector<std::pair<std::wstring, DWORD>> RegKey::EnumValues()
         );
         if (retCode != ERROR_SUCCESS)
         {
-            throw RegException{"Cannot enumerate values: RegEnumValue failed.", retCode};
+            return RegResult{retCode, "Cannot enumerate values: RegEnumValue failed."};
         }
 
         // On success, the RegEnumValue API writes the length of the
@@ -1144,6 +1797,412 @@ inline std::vector<std::pair<std::wstring, DWORD>> RegKey::EnumValues()
     return valueInfo;
 }
 
+inline std::vector<std::pair<std::wstring, DWORD>> RegKey::EnumValues()
+{
+    return TryEnumValues().GetValue();
+}
+
+template <typename F>
+inline RegResult RegKey::TryForEachRawValue(F &&f)
+{
+    _ASSERTE(IsValid());
+
+    // Longest value name, in wchar_ts including the terminating NUL
+    constexpr DWORD kMaxValueNameLen = 16384;
+
+    // ERROR_MORE_DATA retries of one value before giving up
+    constexpr int kMaxRetries = 8;
+
+    std::wstring name;
+    std::unique_ptr<wchar_t[]> nameBuffer;
+    std::vector<BYTE> dataBuffer;
+    DWORD maxValueNameLen{};
+
+    // Size the buffers for the largest value name and data
+    auto prepareBuffers = [&](DWORD &valueCount) -> LONG
+    {
+        DWORD maxValueDataLen{};
+        LONG retCode = ::RegQueryInfoKey(
+            m_hKey,
+            nullptr, // no user-defined class
+            nullptr, // no user-defined class size
+            nullptr, // reserved
+            nullptr, // no subkey count
+            nullptr, // no subkey max length
+            nullptr, // no subkey class length
+            &valueCount,
+            &maxValueNameLen,
+            &maxValueDataLen,
+            nullptr, // no security descriptor
+            nullptr  // no last write time
+        );
+        if (retCode != ERROR_SUCCESS)
+        {
+            return retCode;
+        }
+
+        // The max name length doesn't include the terminating NUL
+        maxValueNameLen++;
+        nameBuffer = std::make_unique<wchar_t[]>(maxValueNameLen);
+        dataBuffer.resize(maxValueDataLen);
+        return ERROR_SUCCESS;
+    };
+
+    DWORD valueCount{};
+    LONG retCode = prepareBuffers(valueCount);
+    if (retCode != ERROR_SUCCESS)
+    {
+        return RegResult{retCode, "RegQueryInfoKey failed while preparing for value enumeration."};
+    }
+
+    int retries = 0;
+    for (DWORD index = 0; index < valueCount;)
+    {
+        DWORD valueNameLen = maxValueNameLen;
+        DWORD valueType{};
+        DWORD dataSize = static_cast<DWORD>(dataBuffer.size());
+        retCode = ::RegEnumValue(
+            m_hKey,
+            index,
+            nameBuffer.get(),
+            &valueNameLen,
+            nullptr, // reserved
+            &valueType,
+            dataBuffer.data(),
+            &dataSize);
+        if (retCode == ERROR_MORE_DATA)
+        {
+            // The value changed since RegQueryInfoKey (or it reported less
+            // than needed): grow the buffer that was short and retry. A value
+            // that keeps growing fails rather than looping forever.
+            if (++retries > kMaxRetries)
+            {
+                return RegResult{retCode, "Cannot enumerate values: RegEnumValue kept returning more data."};
+            }
+            if (dataSize > dataBuffer.size())
+            {
+                dataBuffer.resize(dataSize);
+            }
+            else if (maxValueNameLen < kMaxValueNameLen)
+            {
+                maxValueNameLen = kMaxValueNameLen;
+                nameBuffer = std::make_unique<wchar_t[]>(maxValueNameLen);
+            }
+            continue;
+        }
+        if (retCode == ERROR_NO_MORE_ITEMS)
+        {
+            // Values were deleted meanwhile
+            break;
+        }
+        if (retCode != ERROR_SUCCESS)
+        {
+            return RegResult{retCode, "Cannot enumerate values: RegEnumValue failed."};
+        }
+
+        name.assign(nameBuffer.get(), valueNameLen);
+        f(static_cast<const std::wstring &>(name), valueType, static_cast<const BYTE *>(dataBuffer.data()), dataSize);
+        index++;
+        retries = 0;
+    }
+
+    return RegResult{};
+}
+
+template <typename F>
+inline void RegKey::ForEachRawValue(F &&f)
+{
+    TryForEachRawValue(std::forward<F>(f)).ThrowIfFailed();
+}
+
+inline RegExpected<std::vector<RegValue>> RegKey::TryEnumValuesWithData()
+{
+    std::vector<RegValue> values;
+    const RegResult result = TryForEachRawValue(
+        [&values](const std::wstring &name, const DWORD type, const BYTE *data, const DWORD size) {
+            values.push_back(RegValue{name, type, details::DecodeValueData(type, data, size)});
+        });
+    if (result.Failed())
+    {
+        return result;
+    }
+    return values;
+}
+
+inline std::vector<RegValue> RegKey::EnumValuesWithData()
+{
+    return TryEnumValuesWithData().GetValue();
+}
+
+inline RegResult RegKey::TryEnumSubKeys(NameList &subKeys)
+{
+    _ASSERTE(IsValid());
+
+    subKeys.Clear();
+
+    DWORD subKeyCount{};
+    LONG retCode = ::RegQueryInfoKey(
+        m_hKey,
+        nullptr, // no user-defined class
+        nullptr, // no user-defined class size
+        nullptr, // reserved
+        &subKeyCount,
+        nullptr, // no subkey max length
+        nullptr, // no subkey class length
+        nullptr, // no value count
+        nullptr, // no value name max length
+        nullptr, // no max value length
+        nullptr, // no security descriptor
+        nullptr  // no last write time
+    );
+    if (retCode != ERROR_SUCCESS)
+    {
+        return RegResult{retCode, "RegQueryInfoKey failed while preparing for subkey enumeration."};
+    }
+
+    // Guess 16 wchar_ts per name; the buffer grows as needed
+    subKeys.Reserve(subKeyCount, static_cast<size_t>(subKeyCount) * 16);
+
+    // All of them, including subkeys added meanwhile
+    return TryEnumSubKeys(0, kAllEntries, subKeys);
+}
+
+inline void RegKey::EnumSubKeys(NameList &subKeys)
+{
+    TryEnumSubKeys(subKeys).ThrowIfFailed();
+}
+
+inline RegResult RegKey::TryEnumValues(NameList &values)
+{
+    _ASSERTE(IsValid());
+
+    values.Clear();
+
+    DWORD valueCount{};
+    LONG retCode = ::RegQueryInfoKey(
+        m_hKey,
+        nullptr, // no user-defined class
+        nullptr, // no user-defined class size
+        nullptr, // reserved
+        nullptr, // no subkey count
+        nullptr, // no subkey max length
+        nullptr, // no subkey class length
+        &valueCount,
+        nullptr, // no value name max length
+        nullptr, // no max value length
+        nullptr, // no security descriptor
+        nullptr  // no last write time
+    );
+    if (retCode != ERROR_SUCCESS)
+    {
+        return RegResult{retCode, "RegQueryInfoKey failed while preparing for value enumeration."};
+    }
+
+    values.Reserve(valueCount, static_cast<size_t>(valueCount) * 16);
+
+    return TryEnumValues(0, kAllEntries, values);
+}
+
+inline void RegKey::EnumValues(NameList &values)
+{
+    TryEnumValues(values).ThrowIfFailed();
+}
+
+inline RegExpected<SubKeyDetails> RegKey::TryEnumSubKeysDetailed(const SubKeyCountsOption countsOption)
+{
+    _ASSERTE(IsValid());
+
+    DWORD subKeyCount{};
+    LONG retCode = ::RegQueryInfoKey(
+        m_hKey,
+        nullptr, // no user-defined class
+        nullptr, // no user-defined class size
+        nullptr, // reserved
+        &subKeyCount,
+        nullptr, // no subkey max length
+        nullptr, // no subkey class length
+        nullptr, // no value count
+        nullptr, // no value name max length
+        nullptr, // no max value length
+        nullptr, // no security descriptor
+        nullptr  // no last write time
+    );
+    if (retCode != ERROR_SUCCESS)
+    {
+        return RegResult{retCode, "RegQueryInfoKey failed while preparing for subkey enumeration."};
+    }
+
+    const bool withCounts = countsOption == SubKeyCountsOption::Query;
+    SubKeyDetails details;
+    details.names.Reserve(subKeyCount, static_cast<size_t>(subKeyCount) * 16);
+    details.lastWriteTimes.reserve(subKeyCount);
+    if (withCounts)
+    {
+        details.subKeyCounts.reserve(subKeyCount);
+        details.valueCounts.reserve(subKeyCount);
+    }
+
+    // Registry key names are at most 255 wchar_ts
+    wchar_t nameBuffer[256];
+    for (DWORD index = 0;; index++)
+    {
+        DWORD subKeyNameLen = static_cast<DWORD>(std::size(nameBuffer));
+        FILETIME lastWriteTime{};
+        retCode = ::RegEnumKeyEx(
+            m_hKey,
+            index,
+            nameBuffer,
+            &subKeyNameLen,
+            nullptr, // reserved
+            nullptr, // no class
+            nullptr, // no class
+            &lastWriteTime);
+        if (retCode == ERROR_NO_MORE_ITEMS)
+        {
+            break;
+        }
+        if (retCode != ERROR_SUCCESS)
+        {
+            return RegResult{retCode, "Cannot enumerate subkeys: RegEnumKeyEx failed."};
+        }
+
+        details.names.Append(nameBuffer, subKeyNameLen);
+        details.lastWriteTimes.push_back(lastWriteTime);
+        if (!withCounts)
+        {
+            continue;
+        }
+
+        // RegEnumKeyEx wrote the NUL-terminated name
+        DWORD subKeys{};
+        DWORD values{};
+        HKEY hKey = nullptr;
+        retCode = ::RegOpenKeyEx(m_hKey, nameBuffer, 0, KEY_QUERY_VALUE, &hKey);
+        if (retCode == ERROR_SUCCESS)
+        {
+            retCode = ::RegQueryInfoKey(
+                hKey,
+                nullptr,
+                nullptr,
+                nullptr,
+                &subKeys,
+                nullptr,
+                nullptr,
+                &values,
+                nullptr,
+                nullptr,
+                nullptr,
+                nullptr);
+            ::RegCloseKey(hKey);
+        }
+        if (retCode != ERROR_SUCCESS && retCode != ERROR_FILE_NOT_FOUND && retCode != ERROR_ACCESS_DENIED &&
+            retCode != ERROR_KEY_DELETED)
+        {
+            return RegResult{retCode, "RegQueryInfoKey failed while reading subkey counts."};
+        }
+        details.subKeyCounts.push_back(retCode == ERROR_SUCCESS ? subKeys : 0);
+        details.valueCounts.push_back(retCode == ERROR_SUCCESS ? values : 0);
+    }
+
+    return details;
+}
+
+inline SubKeyDetails RegKey::EnumSubKeysDetailed(const SubKeyCountsOption countsOption)
+{
+    return TryEnumSubKeysDetailed(countsOption).GetValue();
+}
+
+inline RegResult RegKey::TryEnumSubKeys(const DWORD start, const DWORD count, NameList &subKeys)
+{
+    _ASSERTE(IsValid());
+
+    // Keeps the memory of the list
+    subKeys.Clear();
+
+    // Registry key names are at most 255 wchar_ts
+    wchar_t nameBuffer[256];
+    for (DWORD n = 0; n < count; n++)
+    {
+        DWORD subKeyNameLen = static_cast<DWORD>(std::size(nameBuffer));
+        const LONG retCode = ::RegEnumKeyEx(
+            m_hKey,
+            start + n,
+            nameBuffer,
+            &subKeyNameLen,
+            nullptr, // reserved
+            nullptr, // no class
+            nullptr, // no class
+            nullptr  // no last write time
+        );
+        if (retCode == ERROR_NO_MORE_ITEMS)
+        {
+            break;
+        }
+        if (retCode != ERROR_SUCCESS)
+        {
+            return RegResult{retCode, "Cannot enumerate subkeys: RegEnumKeyEx failed."};
+        }
+
+        subKeys.Append(nameBuffer, subKeyNameLen);
+    }
+
+    return RegResult{};
+}
+
+inline void RegKey::EnumSubKeys(const DWORD start, const DWORD count, NameList &subKeys)
+{
+    TryEnumSubKeys(start, count, subKeys).ThrowIfFailed();
+}
+
+inline RegResult RegKey::TryEnumValues(const DWORD start, const DWORD count, NameList &values)
+{
+    _ASSERTE(IsValid());
+
+    values.Clear();
+
+    // Most value names are short: start small, and grow up to the maximum
+    // of 16383 wchar_ts when a longer one shows up
+    std::vector<wchar_t> nameBuffer(256);
+    for (DWORD n = 0; n < count;)
+    {
+        DWORD valueNameLen = static_cast<DWORD>(nameBuffer.size());
+        DWORD valueType{};
+        const LONG retCode = ::RegEnumValue(
+            m_hKey,
+            start + n,
+            nameBuffer.data(),
+            &valueNameLen,
+            nullptr, // reserved
+            &valueType,
+            nullptr, // no data
+            nullptr  // no data size
+        );
+        if (retCode == ERROR_NO_MORE_ITEMS)
+        {
+            break;
+        }
+        if (retCode == ERROR_MORE_DATA && nameBuffer.size() < 16384)
+        {
+            nameBuffer.resize(16384);
+            continue;
+        }
+        if (retCode != ERROR_SUCCESS)
+        {
+            return RegResult{retCode, "Cannot enumerate values: RegEnumValue failed."};
+        }
+
+        values.Append(nameBuffer.data(), valueNameLen, valueType);
+        n++;
+    }
+
+    return RegResult{};
+}
+
+inline void RegKey::EnumValues(const DWORD start, const DWORD count, NameList &values)
+{
+    TryEnumValues(start, count, values).ThrowIfFailed();
+}
+
 inline void RegKey::DeleteValue(const std::wstring &valueName)
 {
     _ASSERTE(IsValid());